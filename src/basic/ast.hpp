@@ -156,10 +156,18 @@ struct LambdaArgs : public Base {
   std::deque<DeclVar> args;
 };
 
+// explicit processing rate of a function relative to the audio rate, like `fn f(x) @/64 {...}`
+struct Rate {
+  enum class Kind { Decimate, Oversample };
+  Kind kind = Kind::Decimate;
+  int factor = 1;
+};
+
 struct Lambda : public Base {
   LambdaArgs args;
   Block body;
   std::optional<types::Value> ret_type;
+  std::optional<Rate> rate = std::nullopt;
 };
 
 struct FcallArgs : public Base {
@@ -34,6 +34,10 @@ void AstStringifier::operator()(const ast::Lambda& ast) {
   const auto& largs = ast.args;
   toStringVec(largs.args);
   output << format.rpar_a;
+  if (ast.rate) {
+    output << (ast.rate->kind == ast::Rate::Kind::Decimate ? "@/" : "@*") << ast.rate->factor
+           << format.delim;
+  }
   (*this)(ast.body);
   output << format.rpar;
 }
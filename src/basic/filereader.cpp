@@ -14,6 +14,7 @@ const std::unordered_map<std::string_view, mimium::FileType> str_to_filetype = {
     {mimium::mmm_ext, mimium::FileType::MimiumSource},
     {mimium::ll_ext, mimium::FileType::LLVMIR},
     {mimium::bc_ext, mimium::FileType::LLVMIR},
+    {mimium::mir_ext, mimium::FileType::MimiumMir},
 };
 };
 
@@ -25,7 +26,7 @@ std::pair<fs::path, FileType> getFilePath(std::string_view val) {
   fs::path res(val);
   auto type = getFileTypeByExt(res.extension().string());
   if (type == FileType::Invalid) {
-    throw std::runtime_error("Unknown file type. Expected either of .mmm, .ll or .bc");
+    throw std::runtime_error("Unknown file type. Expected either of .mmm, .mmmmir, .ll or .bc");
   }
   return std::pair(res, type);
 }
@@ -5,6 +5,10 @@
 #pragma once
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 #include "export.hpp"
 namespace mimium {
 namespace fs = std::filesystem;
@@ -12,17 +16,46 @@ namespace fs = std::filesystem;
 constexpr std::string_view mmm_ext = ".mmm";
 constexpr std::string_view ll_ext = ".ll";
 constexpr std::string_view bc_ext = ".bc";
+constexpr std::string_view mir_ext = ".mmmmir";
 
 enum class FileType {
   Invalid = -1,
   MimiumSource = 0,
-  MimiumMir,  // currently not used
+  MimiumMir,  // binary MIR emitted with --emit-mir-bin
   LLVMIR,
 };
+struct SourceLocation {
+  fs::path filepath;
+  int line = 0;
+};
+
+// Maps each line of a preprocessed source to the file and the line where it originally came from.
+class MIMIUM_DLL_PUBLIC SourceMap {
+ public:
+  int addFile(fs::path path) {
+    files.emplace_back(std::move(path));
+    return static_cast<int>(files.size()) - 1;
+  }
+  void addLine(int fileindex, int line) { lines.emplace_back(fileindex, line); }
+  // line is 1-origin, as same as the location of the parser.
+  [[nodiscard]] std::optional<SourceLocation> resolve(int line) const {
+    if (line < 1 || line > static_cast<int>(lines.size())) { return std::nullopt; }
+    const auto& [fileindex, origline] = lines[line - 1];
+    return SourceLocation{files[fileindex], origline};
+  }
+  [[nodiscard]] size_t size() const { return lines.size(); }
+
+ private:
+  std::vector<fs::path> files;
+  std::vector<std::pair<int, int>> lines;
+};
+
 struct MIMIUM_DLL_PUBLIC Source {
   fs::path filepath;
   FileType filetype;
   std::string source;
+  // available if the source was generated by Preprocessor.
+  std::shared_ptr<const SourceMap> sourcemap = nullptr;
 };
 MIMIUM_DLL_PUBLIC  FileType getFileTypeByExt(std::string_view ext);
 MIMIUM_DLL_PUBLIC  std::pair<fs::path, FileType> getFilePath(std::string_view val);
@@ -48,7 +48,11 @@ std::string toString(Argument const& i) { return i.name; }
 
 std::string instruction::toString(Function const& i) {
   std::stringstream ss;
-  ss << i.name << " = fun" << ((i.isrecursive) ? "[rec]" : "") << " ";
+  ss << i.name << " = fun" << ((i.isrecursive) ? "[rec]" : "");
+  if (i.rate) {
+    ss << (i.rate->kind == ast::Rate::Kind::Decimate ? "@/" : "@*") << i.rate->factor;
+  }
+  ss << " ";
   if (i.args.ret_ptr) { ss << mir::getName(*i.args.ret_ptr.value()) << ", "; }
   ss << join(i.args.args, " , ");
   if (!i.freevariables.empty()) { ss << " fv{" << join(i.freevariables, ",") << "}"; }
@@ -120,6 +120,8 @@ struct Function : public Base {
   blockptr body;
   bool hasself = false;
   bool isrecursive = false;
+  // expanded into resampling code by MultirateExpander before closure conversion
+  std::optional<ast::Rate> rate = std::nullopt;
   // introduced after closure conversion;
   // contains self & delay, and fcall which
   // has self&delay
@@ -283,5 +285,46 @@ bool isInstA(valueptr ptr) {
   return false;
 }
 
+// calls fn with a reference to each operand of the instruction.
+template <typename F>
+void forEachOperand(valueptr inst, F&& fn) {
+  auto* i = std::get_if<Instructions>(inst.get());
+  if (i == nullptr) { return; }
+  std::visit(overloaded{[&](instruction::Ref& i) { fn(i.target); },
+                        [&](instruction::Load& i) { fn(i.target); },
+                        [&](instruction::Store& i) {
+                          fn(i.target);
+                          fn(i.value);
+                        },
+                        [&](instruction::Op& i) {
+                          if (i.lhs.has_value()) { fn(i.lhs.value()); }
+                          fn(i.rhs);
+                        },
+                        [&](instruction::Fcall& i) {
+                          fn(i.fname);
+                          for (auto& a : i.args) { fn(a); }
+                          if (i.time.has_value()) { fn(i.time.value()); }
+                        },
+                        [&](instruction::MakeClosure& i) {
+                          fn(i.fname);
+                          for (auto& c : i.captures) { fn(c); }
+                        },
+                        [&](instruction::Array& i) {
+                          for (auto& a : i.args) { fn(a); }
+                        },
+                        [&](instruction::ArrayAccess& i) {
+                          fn(i.target);
+                          fn(i.index);
+                        },
+                        [&](instruction::Field& i) {
+                          fn(i.target);
+                          fn(i.index);
+                        },
+                        [&](instruction::If& i) { fn(i.cond); },
+                        [&](instruction::Return& i) { fn(i.val); },
+                        [](auto& /*i*/) {}},
+             *i);
+}
+
 }  // namespace mir
 }  // namespace mimium
\ No newline at end of file
@@ -6,12 +6,118 @@
 
 namespace{
   mimium::types::ToStringVisitor tostrvisitor;//FIXWARNING
+
+template <class T>
+struct is_box : std::false_type {};
+template <class T>
+struct is_box<mimium::Box<T>> : std::true_type {};
+
+size_t hashCombine(size_t seed, size_t v) {
+  return seed ^ (v + 0x9e3779b97f4a7c15ULL + (seed << 6U) + (seed >> 2U));
+}
+size_t identityHash(mimium::types::Value const& t) {
+  return std::visit(
+      [&](auto const& v) -> size_t {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, mimium::types::rTypeVar>) {
+          return hashCombine(t.index(), std::hash<int>()(v.getraw().index));
+        } else if constexpr (is_box<T>::value) {
+          return hashCombine(t.index(), std::hash<const void*>()(v.t.get()));
+        } else {
+          return t.index();
+        }
+      },
+      t);
+}
+size_t identityHash(std::vector<mimium::types::Value> const& vec) {
+  size_t res = vec.size();
+  for (const auto& a : vec) { res = hashCombine(res, identityHash(a)); }
+  return res;
+}
+bool isIdentical(std::vector<mimium::types::Value> const& v1,
+                 std::vector<mimium::types::Value> const& v2) {
+  return std::equal(v1.begin(), v1.end(), v2.begin(), v2.end(),
+                    [](auto const& a, auto const& b) { return mimium::types::isIdentical(a, b); });
 }
 
+// hash and equality of a single node, assuming its children are already hash-consed.
+struct NodeHasher {
+  size_t operator()(mimium::types::Ref const& t) const { return identityHash(t.val); }
+  size_t operator()(mimium::types::Pointer const& t) const { return identityHash(t.val); }
+  size_t operator()(mimium::types::Function const& t) const {
+    return hashCombine(identityHash(t.ret_type), identityHash(t.arg_types));
+  }
+  size_t operator()(mimium::types::Closure const& t) const {
+    return hashCombine(identityHash(t.fun.val), identityHash(t.captures));
+  }
+  size_t operator()(mimium::types::Array const& t) const {
+    return hashCombine(identityHash(t.elem_type), std::hash<int>()(t.size));
+  }
+  size_t operator()(mimium::types::Struct const& t) const {
+    size_t res = t.arg_types.size();
+    for (const auto& a : t.arg_types) {
+      res = hashCombine(hashCombine(res, std::hash<std::string>()(a.field)), identityHash(a.val));
+    }
+    return res;
+  }
+  size_t operator()(mimium::types::Tuple const& t) const { return identityHash(t.arg_types); }
+  size_t operator()(mimium::types::Alias const& t) const {
+    return hashCombine(std::hash<std::string>()(t.name), identityHash(t.target));
+  }
+};
+struct NodeEqual {
+  bool operator()(mimium::types::Ref const& t1, mimium::types::Ref const& t2) const {
+    return mimium::types::isIdentical(t1.val, t2.val);
+  }
+  bool operator()(mimium::types::Pointer const& t1, mimium::types::Pointer const& t2) const {
+    return mimium::types::isIdentical(t1.val, t2.val);
+  }
+  bool operator()(mimium::types::Function const& t1, mimium::types::Function const& t2) const {
+    return mimium::types::isIdentical(t1.ret_type, t2.ret_type) &&
+           isIdentical(t1.arg_types, t2.arg_types);
+  }
+  bool operator()(mimium::types::Closure const& t1, mimium::types::Closure const& t2) const {
+    return mimium::types::isIdentical(t1.fun.val, t2.fun.val) &&
+           mimium::types::isIdentical(t1.captures, t2.captures);
+  }
+  bool operator()(mimium::types::Array const& t1, mimium::types::Array const& t2) const {
+    return t1.size == t2.size && mimium::types::isIdentical(t1.elem_type, t2.elem_type);
+  }
+  bool operator()(mimium::types::Struct const& t1, mimium::types::Struct const& t2) const {
+    return std::equal(t1.arg_types.begin(), t1.arg_types.end(), t2.arg_types.begin(),
+                      t2.arg_types.end(), [](auto const& a, auto const& b) {
+                        return a.field == b.field && mimium::types::isIdentical(a.val, b.val);
+                      });
+  }
+  bool operator()(mimium::types::Tuple const& t1, mimium::types::Tuple const& t2) const {
+    return isIdentical(t1.arg_types, t2.arg_types);
+  }
+  bool operator()(mimium::types::Alias const& t1, mimium::types::Alias const& t2) const {
+    return t1.name == t2.name && mimium::types::isIdentical(t1.target, t2.target);
+  }
+};
+}  // namespace
+
 namespace mimium {
 namespace types {
 
-bool isTypeVar(types::Value t) { return std::holds_alternative<Box<types::TypeVar>>(t); }
+bool isTypeVar(types::Value const& t) { return std::holds_alternative<Box<types::TypeVar>>(t); }
+
+bool isIdentical(Value const& t1, Value const& t2) {
+  if (t1.index() != t2.index()) { return false; }
+  return std::visit(
+      [&](auto const& v) {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, rTypeVar>) {
+          return v.getraw().index == std::get<T>(t2).getraw().index;
+        } else if constexpr (is_box<T>::value) {
+          return v.t == std::get<T>(t2).t;
+        } else {
+          return true;
+        }
+      },
+      t1);
+}
 
 std::string toString(const Value& v, bool verbose) {
   tostrvisitor.verbose = verbose;
@@ -22,6 +128,55 @@ void dump(const Value& v, bool verbose) { std::cerr << toString(v, verbose) << "
 
 }  // namespace types
 
+int TypeEnv::findRoot(int tindex) {
+  // path halving
+  while (tv_parent[tindex] != tindex) {
+    tv_parent[tindex] = tv_parent[tv_parent[tindex]];
+    tindex = tv_parent[tindex];
+  }
+  return tindex;
+}
+
+int TypeEnv::unionTypeVar(int t1, int t2) {
+  auto r1 = findRoot(t1);
+  auto r2 = findRoot(t2);
+  if (r1 == r2) { return r1; }
+  if (tv_rank[r1] < tv_rank[r2]) { std::swap(r1, r2); }
+  tv_parent[r2] = r1;
+  if (tv_rank[r1] == tv_rank[r2]) { ++tv_rank[r1]; }
+  return r1;
+}
+
+types::Value TypeEnv::intern(types::Value const& t) {
+  if (types::isPrimitive(t) || types::isTypeVar(t)) { return t; }
+  auto hash = std::visit(
+      [](auto const& v) -> size_t {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (is_box<T>::value && !std::is_same_v<T, types::rTypeVar>) {
+          return NodeHasher{}(v.getraw());
+        } else {
+          return 0;
+        }
+      },
+      t);
+  auto [iter, isnew] = hashcons_table.try_emplace(hashCombine(t.index(), hash), t);
+  if (isnew) { return t; }
+  const auto& candidate = iter->second;
+  bool same = candidate.index() == t.index() &&
+              std::visit(
+                  [&](auto const& v) {
+                    using T = std::decay_t<decltype(v)>;
+                    if constexpr (is_box<T>::value && !std::is_same_v<T, types::rTypeVar>) {
+                      return NodeEqual{}(v.getraw(), std::get<T>(candidate).getraw());
+                    } else {
+                      return false;
+                    }
+                  },
+                  t);
+  // on hash collision, the node is simply left unshared.
+  return same ? candidate : t;
+}
+
 void TypeEnv::replaceTypeVars() {
   for (auto& [key, val] : env) {
     if (rv::holds_alternative<types::TypeVar>(val)) {
@@ -47,10 +202,10 @@ void TypeEnv::dump(bool verbose) {
 }
 void TypeEnv::dumpTvLinks() {
   std::cerr << "------tvlinks-----\n";
-  int i = 0;
-  for (auto& a : tv_container) {
-    std::cerr << "typevar" << i << " : " << types::toString(a) << "\n";
-    ++i;
+  for (int i = 0; i < static_cast<int>(tv_container.size()); i++) {
+    auto root = findRoot(i);
+    std::cerr << "typevar" << i << " -> typevar" << root << " : "
+              << types::toString(tv_container[root]) << "\n";
   }
   std::cerr << "------tvlinks-----" << std::endl;
 }
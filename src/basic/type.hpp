@@ -182,7 +182,10 @@ struct Alias {
   Value target;
 };
 inline bool operator==(const Alias& t1, const Alias& t2) { return (t1.name == t2.name); }
-bool isTypeVar(types::Value t);
+bool isTypeVar(types::Value const& t);
+// shallow identity used for hash-consing: primitives and type variables are compared by value,
+// aggregate types by the address of their storage.
+bool isIdentical(Value const& t1, Value const& t2);
 
 template <class T>
 inline constexpr bool is_pointer_t = std::is_same_v<T, Pointer> || std::is_same_v<T, Ref>;
@@ -205,6 +208,31 @@ inline auto getDelayStruct(){
   return types::Alias{"MmmRingBuf", types::Tuple{{types::Float{}, types::Float{},
                                                   types::Array{types::Float{}, fixed_delaysize}}}};
 }
+// number of nonzero side taps of the halfband filter used for oversampling. The filter length is
+// 4*halfband_sidetaps-1 at the doubled rate.
+constexpr size_t halfband_sidetaps = 8;
+inline auto getHalfbandStruct() {
+  auto buf = types::Array{types::Float{}, 2 * halfband_sidetaps};
+  return types::Alias{"MmmHalfband", types::Tuple{{types::Float{}, std::move(buf)}}};
+}
+// state of the filter builtins, see compiler/filters.hpp.
+inline auto getFilterStruct(std::string const& name, int numstates) {
+  return types::Alias{name, types::Tuple{std::vector<types::Value>(numstates, types::Float{})}};
+}
+// states of numlanes instances of a filter, in which each state variable is an array.
+inline auto getFilterBankStruct(int numstates, int numlanes) {
+  auto lanes = types::Value(types::Array{types::Float{}, numlanes});
+  return types::Tuple{std::vector<types::Value>(numstates, lanes)};
+}
+// state of convolve, which holds a pointer to the instance in the runtime.
+inline auto getConvolverStruct() {
+  return types::Alias{"MmmConvolver", types::Tuple{{types::Float{}, types::Float{}}}};
+}
+// state of osc_table, which holds the phase and a pointer to the mipmap in the runtime.
+inline auto getWavetableOscStruct() {
+  return types::Alias{"MmmWavetableOsc",
+                      types::Tuple{{types::Float{}, types::Float{}, types::Float{}}}};
+}
 
 struct ToStringVisitor {
   bool verbose = false;
@@ -272,18 +300,32 @@ inline bool isClosure(const Value& v) {
 class TypeEnv {
  private:
   int64_t typeid_count{};
+  std::unordered_map<size_t, types::Value> hashcons_table;
 
  public:
   TypeEnv() : env() {}
   std::unordered_map<std::string, types::Value> env;
 
+  // substitution store of type variables, organized as union-find forest.
+  // tv_container of the representative holds the bound type, or the TypeVar of itself if unbound.
   std::deque<types::Value> tv_container;
+  std::vector<int> tv_parent;
+  std::vector<int> tv_rank;
   std::shared_ptr<types::TypeVar> createNewTypeVar() {
     auto res = std::make_shared<types::TypeVar>(typeid_count++);
     tv_container.emplace_back(*res);
+    tv_parent.emplace_back(res->index);
+    tv_rank.emplace_back(0);
     return res;
   }
-  types::Value& findTypeVar(int tindex) { return tv_container[tindex]; }
+  int findRoot(int tindex);
+  // merges two classes by rank and returns new representative. binding is not modified.
+  int unionTypeVar(int t1, int t2);
+  types::Value& findTypeVar(int tindex) { return tv_container[findRoot(tindex)]; }
+  bool isBound(int tindex) { return !types::isTypeVar(findTypeVar(tindex)); }
+  // hash-consing for aggregate types. structurally same node with identical children returns
+  // the same storage, so that equality check and unification can be shortcut by its address.
+  types::Value intern(types::Value const& t);
   [[nodiscard]] bool exist(std::string key) const { return (env.count(key) > 0); }
   auto begin() { return env.begin(); }
   auto end() { return env.end(); }
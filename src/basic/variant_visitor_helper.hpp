@@ -35,6 +35,7 @@ struct Box {
 
 template <typename T>
 inline bool operator==(const Box<T>& t1, const Box<T>& t2) {
+  if (t1.t == t2.t) { return true; }
   return static_cast<const T&>(t1) == static_cast<const T&>(t2);
 }
 template <typename T>
@@ -11,6 +11,13 @@ namespace mimium {
 Driver::Driver() : parser(nullptr), scanner(nullptr) {}
 AstPtr Driver::parse(std::istream& is) {
   scanner = std::make_unique<MimiumScanner>(is);
+  return runParser();
+}
+AstPtr Driver::parseBuffer(std::string_view buffer) {
+  scanner = std::make_unique<MimiumScanner>(buffer);
+  return runParser();
+}
+AstPtr Driver::runParser() {
   parser = std::make_unique<MimiumParser>(*scanner, *this);
   parser->set_debug_level(DEBUG_LEVEL);  // debug
   int res = 0;
@@ -24,17 +31,23 @@ AstPtr Driver::parse(std::istream& is) {
   return ast_top;
 }
 
-AstPtr Driver::parseString(const std::string& source) {
-  std::stringbuf buf(source);
-  std::istream is(&buf);
-  return std::move(parse(is));
-}
+AstPtr Driver::parseString(const std::string& source) { return parseBuffer(source); }
 AstPtr Driver::parseFile(const std::string& filename) {
   FileReader reader(fs::current_path());
   auto src = reader.loadFile(filename);
-  return std::move(parseString(src.source));
+  return parseBuffer(src.source);
 }
 
 void Driver::setTopAst(AstPtr top) { this->ast_top = top; }
+void Driver::setSourceMap(std::shared_ptr<const SourceMap> map) { sourcemap = std::move(map); }
+
+std::string Driver::formatLocation(int line, int col) const {
+  if (sourcemap) {
+    if (auto loc = sourcemap->resolve(line)) {
+      return loc->filepath.string() + ":" + std::to_string(loc->line) + ":" + std::to_string(col);
+    }
+  }
+  return std::to_string(line) + ":" + std::to_string(col);
+}
 
 }  // namespace mimium
\ No newline at end of file
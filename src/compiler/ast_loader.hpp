@@ -13,8 +13,10 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <string_view>
 
 #include "basic/ast.hpp"
+#include "basic/filereader.hpp"
 namespace mimium {
 
 class MimiumScanner;
@@ -26,12 +28,19 @@ class Driver {
  public:
  Driver ();
   AstPtr parse(std::istream& is);
+  // parse without copying the source. The buffer must be alive until parsing finishes.
+  AstPtr parseBuffer(std::string_view buffer);
   AstPtr parseString(const std::string& source);
   AstPtr parseFile(const std::string& filename);
   void setTopAst(AstPtr top);
+  // set source map of preprocessed source to report errors in the original files.
+  void setSourceMap(std::shared_ptr<const SourceMap> map);
+  [[nodiscard]] std::string formatLocation(int line, int col) const;
 
  private:
   AstPtr ast_top;
+  std::shared_ptr<const SourceMap> sourcemap = nullptr;
+  AstPtr runParser();
   std::unique_ptr<MimiumParser> parser;
   std::unique_ptr<MimiumScanner> scanner;
 };
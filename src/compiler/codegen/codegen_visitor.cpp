@@ -7,6 +7,7 @@
 #include "compiler/codegen/typeconverter.hpp"
 #include "compiler/collect_memoryobjs.hpp"
 #include "compiler/ffi.hpp"
+#include "compiler/filters.hpp"
 
 namespace mimium {
 using OpId = ast::OpId;
@@ -25,6 +26,7 @@ CodeGenVisitor::CodeGenVisitor(LLVMGenerator& g, const funobjmap* funobj_map)
       funobj_map(funobj_map),
       isglobal(false),
       context_hasself(false),
+      context_random_has_state(false),
       recursivefn_ptr(nullptr) {}
 
 llvm::Value* CodeGenVisitor::visit(mir::valueptr val) {
@@ -53,7 +55,7 @@ void CodeGenVisitor::registerLlvmValforFreeVar(mir::valueptr mirval, llvm::Value
 llvm::Value* CodeGenVisitor::getConstant(const mir::Constants& val) {
   return std::visit(overloaded{
                         [&](int v) { return (llvm::Value*)G.getConstInt(v); },
-                        [&](double v) { return (llvm::Value*)G.getConstDouble(v); },
+                        [&](double v) { return G.getConstFloat(v); },
                         // todo
                         [](const std::string& v) { return (llvm::Value*)nullptr; },
                     },
@@ -159,7 +161,7 @@ llvm::Value* CodeGenVisitor::createAllocation(bool isglobal, llvm::Type* type,
 }
 
 llvm::Value* CodeGenVisitor::operator()(minst::Number& i) {
-  return llvm::ConstantFP::get(G.ctx, llvm::APFloat(i.val));
+  return G.getConstFloat(i.val);
 }
 llvm::Value* CodeGenVisitor::operator()(minst::String& i) {
   auto* cstr = llvm::ConstantDataArray::getString(G.ctx, i.val);
@@ -207,7 +209,7 @@ llvm::Value* CodeGenVisitor::createUniOp(minst::Op& i) {
       return G.builder->CreateUnOp(llvm::Instruction::UnaryOps::FNeg, rhs, i.name);
       break;
     case ast::OpId::Not:
-      return G.builder->CreateCall(G.getForeignFunction("not"), {rhs}, i.name);
+      return createCall(G.getForeignFunction("not"), {rhs}, i.name);
       break;
     default: return G.builder->CreateUnreachable(); break;
   }
@@ -224,7 +226,7 @@ llvm::Value* CodeGenVisitor::createBinOp(minst::Op& i) {
     default: {
       if (opid_to_ffi.count(i.op) > 0) {
         auto fname = opid_to_ffi.find(i.op)->second;
-        return G.builder->CreateCall(G.getForeignFunction(fname), {lhs, rhs}, i.name);
+        return createCall(G.getForeignFunction(fname), {lhs, rhs}, i.name);
       }
 
       return G.builder->CreateUnreachable();
@@ -235,6 +237,7 @@ llvm::Value* CodeGenVisitor::createBinOp(minst::Op& i) {
 llvm::Value* CodeGenVisitor::operator()(minst::Function& i) {
   mirfv_to_llvm.clear();
   memobj_to_llvm.clear();
+  memobj_strides.clear();
   assert(memobjqueue.empty());
   bool hascapture = !i.freevariables.empty();
 
@@ -244,7 +247,8 @@ llvm::Value* CodeGenVisitor::operator()(minst::Function& i) {
     context_hasself = fobjtree->second->hasself;
     hasmemobj = !fobjtree->second->memobjs.empty() || context_hasself;
   }
-  bool isdsp = i.name == "dsp";
+  context_random_has_state = hasmemobj && fobjtree->second->random_has_state;
+  bool isdsp = LLVMGenerator::isDspLikeFunction(i.name);
   if (isdsp) { G.checkDspFunctionType(i); }
   auto* ft = !isdsp ? createFunctionType(i) : createDspFnType(i, hascapture, hasmemobj);
   auto* f = createFunction(ft, i);
@@ -258,6 +262,7 @@ llvm::Value* CodeGenVisitor::operator()(minst::Function& i) {
   if (G.builder->GetInsertBlock()->getTerminator() == nullptr && ft->getReturnType()->isVoidTy()) {
     G.builder->CreateRetVoid();
   }
+  context_random_has_state = false;
   G.switchToMainFun();
   return f;
 }
@@ -301,7 +306,13 @@ llvm::Function* CodeGenVisitor::createFunction(llvm::FunctionType* type, minst::
 }
 void CodeGenVisitor::addArgstoMap(llvm::Function* f, minst::Function& i, bool hascapture,
                                   bool hasmemobj) {
-  const bool isdsp = i.name == "dsp";
+  const bool isdsp = LLVMGenerator::isDspLikeFunction(i.name);
+  if (isdsp) {
+    auto& info = G.getDspLikeFnInfo(i.name);
+    const int offset = i.args.ret_ptr ? 1 : 0;
+    info.out_arg = i.args.ret_ptr ? 0 : -1;
+    info.in_arg = i.args.args.empty() ? -1 : offset;
+  }
   // arguments are [actual arguments], capture , memobjs
   auto* arg = std::begin(f->args());
   if (auto a = i.args.ret_ptr) {
@@ -336,15 +347,30 @@ void CodeGenVisitor::addArgstoMap(llvm::Function* f, minst::Function& i, bool ha
 void CodeGenVisitor::setMemObjsToMap(mir::valueptr fun, llvm::Value* memarg) {
   auto fobjtree = funobj_map->at(fun);
   auto& memobjs = fobjtree->memobjs;
+  const auto& fields = fobjtree->memobj_fields;
+  const auto& lanes = fobjtree->memobj_lanes;
   int count = 0;
-  // appending order matters! self should be put on last.
+  // without layout, memobjs are in order and self is put on last.
   for (auto& o : memobjs) {
-    memobjqueue.emplace(
-        G.builder->CreateStructGEP(memarg, count++, mir::getName(*o->fname) + ".mem"));
+    auto index = fields.empty() ? count : fields[count];
+    auto lane = lanes.empty() ? -1 : lanes[count];
+    count++;
+    auto name = mir::getName(*o->fname) + ".mem";
+    auto* gep = G.builder->CreateStructGEP(memarg, index, lane < 0 ? name : name + ".bank");
+    if (lane >= 0) {
+      // the states of the lane in the bank of arrays, see layoutMemobjTree.
+      auto* banktype = llvm::cast<llvm::StructType>(gep->getType()->getPointerElementType());
+      auto* arrtype = llvm::cast<llvm::ArrayType>(banktype->getElementType(0));
+      auto* arr = G.builder->CreateStructGEP(gep, 0);
+      gep = G.builder->CreateConstInBoundsGEP2_32(arrtype, arr, 0, lane, name);
+      memobj_strides.emplace(gep, static_cast<int64_t>(arrtype->getNumElements()));
+    }
+    memobjqueue.emplace(gep);
     // memobj_to_llvm.emplace(o->fname, gep);
   }
   if (fobjtree->hasself) {
-    auto* gep = G.builder->CreateStructGEP(memarg, count++, "ptr_self");
+    auto index = fobjtree->self_field >= 0 ? fobjtree->self_field : count;
+    auto* gep = G.builder->CreateStructGEP(memarg, index, "ptr_self");
     fun_to_selfptr.emplace(fun, gep);
     auto* selfval = G.builder->CreateLoad(gep, "self");
     fun_to_selfval.emplace(fun, selfval);
@@ -378,23 +404,32 @@ llvm::Value* CodeGenVisitor::operator()(minst::Fcall& i) {
     }
   }
   auto fobjtree_iter = funobj_map->find(mmmfn);
-  const bool hasmemobj = fobjtree_iter != funobj_map->end();
+  const bool israndom = mir::getName(*i.fname) == "random" && i.ftype == EXTERNAL;
+  const bool hasmemobj =
+      israndom ? context_random_has_state : fobjtree_iter != funobj_map->end();
 
   auto* fun = isrecursive ? G.curfunc : getFunForFcall(i);
   // prepare arguments
   std::vector<llvm::Value*> args = {};
-  if (mir::getName(*i.fname) == "mimium_getnow") { args.push_back(G.getRuntimeInstance()); }
+  const auto fname = mir::getName(*i.fname);
+  if (fname == "mimium_getnow" || LLVMBuiltin::needsRuntime(fname)) {
+    if (i.time.has_value()) {
+      throw std::runtime_error(fname + " cannot be called with @ operator directly.");
+    }
+    args.push_back(G.getRuntimeInstance());
+  }
   if (i.time.has_value()) {
     auto* timeval = getLlvmVal(i.time.value());
     llvm::Value* ptrtofn = G.builder->CreateBitCast(fun, G.geti8PtrTy(), fun->getName() + "_i8");
     args = {G.getRuntimeInstance(), timeval, ptrtofn};
-    if (i.args.empty()) { args.emplace_back(llvm::ConstantFP::get(G.ctx, llvm::APFloat(0.0))); }
+    if (i.args.empty()) { args.emplace_back(G.getConstFloat(0.0)); }
     if (i.args.size() > 1) {
       throw std::runtime_error(
           "currently function call with @ operator can accept only one argument with float type");
     }
     // addTask should be declared in preprocess;
-    fun = G.module->getFunction(isclosure ? "addTask_cls" : "addTask");
+    std::string taskfn = isclosure ? "addTask_cls" : "addTask";
+    fun = G.module->getFunction(G.isFloat32() ? taskfn + "_f32" : taskfn);
   }
   {
     auto tmparg = makeFcallArgs(fun->getType(), i.args);
@@ -410,7 +445,15 @@ llvm::Value* CodeGenVisitor::operator()(minst::Fcall& i) {
     args.emplace_back(capptr);
   }
 
-  if (hasmemobj) {
+  if (hasmemobj && i.ftype == EXTERNAL && filters::getKind(fname) != filters::Kind::None) {
+    // filters take the pointer to the first state and the stride in elements.
+    auto* memobj = popMemobjInContext();
+    auto iter = memobj_strides.find(memobj);
+    const int64_t stride = iter != memobj_strides.end() ? iter->second : 1;
+    args.emplace_back(
+        G.builder->CreateBitCast(memobj, llvm::PointerType::get(G.getFloatTy(), 0)));
+    args.emplace_back(llvm::ConstantInt::get(G.geti64Ty(), stride));
+  } else if (hasmemobj) {
     // auto res = memobj_to_llvm.find(fobjtree_iter->second->fname);
     // if (res != memobj_to_llvm.end()) { args.emplace_back(res->second); }
     args.emplace_back(popMemobjInContext());
@@ -421,12 +464,33 @@ llvm::Value* CodeGenVisitor::operator()(minst::Fcall& i) {
   }
   assert(funtype_raw->isFunctionTy());
   auto* ft = llvm::cast<llvm::FunctionType>(funtype_raw);
+  return createCall(ft, fun, std::move(args), i.name);
+}
+
+llvm::Value* CodeGenVisitor::createCall(llvm::Function* fun, std::vector<llvm::Value*> args,
+                                        std::string const& name) {
+  return createCall(fun->getFunctionType(), fun, std::move(args), name);
+}
+llvm::Value* CodeGenVisitor::createCall(llvm::FunctionType* ft, llvm::Value* fun,
+                                        std::vector<llvm::Value*> args, std::string const& name) {
+  // builtins without single precision version take and return double in float32 mode.
+  for (size_t n = 0; n < args.size() && n < ft->getNumParams(); n++) {
+    auto* ptype = ft->getParamType(n);
+    auto* atype = args[n]->getType();
+    if (ptype != atype && ptype->isFloatingPointTy() && atype->isFloatingPointTy()) {
+      args[n] = G.builder->CreateFPCast(args[n], ptype);
+    }
+  }
   // if return type is void, llvm cannot have return value and name
   if (ft->getReturnType()->isVoidTy()) {
     G.builder->CreateCall(ft, fun, args);
     return nullptr;
   }
-  return G.builder->CreateCall(ft, fun, args, i.name);
+  llvm::Value* res = G.builder->CreateCall(ft, fun, args, name);
+  if (res->getType()->isFloatingPointTy() && res->getType() != G.getFloatTy()) {
+    res = G.builder->CreateFPCast(res, G.getFloatTy(), name + ".cast");
+  }
+  return res;
 }
 llvm::Value* CodeGenVisitor::getFunForFcall(minst::Fcall const& i) {
   switch (i.ftype) {
@@ -457,6 +521,7 @@ llvm::Value* CodeGenVisitor::getClsFun(minst::Fcall const& i) {
 }
 llvm::Value* CodeGenVisitor::getExtFun(minst::Fcall const& i) {
   auto fun = std::get<mir::ExternalSymbol>(*i.fname);
+  if (fun.name == "random") { return G.getRandomFunction(context_random_has_state); }
   if (LLVMBuiltin::ftable.count(fun.name) > 0) { return G.getForeignFunction(fun.name); }
   if (G.runtime_fun_names.count(fun.name) > 0) { return G.getRuntimeFunction(fun.name); }
   assert(false);
@@ -474,7 +539,7 @@ llvm::Value* CodeGenVisitor::operator()(minst::MakeClosure& i) {
   // auto& capturenames = G.cc.getCaptureNames(i.fname);
   assert(types::isClosure(i.type) && "closure type is invalid");
   auto* targetf = getLlvmVal(i.fname);
-  const bool isdsp = targetf->getName() == "dsp";
+  const bool isdsp = LLVMGenerator::isDspLikeFunction(targetf->getName().str());
   auto* closuretype = G.getType(i.type);
   // // always heap allocation!
   auto* closure_ptr = createAllocation(true, closuretype, nullptr, i.name);
@@ -496,7 +561,8 @@ llvm::Value* CodeGenVisitor::operator()(minst::MakeClosure& i) {
     G.builder->CreateStore(capval, gep);
   }
 
-  if (isdsp) { G.runtime_dspfninfo.capptr = capture_ptr; }
+  if (isdsp) { G.getDspLikeFnInfo(targetf->getName().str()).capptr = capture_ptr; }
+  if (targetf->getName() == "midiin") { G.runtime_midiin_capptr = capture_ptr; }
   return closure_ptr;
 }
 llvm::Value* CodeGenVisitor::operator()(minst::Array& i) {
@@ -512,7 +578,8 @@ llvm::Value* CodeGenVisitor::operator()(minst::Array& i) {
 llvm::Value* CodeGenVisitor::operator()(minst::ArrayAccess& i) {
   auto* target = getLlvmVal(i.target);
   auto* index = getLlvmVal(i.index);
-  auto* arraccessfun = G.module->getFunction("access_array_lin_interp");
+  auto* arraccessfun = G.module->getFunction(G.isFloat32() ? "access_array_lin_interp_f32"
+                                                           : "access_array_lin_interp");
   auto* dptrty = arraccessfun->getArg(0)->getType();
   if (target->getType() != dptrty) { target = G.builder->CreateBitCast(target, dptrty); }
   return G.builder->CreateCall(arraccessfun, {target, index}, "arrayaccess");
@@ -552,7 +619,7 @@ llvm::Value* CodeGenVisitor::createIfBody(mir::blockptr& block) {
 llvm::Value* CodeGenVisitor::operator()(minst::If& i) {
   auto* thisbb = G.builder->GetInsertBlock();
   auto* cond = getLlvmVal(i.cond);
-  auto* cmp = G.builder->CreateFCmpOGT(cond, llvm::ConstantFP::get(G.ctx, llvm::APFloat(0.0)));
+  auto* cmp = G.builder->CreateFCmpOGT(cond, G.getConstFloat(0.0));
   auto* endbb = llvm::BasicBlock::Create(G.ctx, i.name + "_end", G.curfunc);
 
   auto* thenbb = llvm::BasicBlock::Create(G.ctx, i.name + "_then", G.curfunc, endbb);
@@ -43,12 +43,19 @@ struct CodeGenVisitor {
   llvm::Value* getLlvmVal(mir::valueptr mirval);
   llvm::Value* getLlvmValForFcallArgs(mir::valueptr mirval);
   std::vector<llvm::Value*> makeFcallArgs(llvm::Type* ft,std::list<mir::valueptr>const& args);
+  // converts floating point arguments and result which differ from the callee in precision.
+  llvm::Value* createCall(llvm::Function* fun, std::vector<llvm::Value*> args,
+                          std::string const& name);
+  llvm::Value* createCall(llvm::FunctionType* ft, llvm::Value* fun, std::vector<llvm::Value*> args,
+                          std::string const& name);
 
   std::unordered_map<mir::valueptr, llvm::Value*> mir_to_llvm;
 
   std::unordered_map<mir::valueptr, llvm::Value*> mirfv_to_llvm;
   std::unordered_map<mir::valueptr, llvm::Value*> memobj_to_llvm;
   std::queue<llvm::Value*> memobjqueue;
+  // distance between the state variables of filters laid out in banks, 1 if not in the map.
+  std::unordered_map<llvm::Value*, int64_t> memobj_strides;
   std::unordered_map<mir::valueptr, llvm::Value*> fun_to_selfval;
   std::unordered_map<mir::valueptr, llvm::Value*> fun_to_selfptr;
 
@@ -58,6 +65,8 @@ struct CodeGenVisitor {
   const funobjmap* funobj_map;
   bool isglobal;
   bool context_hasself;
+  // whether random in the current function has a state in the memory object.
+  bool context_random_has_state;
   minst::Function* recursivefn_ptr;
   llvm::Value* getFunForFcall(minst::Fcall const& i);
   llvm::Value* getDirFun(minst::Fcall const& i);
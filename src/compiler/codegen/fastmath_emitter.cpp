@@ -0,0 +1,148 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/codegen/fastmath_emitter.hpp"
+#include "compiler/codegen/llvm_header.hpp"
+#include "compiler/fast_math.hpp"
+#include "llvm/IR/Intrinsics.h"
+
+namespace mimium {
+namespace {
+namespace fm = fastmath;
+
+// IR version of the templates in fast_math.hpp. Keep both in sync.
+class Emitter {
+ public:
+  Emitter(llvm::IRBuilder<>& b, llvm::Module& m, llvm::Type* ty)
+      : b(b),
+        m(m),
+        ty(ty),
+        isfloat(ty->isFloatTy()),
+        intty(isfloat ? b.getInt32Ty() : b.getInt64Ty()),
+        c(isfloat ? fm::constants_f32 : fm::constants_f64) {}
+
+  llvm::Value* num(double v) { return llvm::ConstantFP::get(ty, v); }
+  llvm::Value* integer(int64_t v) { return llvm::ConstantInt::get(intty, v); }
+  llvm::Value* callIntrinsic(llvm::Intrinsic::ID id, std::vector<llvm::Value*> args) {
+    return b.CreateCall(llvm::Intrinsic::getDeclaration(&m, id, {ty}), args);
+  }
+  llvm::Value* floor(llvm::Value* v) { return callIntrinsic(llvm::Intrinsic::floor, {v}); }
+  llvm::Value* clamp(llvm::Value* v, double lo, double hi) {
+    auto* res = callIntrinsic(llvm::Intrinsic::maxnum, {v, num(lo)});
+    return callIntrinsic(llvm::Intrinsic::minnum, {res, num(hi)});
+  }
+  template <size_t N>
+  llvm::Value* horner(std::array<double, N> const& coeffs, llvm::Value* x) {
+    llvm::Value* res = num(coeffs[N - 1]);
+    for (size_t i = N - 1; i > 0; i--) {
+      res = b.CreateFAdd(b.CreateFMul(res, x), num(coeffs[i - 1]));
+    }
+    return res;
+  }
+  llvm::Value* reducePi(llvm::Value* x, llvm::Value* k) {
+    auto* r = b.CreateFSub(x, b.CreateFMul(k, num(c.pi_hi)));
+    r = b.CreateFSub(r, b.CreateFMul(k, num(c.pi_mid)));
+    return b.CreateFSub(r, b.CreateFMul(k, num(c.pi_lo)));
+  }
+  llvm::Value* getParitySign(llvm::Value* n) {
+    auto* parity = b.CreateFSub(n, b.CreateFMul(num(2.0), floor(b.CreateFMul(n, num(0.5)))));
+    return b.CreateFSub(num(1.0), b.CreateFMul(num(2.0), parity));
+  }
+  llvm::Value* sinPoly(llvm::Value* r) {
+    auto* r2 = b.CreateFMul(r, r);
+    return b.CreateFMul(r,
+                        isfloat ? horner(fm::sin_coeffs_f32, r2) : horner(fm::sin_coeffs_f64, r2));
+  }
+
+  llvm::Value* sin(llvm::Value* x) {
+    auto* n = floor(b.CreateFAdd(b.CreateFMul(x, num(fm::inv_pi)), num(0.5)));
+    return b.CreateFMul(getParitySign(n), sinPoly(reducePi(x, n)));
+  }
+  llvm::Value* cos(llvm::Value* x) {
+    auto* n = floor(b.CreateFMul(x, num(fm::inv_pi)));
+    auto* r = reducePi(x, b.CreateFAdd(n, num(0.5)));
+    return b.CreateFNeg(b.CreateFMul(getParitySign(n), sinPoly(r)));
+  }
+  llvm::Value* exp(llvm::Value* x) {
+    x = clamp(x, c.exp_min, c.exp_max);
+    auto* k = floor(b.CreateFAdd(b.CreateFMul(x, num(fm::log2e)), num(0.5)));
+    auto* r = b.CreateFSub(x, b.CreateFMul(k, num(c.ln2_hi)));
+    r = b.CreateFSub(r, b.CreateFMul(k, num(c.ln2_lo)));
+    auto* biased = b.CreateAdd(b.CreateFPToSI(k, intty), integer(c.exponent_bias));
+    auto* scale = b.CreateBitCast(b.CreateShl(biased, c.mantissa_bits), ty);
+    auto* poly = isfloat ? horner(fm::exp_coeffs_f32, r) : horner(fm::exp_coeffs_f64, r);
+    return b.CreateFMul(poly, scale);
+  }
+  llvm::Value* log(llvm::Value* x) {
+    auto* bits = b.CreateBitCast(x, intty);
+    auto* exponent = b.CreateSub(b.CreateAShr(bits, c.mantissa_bits), integer(c.exponent_bias));
+    llvm::Value* e = b.CreateSIToFP(exponent, ty);
+    auto* mantissa = b.CreateAnd(bits, integer((int64_t(1) << c.mantissa_bits) - 1));
+    auto* one_exponent = integer(int64_t(c.exponent_bias) << c.mantissa_bits);
+    llvm::Value* m = b.CreateBitCast(b.CreateOr(mantissa, one_exponent), ty);
+    auto* large = b.CreateFCmpOGT(m, num(fm::sqrt2));
+    m = b.CreateSelect(large, b.CreateFMul(m, num(0.5)), m);
+    e = b.CreateSelect(large, b.CreateFAdd(e, num(1.0)), e);
+    auto* t = b.CreateFDiv(b.CreateFSub(m, num(1.0)), b.CreateFAdd(m, num(1.0)));
+    auto* t2 = b.CreateFMul(t, t);
+    auto* poly = b.CreateFMul(
+        t, isfloat ? horner(fm::log_coeffs_f32, t2) : horner(fm::log_coeffs_f64, t2));
+    auto* low = b.CreateFAdd(poly, b.CreateFMul(e, num(c.ln2_lo)));
+    llvm::Value* res = b.CreateFAdd(b.CreateFMul(e, num(c.ln2_hi)), low);
+    auto inf = std::numeric_limits<double>::infinity();
+    res = b.CreateSelect(b.CreateFCmpULE(x, num(0.0)),
+                         num(std::numeric_limits<double>::quiet_NaN()), res);
+    res = b.CreateSelect(b.CreateFCmpOEQ(x, num(0.0)), num(-inf), res);
+    return b.CreateSelect(b.CreateFCmpOEQ(x, num(inf)), num(inf), res);
+  }
+  llvm::Value* pow(llvm::Value* x, llvm::Value* y) {
+    llvm::Value* res = exp(b.CreateFMul(y, log(x)));
+    auto* atzero = b.CreateSelect(b.CreateFCmpOGT(y, num(0.0)), num(0.0),
+                                  num(std::numeric_limits<double>::infinity()));
+    res = b.CreateSelect(b.CreateFCmpOEQ(x, num(0.0)), atzero, res);
+    return b.CreateSelect(b.CreateFCmpOEQ(y, num(0.0)), num(1.0), res);
+  }
+  llvm::Value* tanh(llvm::Value* x) {
+    x = clamp(x, -fm::tanh_max, fm::tanh_max);
+    auto* e2x = exp(b.CreateFMul(num(2.0), x));
+    return b.CreateFSub(num(1.0), b.CreateFDiv(num(2.0), b.CreateFAdd(e2x, num(1.0))));
+  }
+
+ private:
+  llvm::IRBuilder<>& b;  // NOLINT
+  llvm::Module& m;       // NOLINT
+  llvm::Type* ty;
+  bool isfloat;
+  llvm::Type* intty;
+  const fm::Constants& c;
+};
+}  // namespace
+
+llvm::Function* FastMathEmitter::getFunction(std::string const& name, llvm::Type* floattype) {
+  assert(fastmath::hasApproximation(name));
+  auto fname = "mimium.fast." + name + (floattype->isFloatTy() ? ".f32" : ".f64");
+  if (auto* f = module.getFunction(fname)) { return f; }
+  const bool isbinary = name == "pow";
+  std::vector<llvm::Type*> argtypes(isbinary ? 2 : 1, floattype);
+  auto* f = llvm::Function::Create(llvm::FunctionType::get(floattype, argtypes, false),
+                                   llvm::Function::InternalLinkage, fname, module);
+  f->addFnAttr(llvm::Attribute::AlwaysInline);
+  f->addFnAttr(llvm::Attribute::ReadNone);
+  f->addFnAttr(llvm::Attribute::NoUnwind);
+  llvm::IRBuilder<> builder(llvm::BasicBlock::Create(module.getContext(), "entry", f));
+  Emitter e(builder, module, floattype);
+  auto* x = f->getArg(0);
+  llvm::Value* res = nullptr;
+  if (name == "sin") { res = e.sin(x); }
+  if (name == "cos") { res = e.cos(x); }
+  if (name == "tan") { res = builder.CreateFDiv(e.sin(x), e.cos(x)); }
+  if (name == "exp") { res = e.exp(x); }
+  if (name == "log") { res = e.log(x); }
+  if (name == "pow") { res = e.pow(x, f->getArg(1)); }
+  if (name == "tanh") { res = e.tanh(x); }
+  builder.CreateRet(res);
+  return f;
+}
+
+}  // namespace mimium
@@ -0,0 +1,24 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <string>
+namespace llvm {
+class Function;
+class Module;
+class Type;
+}  // namespace llvm
+
+namespace mimium {
+// Emits the approximations in compiler/fast_math.hpp as IR functions with internal linkage,
+// which are always inlined so that the optimizer sees plain arithmetic instead of libm calls.
+struct FastMathEmitter {
+  explicit FastMathEmitter(llvm::Module& m) : module(m) {}
+  // returns the approximation of a builtin such as "sin" for double or float.
+  llvm::Function* getFunction(std::string const& name, llvm::Type* floattype);
+
+ private:
+  llvm::Module& module;
+};
+}  // namespace mimium
@@ -0,0 +1,84 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/codegen/filter_emitter.hpp"
+#include <vector>
+#include "compiler/codegen/llvm_header.hpp"
+#include "compiler/filters.hpp"
+
+namespace mimium {
+
+// IR versions of the templates in filters.hpp, with the operations in the same order.
+llvm::Function* FilterEmitter::getFunction(std::string const& name, llvm::Type* floattype) {
+  const bool is32 = floattype->isFloatTy();
+  auto fname = "mimium." + name + (is32 ? ".f32" : ".f64");
+  if (auto* f = module.getFunction(fname)) { return f; }
+  auto& ctx = module.getContext();
+  const auto kind = filters::getKind(name);
+  assert(kind != filters::Kind::None);
+  auto* i64ty = llvm::Type::getInt64Ty(ctx);
+  std::vector<llvm::Type*> argtypes(filters::getNumArgs(kind), floattype);
+  argtypes.emplace_back(llvm::PointerType::get(floattype, 0));
+  argtypes.emplace_back(i64ty);
+  auto* ft = llvm::FunctionType::get(floattype, argtypes, false);
+  auto* f = llvm::Function::Create(ft, llvm::Function::InternalLinkage, fname, module);
+  f->addFnAttr(llvm::Attribute::AlwaysInline);
+  f->addFnAttr(llvm::Attribute::NoUnwind);
+
+  llvm::IRBuilder<> b(llvm::BasicBlock::Create(ctx, "entry", f));
+  auto arg = [&](unsigned n) { return f->getArg(n); };
+  auto c = [&](double v) { return llvm::ConstantFP::get(floattype, v); };
+  const unsigned nargs = filters::getNumArgs(kind);
+  auto* s0ptr = arg(nargs);
+  auto* s0 = b.CreateLoad(floattype, s0ptr, "s0");
+  auto* in = arg(0);
+  switch (kind) {
+    case filters::Kind::Biquad: {
+      auto* s1ptr = b.CreateInBoundsGEP(floattype, s0ptr, arg(nargs + 1), "s1ptr");
+      auto* s1 = b.CreateLoad(floattype, s1ptr, "s1");
+      auto* out = b.CreateFAdd(b.CreateFMul(arg(1), in), s0, "out");
+      auto* ns0 = b.CreateFAdd(b.CreateFSub(b.CreateFMul(arg(2), in), b.CreateFMul(arg(4), out)),
+                               s1, "ns0");
+      b.CreateStore(ns0, s0ptr);
+      auto* ns1 = b.CreateFSub(b.CreateFMul(arg(3), in), b.CreateFMul(arg(5), out), "ns1");
+      b.CreateStore(ns1, s1ptr);
+      b.CreateRet(out);
+      break;
+    }
+    case filters::Kind::Svf: {
+      auto* g = arg(1);
+      auto* k = arg(2);
+      auto* s1ptr = b.CreateInBoundsGEP(floattype, s0ptr, arg(nargs + 1), "s1ptr");
+      auto* s1 = b.CreateLoad(floattype, s1ptr, "s1");
+      auto* a1 = b.CreateFDiv(c(1.0), b.CreateFAdd(c(1.0), b.CreateFMul(g, b.CreateFAdd(g, k))),
+                              "a1");
+      auto* a2 = b.CreateFMul(g, a1, "a2");
+      auto* a3 = b.CreateFMul(g, a2, "a3");
+      auto* v3 = b.CreateFSub(in, s1, "v3");
+      auto* v1 = b.CreateFAdd(b.CreateFMul(a1, s0), b.CreateFMul(a2, v3), "v1");
+      auto* v2 =
+          b.CreateFAdd(b.CreateFAdd(s1, b.CreateFMul(a2, s0)), b.CreateFMul(a3, v3), "v2");
+      b.CreateStore(b.CreateFSub(b.CreateFMul(c(2.0), v1), s0), s0ptr);
+      b.CreateStore(b.CreateFSub(b.CreateFMul(c(2.0), v2), s1), s1ptr);
+      switch (filters::getSvfMode(name)) {
+        case filters::SvfMode::Low: b.CreateRet(v2); break;
+        case filters::SvfMode::Band: b.CreateRet(v1); break;
+        case filters::SvfMode::High:
+          b.CreateRet(b.CreateFSub(b.CreateFSub(in, b.CreateFMul(k, v1)), v2, "hp"));
+          break;
+      }
+      break;
+    }
+    case filters::Kind::OnePole: {
+      auto* out = b.CreateFAdd(in, b.CreateFMul(arg(1), b.CreateFSub(s0, in)), "out");
+      b.CreateStore(out, s0ptr);
+      b.CreateRet(out);
+      break;
+    }
+    case filters::Kind::None: b.CreateRet(in); break;
+  }
+  return f;
+}
+
+}  // namespace mimium
@@ -0,0 +1,24 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <string>
+namespace llvm {
+class Function;
+class Module;
+class Type;
+}  // namespace llvm
+
+namespace mimium {
+// Emits the filters in compiler/filters.hpp as always inlined IR functions, which take the
+// pointer to the first state variable and the stride between the state variables in elements.
+struct FilterEmitter {
+  explicit FilterEmitter(llvm::Module& m) : module(m) {}
+  // returns the filter of a builtin such as "biquad" for double or float.
+  llvm::Function* getFunction(std::string const& name, llvm::Type* floattype);
+
+ private:
+  llvm::Module& module;
+};
+}  // namespace mimium
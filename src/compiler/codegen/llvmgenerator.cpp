@@ -6,8 +6,13 @@
 #include "compiler/collect_memoryobjs.hpp"
 
 #include "compiler/codegen/llvm_header.hpp"
+#include "compiler/codegen/fastmath_emitter.hpp"
+#include "compiler/codegen/filter_emitter.hpp"
+#include "compiler/codegen/prng_emitter.hpp"
 #include "compiler/codegen/typeconverter.hpp"
+#include "compiler/fast_math.hpp"
 #include "compiler/ffi.hpp"
+#include "compiler/filters.hpp"
 
 namespace mimium {
 
@@ -19,11 +24,19 @@ LLVMGenerator::LLVMGenerator(llvm::LLVMContext& ctx)
       mainentry(nullptr),
       currentblock(nullptr),
       typeconverter(std::make_unique<TypeConverter>(*builder, *module)),
+      fastmathemitter(std::make_unique<FastMathEmitter>(*module)),
+      prngemitter(std::make_unique<PrngEmitter>(*module)),
+      filteremitter(std::make_unique<FilterEmitter>(*module)),
       runtime_fun_names(
           {{"mimium_getnow", llvm::FunctionType::get(getDoubleTy(), {geti8PtrTy()}, false)},
            {"access_array_lin_interp",
             llvm::FunctionType::get(
                 getDoubleTy(), {llvm::PointerType::get(getDoubleTy(), 0), getDoubleTy()}, false)},
+           {"access_array_lin_interp_f32",
+            llvm::FunctionType::get(builder->getFloatTy(),
+                                    {llvm::PointerType::get(builder->getFloatTy(), 0),
+                                     builder->getFloatTy()},
+                                    false)},
            {"mimium_malloc",
             llvm::FunctionType::get(geti8PtrTy(), {geti8PtrTy(), geti64Ty()}, false)}}) {}
 
@@ -43,6 +56,11 @@ void LLVMGenerator::reset(std::string filename) {
   init(filename);
 }
 
+void LLVMGenerator::setFloat32(bool isfloat32) {
+  float32 = isfloat32;
+  typeconverter->floattype = isfloat32 ? builder->getFloatTy() : builder->getDoubleTy();
+}
+
 LLVMGenerator::~LLVMGenerator() { dropAllReferences(); }
 void LLVMGenerator::dropAllReferences() {
   if (module != nullptr) { module->dropAllReferences(); }
@@ -59,6 +77,7 @@ llvm::ArrayType* LLVMGenerator::getArrayType(types::Value const& type) {
 }
 
 llvm::Type* LLVMGenerator::getDoubleTy() { return llvm::Type::getDoubleTy(ctx); }
+llvm::Type* LLVMGenerator::getFloatTy() { return typeconverter->floattype; }
 llvm::PointerType* LLVMGenerator::geti8PtrTy() { return builder->getInt8PtrTy(); }
 llvm::Type* LLVMGenerator::geti64Ty() { return builder->getInt64Ty(); }
 llvm::Value* LLVMGenerator::getConstInt(int v, const int bitsize) {
@@ -67,6 +86,9 @@ llvm::Value* LLVMGenerator::getConstInt(int v, const int bitsize) {
 llvm::Value* LLVMGenerator::getConstDouble(double v) {
   return llvm::ConstantFP::get(builder->getDoubleTy(), v);
 }
+llvm::Value* LLVMGenerator::getConstFloat(double v) {
+  return llvm::ConstantFP::get(getFloatTy(), v);
+}
 
 llvm::Value* LLVMGenerator::getZero(const int bitsize) { return getConstInt(0, bitsize); }
 
@@ -85,16 +107,45 @@ void LLVMGenerator::switchToMainFun() {
   curfunc = mainentry->getParent();
 }
 llvm::Function* LLVMGenerator::getForeignFunction(const std::string& name) {
-  const auto& [type, targetname] = LLVMBuiltin::ftable.find(name)->second;
+  if (name == "random") { return getRandomFunction(true); }
+  if (filters::getKind(name) != filters::Kind::None) { return getFilterFunction(name); }
+  auto approximated = fastmath::getApproximatedName(name);
+  if (approximated.empty() && fastmath_enabled && fastmath::hasApproximation(name)) {
+    approximated = name;
+  }
+  if (!approximated.empty()) { return fastmathemitter->getFunction(approximated, getFloatTy()); }
+  const auto& [type, targetname_f64, targetname_f32] = LLVMBuiltin::ftable.find(name)->second;
+  const bool use_f32 = float32 && !targetname_f32.empty();
+  const auto& targetname = use_f32 ? targetname_f32 : targetname_f64;
   auto ftype = rv::get<types::Function>(type);
-  if (name == "delay") { ftype.arg_types.emplace_back(types::Ref{types::getDelayStruct()}); }
-  if (name == "mem") { ftype.arg_types.emplace_back(types::Ref{types::Float{}}); }
+  if (auto memobjtype = LLVMBuiltin::getMemobjType(name)) {
+    ftype.arg_types.emplace_back(types::Ref{memobjtype.value()});
+  }
+  if (LLVMBuiltin::needsRuntime(name)) {
+    ftype.arg_types.insert(ftype.arg_types.begin(), types::Ref{types::Void{}});
+  }
   if (!types::isPrimitive(ftype.ret_type)) {
     // for loadwavfile
     ftype.ret_type = types::Ref{ftype.ret_type};
   }
+  if (float32 && !use_f32) {
+    // builtins only in double. CodeGenVisitor converts the arguments and the result.
+    typeconverter->floattype = getDoubleTy();
+    auto* fntype = getType(ftype);
+    typeconverter->floattype = builder->getFloatTy();
+    return getFunction(targetname, fntype);
+  }
   return getFunction(targetname, getType(ftype));
 }
+llvm::Function* LLVMGenerator::getRandomFunction(bool hasstate) {
+  if (hasstate) { return prngemitter->getFunction(getFloatTy()); }
+  const auto& info = LLVMBuiltin::ftable.at("random");
+  auto name = float32 ? info.target_fnname_f32 : info.target_fnname;
+  return getFunction(name, llvm::FunctionType::get(getFloatTy(), false));
+}
+llvm::Function* LLVMGenerator::getFilterFunction(const std::string& name) {
+  return filteremitter->getFunction(name, getFloatTy());
+}
 llvm::Function* LLVMGenerator::getRuntimeFunction(const std::string& name) {
   const auto& type = runtime_fun_names.at(name);
   return getFunction(name, type);
@@ -150,7 +201,7 @@ void LLVMGenerator::createTaskRegister(bool isclosure = false) {
       builder->getInt8PtrTy(),  // address to runtime instance
       builder->getDoubleTy(),   // time
       builder->getInt8PtrTy(),  // address to function
-      builder->getDoubleTy()    // argument(single)
+      getFloatTy()              // argument(single)
   };
   std::string name = "addTask";
   if (isclosure) {
@@ -158,6 +209,7 @@ void LLVMGenerator::createTaskRegister(bool isclosure = false) {
         builder->getInt8PtrTy());  // address to closure args(instead of void* type)
     name = "addTask_cls";
   }
+  if (float32) { name += "_f32"; }
   auto* fntype = llvm::FunctionType::get(builder->getVoidTy(), argtypes, false);
   auto addtask = module->getOrInsertFunction(name, fntype);
   auto* addtaskfun = llvm::cast<llvm::Function>(addtask.getCallee());
@@ -192,8 +244,12 @@ std::optional<int> LLVMGenerator::getDspFnChannelNumForType(types::Value const&
 }
 
 void LLVMGenerator::checkDspFunctionType(minst::Function const& i) {
-  assert(i.name == "dsp");
+  assert(isDspLikeFunction(i.name));
   assert(rv::holds_alternative<types::Function>(i.type));
+  if (i.name == "spectral") {
+    checkSpectralFunctionType(i);
+    return;
+  }
   auto rettype = rv::get<types::Function>(i.type).ret_type;
   auto argtype = rv::get<types::Function>(i.type).arg_types;
 
@@ -213,16 +269,36 @@ void LLVMGenerator::checkDspFunctionType(minst::Function const& i) {
       inchs = getDspFnChannelNumForType(argtype.at(inputargidx));
     } break;
     default:
-      throw std::runtime_error("Number of Arguments for dsp function must be 0 or 1.");
+      throw std::runtime_error("Number of Arguments for " + i.name +
+                               " function must be 0 or 1.");
       break;
   }
-  if (!inchs) { throw std::runtime_error("Arguments for dsp function must be 1 Tuple of Floats"); }
+  if (!inchs) {
+    throw std::runtime_error("Arguments for " + i.name + " function must be 1 Tuple of Floats");
+  }
   if (!outchs) {
+    throw std::runtime_error("Return type for " + i.name +
+                             " function must be either of Void or Tuple of Floats");
+  }
+  auto& info = getDspLikeFnInfo(i.name);
+  info.in_numchs = inchs.value();
+  info.out_numchs = outchs.value();
+}
+
+void LLVMGenerator::checkSpectralFunctionType(minst::Function const& i) {
+  auto isarray = [](types::Value const& t) {
+    if (!rv::holds_alternative<types::Pointer>(t)) { return false; }
+    const auto& elem = rv::get<types::Pointer>(t).val;
+    return rv::holds_alternative<types::Array>(elem) &&
+           std::holds_alternative<types::Float>(rv::get<types::Array>(elem).elem_type);
+  };
+  const auto& ftype = rv::get<types::Function>(i.type);
+  if (i.args.ret_ptr || !std::holds_alternative<types::Void>(ftype.ret_type) ||
+      ftype.arg_types.size() != 2 || !isarray(ftype.arg_types[0]) ||
+      !isarray(ftype.arg_types[1])) {
     throw std::runtime_error(
-        "Return type for dsp function must be either of Void or Tuple of Floats");
+        "spectral function must take 2 arrays of magnitudes and phases and return nothing");
   }
-  runtime_dspfninfo.in_numchs = inchs.value();
-  runtime_dspfninfo.out_numchs = outchs.value();
 }
 
 void LLVMGenerator::createRuntimeSetDspFn(llvm::Type* memobjtype) {
@@ -261,6 +337,129 @@ void LLVMGenerator::createRuntimeSetDspFn(llvm::Type* memobjtype) {
                                inchs_const, outchs_const});
 }
 
+void LLVMGenerator::createRuntimeSetVoiceFn(llvm::Type* memobjtype) {
+  auto* voicefn = module->getFunction("voice");
+  if (voicefn == nullptr) { return; }
+  auto* voidptrtype = builder->getInt8PtrTy();
+  auto* int32ty = builder->getInt32Ty();
+  auto* clsaddress = (runtime_voicefninfo.capptr != nullptr)
+                         ? builder->CreateBitCast(runtime_voicefninfo.capptr, voidptrtype)
+                         : llvm::ConstantPointerNull::get(voidptrtype);
+  // memory objects are allocated for each voice by runtime
+  auto memobjsize = memobjtype != nullptr ? module->getDataLayout().getTypeAllocSize(memobjtype)
+                                          : 0;
+  auto setvoice = module->getOrInsertFunction(
+      "setVoiceParams",
+      llvm::FunctionType::get(builder->getVoidTy(),
+                              {voidptrtype, voidptrtype, voidptrtype, geti64Ty(), int32ty, int32ty},
+                              false));
+  constexpr int bitsize = 32;
+  builder->CreateCall(setvoice, {getRuntimeInstance(), builder->CreateBitCast(voicefn, voidptrtype),
+                                 clsaddress, getConstInt(memobjsize),
+                                 getConstInt(runtime_voicefninfo.in_numchs, bitsize),
+                                 getConstInt(runtime_voicefninfo.out_numchs, bitsize)});
+}
+
+void LLVMGenerator::createDoubleFrameEntry(std::string const& name) {
+  auto* inner = module->getFunction(name);
+  if (inner == nullptr) { return; }
+  const auto& info = getDspLikeFnInfo(name);
+  inner->setName(name + ".f32");
+  inner->setLinkage(llvm::Function::InternalLinkage);
+  auto* innertype = inner->getFunctionType();
+  auto* dptrtype = llvm::PointerType::get(getDoubleTy(), 0);
+  std::vector<llvm::Type*> argtypes(innertype->param_begin(), innertype->param_end());
+  if (info.out_arg >= 0) { argtypes[info.out_arg] = dptrtype; }
+  if (info.in_arg >= 0) { argtypes[info.in_arg] = dptrtype; }
+  auto* entry =
+      llvm::Function::Create(llvm::FunctionType::get(innertype->getReturnType(), argtypes, false),
+                             llvm::Function::ExternalLinkage, name, *module);
+  auto* savedblock = builder->GetInsertBlock();
+  setBB(llvm::BasicBlock::Create(ctx, "entry", entry));
+  std::vector<llvm::Value*> args;
+  for (auto& a : entry->args()) { args.emplace_back(&a); }
+  auto getFrameType = [&](int idx) {
+    return llvm::cast<llvm::PointerType>(innertype->getParamType(idx))->getElementType();
+  };
+  if (info.in_arg >= 0) {
+    auto* frame = builder->CreateAlloca(getFrameType(info.in_arg), nullptr, "input.f32");
+    for (int ch = 0; ch < info.in_numchs; ch++) {
+      auto* v = builder->CreateLoad(builder->CreateConstGEP1_32(args[info.in_arg], ch));
+      builder->CreateStore(builder->CreateFPTrunc(v, getFloatTy()),
+                           builder->CreateStructGEP(frame, ch));
+    }
+    args[info.in_arg] = frame;
+  }
+  llvm::Value* outframe = nullptr;
+  if (info.out_arg >= 0) {
+    outframe = builder->CreateAlloca(getFrameType(info.out_arg), nullptr, "output.f32");
+    args[info.out_arg] = outframe;
+  }
+  auto* res = builder->CreateCall(inner, args);
+  if (outframe != nullptr) {
+    auto* out = entry->getArg(info.out_arg);
+    for (int ch = 0; ch < info.out_numchs; ch++) {
+      auto* v = builder->CreateLoad(builder->CreateStructGEP(outframe, ch));
+      builder->CreateStore(builder->CreateFPExt(v, getDoubleTy()),
+                           builder->CreateConstGEP1_32(out, ch));
+    }
+  }
+  if (innertype->getReturnType()->isVoidTy()) {
+    builder->CreateRetVoid();
+  } else {
+    builder->CreateRet(res);
+  }
+  setBB(savedblock);
+}
+
+void LLVMGenerator::createRuntimeSetSpectralFn(llvm::Type* memobjtype) {
+  auto* spectralfn = module->getFunction("spectral");
+  if (spectralfn == nullptr) { return; }
+  auto* voidptrtype = builder->getInt8PtrTy();
+  auto* int32ty = builder->getInt32Ty();
+  auto* clsaddress = (runtime_spectralfninfo.capptr != nullptr)
+                         ? builder->CreateBitCast(runtime_spectralfninfo.capptr, voidptrtype)
+                         : llvm::ConstantPointerNull::get(voidptrtype);
+  // memory objects are allocated for each channel by runtime
+  auto memobjsize = memobjtype != nullptr ? module->getDataLayout().getTypeAllocSize(memobjtype)
+                                          : 0;
+  auto setspectral = module->getOrInsertFunction(
+      "setSpectralParams",
+      llvm::FunctionType::get(builder->getVoidTy(),
+                              {voidptrtype, voidptrtype, voidptrtype, geti64Ty(), int32ty}, false));
+  constexpr int bitsize = 32;
+  builder->CreateCall(setspectral,
+                      {getRuntimeInstance(), builder->CreateBitCast(spectralfn, voidptrtype),
+                       clsaddress, getConstInt(memobjsize),
+                       getConstInt(static_cast<int>(float32), bitsize)});
+}
+
+void LLVMGenerator::createRuntimeSetMidiInFn() {
+  auto* midiinfn = module->getFunction("midiin");
+  if (midiinfn == nullptr) { return; }
+  // called like a task, so it can not have memory objects.
+  const unsigned numparams = runtime_midiin_capptr != nullptr ? 2 : 1;
+  auto* ft = midiinfn->getFunctionType();
+  if (!ft->getReturnType()->isVoidTy() || ft->getNumParams() != numparams ||
+      ft->getParamType(0) != getFloatTy()) {
+    throw std::runtime_error(
+        "midiin function must take a Float of MIDI message, return nothing and have no states");
+  }
+  auto* voidptrtype = builder->getInt8PtrTy();
+  auto* int32ty = builder->getInt32Ty();
+  auto* clsaddress = (runtime_midiin_capptr != nullptr)
+                         ? builder->CreateBitCast(runtime_midiin_capptr, voidptrtype)
+                         : llvm::ConstantPointerNull::get(voidptrtype);
+  auto setmidiin = module->getOrInsertFunction(
+      "setMidiInHandler",
+      llvm::FunctionType::get(builder->getVoidTy(),
+                              {voidptrtype, voidptrtype, voidptrtype, int32ty}, false));
+  constexpr int bitsize = 32;
+  builder->CreateCall(setmidiin,
+                      {getRuntimeInstance(), builder->CreateBitCast(midiinfn, voidptrtype),
+                       clsaddress, getConstInt(static_cast<int>(float32), bitsize)});
+}
+
 llvm::Value* LLVMGenerator::getRuntimeInstance() {
   auto* var = module->getNamedGlobal("global_runtime");
   assert(var != nullptr);
@@ -289,15 +488,31 @@ void LLVMGenerator::generateCode(mir::blockptr mir, const funobjmap* funobjs) {
   codegenvisitor = std::make_shared<CodeGenVisitor>(*this, funobjs);
   preprocess();
   llvm::Type* memobjtype = nullptr;
+  llvm::Type* voicememobjtype = nullptr;
+  llvm::Type* spectralmemobjtype = nullptr;
   for (auto& inst : mir->instructions) {
     visitInstructions(inst, true);
-    if (mir::getName(*inst) == "dsp") {
+    const auto name = mir::getName(*inst);
+    if (isDspLikeFunction(name)) {
       auto&& iter = funobjs->find(inst);
-      if (iter != funobjs->end()) { memobjtype = getType(iter->second->objtype); }
+      if (iter != funobjs->end()) {
+        auto& target = name == "dsp"     ? memobjtype
+                       : name == "voice" ? voicememobjtype
+                                         : spectralmemobjtype;
+        target = getType(iter->second->objtype);
+      }
     }
   }
+  if (float32) {
+    createDoubleFrameEntry("dsp");
+    createDoubleFrameEntry("voice");
+  }
   // create a call for setDspParams regardless dsp fn is present
   createRuntimeSetDspFn(memobjtype);
+  createRuntimeSetVoiceFn(voicememobjtype);
+  // after dsp and voice, as the number of channels is decided by them.
+  createRuntimeSetSpectralFn(spectralmemobjtype);
+  createRuntimeSetMidiInFn();
   // main always return null for now;
   builder->CreateRet(llvm::ConstantPointerNull::get(builder->getInt8PtrTy()));
 }
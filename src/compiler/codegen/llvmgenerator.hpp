@@ -5,6 +5,7 @@
 #pragma once
 
 #include "basic/mir.hpp"
+#include "compiler/ffi.hpp"
 namespace llvm {
 class LLVMContext;
 class Module;
@@ -29,6 +30,9 @@ class IRBuilderPrivate;
 struct LLVMBuiltin;
 struct CodeGenVisitor;
 struct TypeConverter;
+struct FastMathEmitter;
+struct PrngEmitter;
+struct FilterEmitter;
 
 namespace minst = mir::instruction;
 class MIMIUM_DLL_PUBLIC LLVMGenerator {
@@ -44,6 +48,12 @@ class MIMIUM_DLL_PUBLIC LLVMGenerator {
   void init(std::string filename);
   void setDataLayout(const llvm::DataLayout& dl);
   void reset(std::string filename);
+  // lowers Float to single precision float instead of double. The entries of dsp and voice
+  // functions still exchange frames in double with runtime.
+  void setFloat32(bool isfloat32);
+  [[nodiscard]] bool isFloat32() const { return float32; }
+  // replaces math builtins such as sin with the inline approximations in fast_math.hpp.
+  void setFastMath(bool isfastmath) { fastmath_enabled = isfastmath; }
 
   void outputToStream(llvm::raw_ostream& ostream);
   static void dumpvar(llvm::Value* v);
@@ -58,6 +68,11 @@ class MIMIUM_DLL_PUBLIC LLVMGenerator {
   llvm::BasicBlock* currentblock;
   std::unique_ptr<TypeConverter> typeconverter;
   std::shared_ptr<CodeGenVisitor> codegenvisitor;
+  std::unique_ptr<FastMathEmitter> fastmathemitter;
+  std::unique_ptr<PrngEmitter> prngemitter;
+  std::unique_ptr<FilterEmitter> filteremitter;
+  bool float32 = false;
+  bool fastmath_enabled = false;
 
   llvm::Type* getType(types::Value const& type);
   // Used for getting Arraytype which is not pointer of elementtype
@@ -66,23 +81,48 @@ class MIMIUM_DLL_PUBLIC LLVMGenerator {
   llvm::Type* getClosureToFunType(types::Value& type);
   const std::unordered_map<std::string, llvm::Type*> runtime_fun_names;
 
-  struct {
+  struct DspFnInfo {
    public:
     llvm::Value* capptr = nullptr;
     llvm::Value* memobjptr = nullptr;
     int in_numchs = 0;
     int out_numchs = 0;
-  } runtime_dspfninfo;
+    // indices of the parameters for output and input frames, or -1 if absent.
+    int out_arg = -1;
+    int in_arg = -1;
+  };
+  DspFnInfo runtime_dspfninfo;
+  // voice function has the same signature as dsp and is instantiated polyphonically by runtime.
+  DspFnInfo runtime_voicefninfo;
+  // spectral function takes arrays of magnitudes and phases, called on each STFT frame by runtime.
+  DspFnInfo runtime_spectralfninfo;
+  // capture of midiin function, which runtime calls with each incoming MIDI message as a task.
+  llvm::Value* runtime_midiin_capptr = nullptr;
+  static bool isDspLikeFunction(std::string const& name) { return RuntimeEntry::isDspLike(name); }
+  DspFnInfo& getDspLikeFnInfo(std::string const& name) {
+    if (name == "spectral") { return runtime_spectralfninfo; }
+    return name == "voice" ? runtime_voicefninfo : runtime_dspfninfo;
+  }
 
   void switchToMainFun();
   void preprocess();
   llvm::Function* getForeignFunction(const std::string& name);
+  // inline generator with the state in the memory object, or the one shared in the process.
+  llvm::Function* getRandomFunction(bool hasstate);
+  // inline filter such as biquad, which takes the pointer to the states and their stride.
+  llvm::Function* getFilterFunction(const std::string& name);
   llvm::Function* getRuntimeFunction(const std::string& name);
   llvm::Function* getFunction(const std::string& name, llvm::Type* type);
 
   void createMiscDeclarations();
   void createRuntimeSetDspFn(llvm::Type* memobjtype);
+  void createRuntimeSetVoiceFn(llvm::Type* memobjtype);
+  void createRuntimeSetSpectralFn(llvm::Type* memobjtype);
+  void createRuntimeSetMidiInFn();
+  // renames single precision dsp-like function and puts an entry with double frames on its name.
+  void createDoubleFrameEntry(std::string const& name);
   void checkDspFunctionType(minst::Function const& i);
+  static void checkSpectralFunctionType(minst::Function const& i);
   static std::optional<int> getDspFnChannelNumForType(types::Value const& t);
   void createMainFun();
   void createTaskRegister(bool isclosure);
@@ -94,10 +134,13 @@ class MIMIUM_DLL_PUBLIC LLVMGenerator {
   llvm::Value* getRuntimeInstance();
 
   llvm::Type* getDoubleTy();
+  // type of Float, double or float.
+  llvm::Type* getFloatTy();
   llvm::PointerType* geti8PtrTy();
   llvm::Type* geti64Ty();
   llvm::Value* getConstInt(int v, int bitsize = 64);
   llvm::Value* getConstDouble(double v);
+  llvm::Value* getConstFloat(double v);
   llvm::Value* getZero(int bitsize = 64);
 };
 
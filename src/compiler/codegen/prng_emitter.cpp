@@ -0,0 +1,76 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/codegen/prng_emitter.hpp"
+#include "compiler/codegen/llvm_header.hpp"
+#include "compiler/prng.hpp"
+
+namespace mimium {
+namespace {
+// IR version of prng::mix. Keep both in sync.
+llvm::Value* createMix(llvm::IRBuilder<>& b, llvm::Value* z, bool is32) {
+  auto* ty = z->getType();
+  auto xorshift = [&](llvm::Value* v, uint64_t shift) {
+    return b.CreateXor(v, b.CreateLShr(v, llvm::ConstantInt::get(ty, shift)));
+  };
+  auto mul = [&](llvm::Value* v, uint64_t c) {
+    return b.CreateMul(v, llvm::ConstantInt::get(ty, c));
+  };
+  if (is32) {
+    z = mul(xorshift(z, 16), 0x7FEB352DU);
+    z = mul(xorshift(z, 15), 0x846CA68BU);
+    return xorshift(z, 16);
+  }
+  z = mul(xorshift(z, 30), 0xBF58476D1CE4E5B9ULL);
+  z = mul(xorshift(z, 27), 0x94D049BB133111EBULL);
+  return xorshift(z, 31);
+}
+}  // namespace
+
+llvm::Function* PrngEmitter::getFunction(llvm::Type* floattype) {
+  const bool is32 = floattype->isFloatTy();
+  auto fname = std::string("mimium.random") + (is32 ? ".f32" : ".f64");
+  if (auto* f = module.getFunction(fname)) { return f; }
+  auto& ctx = module.getContext();
+  auto* statety = is32 ? llvm::Type::getInt32Ty(ctx) : llvm::Type::getInt64Ty(ctx);
+  auto* i64ty = llvm::Type::getInt64Ty(ctx);
+  auto* ft = llvm::FunctionType::get(floattype, {llvm::PointerType::get(floattype, 0)}, false);
+  auto* f = llvm::Function::Create(ft, llvm::Function::InternalLinkage, fname, module);
+  f->addFnAttr(llvm::Attribute::AlwaysInline);
+  f->addFnAttr(llvm::Attribute::NoUnwind);
+  auto* i8ptrty = llvm::Type::getInt8PtrTy(ctx);
+  auto seedfn = module.getOrInsertFunction("mimium_random_seed", i64ty, i8ptrty);
+
+  auto* entry = llvm::BasicBlock::Create(ctx, "entry", f);
+  auto* seedbb = llvm::BasicBlock::Create(ctx, "seed", f);
+  auto* nextbb = llvm::BasicBlock::Create(ctx, "next", f);
+  llvm::IRBuilder<> b(entry);
+  auto* stateptr = b.CreateBitCast(f->getArg(0), llvm::PointerType::get(statety, 0), "stateptr");
+  auto* state = b.CreateLoad(statety, stateptr, "state");
+  auto* isfirst = b.CreateICmpEQ(state, llvm::ConstantInt::get(statety, 0), "isfirst");
+  b.CreateCondBr(isfirst, seedbb, nextbb);
+  // the first call takes the stream of the address.
+  b.SetInsertPoint(seedbb);
+  auto* address = b.CreateBitCast(f->getArg(0), i8ptrty);
+  auto* seedstate = b.CreateTrunc(b.CreateCall(seedfn, {address}, "seed"), statety);
+  b.CreateBr(nextbb);
+
+  b.SetInsertPoint(nextbb);
+  auto* cur = b.CreatePHI(statety, 2, "cur");
+  cur->addIncoming(state, entry);
+  cur->addIncoming(seedstate, seedbb);
+  const uint64_t increment = is32 ? prng::increment_u32 : prng::increment_u64;
+  auto* newstate = b.CreateAdd(cur, llvm::ConstantInt::get(statety, increment), "newstate");
+  b.CreateStore(newstate, stateptr);
+  auto* z = createMix(b, newstate, is32);
+  const unsigned bits = is32 ? prng::getResultBits<float>() : prng::getResultBits<double>();
+  auto* shift = llvm::ConstantInt::get(statety, statety->getIntegerBitWidth() - bits);
+  auto* significand = b.CreateUIToFP(b.CreateLShr(z, shift), floattype);
+  const double scale = is32 ? prng::getResultScale<float>() : prng::getResultScale<double>();
+  auto* res = b.CreateFMul(significand, llvm::ConstantFP::get(floattype, scale));
+  b.CreateRet(b.CreateFSub(res, llvm::ConstantFP::get(floattype, 1.0)));
+  return f;
+}
+
+}  // namespace mimium
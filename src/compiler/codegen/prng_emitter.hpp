@@ -0,0 +1,22 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+namespace llvm {
+class Function;
+class Module;
+class Type;
+}  // namespace llvm
+
+namespace mimium {
+// Emits the generator of compiler/prng.hpp as an always inlined IR function, which takes the
+// pointer to its state in the memory object.
+struct PrngEmitter {
+  explicit PrngEmitter(llvm::Module& m) : module(m) {}
+  llvm::Function* getFunction(llvm::Type* floattype);
+
+ private:
+  llvm::Module& module;
+};
+}  // namespace mimium
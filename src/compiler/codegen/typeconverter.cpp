@@ -6,6 +6,9 @@
 #include "compiler/codegen/llvm_header.hpp"
 
 namespace mimium {
+TypeConverter::TypeConverter(llvm::IRBuilderBase& b, llvm::Module& m)
+    : builder(b), module(m), tmpname(""), floattype(b.getDoubleTy()) {}
+
 
 llvm::Type* TypeConverter::operator()(types::None const& /*i*/) {
   error();
@@ -16,7 +19,7 @@ llvm::Type* TypeConverter::operator()(types::TypeVar const& /*i*/) {
   return nullptr;
 }
 llvm::Type* TypeConverter::operator()(types::Void const& /*i*/) { return builder.getVoidTy(); }
-llvm::Type* TypeConverter::operator()(types::Float const& /*i*/) { return builder.getDoubleTy(); }
+llvm::Type* TypeConverter::operator()(types::Float const& /*i*/) { return floattype; }
 llvm::Type* TypeConverter::operator()(types::String const& /*i*/) { return builder.getInt8PtrTy(); }
 llvm::Type* TypeConverter::operator()(types::Ref const& i) {
   auto* elemty = std::visit(*this, i.val);
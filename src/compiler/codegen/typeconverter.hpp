@@ -12,11 +12,12 @@ namespace llvm{
 namespace mimium {
 
 struct TypeConverter {
-  explicit TypeConverter(llvm::IRBuilderBase& b, llvm::Module& m)
-      : builder(b), module(m), tmpname(""){};
+  explicit TypeConverter(llvm::IRBuilderBase& b, llvm::Module& m);
   llvm::IRBuilderBase& builder;
   llvm::Module& module;
   std::string tmpname;
+  // type which Float is lowered to, double or float.
+  llvm::Type* floattype;
   std::unordered_map<std::string, llvm::Type*> aliasmap;
   static void error() { throw std::runtime_error("Invalid Type"); }
 
@@ -3,6 +3,8 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "collect_memoryobjs.hpp"
+#include "compiler/ffi.hpp"
+#include "compiler/memobj_layout.hpp"
 namespace mimium {
 
 std::unordered_set<mir::valueptr> MemoryObjsCollector::collectToplevelFuns(mir::blockptr toplevel) {
@@ -37,7 +39,10 @@ std::shared_ptr<FunObjTree> MemoryObjsCollector::traverseFunTree(mir::valueptr f
     resulttype.arg_types.emplace_back(rettype);
   }
   auto objptr = std::make_shared<FunObjTree>(FunObjTree{fun, res.hasself, res.objs, res.objtype});
+  objptr->random_has_state = random_has_state;
   if (res.hasself || !res.objs.empty()) {
+    // children are already laid out, so do it before objtype is copied into parents.
+    layoutMemobjTree(*objptr, float_size);
     result_map.emplace(fun, objptr);
     auto& ftype = rv::get<types::Function>(f.type);
     ftype.arg_types.emplace_back(types::Ref{objptr->objtype});
@@ -49,8 +54,13 @@ funobjmap MemoryObjsCollector::process(mir::blockptr toplevel) {
   auto& insts = toplevel->instructions;
   std::shared_ptr<FunObjTree> res;
   std::unordered_set<mir::valueptr> alloca_container;
-  for (auto&& inst : insts) {
-    if (mir::isInstA<minst::Function>(inst)) {
+  auto isdsplike = [](mir::valueptr inst) { return RuntimeEntry::isDspLike(mir::getName(*inst)); };
+  // functions reached from dsp-like functions are traversed first, so that random in them has a
+  // state.
+  for (bool dsppass : {true, false}) {
+    random_has_state = dsppass;
+    for (auto&& inst : insts) {
+      if (!mir::isInstA<minst::Function>(inst) || isdsplike(inst) != dsppass) { continue; }
       if (!std::holds_alternative<mir::ExternalSymbol>(*inst)) {
         res = traverseFunTree(inst);
         auto memtype = res->objtype;
@@ -169,15 +179,10 @@ ResultT MemoryObjsCollector::CollectMemVisitor::operator()(minst::Fcall& i) {
                               return std::nullopt;
                             },
                             [&](const mir::ExternalSymbol& e) -> opt_objtreeptr {
-                              if (e.name == "delay") {
+                              auto type = LLVMBuiltin::getMemobjType(e.name);
+                              if (type && (e.name != "random" || M.random_has_state)) {
                                 auto res = std::make_shared<FunObjTree>(
-                                    FunObjTree{i.fname, false, {}, types::getDelayStruct()});
-                                M.result_map.emplace(i.fname, res);
-                                return res;
-                              }
-                              if(e.name == "mem"){
-                                auto res = std::make_shared<FunObjTree>(
-                                    FunObjTree{i.fname, false, {}, types::Float{}});
+                                    FunObjTree{i.fname, false, {}, type.value()});
                                 M.result_map.emplace(i.fname, res);
                                 return res;
                               }
@@ -12,6 +12,14 @@ struct FunObjTree {
   bool hasself = false;
   std::list<std::shared_ptr<FunObjTree>> memobjs;
   types::Value objtype;
+  // struct index of each element of memobjs and of self in objtype, decided by layoutMemobjTree.
+  // empty means memobjs in order followed by self.
+  std::vector<int> memobj_fields;
+  int self_field = -1;
+  // lane of each element of memobjs in a bank of filter states, or -1 if it has its own field.
+  std::vector<int> memobj_lanes;
+  // whether calls of random in the function have states, see MemoryObjsCollector::process.
+  bool random_has_state = false;
 };
 
 using funobjmap = std::unordered_map<mir::valueptr, std::shared_ptr<FunObjTree>>;
@@ -20,6 +28,8 @@ class MemoryObjsCollector {
  public:
   MemoryObjsCollector() = default;
   funobjmap process(mir::blockptr toplevel);
+  // byte size of Float in the generated code, by which memory objects are laid out.
+  void setFloatSize(size_t size) { float_size = size; }
 
 #ifdef MIMIUM_DEBUG_BUILD
   void dump() const;
@@ -34,6 +44,9 @@ class MemoryObjsCollector {
                                                        std::string const& name);
 
   funobjmap result_map;
+  // random outside of dsp-like functions uses the state shared in the process instead.
+  bool random_has_state = false;
+  size_t float_size = sizeof(double);
 
  public:
   struct CollectMemVisitor {
@@ -31,6 +31,11 @@ void Compiler::setFilePath(std::string path) {
   llvmgenerator.init(path);
 }
 void Compiler::setDataLayout(const llvm::DataLayout& dl) { llvmgenerator.setDataLayout(dl); }
+void Compiler::setFloat32(bool isfloat32) {
+  llvmgenerator.setFloat32(isfloat32);
+  memobjcollector.setFloatSize(isfloat32 ? sizeof(float) : sizeof(double));
+}
+void Compiler::setFastMath(bool isfastmath) { llvmgenerator.setFastMath(isfastmath); }
 
 AstPtr Compiler::loadSource(std::istream& source) { return driver.parse(source); }
 
@@ -38,6 +43,12 @@ AstPtr Compiler::loadSource(const std::string& source) {
   AstPtr ast = driver.parseString(source);
   return ast;
 }
+AstPtr Compiler::loadSource(const Source& source) {
+  driver.setSourceMap(source.sourcemap);
+  AstPtr ast = driver.parseString(source.source);
+  driver.setSourceMap(nullptr);
+  return ast;
+}
 AstPtr Compiler::loadSourceFile(const std::string& filename) {
   AstPtr ast = driver.parseFile(filename);
   return ast;
@@ -46,6 +57,14 @@ AstPtr Compiler::renameSymbols(AstPtr ast) { return symbolrenamer.rename(*ast);
 TypeEnv& Compiler::typeInfer(AstPtr ast) { return typeinferer.infer(*ast); }
 
 mir::blockptr Compiler::generateMir(AstPtr ast) { return mirgenerator.generate(*ast); }
+mir::blockptr Compiler::expandMultirate(mir::blockptr mir) {
+  multirateexpander.process(mir);
+  return mir;
+}
+mir::blockptr Compiler::hoistControlRate(mir::blockptr mir) {
+  controlratehoister.process(mir);
+  return mir;
+}
 mir::blockptr Compiler::closureConvert(mir::blockptr mir) { return closureconverter->convert(mir); }
 
 funobjmap Compiler::collectMemoryObjs(mir::blockptr mir) { return memobjcollector.process(mir); }
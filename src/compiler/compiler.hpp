@@ -15,7 +15,11 @@
 #include "compiler/closure_convert.hpp"
 #include "compiler/codegen/llvmgenerator.hpp"
 #include "compiler/collect_memoryobjs.hpp"
+#include "compiler/control_rate.hpp"
+#include "compiler/memobj_layout.hpp"
+#include "compiler/mir_serializer.hpp"
 #include "compiler/mirgenerator.hpp"
+#include "compiler/multirate.hpp"
 #include "compiler/symbolrenamer.hpp"
 #include "compiler/type_infer_visitor.hpp"
 
@@ -29,14 +33,22 @@ class MIMIUM_DLL_PUBLIC Compiler {
 
   AstPtr loadSource(std::istream& source);
   AstPtr loadSource(const std::string& source);
+  // parse a preprocessed source. Errors are reported with its source map if available.
+  AstPtr loadSource(const Source& source);
   AstPtr loadSourceFile(const std::string& filename);
   void setFilePath(std::string path);
   void setDataLayout(const llvm::DataLayout& dl);
   void setDataLayout();
+  // lowers Float to single precision in generated code. dsp and voice keep double frames.
+  void setFloat32(bool isfloat32);
+  // replaces sin, cos, tan, exp, log, pow and tanh with inline approximations.
+  void setFastMath(bool isfastmath);
 
   AstPtr renameSymbols(AstPtr ast);
   TypeEnv& typeInfer(AstPtr ast);
   mir::blockptr generateMir(AstPtr ast);
+  mir::blockptr expandMultirate(mir::blockptr mir);
+  mir::blockptr hoistControlRate(mir::blockptr mir);
   mir::blockptr closureConvert(mir::blockptr mir);
   funobjmap collectMemoryObjs(mir::blockptr mir);
 
@@ -51,6 +63,8 @@ class MIMIUM_DLL_PUBLIC Compiler {
   SymbolRenamer symbolrenamer;
   TypeInferer typeinferer;
   MirGenerator mirgenerator;
+  MultirateExpander multirateexpander;
+  ControlRateHoister controlratehoister;
   std::shared_ptr<ClosureConverter> closureconverter;
   MemoryObjsCollector memobjcollector;
   LLVMGenerator llvmgenerator;
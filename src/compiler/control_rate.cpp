@@ -0,0 +1,374 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/control_rate.hpp"
+#include <deque>
+#include "compiler/ffi.hpp"
+
+namespace mimium {
+namespace {
+using inst_iter = std::list<mir::valueptr>::iterator;
+
+bool isFloatGlobal(mir::valueptr v) {
+  if (!mir::isInstA<minst::Allocate>(v)) { return false; }
+  auto type = mir::getType(*v);
+  return rv::holds_alternative<types::Pointer>(type) &&
+         std::holds_alternative<types::Float>(rv::get<types::Pointer>(type).val);
+}
+
+// visits instructions in the block and in blocks of nested ifs and functions.
+template <typename F>
+void walkBlock(mir::blockptr block, F&& fn) {
+  for (auto it = block->instructions.begin(); it != block->instructions.end(); ++it) {
+    fn(block, it);
+    auto* i = std::get_if<mir::Instructions>(it->get());
+    if (i == nullptr) { continue; }
+    if (auto* f = std::get_if<minst::Function>(i)) { walkBlock(f->body, fn); }
+    if (auto* ifinst = std::get_if<minst::If>(i)) {
+      walkBlock(ifinst->thenblock, fn);
+      if (ifinst->elseblock.has_value()) { walkBlock(ifinst->elseblock.value(), fn); }
+    }
+  }
+}
+
+mir::valueptr insertInst(mir::Instructions&& inst, mir::blockptr block, inst_iter pos) {
+  auto ptr = std::make_shared<mir::Value>(std::move(inst));
+  std::visit([&](auto& i) { i.parent = block; }, std::get<mir::Instructions>(*ptr));
+  block->instructions.insert(pos, ptr);
+  return ptr;
+}
+}  // namespace
+
+int ControlRateHoister::process(mir::blockptr toplevel) {
+  this->toplevel = toplevel;
+  std::vector<mir::valueptr> dspfns;
+  for (auto& inst : toplevel->instructions) {
+    if (mir::isInstA<minst::Function>(inst) && RuntimeEntry::isDspLike(mir::getName(*inst))) {
+      dspfns.emplace_back(inst);
+    }
+  }
+  int res = 0;
+  for (auto& fn : dspfns) { res += hoistFunction(fn); }
+  return res;
+}
+
+std::unordered_set<mir::valueptr> ControlRateHoister::collectWrittenGlobals(
+    mir::valueptr fn) const {
+  std::unordered_set<mir::valueptr> res;
+  std::unordered_set<mir::valueptr> visited = {fn};
+  std::deque<mir::valueptr> queue = {fn};
+  while (!queue.empty()) {
+    auto& f = mir::getInstRef<minst::Function>(queue.front());
+    queue.pop_front();
+    walkBlock(f.body, [&](mir::blockptr /*b*/, inst_iter it) {
+      const bool isload = mir::isInstA<minst::Load>(*it);
+      mir::forEachOperand(*it, [&](mir::valueptr& v) {
+        // anything but loading a global may modify it.
+        if (globals.count(v) > 0 && !isload) { res.emplace(v); }
+        if (mir::isInstA<minst::Function>(v) && visited.emplace(v).second) {
+          queue.emplace_back(v);
+        }
+      });
+    });
+  }
+  return res;
+}
+
+bool ControlRateHoister::isInvariant(mir::valueptr v) const {
+  return mir::isConstant(*v) || invariants.count(v) > 0;
+}
+
+void ControlRateHoister::analyzeBody(minst::Function& f) {
+  std::unordered_map<mir::valueptr, int> numstores;
+  std::unordered_set<mir::valueptr> escaped;
+  walkBlock(f.body, [&](mir::blockptr /*b*/, inst_iter it) {
+    auto* store = std::get_if<minst::Store>(&std::get<mir::Instructions>(**it));
+    if (store != nullptr) { numstores[store->target]++; }
+    const bool isload = mir::isInstA<minst::Load>(*it);
+    int count = 0;
+    mir::forEachOperand(*it, [&](mir::valueptr& v) {
+      const bool isstoretarget = store != nullptr && count++ == 0;
+      if (mir::isInstA<minst::Allocate>(v) && !isload && !isstoretarget) { escaped.emplace(v); }
+    });
+  });
+  auto isinv = [&](mir::valueptr v) { return isInvariant(v); };
+  // only straight-line code at the top of the body is analyzed.
+  for (auto& inst : f.body->instructions) {
+    auto const& i = std::get<mir::Instructions>(*inst);
+    const bool inv = std::visit(
+        overloaded{
+            [&](minst::Number const& /*i*/) { return true; },
+            [&](minst::Op const& i) {
+              return (!i.lhs.has_value() || isinv(i.lhs.value())) && isinv(i.rhs);
+            },
+            [&](minst::Fcall const& i) {
+              auto const* ext = std::get_if<mir::ExternalSymbol>(i.fname.get());
+              return ext != nullptr && LLVMBuiltin::isPure(ext->name) && !i.time.has_value() &&
+                     std::all_of(i.args.begin(), i.args.end(), isinv);
+            },
+            [&](minst::Load const& i) {
+              return control_globals.count(i.target) > 0 || local_values.count(i.target) > 0;
+            },
+            [&](minst::Store const& i) {
+              const bool islocal = mir::isInstA<minst::Allocate>(i.target) &&
+                                   mir::getInstRef<minst::Allocate>(i.target).parent == f.body;
+              if (islocal && numstores[i.target] == 1 && escaped.count(i.target) == 0 &&
+                  isinv(i.value)) {
+                local_values.emplace(i.target, i.value);
+                return true;
+              }
+              return false;
+            },
+            [](auto const& /*i*/) { return false; }},
+        i);
+    if (inv) { invariants.emplace(inst); }
+  }
+}
+
+mir::valueptr ControlRateHoister::getLocalValue(mir::valueptr v) const {
+  auto* i = std::get_if<mir::Instructions>(v.get());
+  if (i == nullptr) { return v; }
+  if (auto* load = std::get_if<minst::Load>(i)) {
+    auto local = local_values.find(load->target);
+    if (local != local_values.end()) { return getLocalValue(local->second); }
+  }
+  return v;
+}
+
+bool ControlRateHoister::isExpensive(mir::valueptr v) {
+  auto iter = expensive_cache.find(v);
+  if (iter != expensive_cache.end()) { return iter->second; }
+  bool res = false;
+  if (auto* i = std::get_if<mir::Instructions>(v.get())) {
+    res = std::visit(overloaded{[](minst::Fcall& /*i*/) { return true; },
+                                [&](minst::Op& i) {
+                                  // they are lowered to pow and fmod.
+                                  if (i.op == ast::OpId::Exponent || i.op == ast::OpId::Mod) {
+                                    return true;
+                                  }
+                                  return (i.lhs.has_value() && isExpensive(i.lhs.value())) ||
+                                         isExpensive(i.rhs);
+                                },
+                                [&](minst::Load& i) {
+                                  auto local = local_values.find(i.target);
+                                  return local != local_values.end() && isExpensive(local->second);
+                                },
+                                [](auto& /*i*/) { return false; }},
+                     *i);
+  }
+  expensive_cache.emplace(v, res);
+  return res;
+}
+
+void ControlRateHoister::collectInputs(mir::valueptr v,
+                                       std::unordered_set<mir::valueptr>& inputs) const {
+  if (auto* load = std::get_if<minst::Load>(&std::get<mir::Instructions>(*v))) {
+    auto local = local_values.find(load->target);
+    if (local == local_values.end()) {
+      inputs.emplace(load->target);
+    } else if (!mir::isConstant(*local->second)) {
+      collectInputs(local->second, inputs);
+    }
+    return;
+  }
+  mir::forEachOperand(v, [&](mir::valueptr& o) {
+    if (std::holds_alternative<mir::Instructions>(*o)) { collectInputs(o, inputs); }
+  });
+}
+
+mir::valueptr ControlRateHoister::cloneBefore(mir::valueptr v, mir::blockptr block, inst_iter pos) {
+  auto* i = std::get_if<mir::Instructions>(v.get());
+  if (i == nullptr) { return v; }
+  auto tmpl = templates.find(v);
+  if (tmpl != templates.end()) { return cloneBefore(tmpl->second, block, pos); }
+  auto newname = [&](std::string const& name) { return name + ".c" + std::to_string(count++); };
+  return std::visit(
+      overloaded{[&](minst::Number& i) {
+                   return insertInst(minst::Number{{newname(i.name), i.type}, i.val}, block, pos);
+                 },
+                 [&](minst::Load& i) {
+                   auto local = local_values.find(i.target);
+                   if (local != local_values.end()) {
+                     return cloneBefore(local->second, block, pos);
+                   }
+                   return insertInst(minst::Load{{newname(i.name), i.type}, i.target}, block, pos);
+                 },
+                 [&](minst::Op& i) {
+                   std::optional<mir::valueptr> lhs = std::nullopt;
+                   if (i.lhs.has_value()) { lhs = cloneBefore(i.lhs.value(), block, pos); }
+                   auto rhs = cloneBefore(i.rhs, block, pos);
+                   return insertInst(minst::Op{{newname(i.name), i.type}, i.op, lhs, rhs}, block,
+                                     pos);
+                 },
+                 [&](minst::Fcall& i) {
+                   std::list<mir::valueptr> args;
+                   for (auto& a : i.args) { args.emplace_back(cloneBefore(a, block, pos)); }
+                   minst::Fcall fcall{{newname(i.name), i.type}, i.fname, args, i.ftype};
+                   return insertInst(std::move(fcall), block, pos);
+                 },
+                 [&](auto& /*i*/) -> mir::valueptr {
+                   assert(false && "not an invariant instruction");
+                   return v;
+                 }},
+      *i);
+}
+
+void ControlRateHoister::removeDeadCode(mir::blockptr body,
+                                        std::unordered_set<mir::valueptr> const& removable) {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    std::unordered_map<mir::valueptr, int> uses;
+    walkBlock(body, [&](mir::blockptr /*b*/, inst_iter it) {
+      mir::forEachOperand(*it, [&](mir::valueptr& v) { uses[v]++; });
+    });
+    auto& insts = body->instructions;
+    for (auto it = insts.begin(); it != insts.end();) {
+      bool dead = false;
+      if (removable.count(*it) > 0) {
+        // a store is dead when nothing but itself refers to the variable.
+        dead = mir::isInstA<minst::Store>(*it)
+                   ? uses[mir::getInstRef<minst::Store>(*it).target] == 1
+                   : uses[*it] == 0;
+      }
+      if (dead) {
+        it = insts.erase(it);
+        changed = true;
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+int ControlRateHoister::hoistFunction(mir::valueptr fn) {
+  auto& f = mir::getInstRef<minst::Function>(fn);
+  globals.clear();
+  int fnpos = 0;
+  {
+    int pos = 0;
+    for (auto& inst : toplevel->instructions) {
+      if (isFloatGlobal(inst)) { globals.emplace(inst, pos); }
+      if (inst == fn) { fnpos = pos; }
+      pos++;
+    }
+  }
+  auto written = collectWrittenGlobals(fn);
+  control_globals.clear();
+  for (auto& [g, pos] : globals) {
+    if (written.count(g) == 0) { control_globals.emplace(g); }
+  }
+  invariants.clear();
+  local_values.clear();
+  expensive_cache.clear();
+  templates.clear();
+  analyzeBody(f);
+
+  // invariant values used from audio-rate code
+  std::vector<mir::valueptr> roots;
+  std::unordered_set<mir::valueptr> rootset;
+  walkBlock(f.body, [&](mir::blockptr /*b*/, inst_iter it) {
+    if (invariants.count(*it) > 0) { return; }
+    mir::forEachOperand(*it, [&](mir::valueptr& v) {
+      const bool isinst = std::holds_alternative<mir::Instructions>(*v);
+      if (isinst && isInvariant(v) && std::holds_alternative<types::Float>(mir::getType(*v)) &&
+          isExpensive(v) && rootset.emplace(v).second) {
+        roots.emplace_back(v);
+      }
+    });
+  });
+
+  // stores to globals which are not in the dsp function, with position of its toplevel ancestor
+  struct StoreSite {
+    mir::blockptr block;
+    inst_iter iter;
+    int pos;
+    bool infunction;
+  };
+  std::unordered_map<mir::valueptr, std::vector<StoreSite>> sites;
+  {
+    int pos = 0;
+    for (auto it = toplevel->instructions.begin(); it != toplevel->instructions.end();
+         ++it, ++pos) {
+      const bool infunction = mir::isInstA<minst::Function>(*it);
+      auto record = [&](mir::blockptr b, inst_iter i) {
+        if (auto* store = std::get_if<minst::Store>(&std::get<mir::Instructions>(**i))) {
+          if (globals.count(store->target) > 0) {
+            sites[store->target].push_back({b, i, pos, infunction && b != toplevel});
+          }
+        }
+      };
+      record(toplevel, it);
+      if (infunction) {
+        walkBlock(mir::getInstRef<minst::Function>(*it).body, record);
+      } else if (auto* ifinst = std::get_if<minst::If>(&std::get<mir::Instructions>(**it))) {
+        walkBlock(ifinst->thenblock, record);
+        if (ifinst->elseblock.has_value()) { walkBlock(ifinst->elseblock.value(), record); }
+      }
+    }
+  }
+
+  // every reference to a local variable is a distinct load, so roots are grouped by the value
+  // they eventually refer to.
+  std::vector<Hoisted> hoisted;
+  std::vector<std::vector<mir::valueptr>> members;
+  std::unordered_map<mir::valueptr, int> hoisted_index;
+  for (auto& root : roots) {
+    auto value = getLocalValue(root);
+    auto iter = hoisted_index.find(value);
+    if (iter == hoisted_index.end()) {
+      std::unordered_set<mir::valueptr> inputs;
+      collectInputs(value, inputs);
+      int lastinput = -1;
+      for (auto const& in : inputs) { lastinput = std::max(lastinput, globals.at(in)); }
+      // tasks defined before one of the inputs cannot recompute the value.
+      bool ok = true;
+      for (auto const& in : inputs) {
+        for (auto const& site : sites[in]) { ok &= !site.infunction || site.pos > lastinput; }
+      }
+      auto index = ok ? static_cast<int>(hoisted.size()) : -1;
+      iter = hoisted_index.emplace(value, index).first;
+      if (!ok) { continue; }
+      auto global = std::make_shared<mir::Value>(minst::Allocate{
+          {mir::getName(*value) + ".ctrl", types::Pointer{types::Float{}}, toplevel}});
+      hoisted.push_back({std::make_shared<mir::Value>(*value), global, std::move(inputs)});
+      templates.emplace(value, hoisted.back().root);
+      members.emplace_back();
+    }
+    if (iter->second >= 0) { members[iter->second].emplace_back(root); }
+  }
+  // replace the roots after all the templates are copied, as a root may contain another one.
+  std::unordered_set<mir::valueptr> removable = invariants;
+  for (auto const& [v, value] : local_values) { removable.emplace(v); }
+  for (size_t i = 0; i < hoisted.size(); i++) {
+    for (auto& root : members[i]) {
+      auto parent = mir::getParent(std::get<mir::Instructions>(*root));
+      *root = mir::Instructions{
+          minst::Load{{mir::getName(*root), types::Float{}, parent}, hoisted[i].global}};
+      removable.erase(root);
+    }
+  }
+  removeDeadCode(f.body, removable);
+
+  auto fniter = std::find(toplevel->instructions.begin(), toplevel->instructions.end(), fn);
+  for (auto& h : hoisted) {
+    toplevel->instructions.push_front(h.global);
+    // initial value, computed when the dsp function is defined
+    auto init = cloneBefore(h.root, toplevel, fniter);
+    insertInst(minst::Store{{mir::getName(*h.global), types::None{}}, h.global, init}, toplevel,
+               fniter);
+    for (auto& in : h.inputs) {
+      for (auto& site : sites[in]) {
+        if (!site.infunction && site.pos < fnpos) { continue; }
+        auto pos = std::next(site.iter);
+        auto val = cloneBefore(h.root, site.block, pos);
+        insertInst(minst::Store{{mir::getName(*h.global), types::None{}}, h.global, val},
+                   site.block, pos);
+      }
+    }
+  }
+  return static_cast<int>(hoisted.size());
+}
+
+}  // namespace mimium
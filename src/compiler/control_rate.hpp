@@ -0,0 +1,59 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <unordered_map>
+#include <unordered_set>
+#include "basic/mir.hpp"
+#include "export.hpp"
+
+namespace mimium {
+namespace minst = mir::instruction;
+
+// Moves computations in dsp, voice and spectral functions that do not change from sample to
+// sample out of the audio-rate code. An expression is hoisted when it depends only on constants
+// and global variables which are never written from the dsp function, and contains an expensive
+// call like exp or pow. Its value is kept in a new global variable, which is recomputed once at the
+// definition of the dsp function and after every store to its inputs, that is, once per
+// scheduler event which changes them.
+// Runs on MIR before closure conversion, so that new globals are captured as usual.
+class MIMIUM_DLL_PUBLIC ControlRateHoister {
+ public:
+  // returns the number of hoisted expressions.
+  int process(mir::blockptr toplevel);
+
+ private:
+  struct Hoisted {
+    mir::valueptr root;  // copy of the hoisted instruction, kept as a template for recomputation
+    mir::valueptr global;
+    std::unordered_set<mir::valueptr> inputs;
+  };
+  int hoistFunction(mir::valueptr fn);
+  void analyzeBody(minst::Function& f);
+  std::unordered_set<mir::valueptr> collectWrittenGlobals(mir::valueptr fn) const;
+  bool isInvariant(mir::valueptr v) const;
+  // the value stored to the local variable if v loads an invariant one, otherwise v itself.
+  mir::valueptr getLocalValue(mir::valueptr v) const;
+  bool isExpensive(mir::valueptr v);
+  void collectInputs(mir::valueptr v, std::unordered_set<mir::valueptr>& inputs) const;
+  mir::valueptr cloneBefore(mir::valueptr v, mir::blockptr block,
+                            std::list<mir::valueptr>::iterator pos);
+  static void removeDeadCode(mir::blockptr body,
+                             std::unordered_set<mir::valueptr> const& removable);
+
+  mir::blockptr toplevel;
+  // position in toplevel of float global variables
+  std::unordered_map<mir::valueptr, int> globals;
+  // state of the function being processed
+  std::unordered_set<mir::valueptr> control_globals;
+  std::unordered_set<mir::valueptr> invariants;
+  // local variables written once with an invariant value, and the value.
+  std::unordered_map<mir::valueptr, mir::valueptr> local_values;
+  std::unordered_map<mir::valueptr, bool> expensive_cache;
+  // hoisted values and their copies taken before the originals are replaced
+  std::unordered_map<mir::valueptr, mir::valueptr> templates;
+  int count = 0;
+};
+
+}  // namespace mimium
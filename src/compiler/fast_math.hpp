@@ -0,0 +1,225 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Polynomial approximations of math builtins, used instead of libm by `--fast-math` and by the
+// builtins with `fast` prefix (e.g. `fastsin`). FastMathEmitter generates inline IR of the same
+// algorithms from these coefficients.
+// The polynomials are minimax fits of the relative error, with separate shorter coefficient sets
+// for single precision. Measured error bounds in double precision. In single precision they are
+// about 2e-7, or 2e-5 for tan.
+//  - sin, cos: absolute 1e-13 for |x| < 1e4. The argument reduction loses accuracy beyond that.
+//  - tan: relative 1e-13 for |x| < 1e4, where |cos(x)| > 0.1.
+//  - exp: relative 1e-15. The argument is clamped to the finite range, NaN is not propagated.
+//  - log: relative 3e-14 for normal positive x. Subnormal x is inaccurate, 0 gives -inf and
+//    negative x gives NaN.
+//  - pow: relative (1 + |y*log(x)|) * 3e-14 for x > 0. Negative x gives NaN even for integer y.
+//  - tanh: absolute 1e-15.
+namespace mimium::fastmath {
+
+// builtins which have an approximation.
+inline bool hasApproximation(std::string const& name) {
+  return name == "sin" || name == "cos" || name == "tan" || name == "exp" || name == "log" ||
+         name == "pow" || name == "tanh";
+}
+// name of the approximated builtin for a builtin with `fast` prefix, or empty string.
+inline std::string getApproximatedName(std::string const& name) {
+  constexpr std::string_view prefix = "fast";
+  if (name.compare(0, prefix.size(), prefix) != 0) { return ""; }
+  auto res = name.substr(prefix.size());
+  return hasApproximation(res) ? res : "";
+}
+
+struct Constants {
+  // constants split into parts for the argument reduction (Cody-Waite), of which products with
+  // the quotient are exact except for the last part.
+  double pi_hi;
+  double pi_mid;
+  double pi_lo;
+  double ln2_hi;
+  double ln2_lo;
+  // range of exp of which result is a normal number.
+  double exp_min;
+  double exp_max;
+  int mantissa_bits;
+  int exponent_bias;
+};
+constexpr Constants constants_f64 = {3.1415926534682512,
+                                     1.2154201012607932e-10,
+                                     4.044532497591901e-21,
+                                     6.93147180369123816e-1,
+                                     1.90821492927058770e-10,
+                                     -708.0,
+                                     709.0,
+                                     52,
+                                     1023};
+constexpr Constants constants_f32 = {
+    3.140625, 9.675025939941406e-4, 1.5099579909783765e-07, 0.693359375, -2.12194440e-4, -87.0,
+    88.0,     23,                   127};
+template <typename T>
+constexpr const Constants& getConstants() {
+  return std::is_same_v<T, float> ? constants_f32 : constants_f64;
+}
+constexpr double inv_pi = 0.31830988618379067154;
+constexpr double log2e = 1.44269504088896340736;
+constexpr double sqrt2 = 1.41421356237309504880;
+
+// Minimax polynomials of the relative error over the reduced ranges, fitted by the Remez
+// algorithm at the least degree for each precision. The error of the fit is noted for each.
+// sin(r) = r * P(r^2) for |r| <= pi/2.
+constexpr std::array<double, 7> sin_coeffs_f64 = {
+    0.9999999999999376,     -0.1666666666643233,    0.008333333318765514,
+    -0.0001984126641162215, 2.755693192659491e-06,  -2.5029518865603207e-08,
+    1.5401170371414643e-10};  // 6.3e-14
+constexpr std::array<double, 5> sin_coeffs_f32 = {0.9999999946860073, -0.1666665668400715,
+                                                  0.008333025138969368, -0.0001980741872742697,
+                                                  2.60190306765146e-06};  // 5.4e-9
+// exp(r) = P(r) for |r| <= ln2/2.
+constexpr std::array<double, 11> exp_coeffs_f64 = {
+    1.0,                    1.0000000000000064,    0.49999999999997286,   0.16666666666557742,
+    0.04166666666842604,    0.00833333338466586,   0.0013888888499132617, 0.00019841171384145565,
+    2.4801917693499152e-05, 2.763976828264541e-06, 2.748844159545267e-07};  // 2.2e-16
+constexpr std::array<double, 7> exp_coeffs_f32 = {
+    1.0000000005541665,  1.0000000363231987,   0.499999920798166,    0.1666642016984746,
+    0.04166822556948865, 0.008374815804468408, 0.0013836845994063783};  // 1.9e-9
+// log(m) = 2atanh(t) = t * P(t^2) with t = (m-1)/(m+1) for m in [sqrt(1/2), sqrt(2)].
+constexpr std::array<double, 6> log_coeffs_f64 = {
+    1.9999999999999467, 0.6666666667965145,  0.39999994872181466,
+    0.2857216801691576, 0.22174177214539534, 0.1960908402746341};  // 2.7e-14
+constexpr std::array<double, 4> log_coeffs_f32 = {
+    1.99999999862133, 0.6666681595085571, 0.3997479492478841, 0.29925650701767686};  // 6.9e-10
+template <typename T>
+constexpr const auto& getSinCoeffs() {
+  if constexpr (std::is_same_v<T, float>) {
+    return sin_coeffs_f32;
+  } else {
+    return sin_coeffs_f64;
+  }
+}
+template <typename T>
+constexpr const auto& getExpCoeffs() {
+  if constexpr (std::is_same_v<T, float>) {
+    return exp_coeffs_f32;
+  } else {
+    return exp_coeffs_f64;
+  }
+}
+template <typename T>
+constexpr const auto& getLogCoeffs() {
+  if constexpr (std::is_same_v<T, float>) {
+    return log_coeffs_f32;
+  } else {
+    return log_coeffs_f64;
+  }
+}
+// tanh(x) = 1 - 2/(exp(2x)+1), of which argument is clamped here.
+constexpr double tanh_max = 20.0;
+
+template <typename T, size_t N>
+T horner(std::array<double, N> const& coeffs, T x) {
+  T res = static_cast<T>(coeffs[N - 1]);
+  for (size_t i = N - 1; i > 0; i--) { res = res * x + static_cast<T>(coeffs[i - 1]); }
+  return res;
+}
+
+template <typename T>
+using bits_t = std::conditional_t<std::is_same_v<T, float>, int32_t, int64_t>;
+template <typename T>
+T fromBits(bits_t<T> bits) {
+  T res;
+  std::memcpy(&res, &bits, sizeof(T));
+  return res;
+}
+template <typename T>
+bits_t<T> toBits(T v) {
+  bits_t<T> res;
+  std::memcpy(&res, &v, sizeof(T));
+  return res;
+}
+
+// x - k*pi.
+template <typename T>
+T reducePi(T x, T k) {
+  const auto& c = getConstants<T>();
+  T r = x - k * static_cast<T>(c.pi_hi);
+  r = r - k * static_cast<T>(c.pi_mid);
+  return r - k * static_cast<T>(c.pi_lo);
+}
+// (-1)^n for integer n.
+template <typename T>
+T getParitySign(T n) {
+  return 1 - 2 * (n - 2 * std::floor(n * static_cast<T>(0.5)));
+}
+
+// sin(r + n*pi) = (-1)^n sin(r).
+template <typename T>
+T sin(T x) {
+  T n = std::floor(x * static_cast<T>(inv_pi) + static_cast<T>(0.5));
+  T r = reducePi(x, n);
+  return getParitySign(n) * r * horner(getSinCoeffs<T>(), r * r);
+}
+// cos(r + (n+1/2)pi) = (-1)^(n+1) sin(r).
+template <typename T>
+T cos(T x) {
+  T n = std::floor(x * static_cast<T>(inv_pi));
+  T r = reducePi(x, n + static_cast<T>(0.5));
+  return -getParitySign(n) * r * horner(getSinCoeffs<T>(), r * r);
+}
+template <typename T>
+T tan(T x) {
+  return fastmath::sin(x) / fastmath::cos(x);
+}
+
+template <typename T>
+T exp(T x) {
+  const auto& c = getConstants<T>();
+  x = std::fmin(std::fmax(x, static_cast<T>(c.exp_min)), static_cast<T>(c.exp_max));
+  T k = std::floor(x * static_cast<T>(log2e) + static_cast<T>(0.5));
+  T r = (x - k * static_cast<T>(c.ln2_hi)) - k * static_cast<T>(c.ln2_lo);
+  auto scale = (static_cast<bits_t<T>>(k) + c.exponent_bias) << c.mantissa_bits;
+  return horner(getExpCoeffs<T>(), r) * fromBits<T>(scale);
+}
+
+template <typename T>
+T log(T x) {
+  const auto& c = getConstants<T>();
+  auto bits = toBits(x);
+  const bits_t<T> mantissa_mask = (bits_t<T>(1) << c.mantissa_bits) - 1;
+  T e = static_cast<T>((bits >> c.mantissa_bits) - c.exponent_bias);
+  T m = fromBits<T>((bits & mantissa_mask) | (bits_t<T>(c.exponent_bias) << c.mantissa_bits));
+  const bool large = m > static_cast<T>(sqrt2);
+  m = large ? m * static_cast<T>(0.5) : m;
+  e = large ? e + 1 : e;
+  T t = (m - 1) / (m + 1);
+  T res = e * static_cast<T>(c.ln2_hi) +
+          (t * horner(getLogCoeffs<T>(), t * t) + e * static_cast<T>(c.ln2_lo));
+  if (x == std::numeric_limits<T>::infinity()) { return x; }
+  if (x == 0) { return -std::numeric_limits<T>::infinity(); }
+  if (!(x > 0)) { return std::numeric_limits<T>::quiet_NaN(); }
+  return res;
+}
+
+template <typename T>
+T pow(T x, T y) {
+  if (y == 0) { return 1; }
+  if (x == 0) { return y > 0 ? 0 : std::numeric_limits<T>::infinity(); }
+  return fastmath::exp(y * fastmath::log(x));
+}
+
+template <typename T>
+T tanh(T x) {
+  x = std::fmin(std::fmax(x, static_cast<T>(-tanh_max)), static_cast<T>(tanh_max));
+  return 1 - 2 / (fastmath::exp(2 * x) + 1);
+}
+
+}  // namespace mimium::fastmath
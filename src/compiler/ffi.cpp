@@ -3,8 +3,135 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "compiler/ffi.hpp"
+#include <array>
+#include <atomic>
 #include <cmath>
-#include "sndfile.h"
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include "compiler/filters.hpp"
+#include "compiler/oscillators.hpp"
+#include "compiler/prng.hpp"
+
+// stateful builtins, instantiated for each precision of the generated code.
+namespace {
+// side taps of a Kaiser-windowed (beta = 7) halfband lowpass, normalized for unity DC gain.
+// Stopband attenuation is about 80dB above 0.35 of the oversampled rate.
+constexpr double halfband_coeffs[mimium::types::halfband_sidetaps] = {
+    0.31433344365496824,   -0.094603224992531876, 0.046059050321023622,  -0.023742549536312527,
+    0.011624843026749888,  -0.0050374647958463473, 0.0017602997184117371, -0.00039439739646268131};
+
+template <typename T>
+T lin_interp(const T* array, T index_d) {
+  T fract = std::fmod(index_d, T(1));
+  auto index = static_cast<size_t>(std::floor(index_d));
+  if (fract == 0) { return array[index]; }
+  return array[index] * (1 - fract) + array[index + 1] * fract;
+}
+
+template <typename T>
+T memprim(T in, T* valptr) {
+  auto res = *valptr;
+  *valptr = in;
+  return res;
+}
+
+template <typename T>
+T delayprim(T in, T time, MmmRingBufT<T>* rbuf) {
+  constexpr auto size = static_cast<int64_t>(mimium::types::fixed_delaysize);
+  rbuf->writei = (rbuf->writei + 1) % size;
+  T readi = std::fmod((size + rbuf->writei - time), T(size));
+  rbuf->readi = static_cast<mimium::mmm_index_t<T>>(readi);
+  rbuf->buf[rbuf->writei] = in;
+  return lin_interp(rbuf->buf, readi);
+}
+
+template <typename T>
+void halfband_write(T in, MmmHalfbandT<T>* state) {
+  constexpr int64_t size = 2 * mimium::types::halfband_sidetaps;
+  state->pos = (state->pos + 1) % size;
+  state->buf[state->pos] = in;
+}
+
+template <typename T>
+T halfband_fir(T in, MmmHalfbandT<T>* state) {
+  constexpr int64_t m = mimium::types::halfband_sidetaps;
+  halfband_write(in, state);
+  T res = 0.0;
+  for (int64_t i = 0; i < 2 * m; i++) {
+    auto coeff = static_cast<T>(halfband_coeffs[i < m ? m - 1 - i : i - m]);
+    res += coeff * state->buf[(state->pos + 2 * m - i) % (2 * m)];
+  }
+  return res;
+}
+
+template <typename T>
+T halfband_delay(T in, MmmHalfbandT<T>* state) {
+  constexpr int64_t m = mimium::types::halfband_sidetaps;
+  halfband_write(in, state);
+  return state->buf[(state->pos + m + 1) % (2 * m)];
+}
+
+std::atomic<uint64_t> random_seed{0};
+// number of the streams given to the states of random outside of the registered memory.
+std::atomic<uint64_t> random_streams{0};
+
+struct RandomArenaSlot {
+  std::atomic<uintptr_t> base{0};
+  size_t size = 0;
+  size_t stride = 0;
+  uint64_t id = 0;
+  const uint64_t* generations = nullptr;
+};
+// written only by the registration, and scanned without locks by the first calls of random.
+constexpr size_t max_random_arenas = 64;
+std::array<RandomArenaSlot, max_random_arenas> random_arenas;
+std::mutex random_arenas_mutex;
+
+uint64_t getArenaStream(RandomArenaSlot const& arena, uint64_t offset) {
+  uint64_t generation = 0;
+  if (arena.generations != nullptr && arena.stride > 0) {
+    generation = arena.generations[offset / arena.stride];
+  }
+  return mimium::prng::getStreamIndex(arena.id, offset, generation);
+}
+// state of random outside of dsp-like functions, which takes the last stream.
+constexpr uint64_t shared_stream = std::numeric_limits<uint64_t>::max();
+std::atomic<uint64_t> random_shared_state{mimium::prng::getStreamSeed(0, shared_stream)};
+}  // namespace
+
+namespace mimium {
+void setRandomSeed(uint64_t seed) {
+  random_seed = seed;
+  random_streams = 0;
+  random_shared_state = prng::getStreamSeed(seed, shared_stream);
+}
+
+void registerRandomArena(const void* base, size_t size, RandomArena id, size_t stride,
+                         const uint64_t* generations) {
+  std::lock_guard<std::mutex> lock(random_arenas_mutex);
+  for (auto& arena : random_arenas) {
+    if (arena.base.load(std::memory_order_relaxed) != 0) { continue; }
+    arena.size = size;
+    arena.stride = stride;
+    arena.id = static_cast<uint64_t>(id);
+    arena.generations = generations;
+    arena.base.store(reinterpret_cast<uintptr_t>(base), std::memory_order_release);
+    return;
+  }
+  throw std::runtime_error("too many memory objects of random are registered.");
+}
+
+void unregisterRandomArena(const void* base) {
+  std::lock_guard<std::mutex> lock(random_arenas_mutex);
+  for (auto& arena : random_arenas) {
+    if (arena.base.load(std::memory_order_relaxed) == reinterpret_cast<uintptr_t>(base)) {
+      arena.base.store(0, std::memory_order_release);
+      return;
+    }
+  }
+}
+}  // namespace mimium
 
 extern "C"{
 MIMIUM_DLL_PUBLIC void dumpaddress(void* a) { std::cerr << a << "\n"; }
@@ -14,7 +141,24 @@ MIMIUM_DLL_PUBLIC void printlndouble(double d) { std::cout << d << "\n"; }
 
 MIMIUM_DLL_PUBLIC void printlnstr(char* str) { std::cout << str << "\n"; }
 
-MIMIUM_DLL_PUBLIC double mimiumrand() { return ((double)rand() / RAND_MAX) * 2 - 1; }
+MIMIUM_DLL_PUBLIC uint64_t mimium_random_seed(const void* state) {
+  const auto address = reinterpret_cast<uintptr_t>(state);
+  for (auto const& arena : random_arenas) {
+    const auto base = arena.base.load(std::memory_order_acquire);
+    if (base == 0 || address < base || address - base >= arena.size) { continue; }
+    return mimium::prng::getStreamSeed(random_seed, getArenaStream(arena, address - base));
+  }
+  return mimium::prng::getStreamSeed(random_seed, random_streams++);
+}
+MIMIUM_DLL_PUBLIC double mimium_random() {
+  auto state = random_shared_state.fetch_add(mimium::prng::increment_u64);
+  return mimium::prng::toFloat<double>(mimium::prng::mix(state + mimium::prng::increment_u64));
+}
+MIMIUM_DLL_PUBLIC float mimium_random_f32() {
+  auto state = random_shared_state.fetch_add(mimium::prng::increment_u64);
+  auto z = static_cast<uint32_t>(mimium::prng::mix(state + mimium::prng::increment_u64));
+  return mimium::prng::toFloat<float>(z);
+}
 
 MIMIUM_DLL_PUBLIC bool mimium_dtob(double d) { return d > 0; }
 MIMIUM_DLL_PUBLIC int64_t mimium_dtoi(double d) { return static_cast<int64_t>(d); }
@@ -38,52 +182,83 @@ MIMIUM_DLL_PUBLIC double mimium_rshift(double d1, double d2) {
 }
 
 MIMIUM_DLL_PUBLIC double access_array_lin_interp(double* array, double index_d) {
-  double fract = fmod(index_d, 1.000);
-  size_t index = floor(index_d);
-  if (fract == 0) { return array[index]; }
-  return array[index] * (1 - fract) + array[index + 1] * fract;
+  return lin_interp(array, index_d);
 }
-struct MmmRingBuf {
-  // int64_t size=5000;
-  int64_t readi = 0;
-  int64_t writei = 0;
-  double buf[mimium::types::fixed_delaysize]{};
-};
-
-MIMIUM_DLL_PUBLIC double mimium_memprim(double in, double* valptr){
-  auto res= *valptr;
-  *valptr = in;
-  return res;
+MIMIUM_DLL_PUBLIC float access_array_lin_interp_f32(float* array, float index_d) {
+  return lin_interp(array, index_d);
 }
+
+MIMIUM_DLL_PUBLIC double mimium_memprim(double in, double* valptr) { return memprim(in, valptr); }
+MIMIUM_DLL_PUBLIC float mimium_memprim_f32(float in, float* valptr) { return memprim(in, valptr); }
 MIMIUM_DLL_PUBLIC double mimium_delayprim(double in, double time, MmmRingBuf* rbuf) {
-  auto size = sizeof(rbuf->buf) / sizeof(double);
-  rbuf->writei = (rbuf->writei + 1) % size;
-  double readi = fmod((size + rbuf->writei - time), size);
-  rbuf->readi = (int64_t)readi;
-  rbuf->buf[rbuf->writei] = in;
-  return access_array_lin_interp(rbuf->buf, readi);
+  return delayprim(in, time, rbuf);
 }
-
-MIMIUM_DLL_PUBLIC double libsndfile_loadwavsize(char* filename) {
-  SF_INFO sfinfo;
-  auto* sfile = sf_open(filename, SFM_READ, &sfinfo);
-  if (sfile == nullptr) { std::cerr << sf_strerror(sfile) << "\n"; }
-  auto res = sfinfo.frames;
-  sf_close(sfile);
-  return res;
+MIMIUM_DLL_PUBLIC float mimium_delayprim_f32(float in, float time, MmmRingBufF32* rbuf) {
+  return delayprim(in, time, rbuf);
 }
 
-MIMIUM_DLL_PUBLIC double* libsndfile_loadwav(char* filename) {
-  SF_INFO sfinfo;
-  auto* sfile = sf_open(filename, SFM_READ, &sfinfo);
-  if (sfile == nullptr) { std::cerr << sf_strerror(sfile) << "\n"; }
+MIMIUM_DLL_PUBLIC double mimium_halfband_fir(double in, MmmHalfband* state) {
+  return halfband_fir(in, state);
+}
+MIMIUM_DLL_PUBLIC float mimium_halfband_fir_f32(float in, MmmHalfbandF32* state) {
+  return halfband_fir(in, state);
+}
+MIMIUM_DLL_PUBLIC double mimium_halfband_delay(double in, MmmHalfband* state) {
+  return halfband_delay(in, state);
+}
+MIMIUM_DLL_PUBLIC float mimium_halfband_delay_f32(float in, MmmHalfbandF32* state) {
+  return halfband_delay(in, state);
+}
 
-  const int bufsize = sfinfo.frames * sfinfo.channels;
-  double* buffer = new double[bufsize];
-  sf_readf_double(sfile, buffer, bufsize);
-  // sf_close(sfile);
-  // std::cerr<< filename << "(" << size << ") is succecfully loaded";
-  return buffer;
+MIMIUM_DLL_PUBLIC double mimium_biquad(double in, double b0, double b1, double b2, double a1,
+                                       double a2, double* state, int64_t stride) {
+  return mimium::filters::biquad(in, b0, b1, b2, a1, a2, state, stride);
+}
+MIMIUM_DLL_PUBLIC float mimium_biquad_f32(float in, float b0, float b1, float b2, float a1,
+                                          float a2, float* state, int64_t stride) {
+  return mimium::filters::biquad(in, b0, b1, b2, a1, a2, state, stride);
+}
+MIMIUM_DLL_PUBLIC double mimium_svf_lp(double in, double g, double k, double* state,
+                                        int64_t stride) {
+  return mimium::filters::svf(in, g, k, state, stride, mimium::filters::SvfMode::Low);
+}
+MIMIUM_DLL_PUBLIC float mimium_svf_lp_f32(float in, float g, float k, float* state,
+                                          int64_t stride) {
+  return mimium::filters::svf(in, g, k, state, stride, mimium::filters::SvfMode::Low);
+}
+MIMIUM_DLL_PUBLIC double mimium_svf_bp(double in, double g, double k, double* state,
+                                        int64_t stride) {
+  return mimium::filters::svf(in, g, k, state, stride, mimium::filters::SvfMode::Band);
+}
+MIMIUM_DLL_PUBLIC float mimium_svf_bp_f32(float in, float g, float k, float* state,
+                                          int64_t stride) {
+  return mimium::filters::svf(in, g, k, state, stride, mimium::filters::SvfMode::Band);
+}
+MIMIUM_DLL_PUBLIC double mimium_svf_hp(double in, double g, double k, double* state,
+                                        int64_t stride) {
+  return mimium::filters::svf(in, g, k, state, stride, mimium::filters::SvfMode::High);
+}
+MIMIUM_DLL_PUBLIC float mimium_svf_hp_f32(float in, float g, float k, float* state,
+                                          int64_t stride) {
+  return mimium::filters::svf(in, g, k, state, stride, mimium::filters::SvfMode::High);
+}
+MIMIUM_DLL_PUBLIC double mimium_osc_saw_blep(double freq, double* phase) {
+  return mimium::osc::sawBlep(freq, phase);
+}
+MIMIUM_DLL_PUBLIC float mimium_osc_saw_blep_f32(float freq, float* phase) {
+  return mimium::osc::sawBlep(freq, phase);
+}
+MIMIUM_DLL_PUBLIC double mimium_osc_square_blep(double freq, double* phase) {
+  return mimium::osc::squareBlep(freq, phase);
+}
+MIMIUM_DLL_PUBLIC float mimium_osc_square_blep_f32(float freq, float* phase) {
+  return mimium::osc::squareBlep(freq, phase);
+}
+MIMIUM_DLL_PUBLIC double mimium_onepole(double in, double a, double* state, int64_t /*stride*/) {
+  return mimium::filters::onepole(in, a, state);
+}
+MIMIUM_DLL_PUBLIC float mimium_onepole_f32(float in, float a, float* state, int64_t /*stride*/) {
+  return mimium::filters::onepole(in, a, state);
 }
 }
 
@@ -95,38 +270,47 @@ const std::unordered_map<std::string, BuiltinFnInfo> LLVMBuiltin::ftable = {
     {"println", initBI(Function{Void{}, {Float{}}}, "printlndouble")},
     {"printlnstr", initBI(Function{Void{}, {String{}}}, "printlnstr")},
 
-    {"sin", initBI(Function{Float{}, {Float{}}}, "sin")},
-    {"cos", initBI(Function{Float{}, {Float{}}}, "cos")},
-    {"tan", initBI(Function{Float{}, {Float{}}}, "tan")},
+    {"sin", initBI(Function{Float{}, {Float{}}}, "sin", "sinf")},
+    {"cos", initBI(Function{Float{}, {Float{}}}, "cos", "cosf")},
+    {"tan", initBI(Function{Float{}, {Float{}}}, "tan", "tanf")},
 
-    {"asin", initBI(Function{Float{}, {Float{}}}, "asin")},
-    {"acos", initBI(Function{Float{}, {Float{}}}, "acos")},
-    {"atan", initBI(Function{Float{}, {Float{}}}, "atan")},
-    {"atan2", initBI(Function{Float{}, {Float{}, Float{}}}, "atan2")},
+    {"asin", initBI(Function{Float{}, {Float{}}}, "asin", "asinf")},
+    {"acos", initBI(Function{Float{}, {Float{}}}, "acos", "acosf")},
+    {"atan", initBI(Function{Float{}, {Float{}}}, "atan", "atanf")},
+    {"atan2", initBI(Function{Float{}, {Float{}, Float{}}}, "atan2", "atan2f")},
 
-    {"sinh", initBI(Function{Float{}, {Float{}}}, "sinh")},
-    {"cosh", initBI(Function{Float{}, {Float{}}}, "cosh")},
-    {"tanh", initBI(Function{Float{}, {Float{}}}, "tanh")},
-    {"exp", initBI(Function{Float{}, {Float{}}}, "exp")},
-    {"pow", initBI(Function{Float{}, {Float{}, Float{}}}, "pow")},
+    {"sinh", initBI(Function{Float{}, {Float{}}}, "sinh", "sinhf")},
+    {"cosh", initBI(Function{Float{}, {Float{}}}, "cosh", "coshf")},
+    {"tanh", initBI(Function{Float{}, {Float{}}}, "tanh", "tanhf")},
+    {"exp", initBI(Function{Float{}, {Float{}}}, "exp", "expf")},
+    {"pow", initBI(Function{Float{}, {Float{}, Float{}}}, "pow", "powf")},
 
-    {"log", initBI(Function{Float{}, {Float{}}}, "log")},
-    {"log10", initBI(Function{Float{}, {Float{}}}, "log10")},
-    {"random", initBI(Function{Float{}, {}}, "mimiumrand")},
+    {"log", initBI(Function{Float{}, {Float{}}}, "log", "logf")},
+    {"log10", initBI(Function{Float{}, {Float{}}}, "log10", "log10f")},
+    // inlined polynomial approximations, see fast_math.hpp.
+    {"fastsin", initBI(Function{Float{}, {Float{}}}, "sin", "sinf")},
+    {"fastcos", initBI(Function{Float{}, {Float{}}}, "cos", "cosf")},
+    {"fasttan", initBI(Function{Float{}, {Float{}}}, "tan", "tanf")},
+    {"fasttanh", initBI(Function{Float{}, {Float{}}}, "tanh", "tanhf")},
+    {"fastexp", initBI(Function{Float{}, {Float{}}}, "exp", "expf")},
+    {"fastlog", initBI(Function{Float{}, {Float{}}}, "log", "logf")},
+    {"fastpow", initBI(Function{Float{}, {Float{}, Float{}}}, "pow", "powf")},
+    // inlined generator with the state in the memory object in dsp-like functions, see prng.hpp.
+    {"random", initBI(Function{Float{}, {}}, "mimium_random", "mimium_random_f32")},
 
-    {"sqrt", initBI(Function{Float{}, {Float{}}}, "sqrt")},
-    {"abs", initBI(Function{Float{}, {Float{}}}, "fabs")},
+    {"sqrt", initBI(Function{Float{}, {Float{}}}, "sqrt", "sqrtf")},
+    {"abs", initBI(Function{Float{}, {Float{}}}, "fabs", "fabsf")},
 
-    {"ceil", initBI(Function{Float{}, {Float{}}}, "ceil")},
-    {"floor", initBI(Function{Float{}, {Float{}}}, "floor")},
-    {"trunc", initBI(Function{Float{}, {Float{}}}, "trunc")},
-    {"round", initBI(Function{Float{}, {Float{}}}, "round")},
+    {"ceil", initBI(Function{Float{}, {Float{}}}, "ceil", "ceilf")},
+    {"floor", initBI(Function{Float{}, {Float{}}}, "floor", "floorf")},
+    {"trunc", initBI(Function{Float{}, {Float{}}}, "trunc", "truncf")},
+    {"round", initBI(Function{Float{}, {Float{}}}, "round", "roundf")},
 
-    {"fmod", initBI(Function{Float{}, {Float{}, Float{}}}, "fmod")},
-    {"remainder", initBI(Function{Float{}, {Float{}, Float{}}}, "remainder")},
+    {"fmod", initBI(Function{Float{}, {Float{}, Float{}}}, "fmod", "fmodf")},
+    {"remainder", initBI(Function{Float{}, {Float{}, Float{}}}, "remainder", "remainderf")},
 
-    {"min", initBI(Function{Float{}, {Float{}, Float{}}}, "fmin")},
-    {"max", initBI(Function{Float{}, {Float{}, Float{}}}, "fmax")},
+    {"min", initBI(Function{Float{}, {Float{}, Float{}}}, "fmin", "fminf")},
+    {"max", initBI(Function{Float{}, {Float{}, Float{}}}, "fmax", "fmaxf")},
 
     {"ge", initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_ge")},
     {"le", initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_le")},
@@ -139,15 +323,102 @@ const std::unordered_map<std::string, BuiltinFnInfo> LLVMBuiltin::ftable = {
     {"lshift", initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_lshift")},
     {"rshift", initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_rshift")},
 
-    {"mem", initBI(Function{Float{}, {Float{}}}, "mimium_memprim")},
-    {"delay", initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_delayprim")},
+    {"mem", initBI(Function{Float{}, {Float{}}}, "mimium_memprim", "mimium_memprim_f32")},
+    {"delay",
+     initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_delayprim", "mimium_delayprim_f32")},
+    // used for oversampled functions
+    {"halfband_fir",
+     initBI(Function{Float{}, {Float{}}}, "mimium_halfband_fir", "mimium_halfband_fir_f32")},
+    {"halfband_delay",
+     initBI(Function{Float{}, {Float{}}}, "mimium_halfband_delay", "mimium_halfband_delay_f32")},
+    // inlined filters with the states in the memory object, see filters.hpp.
+    {"biquad", initBI(Function{Float{}, {Float{}, Float{}, Float{}, Float{}, Float{}, Float{}}},
+                      "mimium_biquad", "mimium_biquad_f32")},
+    {"svf_lp", initBI(Function{Float{}, {Float{}, Float{}, Float{}}}, "mimium_svf_lp",
+                      "mimium_svf_lp_f32")},
+    {"svf_bp", initBI(Function{Float{}, {Float{}, Float{}, Float{}}}, "mimium_svf_bp",
+                      "mimium_svf_bp_f32")},
+    {"svf_hp", initBI(Function{Float{}, {Float{}, Float{}, Float{}}}, "mimium_svf_hp",
+                      "mimium_svf_hp_f32")},
+    {"onepole",
+     initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_onepole", "mimium_onepole_f32")},
+    // oscillators with the phase in the memory object, see oscillators.hpp. freq is in cycles per
+    // sample.
+    {"osc_saw_blep", initBI(Function{Float{}, {Float{}}}, "mimium_osc_saw_blep",
+                            "mimium_osc_saw_blep_f32")},
+    {"osc_square_blep", initBI(Function{Float{}, {Float{}}}, "mimium_osc_square_blep",
+                               "mimium_osc_square_blep_f32")},
 
-    {"loadwavsize", initBI(Function{Float{}, {String{}}}, "libsndfile_loadwavsize")},
-    {"loadwav", initBI(Function{Array{Float{}, 0}, {String{}}}, "libsndfile_loadwav")},
+    // defined in runtime, they take the runtime instance as the first argument.
+    {"voiceon", initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_voiceon")},
+    {"voiceoff", initBI(Function{Void{}, {Float{}}}, "mimium_voiceoff")},
+    // sends (status, data1, data2) to the MIDI output, timed at the current sample.
+    {"midiout", initBI(Function{Void{}, {Float{}, Float{}, Float{}}}, "mimium_midiout")},
+    // slot of a parameter set by OSC messages to the address, and its current value.
+    {"oscparam", initBI(Function{Float{}, {String{}, Float{}}}, "mimium_oscparam")},
+    {"oscvalue", initBI(Function{Float{}, {Float{}}}, "mimium_oscvalue")},
+
+    {"loadwavsize", initBI(Function{Float{}, {String{}}}, "mimium_loadwavsize")},
+    {"loadwav",
+     initBI(Function{Array{Float{}, 0}, {String{}}}, "mimium_loadwav", "mimium_loadwav_f32")},
+    {"openstream", initBI(Function{Float{}, {String{}}}, "mimium_openstream")},
+    {"readstream", initBI(Function{Float{}, {Float{}}}, "mimium_readstream")},
+    {"streamchannel", initBI(Function{Float{}, {Float{}, Float{}}}, "mimium_streamchannel")},
+    // impulse response preprocessed for convolve at load time.
+    {"loadir",
+     initBI(Function{Array{Float{}, 0}, {String{}}}, "mimium_loadir", "mimium_loadir_f32")},
+    {"convolve", initBI(Function{Float{}, {Float{}, Array{Float{}, 0}}}, "mimium_convolve",
+                        "mimium_convolve_f32")},
+    // wavetable oscillators with the mipmaps in the runtime, see runtime/wavetable.hpp.
+    {"osc_saw", initBI(Function{Float{}, {Float{}}}, "mimium_osc_saw", "mimium_osc_saw_f32")},
+    {"osc_square",
+     initBI(Function{Float{}, {Float{}}}, "mimium_osc_square", "mimium_osc_square_f32")},
+    {"osc_tri", initBI(Function{Float{}, {Float{}}}, "mimium_osc_tri", "mimium_osc_tri_f32")},
+    // a cycle loaded from a file, of which the mipmap is made at load time.
+    {"loadwavetable", initBI(Function{Array{Float{}, 0}, {String{}}}, "mimium_loadwavetable",
+                             "mimium_loadwavetable_f32")},
+    {"osc_table", initBI(Function{Float{}, {Float{}, Array{Float{}, 0}}}, "mimium_osc_table",
+                         "mimium_osc_table_f32")},
 
     {"access_array_lin_interp",
      initBI(Function{Float{}, {Float{}, Float{}}}, "access_array_lin_interp")}
 
 };
 
+const std::unordered_set<std::string> LLVMBuiltin::pure_functions = {
+    "sin",     "cos",      "tan",     "asin",    "acos",    "atan",      "atan2",  "sinh",
+    "cosh",    "tanh",     "exp",     "pow",     "log",     "log10",     "sqrt",   "abs",
+    "ceil",    "floor",    "trunc",   "round",   "fmod",    "remainder", "min",    "max",
+    "ge",      "le",       "gt",      "lt",      "and",     "or",        "not",    "lshift",
+    "rshift",  "fastsin",  "fastcos", "fasttan", "fasttanh", "fastexp",  "fastlog", "fastpow"};
+
+const std::unordered_set<std::string> RuntimeEntry::functions = {"dsp", "voice", "spectral",
+                                                                 "midiin"};
+const std::unordered_set<std::string> RuntimeEntry::dsp_like_functions = {"dsp", "voice",
+                                                                          "spectral"};
+
+const std::unordered_set<std::string> LLVMBuiltin::runtime_functions = {
+    "voiceon",  "voiceoff",   "loadwav", "loadwavsize",   "openstream", "readstream",
+    "loadir",   "convolve",   "osc_saw", "osc_square",    "osc_tri",    "streamchannel",
+    "midiout",  "osc_table",  "oscparam", "loadwavetable", "oscvalue"};
+
+std::optional<types::Value> LLVMBuiltin::getMemobjType(std::string const& fname) {
+  if (fname == "delay") { return getDelayStruct(); }
+  if (fname == "mem" || fname == "random") { return Float{}; }
+  if (fname == "halfband_fir" || fname == "halfband_delay") { return getHalfbandStruct(); }
+  if (fname == "convolve") { return getConvolverStruct(); }
+  if (fname == "osc_table") { return getWavetableOscStruct(); }
+  if (fname == "osc_saw" || fname == "osc_square" || fname == "osc_tri" ||
+      fname == "osc_saw_blep" || fname == "osc_square_blep") {
+    return Float{};
+  }
+  switch (filters::getKind(fname)) {
+    case filters::Kind::Biquad: return getFilterStruct("MmmBiquad", 2);
+    case filters::Kind::Svf: return getFilterStruct("MmmSvf", 2);
+    case filters::Kind::OnePole: return getFilterStruct("MmmOnePole", 1);
+    case filters::Kind::None: break;
+  }
+  return std::nullopt;
+}
+
 }  // namespace mimium
\ No newline at end of file
@@ -5,8 +5,11 @@
 #pragma once
 #define LLVM_DISABLE_ABI_BREAKING_CHECKS_ENFORCING 1
 #include "export.hpp"
+#include <cstdint>
 #include <initializer_list>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
 
 // #include "compiler/runtime/mididriver.hpp"
 #include "basic/type.hpp"
@@ -16,15 +19,111 @@ namespace mimium {
 struct BuiltinFnInfo {
   types::Value mmmtype;
   std::string target_fnname;
+  // implementation used when Float is lowered to single precision. If empty, the double one is
+  // called with conversions of the arguments and the result.
+  std::string target_fnname_f32;
 };
 
-inline BuiltinFnInfo initBI(types::Function&& f, std::string&& s) {
-  return BuiltinFnInfo{std::move(f), std::move(s)};
+inline BuiltinFnInfo initBI(types::Function&& f, std::string&& s, std::string&& s_f32 = "") {
+  return BuiltinFnInfo{std::move(f), std::move(s), std::move(s_f32)};
 }
 
 struct MIMIUM_DLL_PUBLIC LLVMBuiltin {
   const static std::unordered_map<std::string, BuiltinFnInfo> ftable;
+  // builtins without side effects and internal states, which return the same value for the same
+  // arguments.
+  const static std::unordered_set<std::string> pure_functions;
+  static bool isPure(std::string const& fname) { return pure_functions.count(fname) > 0; }
   static bool isBuiltin(std::string fname) { return LLVMBuiltin::ftable.count(fname) > 0; }
+  // builtins which keep an internal state in a memory object of the returned type, passed by
+  // reference as the last argument. random has the state only in dsp-like functions.
+  static std::optional<types::Value> getMemobjType(std::string const& fname);
+  // builtins which take the runtime instance as the first argument.
+  const static std::unordered_set<std::string> runtime_functions;
+  static bool needsRuntime(std::string const& fname) { return runtime_functions.count(fname) > 0; }
 };
 
-}  // namespace mimium
\ No newline at end of file
+// functions defined in sources and called by the runtime, of which the names are kept by renaming.
+struct MIMIUM_DLL_PUBLIC RuntimeEntry {
+  const static std::unordered_set<std::string> functions;
+  // the entries called for each sample or frame, of which the memory objects are instantiated by
+  // the runtime. random has its state only in them and the functions called from them.
+  const static std::unordered_set<std::string> dsp_like_functions;
+  static bool isDspLike(std::string const& name) { return dsp_like_functions.count(name) > 0; }
+};
+
+// restarts the streams of random for reproducible results. The default seed is 0.
+MIMIUM_DLL_PUBLIC void setRandomSeed(uint64_t seed);
+
+// memory in which the states of random take their streams from their offsets, instead of the
+// order of the first calls, which varies when voices run on several threads.
+enum class RandomArena : uint64_t { Dsp = 0, Voice, Spectral };
+// if the memory is divided into objects of the stride, generations counts the reuses of each
+// object, so that a reused object takes new streams.
+MIMIUM_DLL_PUBLIC void registerRandomArena(const void* base, size_t size, RandomArena id,
+                                           size_t stride = 0,
+                                           const uint64_t* generations = nullptr);
+MIMIUM_DLL_PUBLIC void unregisterRandomArena(const void* base);
+}  // namespace mimium
+
+namespace mimium {
+// integer fields of the states below have the size of the sample, so that their layouts match the
+// memory object types, in which they are Float.
+template <typename T>
+using mmm_index_t = std::conditional_t<sizeof(T) == sizeof(int64_t), int64_t, int32_t>;
+}  // namespace mimium
+
+template <typename T>
+struct MmmRingBufT {
+  mimium::mmm_index_t<T> readi = 0;
+  mimium::mmm_index_t<T> writei = 0;
+  T buf[mimium::types::fixed_delaysize]{};
+};
+using MmmRingBuf = MmmRingBufT<double>;
+using MmmRingBufF32 = MmmRingBufT<float>;
+
+// state of the halfband filters which resample the arguments and the result of oversampled
+// functions.
+template <typename T>
+struct MmmHalfbandT {
+  mimium::mmm_index_t<T> pos = 0;
+  T buf[2 * mimium::types::halfband_sidetaps]{};
+};
+using MmmHalfband = MmmHalfbandT<double>;
+using MmmHalfbandF32 = MmmHalfbandT<float>;
+
+extern "C" {
+// polyphase branch of the halfband filter which has the nonzero odd taps.
+MIMIUM_DLL_PUBLIC double mimium_halfband_fir(double in, MmmHalfband* state);
+MIMIUM_DLL_PUBLIC float mimium_halfband_fir_f32(float in, MmmHalfbandF32* state);
+// the other branch, which is a pure delay of halfband_sidetaps-1 samples.
+MIMIUM_DLL_PUBLIC double mimium_halfband_delay(double in, MmmHalfband* state);
+MIMIUM_DLL_PUBLIC float mimium_halfband_delay_f32(float in, MmmHalfbandF32* state);
+// references of the inlined filters, of which the state variables are stride elements apart.
+MIMIUM_DLL_PUBLIC double mimium_biquad(double in, double b0, double b1, double b2, double a1,
+                                       double a2, double* state, int64_t stride);
+MIMIUM_DLL_PUBLIC float mimium_biquad_f32(float in, float b0, float b1, float b2, float a1,
+                                          float a2, float* state, int64_t stride);
+MIMIUM_DLL_PUBLIC double mimium_svf_lp(double in, double g, double k, double* state,
+                                       int64_t stride);
+MIMIUM_DLL_PUBLIC float mimium_svf_lp_f32(float in, float g, float k, float* state,
+                                          int64_t stride);
+MIMIUM_DLL_PUBLIC double mimium_svf_bp(double in, double g, double k, double* state,
+                                       int64_t stride);
+MIMIUM_DLL_PUBLIC float mimium_svf_bp_f32(float in, float g, float k, float* state,
+                                          int64_t stride);
+MIMIUM_DLL_PUBLIC double mimium_svf_hp(double in, double g, double k, double* state,
+                                       int64_t stride);
+MIMIUM_DLL_PUBLIC float mimium_svf_hp_f32(float in, float g, float k, float* state,
+                                          int64_t stride);
+// oscillators with polyBLEP, of which the state is the phase.
+MIMIUM_DLL_PUBLIC double mimium_osc_saw_blep(double freq, double* phase);
+MIMIUM_DLL_PUBLIC float mimium_osc_saw_blep_f32(float freq, float* phase);
+MIMIUM_DLL_PUBLIC double mimium_osc_square_blep(double freq, double* phase);
+MIMIUM_DLL_PUBLIC float mimium_osc_square_blep_f32(float freq, float* phase);
+// linear interpolation of array at a fractional index.
+MIMIUM_DLL_PUBLIC double access_array_lin_interp(double* array, double index_d);
+MIMIUM_DLL_PUBLIC float access_array_lin_interp_f32(float* array, float index_d);
+MIMIUM_DLL_PUBLIC double mimium_onepole(double in, double a, double* state, int64_t stride);
+MIMIUM_DLL_PUBLIC float mimium_onepole_f32(float in, float a, float* state, int64_t stride);
+}
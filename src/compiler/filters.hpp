@@ -0,0 +1,76 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+// Filters of `biquad`, `svf_lp`, `svf_bp`, `svf_hp` and `onepole`. Each instance keeps its state
+// variables in the memory object, stride elements apart. When a function calls filters of the
+// same kind more than once, their states are laid out as lanes of a bank, in which each state
+// variable is an array over the instances (see layoutMemobjTree), so that the SLP vectorizer can
+// process the instances together.
+namespace mimium::filters {
+
+enum class Kind { None, Biquad, Svf, OnePole };
+enum class SvfMode { Low, Band, High };
+
+inline Kind getKind(std::string_view fname) {
+  if (fname == "biquad") { return Kind::Biquad; }
+  if (fname == "svf_lp" || fname == "svf_bp" || fname == "svf_hp") { return Kind::Svf; }
+  if (fname == "onepole") { return Kind::OnePole; }
+  return Kind::None;
+}
+inline SvfMode getSvfMode(std::string_view fname) {
+  return fname == "svf_bp" ? SvfMode::Band : fname == "svf_hp" ? SvfMode::High : SvfMode::Low;
+}
+// number of the state variables.
+constexpr int getStateSize(Kind kind) { return kind == Kind::OnePole ? 1 : 2; }
+// number of the arguments including the input, without the state.
+constexpr int getNumArgs(Kind kind) {
+  switch (kind) {
+    case Kind::Biquad: return 6;
+    case Kind::Svf: return 3;
+    default: return 2;
+  }
+}
+
+// transposed direct form II, with a0 normalized to 1.
+template <typename T>
+T biquad(T in, T b0, T b1, T b2, T a1, T a2, T* state, int64_t stride) {
+  const T out = b0 * in + state[0];
+  state[0] = b1 * in - a1 * out + state[stride];
+  state[stride] = b2 * in - a2 * out;
+  return out;
+}
+
+// topology-preserving transform state variable filter. g is tan(pi*cutoff/samplerate) and k is
+// 1/Q, which can be computed outside of the audio rate.
+template <typename T>
+T svf(T in, T g, T k, T* state, int64_t stride, SvfMode mode) {
+  const T a1 = T(1) / (T(1) + g * (g + k));
+  const T a2 = g * a1;
+  const T a3 = g * a2;
+  const T v3 = in - state[stride];
+  const T v1 = a1 * state[0] + a2 * v3;
+  const T v2 = state[stride] + a2 * state[0] + a3 * v3;
+  state[0] = T(2) * v1 - state[0];
+  state[stride] = T(2) * v2 - state[stride];
+  switch (mode) {
+    case SvfMode::Low: return v2;
+    case SvfMode::Band: return v1;
+    case SvfMode::High: return in - k * v1 - v2;
+  }
+  return v2;
+}
+
+// lowpass which moves to the input by 1-a of the distance every sample.
+template <typename T>
+T onepole(T in, T a, T* state) {
+  const T out = in + a * (state[0] - in);
+  state[0] = out;
+  return out;
+}
+
+}  // namespace mimium::filters
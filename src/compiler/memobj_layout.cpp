@@ -0,0 +1,228 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/memobj_layout.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include "compiler/filters.hpp"
+
+namespace mimium {
+namespace {
+constexpr size_t pointer_size = 8;
+
+enum class FieldGroup { Self = 0, Scalar, Nested, Buffer };
+
+struct LayoutEntry {
+  int src;
+  size_t size;
+  size_t align;
+  FieldGroup group;
+  // index of the bank instead of src, or -1.
+  int bank = -1;
+};
+
+size_t alignTo(size_t offset, size_t align) { return (offset + align - 1) / align * align; }
+
+struct TypeLayout {
+  size_t size;
+  size_t align;
+};
+
+struct TypeLayoutVisitor {
+  size_t float_size;
+  TypeLayout operator()(types::Void const& /*t*/) { return {0, 1}; }
+  TypeLayout operator()(types::Float const& /*t*/) { return {float_size, float_size}; }
+  TypeLayout operator()(types::rArray const& t) {
+    auto elem = std::visit(*this, t.getraw().elem_type);
+    return {elem.size * t.getraw().size, elem.align};
+  }
+  TypeLayout operator()(types::rTuple const& t) { return layoutOf(t.getraw().arg_types); }
+  TypeLayout operator()(types::rStruct const& t) {
+    std::vector<types::Value> fields;
+    for (const auto& a : t.getraw().arg_types) { fields.emplace_back(a.val); }
+    return layoutOf(fields);
+  }
+  TypeLayout operator()(types::rAlias const& t) { return std::visit(*this, t.getraw().target); }
+  template <typename T>
+  TypeLayout operator()(T const& /*t*/) {
+    // other primitives and pointers
+    return {pointer_size, pointer_size};
+  }
+  TypeLayout layoutOf(std::vector<types::Value> const& v) {
+    size_t offset = 0;
+    size_t align = 1;
+    for (const auto& a : v) {
+      auto field = std::visit(*this, a);
+      offset = alignTo(offset, field.align) + field.size;
+      align = std::max(align, field.align);
+    }
+    return {alignTo(offset, align), align};
+  }
+};
+
+TypeLayout getTypeLayout(types::Value const& t, size_t float_size) {
+  return std::visit(TypeLayoutVisitor{float_size}, t);
+}
+
+types::Tuple& getObjTuple(FunObjTree& tree) {
+  return MemoryObjsCollector::CollectMemVisitor::getTupleFromAlias(tree.objtype);
+}
+
+std::string getTreeName(FunObjTree const& tree) { return mir::getName(*tree.fname); }
+
+filters::Kind getFilterKind(FunObjTree const& tree) {
+  const auto* ext = std::get_if<mir::ExternalSymbol>(tree.fname.get());
+  return ext != nullptr ? filters::getKind(ext->name) : filters::Kind::None;
+}
+
+FieldGroup getFieldGroup(size_t size, size_t float_size) {
+  return (size <= float_size)                ? FieldGroup::Scalar
+         : (size >= memobj_buffer_threshold) ? FieldGroup::Buffer
+                                             : FieldGroup::Nested;
+}
+
+}  // namespace
+
+size_t getMemobjByteSize(types::Value const& t, size_t float_size) {
+  return getTypeLayout(t, float_size).size;
+}
+
+std::vector<size_t> getMemobjFieldOffsets(std::vector<types::Value> const& fields,
+                                          size_t float_size) {
+  std::vector<size_t> res;
+  size_t offset = 0;
+  for (const auto& f : fields) {
+    auto layout = getTypeLayout(f, float_size);
+    offset = alignTo(offset, layout.align);
+    res.emplace_back(offset);
+    offset += layout.size;
+  }
+  return res;
+}
+
+void layoutMemobjTree(FunObjTree& tree, size_t float_size) {
+  auto& fields = getObjTuple(tree).arg_types;
+  const int nfields = static_cast<int>(fields.size());
+  const int selfindex = tree.hasself ? nfields - 1 : -1;
+  assert(static_cast<int>(tree.memobjs.size()) == nfields - (tree.hasself ? 1 : 0));
+
+  // members of the banks, by the kind of filter.
+  std::map<filters::Kind, std::vector<int>> members;
+  {
+    int i = 0;
+    for (auto const& o : tree.memobjs) {
+      auto kind = getFilterKind(*o);
+      if (kind != filters::Kind::None) { members[kind].emplace_back(i); }
+      i++;
+    }
+  }
+  std::vector<types::Value> banks;
+  std::vector<int> memobj_bank(tree.memobjs.size(), -1);
+  tree.memobj_lanes.assign(tree.memobjs.size(), -1);
+  for (auto const& [kind, srcs] : members) {
+    if (srcs.size() < 2) { continue; }
+    const auto numlanes = static_cast<int>(srcs.size());
+    for (int lane = 0; lane < numlanes; lane++) {
+      memobj_bank[srcs[lane]] = static_cast<int>(banks.size());
+      tree.memobj_lanes[srcs[lane]] = lane;
+    }
+    banks.emplace_back(types::getFilterBankStruct(filters::getStateSize(kind), numlanes));
+  }
+
+  std::vector<LayoutEntry> entries;
+  entries.reserve(nfields);
+  for (int i = 0; i < nfields; i++) {
+    if (i != selfindex && memobj_bank[i] >= 0) {
+      // the bank takes the place of its first member.
+      const int bank = memobj_bank[i];
+      if (tree.memobj_lanes[i] == 0) {
+        auto [size, align] = getTypeLayout(banks[bank], float_size);
+        entries.push_back({-1, size, align, getFieldGroup(size, float_size), bank});
+      }
+      continue;
+    }
+    auto [size, align] = getTypeLayout(fields[i], float_size);
+    auto group = (i == selfindex) ? FieldGroup::Self : getFieldGroup(size, float_size);
+    entries.push_back({i, size, align, group});
+  }
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](auto const& a, auto const& b) { return a.group < b.group; });
+
+  std::vector<types::Value> newfields;
+  newfields.reserve(nfields + entries.size());
+  tree.memobj_fields.assign(tree.memobjs.size(), -1);
+  tree.self_field = -1;
+  size_t offset = 0;
+  for (auto const& e : entries) {
+    offset = alignTo(offset, e.align);
+    if (e.group == FieldGroup::Buffer && offset % memobj_cacheline_size != 0) {
+      // every size and alignment is a multiple of the size of Float.
+      auto pad = memobj_cacheline_size - offset % memobj_cacheline_size;
+      newfields.emplace_back(types::Array{types::Float{}, static_cast<int>(pad / float_size)});
+      offset += pad;
+    }
+    const int index = static_cast<int>(newfields.size());
+    offset += e.size;
+    if (e.bank >= 0) {
+      newfields.emplace_back(banks[e.bank]);
+      for (size_t i = 0; i < memobj_bank.size(); i++) {
+        if (memobj_bank[i] == e.bank) { tree.memobj_fields[i] = index; }
+      }
+      continue;
+    }
+    newfields.emplace_back(fields[e.src]);
+    if (e.src == selfindex) {
+      tree.self_field = index;
+    } else {
+      tree.memobj_fields[e.src] = index;
+    }
+  }
+  fields = std::move(newfields);
+}
+
+void dumpMemobjLayout(std::ostream& out, funobjmap const& funobjs, size_t float_size) {
+  std::vector<std::shared_ptr<FunObjTree>> trees;
+  for (auto const& [fun, tree] : funobjs) {
+    if (mir::isInstA<minst::Function>(fun)) { trees.emplace_back(tree); }
+  }
+  std::sort(trees.begin(), trees.end(),
+            [](auto const& a, auto const& b) { return getTreeName(*a) < getTreeName(*b); });
+
+  for (auto const& tree : trees) {
+    auto& fields = getObjTuple(*tree).arg_types;
+    std::vector<std::string> names(fields.size(), "(padding)");
+    std::map<size_t, int> numlanes;
+    auto iter = tree->memobjs.begin();
+    for (size_t i = 0; i < tree->memobjs.size(); i++, ++iter) {
+      auto index = tree->memobj_fields.empty() ? i : tree->memobj_fields[i];
+      names[index] = getTreeName(**iter);
+      if (!tree->memobj_lanes.empty() && tree->memobj_lanes[i] >= 0) { numlanes[index]++; }
+    }
+    for (auto const& [index, n] : numlanes) { names[index] += " x" + std::to_string(n); }
+    if (tree->hasself) {
+      names[tree->self_field >= 0 ? tree->self_field : fields.size() - 1] = "self";
+    }
+    auto offsets = getMemobjFieldOffsets(fields, float_size);
+    const auto totalsize = getMemobjByteSize(tree->objtype, float_size);
+    size_t hotsize = 0;
+    std::ostringstream ss;
+    for (size_t i = 0; i < fields.size(); i++) {
+      auto size = getMemobjByteSize(fields[i], float_size);
+      if (size < memobj_buffer_threshold && names[i] != "(padding)") {
+        hotsize = offsets[i] + size;
+      }
+      ss << "  [" << i << "] offset " << std::setw(8) << offsets[i] << "  size " << std::setw(8)
+         << size << "  " << names[i] << "\n";
+    }
+    auto hotlines = (hotsize + memobj_cacheline_size - 1) / memobj_cacheline_size;
+    out << getTreeName(*tree) << ": " << totalsize << " bytes, hot " << hotsize << " bytes ("
+        << hotlines << " cache lines)\n"
+        << ss.str();
+  }
+}
+
+}  // namespace mimium
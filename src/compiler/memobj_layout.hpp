@@ -0,0 +1,32 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <iosfwd>
+#include "compiler/collect_memoryobjs.hpp"
+
+namespace mimium {
+
+constexpr size_t memobj_cacheline_size = 64;
+// memory objects at least this large are treated as buffers.
+constexpr size_t memobj_buffer_threshold = 4 * memobj_cacheline_size;
+
+// byte size of the type as laid out by codegen, where Float has float_size bytes, the size of
+// the sample, and the other primitives are pointers. Fields are aligned as in llvm structs.
+size_t getMemobjByteSize(types::Value const& t, size_t float_size = sizeof(double));
+// byte offset of each of the fields of a memory object.
+std::vector<size_t> getMemobjFieldOffsets(std::vector<types::Value> const& fields,
+                                          size_t float_size = sizeof(double));
+
+// Reorders fields of tree.objtype so that self and small scalars like mem come first, nested
+// objects next, and large buffers like delay last at cache-line aligned offsets.
+// Filters of the same kind called more than once share a field of a bank, in which each state
+// variable is an array over the calls, so that they can be vectorized together.
+// objtype must be the tuple of memobjs in order followed by self, as made by MemoryObjsCollector.
+void layoutMemobjTree(FunObjTree& tree, size_t float_size = sizeof(double));
+
+MIMIUM_DLL_PUBLIC void dumpMemobjLayout(std::ostream& out, funobjmap const& funobjs,
+                                        size_t float_size = sizeof(double));
+
+}  // namespace mimium
@@ -180,6 +180,7 @@ namespace mimium{
 %type <ast::Assign> assign "assign"
 // Syntax Sugar 
 %type <ast::Fdef> fdef "fdef"
+%type <ast::Rate> rate "rate of function"
 
 
 %type <ast::ExprPtr> cond "if condition"
@@ -434,12 +435,21 @@ arguments: declvar ',' arguments {$3.push_front(std::move($1));
          | declvar  {$$ = std::deque<ast::DeclVar>{std::move($1)};}
          | %empty {$$ = {};}
 
+rate: AT DIV NUM {$$ = ast::Rate{ast::Rate::Kind::Decimate, static_cast<int>($3)};}
+    | AT MUL NUM {$$ = ast::Rate{ast::Rate::Kind::Oversample, static_cast<int>($3)};}
+
 fdef: FUNC declvar arguments_top block {
       auto lambda = ast::Lambda{{@$,"lambda"} ,std::move($3),std::move($4),std::nullopt};
       $$ = ast::Fdef{{@$,"fdef"},std::move($2),lambda};}
       |FUNC declvar arguments_top ARROW types block {
       auto lambda = ast::Lambda{{@$,"lambda"} ,std::move($3),std::move($6),std::move($5)};
       $$ = ast::Fdef{{@$,"fdef"},std::move($2),lambda};}
+      |FUNC declvar arguments_top rate block {
+      auto lambda = ast::Lambda{{@$,"lambda"} ,std::move($3),std::move($5),std::nullopt,$4};
+      $$ = ast::Fdef{{@$,"fdef"},std::move($2),lambda};}
+      |FUNC declvar arguments_top ARROW types rate block {
+      auto lambda = ast::Lambda{{@$,"lambda"} ,std::move($3),std::move($7),std::move($5),$6};
+      $$ = ast::Fdef{{@$,"fdef"},std::move($2),lambda};}
 
 
 top:  statements opt_nl ENDFILE {driver.setTopAst(std::make_shared<ast::Statements>(std::move($1)));}
@@ -499,6 +509,7 @@ void
 MimiumParser::error( const location_type &l, const std::string &err_message )
 {
        std::stringstream ss;
-      ss  << err_message << " at " << l.begin.line <<  ":" << l.begin.col << " to " << l.end.line <<  ":" << l.end.col << "\n";
+      ss  << err_message << " at " << driver.formatLocation(l.begin.line, l.begin.col)
+          << " to " << driver.formatLocation(l.end.line, l.end.col) << "\n";
       mimium::Logger::debug_log(ss.str(),mimium::Logger::ERROR_);
 }
\ No newline at end of file
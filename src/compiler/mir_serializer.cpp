@@ -0,0 +1,643 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/mir_serializer.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include "basic/error_def.hpp"
+
+// Layout of the binary (all integers are LEB128 varints, doubles are raw host-order bytes):
+//   magic, version, precision (1 if Float is single precision)
+//   type table
+//   number of values, blocks, arguments and funobj trees
+//   kind of each value (variant index, plus instruction index for instructions)
+//   roots: toplevel block and the funobjmap entries
+//   sections: arguments, blocks, values, funobj trees (in id order)
+// References to values/blocks/arguments/trees are written as id + 1, 0 meaning null.
+
+namespace mimium {
+namespace {
+
+class BinaryWriter {
+ public:
+  explicit BinaryWriter(std::ostream& out) : out(out) {}
+  void writeUInt(uint64_t v) {
+    do {
+      auto byte = static_cast<uint8_t>(v & 0x7fU);
+      v >>= 7U;
+      if (v != 0) { byte |= 0x80U; }
+      out.put(static_cast<char>(byte));
+    } while (v != 0);
+  }
+  void writeInt(int64_t v) {
+    // zigzag encoding
+    writeUInt((static_cast<uint64_t>(v) << 1U) ^ static_cast<uint64_t>(v >> 63));
+  }
+  void writeDouble(double v) {
+    std::array<char, sizeof(double)> buf{};
+    std::memcpy(buf.data(), &v, sizeof(double));
+    out.write(buf.data(), buf.size());
+  }
+  void writeString(std::string_view s) {
+    writeUInt(s.size());
+    out.write(s.data(), static_cast<std::streamsize>(s.size()));
+  }
+  void writeRaw(std::string_view s) { out.write(s.data(), static_cast<std::streamsize>(s.size())); }
+
+ private:
+  std::ostream& out;
+};
+
+class BinaryReader {
+ public:
+  explicit BinaryReader(std::istream& in) : in(in) {
+    // the size is unknown if the stream is not seekable, and counts are checked only by max.
+    const auto start = in.tellg();
+    if (start != std::streampos(-1) && in.seekg(0, std::ios::end)) {
+      const auto end = in.tellg();
+      if (end != std::streampos(-1) && end >= start) {
+        remaining = static_cast<uint64_t>(end - start);
+      }
+    }
+    in.clear();
+    if (start != std::streampos(-1)) { in.seekg(start); }
+  }
+  uint64_t readUInt() {
+    uint64_t res = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      auto byte = static_cast<uint8_t>(readByte());
+      res |= static_cast<uint64_t>(byte & 0x7fU) << shift;
+      if ((byte & 0x80U) == 0) { return res; }
+    }
+    throw CompileError("Malformed MIR binary: integer overflow");
+  }
+  int64_t readInt() {
+    auto v = readUInt();
+    return static_cast<int64_t>(v >> 1U) ^ -static_cast<int64_t>(v & 1U);
+  }
+  double readDouble() {
+    std::array<char, sizeof(double)> buf{};
+    read(buf.data(), buf.size());
+    double res = 0.0;
+    std::memcpy(&res, buf.data(), sizeof(double));
+    return res;
+  }
+  // read in chunks, so that a malformed size fails at the end of the file before it allocates.
+  std::string readString() {
+    const size_t size = readCount(1);
+    std::string res;
+    std::array<char, 4096> buf{};
+    while (res.size() < size) {
+      const size_t len = std::min(buf.size(), size - res.size());
+      read(buf.data(), len);
+      res.append(buf.data(), len);
+    }
+    return res;
+  }
+  size_t readSize() {
+    auto size = readUInt();
+    if (size > max_elements) { throw CompileError("Malformed MIR binary: invalid size"); }
+    return static_cast<size_t>(size);
+  }
+  // number of elements each of which is encoded in min_bytes at least, checked against the rest
+  // of the file before the elements are allocated.
+  size_t readCount(uint64_t min_bytes) {
+    const auto size = readSize();
+    if (size * min_bytes > remaining) {
+      throw CompileError("Malformed MIR binary: size exceeds the end of file");
+    }
+    return size;
+  }
+  void read(char* dest, size_t size) {
+    in.read(dest, static_cast<std::streamsize>(size));
+    if (!in) { throw CompileError("Malformed MIR binary: unexpected end of file"); }
+    remaining -= std::min<uint64_t>(remaining, size);
+  }
+
+ private:
+  static constexpr uint64_t max_elements = 1ULL << 32U;
+  uint64_t remaining = std::numeric_limits<uint64_t>::max();
+  char readByte() {
+    char c = 0;
+    read(&c, 1);
+    return c;
+  }
+  std::istream& in;
+};
+
+// type table entries are encoded recursively by their variant index.
+void writeType(BinaryWriter& w, types::Value const& t) {
+  w.writeUInt(t.index());
+  std::visit(overloaded{[&](types::rRef const& r) { writeType(w, r.getraw().val); },
+                        [&](types::rPointer const& r) { writeType(w, r.getraw().val); },
+                        [&](types::rTypeVar const& r) { w.writeInt(r.getraw().index); },
+                        [&](types::rFunction const& r) {
+                          writeType(w, r.getraw().ret_type);
+                          w.writeUInt(r.getraw().arg_types.size());
+                          for (const auto& a : r.getraw().arg_types) { writeType(w, a); }
+                        },
+                        [&](types::rClosure const& r) {
+                          writeType(w, r.getraw().fun.val);
+                          writeType(w, r.getraw().captures);
+                        },
+                        [&](types::rArray const& r) {
+                          writeType(w, r.getraw().elem_type);
+                          w.writeInt(r.getraw().size);
+                        },
+                        [&](types::rStruct const& r) {
+                          w.writeUInt(r.getraw().arg_types.size());
+                          for (const auto& a : r.getraw().arg_types) {
+                            w.writeString(a.field);
+                            writeType(w, a.val);
+                          }
+                        },
+                        [&](types::rTuple const& r) {
+                          w.writeUInt(r.getraw().arg_types.size());
+                          for (const auto& a : r.getraw().arg_types) { writeType(w, a); }
+                        },
+                        [&](types::rAlias const& r) {
+                          w.writeString(r.getraw().name);
+                          writeType(w, r.getraw().target);
+                        },
+                        [](auto const& /*primitive*/) {}},
+             t);
+}
+
+// least bytes of the encoded entities, by which the counts read from a file are checked.
+constexpr uint64_t min_type_bytes = 1;    // tag
+constexpr uint64_t min_value_bytes = 1;   // kind
+constexpr uint64_t min_block_bytes = 4;   // parent, label, instructions, indent level
+constexpr uint64_t min_arg_bytes = 3;     // name, type, parent function
+constexpr uint64_t min_tree_bytes = 8;    // the fields of transfer(FunObjTree)
+constexpr uint64_t min_funobj_bytes = 2;  // key and tree
+constexpr uint64_t min_element_bytes = 1;
+
+types::Value readType(BinaryReader& r) {
+  auto readlist = [&r]() {
+    std::vector<types::Value> res(r.readCount(min_type_bytes), types::None{});
+    for (auto& a : res) { a = readType(r); }
+    return res;
+  };
+  switch (r.readUInt()) {
+    case 0: return types::None{};
+    case 1: return types::Void{};
+    case 2: return types::Float{};
+    case 3: return types::String{};
+    case 4: return types::Ref{readType(r)};
+    case 5: return types::TypeVar{static_cast<int>(r.readInt())};
+    case 6: return types::Pointer{readType(r)};
+    case 7: {
+      auto ret = readType(r);
+      return types::Function{std::move(ret), readlist()};
+    }
+    case 8: {
+      auto fun = readType(r);
+      auto captures = readType(r);
+      return types::Closure{types::Ref{std::move(fun)}, std::move(captures)};
+    }
+    case 9: {
+      auto elem = readType(r);
+      return types::Array{std::move(elem), static_cast<int>(r.readInt())};
+    }
+    case 10: {
+      types::Struct res;
+      // a field is its name and its type.
+      res.arg_types.resize(r.readCount(1 + min_type_bytes),
+                           types::Struct::Keytype{"", types::None{}});
+      for (auto& a : res.arg_types) {
+        a.field = r.readString();
+        a.val = readType(r);
+      }
+      return res;
+    }
+    case 11: return types::Tuple{readlist()};
+    case 12: {
+      auto name = r.readString();
+      return types::Alias{std::move(name), readType(r)};
+    }
+    default: throw CompileError("Malformed MIR binary: unknown type tag");
+  }
+}
+
+// Field lists shared by the writer and the reader archive.
+
+template <class Archive>
+void transfer(Archive& a, minst::Base& i) {
+  a(i.name);
+  a(i.type);
+  a(i.parent);
+}
+template <class Archive>
+void transfer(Archive& a, minst::Number& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.val);
+}
+template <class Archive>
+void transfer(Archive& a, minst::String& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.val);
+}
+template <class Archive>
+void transfer(Archive& a, minst::Allocate& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+}
+template <class Archive>
+void transfer(Archive& a, minst::Ref& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.target);
+}
+template <class Archive>
+void transfer(Archive& a, minst::Load& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.target);
+}
+template <class Archive>
+void transfer(Archive& a, minst::Store& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.target);
+  a(i.value);
+}
+template <class Archive>
+void transfer(Archive& a, minst::Op& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.op);
+  a(i.lhs);
+  a(i.rhs);
+}
+template <class Archive>
+void transfer(Archive& a, minst::Function& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.args.ret_ptr);
+  a(i.args.args);
+  a(i.body);
+  a(i.hasself);
+  a(i.isrecursive);
+  a(i.freevariables);
+  a(i.memory_objects);
+  a(i.ccflag);
+}
+template <class Archive>
+void transfer(Archive& a, minst::Fcall& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.fname);
+  a(i.args);
+  a(i.ftype);
+  a(i.time);
+}
+template <class Archive>
+void transfer(Archive& a, minst::MakeClosure& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.fname);
+  a(i.captures);
+}
+template <class Archive>
+void transfer(Archive& a, minst::Array& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.args);
+}
+template <class Archive>
+void transfer(Archive& a, minst::ArrayAccess& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.target);
+  a(i.index);
+}
+template <class Archive>
+void transfer(Archive& a, minst::Field& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.target);
+  a(i.index);
+}
+template <class Archive>
+void transfer(Archive& a, minst::If& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.cond);
+  a(i.thenblock);
+  a(i.elseblock);
+}
+template <class Archive>
+void transfer(Archive& a, minst::Return& i) {
+  transfer(a, static_cast<minst::Base&>(i));
+  a(i.val);
+}
+template <class Archive>
+void transfer(Archive& a, mir::Argument& i) {
+  a(i.name);
+  a(i.type);
+  a(i.parentfn);
+}
+template <class Archive>
+void transfer(Archive& a, mir::block& i) {
+  a(i.parent);
+  a(i.label);
+  a(i.instructions);
+  a(i.indent_level);
+}
+template <class Archive>
+void transfer(Archive& a, FunObjTree& i) {
+  a(i.fname);
+  a(i.hasself);
+  a(i.memobjs);
+  a(i.objtype);
+  a(i.memobj_fields);
+  a(i.self_field);
+  a(i.memobj_lanes);
+  a(i.random_has_state);
+}
+template <class Archive>
+void transfer(Archive& a, mir::Value& v) {
+  std::visit(overloaded{[&](mir::Instructions& inst) {
+                          std::visit([&](auto& i) { transfer(a, i); }, inst);
+                        },
+                        [&](mir::Constants& c) { a(c); },
+                        [&](mir::ExternalSymbol& s) {
+                          a(s.name);
+                          a(s.type);
+                        },
+                        [&](std::shared_ptr<mir::Argument>& arg) { a(arg); },
+                        [&](mir::Self& s) {
+                          a(s.fn);
+                          a(s.type);
+                        }},
+             v);
+}
+
+// Table of entities of one kind indexed by the order of the first appearance.
+template <class T>
+struct IdTable {
+  std::unordered_map<T const*, uint64_t> ids;
+  std::vector<std::shared_ptr<T>> entries;
+  size_t next = 0;
+  uint64_t getRef(std::shared_ptr<T> const& ptr) {
+    if (!ptr) { return 0; }
+    auto [iter, isnew] = ids.try_emplace(ptr.get(), entries.size());
+    if (isnew) { entries.emplace_back(ptr); }
+    return iter->second + 1;
+  }
+  bool hasPending() const { return next < entries.size(); }
+};
+
+class MirWriter {
+ public:
+  void write(std::ostream& out, MirBinary const& mir) {
+    BinaryWriter roots_w(roots);
+    roots_w.writeUInt(blocks.getRef(mir.toplevel));
+    roots_w.writeUInt(mir.funobjs.size());
+    for (const auto& [key, tree] : mir.funobjs) {
+      roots_w.writeUInt(values.getRef(key));
+      roots_w.writeUInt(trees.getRef(tree));
+    }
+    // writing contents may discover new entities, iterate until all of them are written.
+    while (args.hasPending() || blocks.hasPending() || values.hasPending() ||
+           trees.hasPending()) {
+      writePending(args, arg_buf);
+      writePending(blocks, block_buf);
+      writePending(values, value_buf);
+      writePending(trees, tree_buf);
+    }
+    BinaryWriter w(out);
+    w.writeRaw(mir_binary_magic);
+    w.writeUInt(mir_binary_version);
+    w.writeUInt(mir.float32 ? 1 : 0);
+    w.writeUInt(type_count);
+    w.writeRaw(type_buf.str());
+    w.writeUInt(values.entries.size());
+    w.writeUInt(blocks.entries.size());
+    w.writeUInt(args.entries.size());
+    w.writeUInt(trees.entries.size());
+    for (const auto& v : values.entries) {
+      w.writeUInt(v->index());
+      if (auto* inst = std::get_if<mir::Instructions>(v.get())) { w.writeUInt(inst->index()); }
+    }
+    w.writeRaw(roots.str());
+    w.writeRaw(arg_buf.str());
+    w.writeRaw(block_buf.str());
+    w.writeRaw(value_buf.str());
+    w.writeRaw(tree_buf.str());
+  }
+
+  // archive interface used by transfer()
+  void operator()(std::string& v) { cur->writeString(v); }
+  void operator()(double& v) { cur->writeDouble(v); }
+  void operator()(int& v) { cur->writeInt(v); }
+  void operator()(bool& v) { cur->writeUInt(v ? 1 : 0); }
+  template <class E>
+  std::enable_if_t<std::is_enum_v<E>> operator()(E& v) {
+    cur->writeInt(static_cast<int64_t>(v));
+  }
+  void operator()(types::Value& v) {
+    auto key = types::toString(v, true);
+    auto [iter, isnew] = type_ids.try_emplace(key, type_count);
+    if (isnew) {
+      BinaryWriter tw(type_buf);
+      writeType(tw, v);
+      ++type_count;
+    }
+    cur->writeUInt(iter->second);
+  }
+  void operator()(mir::Constants& v) {
+    cur->writeUInt(v.index());
+    std::visit(overloaded{[&](int i) { cur->writeInt(i); }, [&](double d) { cur->writeDouble(d); },
+                          [&](std::string& s) { cur->writeString(s); }},
+               v);
+  }
+  void operator()(mir::valueptr& v) { cur->writeUInt(values.getRef(v)); }
+  void operator()(mir::blockptr& v) { cur->writeUInt(blocks.getRef(v)); }
+  void operator()(std::shared_ptr<mir::Argument>& v) { cur->writeUInt(args.getRef(v)); }
+  void operator()(std::shared_ptr<FunObjTree>& v) { cur->writeUInt(trees.getRef(v)); }
+  template <class T>
+  void operator()(std::optional<T>& v) {
+    cur->writeUInt(v.has_value() ? 1 : 0);
+    if (v) { (*this)(v.value()); }
+  }
+  template <class T>
+  void operator()(std::list<T>& v) {
+    writeSequence(v);
+  }
+  template <class T>
+  void operator()(std::vector<T>& v) {
+    writeSequence(v);
+  }
+
+ private:
+  template <class T>
+  void writePending(IdTable<T>& table, std::ostringstream& buf) {
+    BinaryWriter w(buf);
+    cur = &w;
+    // entries may grow while iterating
+    for (; table.hasPending(); ++table.next) {
+      auto entry = table.entries[table.next];
+      transfer(*this, *entry);
+    }
+    cur = nullptr;
+  }
+  template <class C>
+  void writeSequence(C& c) {
+    cur->writeUInt(c.size());
+    for (auto& elem : c) { (*this)(elem); }
+  }
+  BinaryWriter* cur = nullptr;
+  IdTable<mir::Value> values;
+  IdTable<mir::block> blocks;
+  IdTable<mir::Argument> args;
+  IdTable<FunObjTree> trees;
+  std::unordered_map<std::string, uint64_t> type_ids;
+  uint64_t type_count = 0;
+  std::ostringstream type_buf;
+  std::ostringstream roots;
+  std::ostringstream arg_buf;
+  std::ostringstream block_buf;
+  std::ostringstream value_buf;
+  std::ostringstream tree_buf;
+};
+
+template <class Variant, size_t... I>
+Variant makeDefaultByIndex(size_t index, std::index_sequence<I...> /*unused*/) {
+  using ctor_t = Variant (*)();
+  static const std::array<ctor_t, sizeof...(I)> ctors = {
+      +[]() -> Variant { return std::variant_alternative_t<I, Variant>{}; }...};
+  if (index >= ctors.size()) { throw CompileError("Malformed MIR binary: unknown value kind"); }
+  return ctors[index]();
+}
+template <class Variant>
+Variant makeDefaultByIndex(size_t index) {
+  return makeDefaultByIndex<Variant>(index,
+                                     std::make_index_sequence<std::variant_size_v<Variant>>{});
+}
+
+class MirReader {
+ public:
+  MirReader(std::istream& in, bool float32) : r(in), float32(float32) {}
+  MirBinary read() {
+    std::string magic(mir_binary_magic.size(), '\0');
+    r.read(magic.data(), magic.size());
+    if (magic != mir_binary_magic) { throw CompileError("Not a mimium MIR binary"); }
+    auto version = r.readUInt();
+    if (version != mir_binary_version) {
+      throw CompileError("Unsupported MIR binary version: " + std::to_string(version));
+    }
+    // the layout of memory objects depends on the size of float.
+    if ((r.readUInt() != 0) != float32) {
+      throw CompileError(std::string("MIR binary was not compiled in ") +
+                         (float32 ? "float" : "double") + " precision");
+    }
+    typetable.resize(r.readCount(min_type_bytes), types::None{});
+    for (auto& t : typetable) { t = readType(r); }
+
+    values.resize(r.readCount(min_value_bytes));
+    blocks.resize(r.readCount(min_block_bytes));
+    args.resize(r.readCount(min_arg_bytes));
+    trees.resize(r.readCount(min_tree_bytes));
+    for (auto& v : values) {
+      auto kind = r.readUInt();
+      if (kind == 0) {
+        v = std::make_shared<mir::Value>(makeDefaultByIndex<mir::Instructions>(r.readUInt()));
+      } else {
+        v = std::make_shared<mir::Value>(makeDefaultByIndex<mir::Value>(kind));
+      }
+    }
+    for (auto& b : blocks) { b = std::make_shared<mir::block>(); }
+    for (auto& a : args) { a = std::make_shared<mir::Argument>(); }
+    for (auto& t : trees) { t = std::make_shared<FunObjTree>(); }
+
+    MirBinary res;
+    res.float32 = float32;
+    (*this)(res.toplevel);
+    auto mapsize = r.readCount(min_funobj_bytes);
+    for (size_t i = 0; i < mapsize; i++) {
+      mir::valueptr key;
+      std::shared_ptr<FunObjTree> tree;
+      (*this)(key);
+      (*this)(tree);
+      res.funobjs.emplace(key, tree);
+    }
+    for (auto& a : args) { transfer(*this, *a); }
+    for (auto& b : blocks) { transfer(*this, *b); }
+    for (auto& v : values) { transfer(*this, *v); }
+    for (auto& t : trees) { transfer(*this, *t); }
+    if (!res.toplevel) { throw CompileError("Malformed MIR binary: missing toplevel block"); }
+    return res;
+  }
+
+  // archive interface used by transfer()
+  void operator()(std::string& v) { v = r.readString(); }
+  void operator()(double& v) { v = r.readDouble(); }
+  void operator()(int& v) { v = static_cast<int>(r.readInt()); }
+  void operator()(bool& v) { v = r.readUInt() != 0; }
+  template <class E>
+  std::enable_if_t<std::is_enum_v<E>> operator()(E& v) {
+    v = static_cast<E>(r.readInt());
+  }
+  void operator()(types::Value& v) { v = getEntry(typetable, r.readUInt()); }
+  void operator()(mir::Constants& v) {
+    switch (r.readUInt()) {
+      case 0: v = static_cast<int>(r.readInt()); break;
+      case 1: v = r.readDouble(); break;
+      case 2: v = r.readString(); break;
+      default: throw CompileError("Malformed MIR binary: unknown constant kind");
+    }
+  }
+  void operator()(mir::valueptr& v) { v = getRef(values); }
+  void operator()(mir::blockptr& v) { v = getRef(blocks); }
+  void operator()(std::shared_ptr<mir::Argument>& v) { v = getRef(args); }
+  void operator()(std::shared_ptr<FunObjTree>& v) { v = getRef(trees); }
+  template <class T>
+  void operator()(std::optional<T>& v) {
+    v = std::nullopt;
+    if (r.readUInt() != 0) {
+      T tmp{};
+      (*this)(tmp);
+      v = std::move(tmp);
+    }
+  }
+  template <class T>
+  void operator()(std::list<T>& v) {
+    readSequence(v);
+  }
+  template <class T>
+  void operator()(std::vector<T>& v) {
+    readSequence(v);
+  }
+
+ private:
+  template <class T>
+  static T const& getEntry(std::vector<T> const& table, uint64_t index) {
+    if (index >= table.size()) { throw CompileError("Malformed MIR binary: invalid reference"); }
+    return table[index];
+  }
+  template <class T>
+  std::shared_ptr<T> getRef(std::vector<std::shared_ptr<T>> const& table) {
+    auto id = r.readUInt();
+    return id == 0 ? nullptr : getEntry(table, id - 1);
+  }
+  template <class C>
+  void readSequence(C& c) {
+    c.clear();
+    auto size = r.readCount(min_element_bytes);
+    for (size_t i = 0; i < size; i++) {
+      typename C::value_type tmp{};
+      (*this)(tmp);
+      c.emplace_back(std::move(tmp));
+    }
+  }
+  BinaryReader r;
+  bool float32;
+  std::vector<types::Value> typetable;
+  std::vector<mir::valueptr> values;
+  std::vector<mir::blockptr> blocks;
+  std::vector<std::shared_ptr<mir::Argument>> args;
+  std::vector<std::shared_ptr<FunObjTree>> trees;
+};
+
+}  // namespace
+
+void writeMirBinary(std::ostream& out, MirBinary const& mir) { MirWriter().write(out, mir); }
+
+MirBinary readMirBinary(std::istream& in, bool float32) { return MirReader(in, float32).read(); }
+
+}  // namespace mimium
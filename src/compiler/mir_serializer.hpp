@@ -0,0 +1,34 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include "basic/mir.hpp"
+#include "compiler/collect_memoryobjs.hpp"
+#include "export.hpp"
+
+namespace mimium {
+
+// Compact binary form of closure-converted MIR together with its memory object trees, so that
+// the frontend stages can be skipped and the result fed directly into LLVMGenerator.
+// Sharing between values, blocks and arguments is preserved through id tables, as codegen
+// relies on pointer identity of them.
+
+constexpr std::string_view mir_binary_magic = "MMMMIR";
+constexpr uint32_t mir_binary_version = 5;
+
+struct MirBinary {
+  mir::blockptr toplevel;
+  funobjmap funobjs;
+  // whether Float was compiled in single precision, on which the memory objects depend.
+  bool float32 = false;
+};
+
+MIMIUM_DLL_PUBLIC void writeMirBinary(std::ostream& out, MirBinary const& mir);
+// throws CompileError if the file is malformed or was compiled in the other precision.
+MIMIUM_DLL_PUBLIC MirBinary readMirBinary(std::istream& in, bool float32);
+
+}  // namespace mimium
@@ -135,6 +135,7 @@ mir::valueptr ExprKnormVisitor::operator()(ast::Lambda& ast) {
   auto& fref = mir::getInstRef<minst::Function>(resptr);
 
   for (auto& a : fref.args.args) { a->parentfn = resptr; }
+  fref.rate = ast.rate;
 
   fref.body = body;
 
@@ -0,0 +1,239 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "compiler/multirate.hpp"
+#include <algorithm>
+#include "compiler/ffi.hpp"
+
+namespace mimium {
+namespace {
+
+// visits instructions in the block and in blocks of nested ifs, but not of nested functions.
+template <typename F>
+void walkFunctionBlock(mir::blockptr block, F&& fn) {
+  for (auto& inst : block->instructions) {
+    fn(block, inst);
+    if (mir::isInstA<minst::If>(inst)) {
+      auto& ifinst = mir::getInstRef<minst::If>(inst);
+      walkFunctionBlock(ifinst.thenblock, fn);
+      if (ifinst.elseblock.has_value()) { walkFunctionBlock(ifinst.elseblock.value(), fn); }
+    }
+  }
+}
+
+void collectRatedFunctions(mir::blockptr block, std::vector<mir::valueptr>& res) {
+  for (auto& inst : block->instructions) {
+    if (mir::isInstA<minst::Function>(inst)) {
+      auto& f = mir::getInstRef<minst::Function>(inst);
+      collectRatedFunctions(f.body, res);
+      if (f.rate.has_value()) { res.emplace_back(inst); }
+    }
+    if (mir::isInstA<minst::If>(inst)) {
+      auto& ifinst = mir::getInstRef<minst::If>(inst);
+      collectRatedFunctions(ifinst.thenblock, res);
+      if (ifinst.elseblock.has_value()) { collectRatedFunctions(ifinst.elseblock.value(), res); }
+    }
+  }
+}
+
+void insertBefore(mir::valueptr inst, mir::valueptr pos) {
+  auto block = mir::getParent(std::get<mir::Instructions>(*pos));
+  auto& insts = block->instructions;
+  std::visit([&](auto& i) { i.parent = block; }, std::get<mir::Instructions>(*inst));
+  insts.insert(std::find(insts.begin(), insts.end(), pos), inst);
+}
+
+mir::valueptr makeFunction(std::string const& name, types::Value const& type, int indent,
+                           mir::FnArgs&& args) {
+  auto res = std::make_shared<mir::Value>(minst::Function{{name, type}, std::move(args)});
+  auto& f = mir::getInstRef<minst::Function>(res);
+  f.body = mir::makeBlock(name, indent);
+  f.body->parent = res;
+  return res;
+}
+
+mir::valueptr makeNumber(std::string const& name, double val, mir::blockptr block) {
+  return mir::addInstToBlock(minst::Number{{name, types::Float{}}, val}, block);
+}
+
+mir::valueptr makeOp(std::string const& name, ast::OpId op, mir::valueptr lhs, mir::valueptr rhs,
+                     mir::blockptr block) {
+  return mir::addInstToBlock(minst::Op{{name, types::Float{}}, op, lhs, rhs}, block);
+}
+
+mir::valueptr makeCall(std::string const& name, mir::valueptr fn, std::list<mir::valueptr> args,
+                       mir::blockptr block) {
+  auto kind = std::holds_alternative<mir::ExternalSymbol>(*fn) ? EXTERNAL : CLOSURE;
+  return mir::addInstToBlock(
+      minst::Fcall{{name, types::Float{}}, fn, std::move(args), kind, std::nullopt}, block);
+}
+
+mir::valueptr makeSelf(mir::valueptr fn) {
+  return std::make_shared<mir::Value>(mir::Self{fn, types::Float{}});
+}
+
+}  // namespace
+
+int MultirateExpander::process(mir::blockptr toplevel) {
+  std::vector<mir::valueptr> fns;
+  collectRatedFunctions(toplevel, fns);
+  int count = 0;
+  for (auto& fn : fns) {
+    auto& f = mir::getInstRef<minst::Function>(fn);
+    auto rate = f.rate.value();
+    f.rate = std::nullopt;
+    if (rate.factor < 1) {
+      throw std::runtime_error("rate factor of function " + f.name + " must be positive");
+    }
+    if (rate.factor == 1) { continue; }
+    if (f.isrecursive) {
+      throw std::runtime_error("recursive function " + f.name + " cannot have explicit rate");
+    }
+    const auto& ret_type = rv::get<types::Function>(f.type).ret_type;
+    if (f.args.ret_ptr.has_value() || !std::holds_alternative<types::Float>(ret_type)) {
+      throw std::runtime_error("function " + f.name +
+                               " with explicit rate must return a float value");
+    }
+    auto inner = moveToInner(fn);
+    if (rate.kind == ast::Rate::Kind::Decimate) {
+      makeDecimator(fn, inner, rate.factor);
+    } else {
+      if (rate.factor != 2) {
+        throw std::runtime_error("function " + f.name + ": only 2x oversampling is supported");
+      }
+      makeOversampler(fn, inner);
+    }
+    count++;
+  }
+  return count;
+}
+
+mir::valueptr MultirateExpander::moveToInner(mir::valueptr fn) {
+  auto& f = mir::getInstRef<minst::Function>(fn);
+  auto inner = std::make_shared<mir::Value>(minst::Function{{f.name + ".inner", f.type}, f.args});
+  auto& innerf = mir::getInstRef<minst::Function>(inner);
+  innerf.body = f.body;
+  for (auto& a : innerf.args.args) { a->parentfn = inner; }
+  walkFunctionBlock(innerf.body, [&](mir::blockptr block, mir::valueptr inst) {
+    block->parent = inner;
+    mir::forEachOperand(inst, [&](mir::valueptr& v) {
+      auto* self = std::get_if<mir::Self>(v.get());
+      if (self != nullptr && self->fn == fn) { self->fn = inner; }
+    });
+  });
+  // blocks without instructions are not visited above.
+  innerf.body->parent = inner;
+  innerf.body->label = innerf.name;
+  insertBefore(inner, fn);
+
+  std::list<std::shared_ptr<mir::Argument>> newargs;
+  for (auto& a : innerf.args.args) {
+    newargs.emplace_back(std::make_shared<mir::Argument>(mir::Argument{a->name, a->type, fn}));
+  }
+  f.args.args = std::move(newargs);
+  f.body = mir::makeBlock(f.name, innerf.body->indent_level);
+  f.body->parent = fn;
+  return inner;
+}
+
+mir::valueptr MultirateExpander::makeCounter(mir::valueptr fn, int factor) {
+  // counts down from factor-1 to 0 repeatedly, starting at the first sample.
+  auto const& name = mir::getName(*fn);
+  auto counter = makeFunction(name + ".counter", types::Function{types::Float{}, {}},
+                              mir::getInstRef<minst::Function>(fn).body->indent_level, {});
+  auto body = mir::getInstRef<minst::Function>(counter).body;
+  auto k = makeNumber(name + ".k", factor - 1, body);
+  auto sum = makeOp(name + ".sum", ast::OpId::Add, makeSelf(counter), k, body);
+  auto n = makeNumber(name + ".n", factor, body);
+  auto phase = makeOp(name + ".phase", ast::OpId::Mod, sum, n, body);
+  mir::addInstToBlock(minst::Return{{name + ".ret", types::Float{}}, phase}, body);
+  insertBefore(counter, fn);
+  return counter;
+}
+
+void MultirateExpander::makeDecimator(mir::valueptr fn, mir::valueptr inner, int factor) {
+  auto counter = makeCounter(fn, factor);
+  auto& f = mir::getInstRef<minst::Function>(fn);
+  auto body = f.body;
+  auto phase = makeCall(f.name + ".phase", counter, {}, body);
+  auto threshold = makeNumber(f.name + ".th", factor - 1.5, body);
+  auto cond = makeOp(f.name + ".cond", ast::OpId::Sub, phase, threshold, body);
+
+  auto thenblock = mir::makeBlock(f.name + "$then", body->indent_level + 1);
+  thenblock->parent = fn;
+  std::list<mir::valueptr> args;
+  for (auto& a : f.args.args) { args.emplace_back(std::make_shared<mir::Value>(a)); }
+  auto val = makeCall(f.name + ".val", inner, std::move(args), thenblock);
+  mir::addInstToBlock(minst::Return{{f.name + ".newval", types::Float{}}, val}, thenblock);
+
+  // holds the previous result. self cannot be returned directly.
+  auto elseblock = mir::makeBlock(f.name + "$else", body->indent_level + 1);
+  elseblock->parent = fn;
+  auto zero = makeNumber(f.name + ".zero", 0.0, elseblock);
+  auto held = makeOp(f.name + ".held", ast::OpId::Add, makeSelf(fn), zero, elseblock);
+  mir::addInstToBlock(minst::Return{{f.name + ".oldval", types::Float{}}, held}, elseblock);
+
+  auto res = mir::addInstToBlock(
+      minst::If{{f.name + ".res", types::Float{}}, cond, thenblock, elseblock}, body);
+  mir::addInstToBlock(minst::Return{{f.name + ".ret", types::Float{}}, res}, body);
+}
+
+void MultirateExpander::makeOversampler(mir::valueptr fn, mir::valueptr inner) {
+  auto& f = mir::getInstRef<minst::Function>(fn);
+  walkFunctionBlock(mir::getInstRef<minst::Function>(inner).body,
+                    [&](mir::blockptr /*block*/, mir::valueptr inst) {
+                      mir::forEachOperand(inst, [&](mir::valueptr& v) {
+                        if (std::holds_alternative<mir::Self>(*v)) {
+                          throw std::runtime_error("oversampled function " + f.name +
+                                                   " cannot use self");
+                        }
+                      });
+                      if (!mir::isInstA<minst::Fcall>(inst)) { return; }
+                      auto* ext = std::get_if<mir::ExternalSymbol>(
+                          mir::getInstRef<minst::Fcall>(inst).fname.get());
+                      if (ext == nullptr || !LLVMBuiltin::isPure(ext->name)) {
+                        throw std::runtime_error("oversampled function " + f.name +
+                                                 " can call only stateless builtin functions");
+                      }
+                    });
+  auto body = f.body;
+  auto fir = getBuiltin("halfband_fir");
+  auto delay = getBuiltin("halfband_delay");
+  // polyphase interpolation: the even phase is the filtered branch, the odd one is delayed.
+  std::list<mir::valueptr> evenargs;
+  std::list<mir::valueptr> oddargs;
+  for (auto& a : f.args.args) {
+    if (!std::holds_alternative<types::Float>(a->type)) {
+      throw std::runtime_error("arguments of oversampled function " + f.name +
+                               " must be float values");
+    }
+    auto arg = std::make_shared<mir::Value>(a);
+    auto filtered = makeCall(a->name + ".fir", fir, {arg}, body);
+    auto two = makeNumber(a->name + ".gain", 2.0, body);
+    evenargs.emplace_back(makeOp(a->name + ".even", ast::OpId::Mul, two, filtered, body));
+    oddargs.emplace_back(makeCall(a->name + ".odd", delay, {arg}, body));
+  }
+  auto even = makeCall(f.name + ".even", inner, std::move(evenargs), body);
+  auto odd = makeCall(f.name + ".odd", inner, std::move(oddargs), body);
+  // polyphase decimation with the same filter, of which center tap 0.5 meets the odd phase one
+  // sample later than the last tap of the even phase.
+  auto side = makeCall(f.name + ".side", fir, {even}, body);
+  auto delayed = makeCall(f.name + ".delayed", delay, {odd}, body);
+  auto aligned = makeCall(f.name + ".aligned", getBuiltin("mem"), {delayed}, body);
+  auto half = makeNumber(f.name + ".half", 0.5, body);
+  auto center = makeOp(f.name + ".center", ast::OpId::Mul, half, aligned, body);
+  auto res = makeOp(f.name + ".res", ast::OpId::Add, side, center, body);
+  mir::addInstToBlock(minst::Return{{f.name + ".ret", types::Float{}}, res}, body);
+}
+
+mir::valueptr MultirateExpander::getBuiltin(std::string const& name) {
+  auto [iter, isnew] = builtins.try_emplace(name, nullptr);
+  if (isnew) {
+    auto const& type = LLVMBuiltin::ftable.at(name).mmmtype;
+    iter->second = std::make_shared<mir::Value>(mir::ExternalSymbol{name, type});
+  }
+  return iter->second;
+}
+
+}  // namespace mimium
@@ -0,0 +1,39 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <unordered_map>
+#include "basic/mir.hpp"
+#include "export.hpp"
+
+namespace mimium {
+namespace minst = mir::instruction;
+
+// Expands functions declared with an explicit rate into resampling code around their body.
+// The body is moved into a new function `<name>.inner`, and the original function becomes a
+// wrapper which keeps its callers unchanged.
+//  - `fn f(x) @/N {...}` runs the body once every N samples and holds the result in between.
+//    The body may have internal states, which then advance at the decimated rate.
+//  - `fn f(x) @*2 {...}` runs the body twice per sample on the arguments interpolated by
+//    polyphase halfband filters, and decimates the results with the same filter. The latency is
+//    2*halfband_sidetaps-1 samples. The body must not have internal states, since both calls
+//    belong to one stream at the doubled rate.
+// Runs on MIR before closure conversion.
+class MIMIUM_DLL_PUBLIC MultirateExpander {
+ public:
+  // returns the number of expanded functions.
+  int process(mir::blockptr toplevel);
+
+ private:
+  // moves body and arguments of fn into a new function inserted before fn.
+  mir::valueptr moveToInner(mir::valueptr fn);
+  mir::valueptr makeCounter(mir::valueptr fn, int factor);
+  void makeDecimator(mir::valueptr fn, mir::valueptr inner, int factor);
+  void makeOversampler(mir::valueptr fn, mir::valueptr inner);
+  mir::valueptr getBuiltin(std::string const& name);
+
+  std::unordered_map<std::string, mir::valueptr> builtins;
+};
+
+}  // namespace mimium
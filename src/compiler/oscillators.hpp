@@ -0,0 +1,55 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cmath>
+
+// Oscillators of which the state in the memory object is the phase in [0,1). The frequency is
+// given in cycles per sample, i.e. divided by the sample rate. The wavetable oscillators are in
+// runtime/wavetable.hpp.
+namespace mimium::osc {
+
+// returns the current phase and moves it by freq.
+template <typename T>
+T advancePhase(T freq, T* phase) {
+  const T res = *phase;
+  const T next = res + freq;
+  *phase = next - std::floor(next);
+  return res;
+}
+
+// polynomial approximation of the band-limited step minus the naive step at phase 0, spread over
+// one sample on both sides.
+template <typename T>
+T polyblep(T t, T dt) {
+  if (t < dt) {
+    t /= dt;
+    return t + t - t * t - T(1);
+  }
+  if (t > T(1) - dt) {
+    t = (t - T(1)) / dt;
+    return t * t + t + t + T(1);
+  }
+  return T(0);
+}
+
+// 2*phase-1 with the step at phase 0 smoothed.
+template <typename T>
+T sawBlep(T freq, T* state) {
+  const T dt = std::abs(freq);
+  const T t = advancePhase(freq, state);
+  return T(2) * t - T(1) - polyblep(t, dt);
+}
+
+// 1 in the first half and -1 in the second, with the both steps smoothed.
+template <typename T>
+T squareBlep(T freq, T* state) {
+  const T dt = std::abs(freq);
+  const T t = advancePhase(freq, state);
+  const T half = t + T(0.5);
+  const T naive = t < T(0.5) ? T(1) : T(-1);
+  return naive + polyblep(t, dt) - polyblep(half - std::floor(half), dt);
+}
+
+}  // namespace mimium::osc
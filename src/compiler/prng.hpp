@@ -0,0 +1,73 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+// Pseudo random number generator of `random()`. The state is a counter incremented by an odd
+// constant (Weyl sequence) and the output is its hash (SplitMix64 for double, lowbias32 for
+// float), so that it is cheap enough to be inlined into dsp functions.
+// In dsp-like functions and functions called from them, each call of `random()` has its own state
+// in the memory object. The state is 0 until the first call, which takes the seed of the stream
+// for its address from mimium_random_seed. Elsewhere it uses a state shared in the process.
+namespace mimium::prng {
+
+template <typename T>
+using state_t = std::conditional_t<std::is_same_v<T, float>, uint32_t, uint64_t>;
+
+constexpr uint64_t increment_u64 = 0x9E3779B97F4A7C15ULL;
+constexpr uint32_t increment_u32 = 0x9E3779B9U;
+template <typename T>
+constexpr state_t<T> getIncrement() {
+  return std::is_same_v<T, float> ? increment_u32 : increment_u64;
+}
+
+constexpr uint64_t mix(uint64_t z) {
+  z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31U);
+}
+constexpr uint32_t mix(uint32_t z) {
+  z = (z ^ (z >> 16U)) * 0x7FEB352DU;
+  z = (z ^ (z >> 15U)) * 0x846CA68BU;
+  return z ^ (z >> 16U);
+}
+
+// number of the significant bits of the result, and their scale to map them to [-1, 1).
+template <typename T>
+constexpr unsigned getResultBits() {
+  return std::is_same_v<T, float> ? 24 : 53;
+}
+template <typename T>
+constexpr T getResultScale() {
+  return static_cast<T>(2.0) / static_cast<T>(state_t<T>(1) << getResultBits<T>());
+}
+
+template <typename T>
+T toFloat(state_t<T> z) {
+  constexpr unsigned shift = sizeof(state_t<T>) * 8 - getResultBits<T>();
+  return static_cast<T>(z >> shift) * getResultScale<T>() - static_cast<T>(1.0);
+}
+
+// the next value in [-1, 1).
+template <typename T>
+T next(state_t<T>& state) {
+  state += getIncrement<T>();
+  return toFloat<T>(mix(state));
+}
+
+// initial state of the n-th stream for a seed, which is never 0.
+constexpr uint64_t getStreamSeed(uint64_t seed, uint64_t n) {
+  auto res = mix(seed + (n + 1) * increment_u64);
+  return res == 0 ? 1 : res;
+}
+
+// index of the stream for the state at the offset in a registered memory. The generation counts
+// the reuses of the memory.
+constexpr uint64_t getStreamIndex(uint64_t arena, uint64_t offset, uint64_t generation) {
+  return mix(mix(arena + 1) ^ offset) + generation;
+}
+
+}  // namespace mimium::prng
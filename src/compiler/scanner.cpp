@@ -3,6 +3,8 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "scanner.hpp"
+#include <algorithm>
+#include <cstring>
 namespace mimium {
 
 MimiumScanner::MimiumScanner(std::istream& in)
@@ -14,4 +16,24 @@ MimiumScanner::MimiumScanner(std::istream& in)
   yy_flex_debug = 1;
 #endif
 };
-}  // namespace mimium
\ No newline at end of file
+MimiumScanner::MimiumScanner(std::string_view buffer)
+    : yyFlexLexer(std::cin, std::cout),
+      loc(std::make_unique<MimiumParser::location_type>()),
+      yylval(nullptr),
+      input_buffer(buffer) {
+#ifdef MIMIUM_PARSER_DEBUG
+  yy_flex_debug = 1;
+#endif
+}
+
+// flex refills its buffer through this. When scanning from memory, copy the next chunk straight
+// from the source instead of going through std::istream.
+int MimiumScanner::LexerInput(char* buf, int max_size) {
+  if (!input_buffer) { return yyFlexLexer::LexerInput(buf, max_size); }
+  auto& rest = input_buffer.value();
+  auto size = std::min(rest.size(), static_cast<size_t>(max_size));
+  std::memcpy(buf, rest.data(), size);
+  rest.remove_prefix(size);
+  return static_cast<int>(size);
+}
+}  // namespace mimium
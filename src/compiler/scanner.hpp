@@ -4,6 +4,8 @@
 
 #pragma once
 #include <iostream>
+#include <optional>
+#include <string_view>
 
 #if !defined(yyFlexLexerOnce)
 #include "FlexLexer.h"
@@ -16,10 +18,13 @@ class MimiumParser;
 class MimiumScanner : public yyFlexLexer {
  public:
   explicit MimiumScanner(std::istream& in);
+  // scan directly from memory. The buffer must outlive the scanner.
+  explicit MimiumScanner(std::string_view buffer);
   ~MimiumScanner() override = default;
 
   virtual int yylex(MimiumParser::semantic_type* lval, MimiumParser::location_type* location);
   void LexerError(const char* msg) override { throw std::runtime_error(msg); }
+  int LexerInput(char* buf, int max_size) override;
 
   // YY_DECL defined in mc_lexer.l
   // Method body created by flex in mc_lexer.yy.cc
@@ -27,6 +32,7 @@ class MimiumScanner : public yyFlexLexer {
   /* yyval ptr */
   MimiumParser::semantic_type* yylval;
   std::shared_ptr<MimiumParser::location_type> loc;
+  std::optional<std::string_view> input_buffer = std::nullopt;
 };
 
 }  // namespace mimium
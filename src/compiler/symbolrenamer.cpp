@@ -3,12 +3,13 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "compiler/symbolrenamer.hpp"
+#include "compiler/ffi.hpp"
 namespace mimium {
 
 // new alphaconverter
 SymbolRenamer::SymbolRenamer() : SymbolRenamer(std::make_shared<RenameEnvironment>()) {}
 SymbolRenamer::SymbolRenamer(std::shared_ptr<RenameEnvironment> env) : env(std::move(env)) {
-  this->env->rename_map.emplace("dsp", "dsp");
+  for (auto const& name : RuntimeEntry::functions) { this->env->rename_map.emplace(name, name); }
 }
 
 AstPtr SymbolRenamer::rename(ast::Statements& ast) {
@@ -70,7 +71,8 @@ ast::Lambda ExprRenameVisitor::renameLambda(ast::Lambda& ast) {
   auto newargsast = renameLambdaArgs(ast.args);
   auto newbody = renamer.renameBlock(ast.body);
   renamer.env = renamer.env->parent_env;
-  return ast::Lambda{{{ast.debuginfo}}, std::move(newargsast), std::move(newbody), ast.ret_type};
+  return ast::Lambda{{{ast.debuginfo}}, std::move(newargsast), std::move(newbody), ast.ret_type,
+                     ast.rate};
 }
 
 ast::ExprPtr ExprRenameVisitor::operator()(ast::Lambda& ast) {
@@ -36,7 +36,7 @@ types::Value ExprTypeVisitor::operator()(ast::Lambda& ast) {
   auto rettype = (*this)(ast.body);
   auto uni_rettype = inferer.unify(rettype_tv, rettype);
   inferer.selftype_stack.pop();
-  return types::Function{uni_rettype, argtypes};
+  return inferer.typeenv.intern(types::Function{uni_rettype, argtypes});
 }
 
 types::Value TypeInferer::inferFcall(ast::Fcall& fcall) {
@@ -45,6 +45,7 @@ types::Value TypeInferer::inferFcall(ast::Fcall& fcall) {
   std::transform(args.begin(), args.end(), std::back_inserter(argtypes),
                  [&](ast::ExprPtr expr) { return exprvisitor.infer(expr); });
   auto frettype = *typeenv.createNewTypeVar();
+  // not interned: fresh return typevar makes it unique anyway.
   types::Value ftype = types::Function{frettype, argtypes};
   types::Value targettype = exprvisitor.infer(fcall.fn);
   auto res = unify(targettype, ftype);
@@ -79,7 +80,7 @@ types::Value ExprTypeVisitor::operator()(ast::ArrayInit& ast) {
   types::Value atype = std::accumulate(
       ast.args.begin(), ast.args.end(), types::Value(*inferer.typeenv.createNewTypeVar()),
       [&](types::Value v, ast::ExprPtr e) { return inferer.unify(v, std::visit(*this, *e)); });
-  return types::Array{std::move(atype), static_cast<int>(ast.args.size())};
+  return inferer.typeenv.intern(types::Array{std::move(atype), static_cast<int>(ast.args.size())});
 }
 types::Value ExprTypeVisitor::operator()(ast::ArrayAccess& ast) {
   inferer.unify(std::visit(*this, *ast.index), types::Value(types::Float{}));
@@ -97,7 +98,7 @@ types::Value ExprTypeVisitor::operator()(ast::Tuple& ast) {
   // Todo(tomoya)
   types::Tuple res{};
   for (auto& a : ast.args) { res.arg_types.emplace_back(inferer.inferExpr(a)); }
-  return res;
+  return inferer.typeenv.intern(res);
 }
 
 types::Value ExprTypeVisitor::operator()(ast::Block& ast) {
@@ -183,76 +184,70 @@ types::Value TypeInferer::addDeclVar(ast::DeclVar& lvar) {
 }
 
 types::Value TypeUnifyVisitor::unify(types::rTypeVar t1, types::rTypeVar t2) {
-  types::Value res = t1;
-  auto i1 = t1.getraw().index;
-  auto i2 = t2.getraw().index;
-  auto& t1_point = inferer.typeenv.tv_container[i1];
-  auto& t2_point = inferer.typeenv.tv_container[i2];
-  bool t1contain = !std::holds_alternative<types::rTypeVar>(t1_point);
-  bool t2contain = !std::holds_alternative<types::rTypeVar>(t2_point);
-  if (i1 != i2) {
-    if (!t1contain && !t2contain) {
-      if (i1 > i2) {
-        t1_point = t2_point;
-        res = t2_point;
-      } else if (i1 < i2) {
-        t2_point = t1_point;
-        res = t1_point;
-      }
-    } else {
-      res = inferer.unify(t1_point, t2_point);
+  auto& env = inferer.typeenv;
+  auto r1 = env.findRoot(t1.getraw().index);
+  auto r2 = env.findRoot(t2.getraw().index);
+  if (r1 == r2) { return env.tv_container[r1]; }
+  types::Value b1 = env.tv_container[r1];
+  types::Value b2 = env.tv_container[r2];
+  bool t1contain = env.isBound(r1);
+  bool t2contain = env.isBound(r2);
+  types::Value res = t1contain ? b1 : b2;
+  if (t1contain && t2contain) {
+    res = inferer.unify(b1, b2);
+  } else if (t1contain != t2contain) {
+    auto& unbound = rv::get<types::TypeVar>(t1contain ? b2 : b1);
+    if (std::visit(OccurChecker{unbound, &env}, res)) {
+      throw std::runtime_error("type loop detected");
     }
   }
+  auto root = env.unionTypeVar(r1, r2);
+  if (t1contain || t2contain) {
+    env.tv_container[root] = t1contain ? b1 : b2;
+  } else {
+    res = env.tv_container[root];
+  }
   return res;
 }
 
 types::Value TypeUnifyVisitor::unify(types::rPointer p1, types::rPointer p2) {
-  auto lhs = p1.getraw().val;
-  auto rhs = p2.getraw().val;
-  auto target = inferer.unify(std::move(lhs), std::move(rhs));
-  return types::Pointer{target};
+  auto target = inferer.unify(p1.getraw().val, p2.getraw().val);
+  return inferer.typeenv.intern(types::Pointer{target});
 }
 types::Value TypeUnifyVisitor::unify(types::rRef p1, types::rRef p2) {
   auto target = inferer.unify(p1.getraw().val, p2.getraw().val);
-  return types::Ref{target};
+  return inferer.typeenv.intern(types::Ref{target});
 }
 types::Value TypeUnifyVisitor::unify(types::rAlias a1, types::rAlias a2) {
   return inferer.unify(a1.getraw().target, a2.getraw().target);
-  ;
 }
 types::Value TypeUnifyVisitor::unify(types::rFunction f1, types::rFunction f2) {
   auto argtype = unifyArgs(f1.getraw().arg_types, f2.getraw().arg_types);
   auto rettype = inferer.unify(f1.getraw().ret_type, f2.getraw().ret_type);
-  return types::Function{std::move(rettype), std::move(argtype)};
+  return inferer.typeenv.intern(types::Function{std::move(rettype), std::move(argtype)});
 }
 
 types::Value TypeUnifyVisitor::unify(types::rArray a1, types::rArray a2) {
-  auto lhs = a1.getraw().elem_type;
-  auto rhs = a2.getraw().elem_type;
-  auto elemtype = inferer.unify(std::move(lhs), std::move(rhs));
+  auto elemtype = inferer.unify(a1.getraw().elem_type, a2.getraw().elem_type);
   // size check?
-  return types::Array{elemtype, a1.getraw().size};
+  return inferer.typeenv.intern(types::Array{elemtype, a1.getraw().size});
 }
 types::Value TypeUnifyVisitor::unify(types::rStruct s1, types::rStruct s2) {
   // TODO(tomoya)
   return s1;
 }
 types::Value TypeUnifyVisitor::unify(types::rTuple t1, types::rTuple t2) {
-  auto lhs = t1.getraw();
-  auto rhs = t2.getraw();
-  return types::Tuple{unifyArgs(lhs.arg_types, rhs.arg_types)};
+  auto argtypes = unifyArgs(t1.getraw().arg_types, t2.getraw().arg_types);
+  return inferer.typeenv.intern(types::Tuple{std::move(argtypes)});
 }
-std::vector<types::Value> TypeUnifyVisitor::unifyArgs(std::vector<types::Value>& v1,
-                                                      std::vector<types::Value>& v2) {
-  std::vector<types::Value> res;
+std::vector<types::Value> TypeUnifyVisitor::unifyArgs(std::vector<types::Value> const& v1,
+                                                      std::vector<types::Value> const& v2) {
   if (v1.size() != v2.size()) {
     throw std::runtime_error("type mismatch: argument size are different");
   }
-  for (int i = 0; i < v1.size(); i++) {
-    auto lhs = v1.at(i);
-    auto rhs = v2.at(i);
-    res.emplace_back(inferer.unify(lhs, rhs));  // discard return values
-  }
+  std::vector<types::Value> res;
+  res.reserve(v1.size());
+  for (size_t i = 0; i < v1.size(); i++) { res.emplace_back(inferer.unify(v1[i], v2[i])); }
   return res;
 }
 
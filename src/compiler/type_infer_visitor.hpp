@@ -13,14 +13,19 @@
 namespace mimium {
 struct OccurChecker {
   types::TypeVar& tv;
-  explicit OccurChecker(types::TypeVar& target) : tv(target) {}
+  // if env is given, type variables in the same class are also regarded as occurrence.
+  TypeEnv* env = nullptr;
+  explicit OccurChecker(types::TypeVar& target, TypeEnv* env = nullptr) : tv(target), env(env) {}
   bool operator()(const types::Function& t) const {
     return std::visit(*this, t.ret_type) || checkArgs(t.arg_types);
   }
   bool operator()(const types::Array& t) const { return std::visit(*this, t.elem_type); }
   bool operator()(const types::Struct& t) const { return checkArgs(t.arg_types); }
   bool operator()(const types::Tuple& t) const { return checkArgs(t.arg_types); };
-  bool operator()(const types::TypeVar& t) const { return (t.index == tv.index); }
+  bool operator()(const types::TypeVar& t) const {
+    return (env != nullptr) ? env->findRoot(t.index) == env->findRoot(tv.index)
+                            : (t.index == tv.index);
+  }
   template <typename T>
   bool operator()(const Box<T>& t) const {
     return (*this)(static_cast<T const&>(t));
@@ -108,17 +113,15 @@ struct TypeInferer {
     // // typevar unifying
     template <typename T>
     types::Value unify(T t1, types::rTypeVar t2) {
-      types::Value res = t1;
-      auto& t2_real = inferer.typeenv.findTypeVar(t2.getraw().index);
-      if (!std::holds_alternative<types::rTypeVar>(t2_real)) {
-        res = inferer.unify(t2_real, types::Value(t1));
-      } else {
-        if (OccurChecker{rv::get<types::TypeVar>(t2_real)}(t1)) {
-          throw std::runtime_error("type loop detected");
-        }
-        inferer.typeenv.tv_container[rv::get<types::TypeVar>(t2_real).index] = t1;
+      auto& env = inferer.typeenv;
+      auto root = env.findRoot(t2.getraw().index);
+      if (env.isBound(root)) {
+        types::Value bound = env.tv_container[root];
+        return inferer.unify(bound, types::Value(t1));
       }
-      return res;
+      if (OccurChecker{t2.getraw(), &env}(t1)) { throw std::runtime_error("type loop detected"); }
+      env.tv_container[root] = t1;
+      return t1;
     }
     template <typename T>
     types::Value unify(types::rTypeVar t1, T t2) {
@@ -159,14 +162,15 @@ struct TypeInferer {
       if constexpr (issame || istv_l || istv_r) { return unify(t1, t2); }
       throw std::runtime_error("type mismatch");
     }
-    std::vector<types::Value> unifyArgs(std::vector<types::Value>& v1,
-                                        std::vector<types::Value>& v2);
+    std::vector<types::Value> unifyArgs(std::vector<types::Value> const& v1,
+                                        std::vector<types::Value> const& v2);
   };
   struct SubstituteVisitor {
     explicit SubstituteVisitor(TypeInferer& parent) : inferer(parent) {}
     types::Value operator()(types::TypeVar& t) {
-      auto& target = inferer.typeenv.findTypeVar(t.index);
-      if (std::visit(OccurChecker{t}, target)) {
+      auto& env = inferer.typeenv;
+      types::Value target = env.findTypeVar(t.index);
+      if (!env.isBound(t.index) || std::visit(OccurChecker{t, &env}, target)) {
         Logger::debug_log("type loop detected. decuced into float type.", Logger::WARNING);
         return types::Float{};
       }
@@ -176,7 +180,7 @@ struct TypeInferer {
         throw std::runtime_error("failed to replace typevar. decuced into float type.");
         return types::Float{};
       }
-      return std::visit(*this, target);
+      return contained;
     }
     types::Value operator()(types::Float& t) { return t; }
     types::Value operator()(types::String& t) { return t; }
@@ -257,7 +261,9 @@ struct TypeInferer {
   types::Value inferFcall(ast::Fcall& fcall);
   types::Value inferIf(ast::If& ast);
 
-  types::Value unify(types::Value lhs, types::Value rhs) {
+  types::Value unify(types::Value const& lhs, types::Value const& rhs) {
+    // hash-consed types sharing the storage need no further unification.
+    if (types::isIdentical(lhs, rhs)) { return lhs; }
     return std::visit(unifyvisitor, lhs, rhs);
   }
 
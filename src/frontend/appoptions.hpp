@@ -14,6 +14,7 @@ enum class CompileStage {
   MirEmit,
   ClosureConvert,
   MemobjCollect,
+  MemobjLayout,
   Codegen,
   Run
 };
@@ -30,14 +31,49 @@ enum class BackEnd { Invalid = -1, API, Test, RtAudio };
 
 enum class OptimizeLevel { ON, OFF };
 
+// precision of Float in compiled code and of the audio device buffers.
+enum class Precision { Invalid = -1, Double = 0, Float };
+
 struct CompileOption {
   CompileStage stage = CompileStage::Run;
+  Precision precision = Precision::Double;
+  bool fast_math = false;
 };
 
 struct RuntimeOption {
   ExecutionEngine engine = ExecutionEngine::LLVM;
   BackEnd backend = BackEnd::RtAudio;
   OptimizeLevel optimize_level;
+  // number of module partitions compiled in parallel by JIT. 0 means a single module.
+  unsigned jit_threads = 0;
+  // number of instances of voice function.
+  int num_voices = 16;
+  // number of threads evaluating voices in parallel. 0 or 1 means the audio thread only.
+  int dsp_threads = 0;
+  // frames read from files opened by openstream before they are played.
+  int64_t stream_preload = 1 << 15;
+  Precision device_precision = Precision::Double;
+  // vector math library which vectorized loops may call: none, accelerate, svml, massv, libmvec.
+  std::string veclib = "none";
+  // seed of random, which gives the same sequences for the same seed.
+  uint64_t random_seed = 0;
+  // analysis of spectral function. hop must not be bigger than the size.
+  int stft_size = 1024;
+  int stft_hop = 256;
+  // window of spectral function: hann, hamming, blackman, rect.
+  std::string stft_window = "hann";
+  // port of MIDI input calling midiin function, a number or "virtual". Empty opens no input.
+  std::string midi_in;
+  // port of MIDI output which midiout sends to, in the same form as midi_in.
+  std::string midi_out;
+  // UDP port of localhost for OSC messages to oscparam. 0 opens no port.
+  int osc_port = 0;
+  // seconds of audio rendered offline by --bench instead of playing. 0 plays on the device.
+  double bench_seconds = 0;
+  int bench_samplerate = 48000;
+  int bench_framesize = 256;
+  // prints the result of --bench as JSON instead of text.
+  bool bench_json = false;
 };
 struct AppOption {
   CompileOption compile_option;
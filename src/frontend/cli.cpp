@@ -9,11 +9,16 @@ namespace {
 
 using ak = mimium::app::cli::ArgKind;
 
+// more threads than partitions worth compiling in parallel only add overhead.
+constexpr int max_jit_threads = 64;
+
 const std::unordered_map<std::string_view, ak> str_to_argkind = {
     {"--emit-ast", ak::EmitAst},
     {"--emit-ast-u", ak::EmitAstUniqueSymbol},
     {"--emit-mir", ak::EmitMir},
     {"--emit-mir-cc", ak::EmitMirClosureCoverted},
+    {"--emit-mir-bin", ak::EmitMirBinary},
+    {"--emit-memobj-layout", ak::EmitMemobjLayout},
     {"--emit-llvm", ak::EmitLLVMIR},
     {"--verbose", ak::Verbose},
     {"--version", ak::ShowVersion},
@@ -22,6 +27,24 @@ const std::unordered_map<std::string_view, ak> str_to_argkind = {
     {"-o", ak::Output},
     {"--output", ak::Output},
     {"--optimize", ak::OptimizeLevel},
+    {"--jit-threads", ak::JitThreads},
+    {"--voices", ak::Voices},
+    {"--dsp-threads", ak::DspThreads},
+    {"--stream-preload", ak::StreamPreload},
+    {"--precision", ak::Precision},
+    {"--fast-math", ak::FastMath},
+    {"--veclib", ak::VecLib},
+    {"--seed", ak::Seed},
+    {"--stft-size", ak::StftSize},
+    {"--stft-hop", ak::StftHop},
+    {"--stft-window", ak::StftWindow},
+    {"--midi-in", ak::MidiIn},
+    {"--midi-out", ak::MidiOut},
+    {"--osc-port", ak::OscPort},
+    {"--bench", ak::Bench},
+    {"--bench-rate", ak::BenchRate},
+    {"--bench-block", ak::BenchBlock},
+    {"--bench-json", ak::BenchJson},
     {"--backend", ak::BackEnd},
     {"--engine", ak::ExecutionEngine},
 };
@@ -40,7 +63,11 @@ bool isArgPaired(ArgKind arg) {
     case ak::EmitAstUniqueSymbol:
     case ak::EmitMir:
     case ak::EmitMirClosureCoverted:
+    case ak::EmitMirBinary:
+    case ak::EmitMemobjLayout:
     case ak::EmitLLVMIR:
+    case ak::FastMath:
+    case ak::BenchJson:
     case ak::Verbose: return false;
     default: return true;
   }
@@ -57,6 +84,24 @@ Options:
 
   -o|--output [*.mmmast,*.mmmmir,*.ll] - Specify output filename.
   --optimize  [0,1(default)]           - Set Optimization Level.
+  --jit-threads [0(default),N]         - Split module and compile it with N threads.
+  --voices    [16(default),N]          - Set number of voices for voice function.
+  --dsp-threads [0(default),N]         - Process voices in parallel with N threads.
+  --stream-preload [32768(default),N]  - Read N frames of streamed files before playback.
+  --precision [double(default),float]  - Set precision of Float values and audio buffers.
+  --fast-math                          - Use inline approximations of sin,cos,tan,exp,log,pow,tanh.
+  --veclib    [none(default),svml,...] - Let vectorized loops call a vector math library.
+  --seed      [0(default),N]           - Set seed of random for reproducible output.
+  --stft-size [1024(default),N]        - Set FFT size of spectral function.
+  --stft-hop  [256(default),N]         - Set hop size of spectral function.
+  --stft-window [hann(default),...]    - Set window of spectral function: hamming,blackman,rect.
+  --midi-in   [N,virtual]              - Open MIDI input port N for midiin function.
+  --midi-out  [N,virtual]              - Open MIDI output port N for midiout.
+  --osc-port  [N]                      - Receive OSC for oscparam on UDP port N of localhost.
+  --bench     [seconds]                - Render offline without a device and report the speed.
+  --bench-rate [48000(default),N]      - Set sample rate of --bench.
+  --bench-block [256(default),N]       - Set block size of --bench.
+  --bench-json                         - Print the report of --bench as JSON.
   --engine    [llvm(default)]          - Set execution engine.
   --backend   [rtaudio(default)]       - Set Audio Backend.
   --version                            - Print a version number to stdout.
@@ -71,6 +116,8 @@ Debug Informations (if no output file specified, emit to stdout.)
   --emit-types  - emit type information for all variables
   --emit-mir    - emit MIR
   --emit-mir-cc - emit MIR after closure convertsion
+  --emit-mir-bin - emit binary MIR(.mmmmir) which can be run directly
+  --emit-memobj-layout - emit byte layout of memory objects per function
   --emit-llvm   - emit LLVM IR
 )";
   }
@@ -90,12 +137,142 @@ void CliApp::OptionParser::processArgs(ArgKind arg, std::string_view val) {
     case ak::Output: result.output_path = val; break;
     case ak::BackEnd: result.runtime_option.backend = getBackEnd(val); break;
     case ak::ExecutionEngine: result.runtime_option.engine = getExecutionEngine(val); break;
+    case ak::JitThreads: {
+      int threads = 0;
+      try {
+        threads = std::stoi(std::string(val));
+      } catch (std::logic_error& e) {
+        throw CliAppError("--jit-threads expects a number of threads: " + std::string(val));
+      }
+      if (threads < 0 || threads > max_jit_threads) {
+        throw CliAppError("--jit-threads expects a number from 0 to " +
+                          std::to_string(max_jit_threads) + ": " + std::string(val));
+      }
+      result.runtime_option.jit_threads = static_cast<unsigned>(threads);
+      break;
+    }
+    case ak::Voices:
+      try {
+        result.runtime_option.num_voices = std::stoi(std::string(val));
+      } catch (std::logic_error& e) {
+        throw CliAppError("--voices expects a number of voices: " + std::string(val));
+      }
+      if (result.runtime_option.num_voices <= 0) {
+        throw CliAppError("--voices expects a positive number: " + std::string(val));
+      }
+      break;
+    case ak::DspThreads:
+      try {
+        result.runtime_option.dsp_threads = std::stoi(std::string(val));
+      } catch (std::logic_error& e) {
+        throw CliAppError("--dsp-threads expects a number of threads: " + std::string(val));
+      }
+      if (result.runtime_option.dsp_threads < 0) {
+        throw CliAppError("--dsp-threads expects a non-negative number: " + std::string(val));
+      }
+      break;
+    case ak::StreamPreload:
+      try {
+        result.runtime_option.stream_preload = std::stoll(std::string(val));
+      } catch (std::logic_error& e) {
+        throw CliAppError("--stream-preload expects a number of frames: " + std::string(val));
+      }
+      if (result.runtime_option.stream_preload < 0) {
+        throw CliAppError("--stream-preload expects a non-negative number: " + std::string(val));
+      }
+      break;
+    case ak::Precision: {
+      auto precision = getPrecision(val);
+      if (precision == Precision::Invalid) {
+        throw CliAppError("--precision expects double or float: " + std::string(val));
+      }
+      result.compile_option.precision = precision;
+      result.runtime_option.device_precision = precision;
+    } break;
+    case ak::FastMath: result.compile_option.fast_math = true; break;
+    case ak::VecLib: result.runtime_option.veclib = val; break;
+    case ak::Seed:
+      try {
+        result.runtime_option.random_seed = std::stoull(std::string(val));
+      } catch (std::logic_error& e) {
+        throw CliAppError("--seed expects a non-negative integer: " + std::string(val));
+      }
+      break;
+    case ak::StftSize: {
+      auto& size = result.runtime_option.stft_size;
+      try {
+        size = std::stoi(std::string(val));
+      } catch (std::logic_error& e) {
+        throw CliAppError("--stft-size expects a number of samples: " + std::string(val));
+      }
+      if (size < 2 || (size & (size - 1)) != 0) {
+        throw CliAppError("--stft-size expects a power of 2: " + std::string(val));
+      }
+    } break;
+    case ak::StftHop:
+      try {
+        result.runtime_option.stft_hop = std::stoi(std::string(val));
+      } catch (std::logic_error& e) {
+        throw CliAppError("--stft-hop expects a number of samples: " + std::string(val));
+      }
+      if (result.runtime_option.stft_hop <= 0) {
+        throw CliAppError("--stft-hop expects a positive number: " + std::string(val));
+      }
+      break;
+    case ak::StftWindow: result.runtime_option.stft_window = val; break;
+    case ak::MidiIn:
+    case ak::MidiOut: {
+      const bool isin = arg == ak::MidiIn;
+      if (val != "virtual" && val.find_first_not_of("0123456789") != std::string_view::npos) {
+        throw CliAppError(std::string(isin ? "--midi-in" : "--midi-out") +
+                          " expects a port number or virtual: " + std::string(val));
+      }
+      (isin ? result.runtime_option.midi_in : result.runtime_option.midi_out) = val;
+    } break;
+    case ak::OscPort: {
+      auto& port = result.runtime_option.osc_port;
+      try {
+        port = std::stoi(std::string(val));
+      } catch (std::logic_error& e) {
+        throw CliAppError("--osc-port expects a port number: " + std::string(val));
+      }
+      if (port <= 0 || port > 65535) {
+        throw CliAppError("--osc-port expects a port number: " + std::string(val));
+      }
+    } break;
+    case ak::Bench: {
+      auto& seconds = result.runtime_option.bench_seconds;
+      try {
+        seconds = std::stod(std::string(val));
+      } catch (std::logic_error& e) {
+        throw CliAppError("--bench expects a number of seconds: " + std::string(val));
+      }
+      if (!(seconds > 0)) {
+        throw CliAppError("--bench expects a positive number: " + std::string(val));
+      }
+    } break;
+    case ak::BenchRate:
+    case ak::BenchBlock: {
+      const bool israte = arg == ak::BenchRate;
+      auto& num = israte ? result.runtime_option.bench_samplerate
+                         : result.runtime_option.bench_framesize;
+      const std::string name = israte ? "--bench-rate" : "--bench-block";
+      try {
+        num = std::stoi(std::string(val));
+      } catch (std::logic_error& e) {
+        throw CliAppError(name + " expects a number: " + std::string(val));
+      }
+      if (num <= 0) { throw CliAppError(name + " expects a positive number: " + std::string(val)); }
+    } break;
+    case ak::BenchJson: result.runtime_option.bench_json = true; break;
     case ak::EmitAst: result.compile_option.stage = CompileStage::Parse; break;
     case ak::EmitAstUniqueSymbol: result.compile_option.stage = CompileStage::SymbolRename; break;
     case ak::EmitMir: result.compile_option.stage = CompileStage::MirEmit; break;
     case ak::EmitMirClosureCoverted:
       result.compile_option.stage = CompileStage::ClosureConvert;
       break;
+    case ak::EmitMirBinary: result.compile_option.stage = CompileStage::MemobjCollect; break;
+    case ak::EmitMemobjLayout: result.compile_option.stage = CompileStage::MemobjLayout; break;
     case ak::EmitLLVMIR: result.compile_option.stage = CompileStage::Codegen; break;
     case ak::ShowVersion: res_mode = CliAppMode::ShowVersion; return;
     case ak::ShowHelp: res_mode = CliAppMode::ShowHelp; return;
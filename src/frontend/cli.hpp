@@ -24,8 +24,28 @@ enum class ArgKind {
   EmitAstUniqueSymbol,
   EmitMir,
   EmitMirClosureCoverted,
+  EmitMirBinary,
+  EmitMemobjLayout,
   EmitLLVMIR,
   OptimizeLevel,
+  JitThreads,
+  Voices,
+  DspThreads,
+  StreamPreload,
+  Precision,
+  FastMath,
+  VecLib,
+  Seed,
+  StftSize,
+  StftHop,
+  StftWindow,
+  MidiIn,
+  MidiOut,
+  OscPort,
+  Bench,
+  BenchRate,
+  BenchBlock,
+  BenchJson,
   ShowVersion,
   ShowHelp,
   Verbose,
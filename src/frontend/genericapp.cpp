@@ -3,8 +3,12 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "genericapp.hpp"
+#include <chrono>
+#include <iomanip>
 #include "compiler/codegen/llvm_header.hpp"
 #include "basic/ast_to_string.hpp"
+#include "basic/error_def.hpp"
+#include "preprocessor/preprocessor.hpp"
 
 namespace {
 const std::string_view about_message =
@@ -25,6 +29,35 @@ const std::unordered_map<std::string_view, mimium::app::BackEnd> str_to_backend
     {"test", mimium::app::BackEnd::Test},
 };
 
+const std::unordered_map<std::string_view, mimium::app::Precision> str_to_precision = {
+    {"double", mimium::app::Precision::Double},
+    {"float", mimium::app::Precision::Float},
+};
+
+double getSecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string escapeJson(std::string const& str) {
+  constexpr std::string_view hex = "0123456789abcdef";
+  std::string res;
+  for (char c : str) {
+    const auto code = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      res += '\\';
+      res += c;
+    } else if (code < 0x20) {
+      // control characters are not allowed in strings of JSON.
+      res += "\\u00";
+      res += hex[code >> 4U];
+      res += hex[code & 0xFU];
+    } else {
+      res += c;
+    }
+  }
+  return res;
+}
+
 }  // namespace
 
 namespace mimium::app {
@@ -35,6 +68,42 @@ ExecutionEngine getExecutionEngine(std::string_view val) {
 
 BackEnd getBackEnd(std::string_view val) { return getEnumByStr(str_to_backend, val); }
 
+Precision getPrecision(std::string_view val) { return getEnumByStr(str_to_precision, val); }
+
+std::optional<unsigned int> getMidiPort(std::string const& val) {
+  if (val == "virtual") { return std::nullopt; }
+  return static_cast<unsigned int>(std::stoul(val));
+}
+
+std::ostream& printBenchReport(std::ostream& out, BenchReport const& report, bool json) {
+  const auto flags = out.flags();
+  out << std::fixed << std::setprecision(3);
+  if (json) {
+    out << "{\"source\": \"" << escapeJson(report.source) << "\", "
+        << "\"samplerate\": " << report.samplerate << ", "
+        << "\"framesize\": " << report.framesize << ", "
+        << "\"frames\": " << report.frames << ", "
+        << "\"compile_ms\": " << report.compile_seconds * 1e3 << ", "
+        << "\"jit_ms\": " << report.jit_seconds * 1e3 << ", "
+        << "\"process_ms\": " << report.process_seconds * 1e3 << ", "
+        << "\"ns_per_sample\": " << report.getNsPerSample() << ", "
+        << "\"realtime_factor\": " << report.getRealtimeFactor() << ", "
+        << "\"memobj_bytes\": " << report.memobj_bytes << "}" << std::endl;
+  } else {
+    out << "source          : " << report.source << "\n"
+        << "rendered        : " << report.frames << " samples at " << report.samplerate
+        << " Hz, block " << report.framesize << "\n"
+        << "compile         : " << report.compile_seconds * 1e3 << " ms\n"
+        << "jit and main    : " << report.jit_seconds * 1e3 << " ms\n"
+        << "process         : " << report.process_seconds * 1e3 << " ms\n"
+        << "ns/sample       : " << report.getNsPerSample() << "\n"
+        << "realtime factor : " << report.getRealtimeFactor() << "\n"
+        << "memory objects  : " << report.memobj_bytes << " bytes" << std::endl;
+  }
+  out.flags(flags);
+  return out;
+}
+
 GenericApp::GenericApp(std::unique_ptr<AppOption> option) : option(std::move(option)) {}
 
 std::ostream& GenericApp::printAbout(std::ostream& out) {
@@ -56,27 +125,47 @@ volatile std::sig_atomic_t GenericApp::signal_status = 0;  // NOLINT
 
 void GenericApp::handleSignal(int signal) { GenericApp::signal_status = signal; }
 
+std::unique_ptr<Compiler> GenericApp::makeCompiler(const CompileOption& option) {
+  auto compiler = std::make_unique<Compiler>();
+  compiler->setFloat32(option.precision == Precision::Float);
+  compiler->setFastMath(option.fast_math);
+  return compiler;
+}
+
+AstPtr GenericApp::loadSource(Compiler& compiler, const Source& input) {
+  compiler.setFilePath(fs::absolute(input.filepath).string());
+  Preprocessor preprocessor(fs::current_path());
+  return compiler.loadSource(input.source.empty()
+                                 ? preprocessor.process(input.filepath)
+                                 : preprocessor.process(input.source, input.filepath));
+}
+
 bool GenericApp::compileMainLoop(Compiler& compiler, const CompileOption& option,
                                  const std::optional<Source>& input,
                                  std::optional<fs::path>& output_path) {
-  auto stage = option.stage;
-  compiler.setFilePath(input ? fs::absolute(input.value().filepath).string() : "/stdin");
-  std::ifstream ifs;
+  AstPtr ast;
   if (input) {
-    ifs.open(input.value().filepath.string());
+    ast = loadSource(compiler, input.value());
   } else {
+    compiler.setFilePath("/stdin");
     Logger::debug_log(
         "Reading from stdin. If you are typing from terminal, type Ctrl+D to finish input. ",
         Logger::INFO);
+    ast = compiler.loadSource(std::cin);
   }
-  std::istream& in = input ? ifs : std::cin;
-  auto ast = compiler.loadSource(in);
 
   std::ofstream fout;
-  if (output_path) { fout.open(output_path.value()); }
-
-  std::ostream& out = output_path ? fout : std::cout;
+  if (output_path) {
+    auto mode = (option.stage == CompileStage::MemobjCollect) ? std::ios::out | std::ios::binary
+                                                              : std::ios::out;
+    fout.open(output_path.value(), mode);
+  }
+  return compileAst(compiler, option, ast, output_path ? fout : std::cout);
+}
 
+bool GenericApp::compileAst(Compiler& compiler, const CompileOption& option, AstPtr ast,
+                            std::ostream& out) {
+  auto stage = option.stage;
   if (stage == CompileStage::Parse) {
     out << *ast << std::endl;
     return false;
@@ -96,19 +185,27 @@ bool GenericApp::compileMainLoop(Compiler& compiler, const CompileOption& option
     out << mir::toString(mir) << std::endl;
     return false;
   }
-  auto mir_cc = compiler.closureConvert(mir);
+  auto mir_cc =
+      compiler.closureConvert(compiler.hoistControlRate(compiler.expandMultirate(mir)));
   auto funobjs = compiler.collectMemoryObjs(mir_cc);
   if (stage == CompileStage::ClosureConvert) {
     out << mir::toString(mir_cc) << std::endl;
     return false;
   }
+  if (stage == CompileStage::MemobjCollect) {
+    writeMirBinary(out, {mir_cc, funobjs, option.precision == Precision::Float});
+    return false;
+  }
+  if (stage == CompileStage::MemobjLayout) {
+    dumpMemobjLayout(out, funobjs,
+                     option.precision == Precision::Float ? sizeof(float) : sizeof(double));
+    return false;
+  }
   compiler.generateLLVMIr(mir_cc, funobjs);
   if (stage == CompileStage::Codegen) {
     compiler.dumpLLVMModule(out);
     return false;
   }
-
-  if (output_path) { dynamic_cast<std::ofstream&>(out).close(); }
   return true;
 }
 
@@ -116,24 +213,72 @@ int GenericApp::runtimeMainLoop(const RuntimeOption& option, const fs::path& inp
                                 FileType inputtype, std::optional<fs::path>& /*output_path*/) {
   std::unique_ptr<Runtime> runtime;
   try {
-    auto backend = std::make_unique<AudioDriverRtAudio>();
+    std::unique_ptr<AudioDriver> backend;
+    AudioDriverAPI* benchdriver = nullptr;
+    if (option.bench_seconds > 0) {
+      auto driver =
+          std::make_unique<AudioDriverAPI>(option.bench_samplerate, option.bench_framesize);
+      benchdriver = driver.get();
+      backend = std::move(driver);
+    } else {
+      backend = std::make_unique<AudioDriverRtAudio>();
+    }
     bool optimize = option.optimize_level == OptimizeLevel::ON;
     if (option.engine == ExecutionEngine::LLVM) {
       switch (inputtype) {
         case FileType::MimiumSource:
           runtime = std::make_unique<Runtime_LLVM>(
               compiler->moveLLVMCtx(), compiler->moveLLVMModule(),
-              fs::absolute(input_path).string(), std::move(backend), optimize);
+              fs::absolute(input_path).string(), std::move(backend), optimize, option.jit_threads);
           break;
         case FileType::LLVMIR:
-          runtime = std::make_unique<Runtime_LLVM>(fs::absolute(input_path).string(),
-                                                   std::move(backend), optimize);
+          runtime =
+              std::make_unique<Runtime_LLVM>(fs::absolute(input_path).string(), std::move(backend),
+                                             optimize, option.jit_threads);
           break;
-        case FileType::MimiumMir:
-          throw std::runtime_error("MIR Parser is not available yet.");
-          return -1;
+        case FileType::MimiumMir: {
+          std::ifstream ifs(input_path, std::ios::in | std::ios::binary);
+          if (!ifs) { throw FileNotFound(input_path.string()); }
+          auto mir = readMirBinary(
+              ifs, this->option->compile_option.precision == Precision::Float);
+          compiler->setFilePath(fs::absolute(input_path).string());
+          compiler->generateLLVMIr(mir.toplevel, mir.funobjs);
+          runtime = std::make_unique<Runtime_LLVM>(
+              compiler->moveLLVMCtx(), compiler->moveLLVMModule(),
+              fs::absolute(input_path).string(), std::move(backend), optimize, option.jit_threads);
+          break;
+        }
         default: throw std::runtime_error("Unknown File Type"); return -1;
       }
+      static_cast<Runtime_LLVM&>(*runtime).setVectorLibrary(option.veclib);
+      setRandomSeed(option.random_seed);
+      runtime->setNumVoices(option.num_voices);
+      if (option.stft_hop > option.stft_size) {
+        throw std::runtime_error("--stft-hop must not be bigger than --stft-size");
+      }
+      runtime->setStftConfig(
+          StftConfig{option.stft_size, option.stft_hop, getWindowType(option.stft_window)});
+      SampleStoreConfig storeconfig;
+      storeconfig.preload_frames = option.stream_preload;
+      runtime->setSampleStoreConfig(std::move(storeconfig));
+      runtime->getAudioDriver().setDspThreads(option.dsp_threads);
+      if (!option.midi_in.empty()) {
+        runtime->getAudioDriver().setMidiInput(std::make_unique<MidiInput>(
+            std::make_unique<MidiSourceRtMidi>(getMidiPort(option.midi_in))));
+      }
+      if (!option.midi_out.empty()) {
+        runtime->getAudioDriver().setMidiOutput(std::make_unique<MidiOutput>(
+            std::make_unique<MidiSinkRtMidi>(getMidiPort(option.midi_out))));
+      }
+      if (option.osc_port > 0) {
+        runtime->getAudioDriver().setOscServer(std::make_unique<OscServer>(option.osc_port));
+      }
+      if (benchdriver != nullptr) {
+        return benchMainLoop(*runtime, *benchdriver, option, input_path);
+      }
+      runtime->getAudioDriver().setSampleFormat(option.device_precision == Precision::Float
+                                                    ? SampleFormat::Float32
+                                                    : SampleFormat::Float64);
       runtime->runMainFun();
       runtime->start();  // start() blocks thread until scheduler stops
       return 0;
@@ -150,19 +295,59 @@ int GenericApp::runtimeMainLoop(const RuntimeOption& option, const fs::path& inp
   }
 }
 
+int GenericApp::benchMainLoop(Runtime& runtime, AudioDriverAPI& driver,
+                              const RuntimeOption& option, const fs::path& input_path) const {
+  BenchReport report;
+  report.source = input_path.string();
+  report.samplerate = option.bench_samplerate;
+  report.framesize = option.bench_framesize;
+  report.compile_seconds = compile_seconds;
+  auto start = std::chrono::steady_clock::now();
+  runtime.runMainFun();
+  report.jit_seconds = getSecondsSince(start);
+  driver.setup(driver.getDefaultAudioParameter(option.bench_samplerate, option.bench_framesize));
+  driver.start();
+  // silent input, as a device would give.
+  const int framesize = option.bench_framesize;
+  std::vector<std::vector<float>> inputs(driver.getInNumChs(), std::vector<float>(framesize));
+  std::vector<std::vector<float>> outputs(driver.getOutNumChs(), std::vector<float>(framesize));
+  std::vector<const float*> inptrs;
+  std::vector<float*> outptrs;
+  for (auto& ch : inputs) { inptrs.push_back(ch.data()); }
+  for (auto& ch : outputs) { outptrs.push_back(ch.data()); }
+  const auto total = static_cast<int64_t>(option.bench_seconds * option.bench_samplerate);
+  start = std::chrono::steady_clock::now();
+  while (report.frames < total) {
+    const auto frames = static_cast<int>(std::min<int64_t>(framesize, total - report.frames));
+    if (!driver.processPlanar(inptrs.data(), outptrs.data(), frames)) { break; }
+    report.frames += frames;
+  }
+  report.process_seconds = getSecondsSince(start);
+  driver.stop();
+  report.memobj_bytes = runtime.getMallocSize();
+  if (auto* voices = driver.getVoicePool()) { report.memobj_bytes += voices->getMemObjsSize(); }
+  if (auto* spectral = driver.getSpectralProcessor()) {
+    report.memobj_bytes += spectral->getMemObjsSize();
+  }
+  printBenchReport(std::cout, report, option.bench_json);
+  return 0;
+}
+
 int GenericApp::run() {
   try {
-    this->compiler = std::make_unique<Compiler>();
+    this->compiler = makeCompiler(option->compile_option);
     bool should_compile = true;
     bool should_run = false;
     if (option->input) {
       auto type = option->input.value().filetype;
       if (type != FileType::MimiumSource) { should_compile = false; }
-      if (type == FileType::LLVMIR) { should_run = true; }
+      if (type == FileType::LLVMIR || type == FileType::MimiumMir) { should_run = true; }
     }
     if (should_compile) {
+      const auto start = std::chrono::steady_clock::now();
       should_run =
           compileMainLoop(*compiler, option->compile_option, option->input, option->output_path);
+      compile_seconds = getSecondsSince(start);
     }
 
     int res = 0;
@@ -14,6 +14,36 @@ MIMIUM_DLL_PUBLIC ExecutionEngine getExecutionEngine(std::string_view val);
 
 MIMIUM_DLL_PUBLIC BackEnd getBackEnd(std::string_view val);
 
+MIMIUM_DLL_PUBLIC Precision getPrecision(std::string_view val);
+
+// port number of MIDI, or nullopt for "virtual" which opens a virtual port.
+MIMIUM_DLL_PUBLIC std::optional<unsigned int> getMidiPort(std::string const& val);
+
+// result of --bench in wall-clock time.
+struct BenchReport {
+  std::string source;
+  double samplerate = 0;
+  int framesize = 0;
+  // frames rendered, fewer than requested if the program ended.
+  int64_t frames = 0;
+  // from parsing to LLVM IR.
+  double compile_seconds = 0;
+  // JIT compilation and the main function.
+  double jit_seconds = 0;
+  double process_seconds = 0;
+  // memory objects and global values of the compiled code, including voices and spectral.
+  size_t memobj_bytes = 0;
+  [[nodiscard]] double getNsPerSample() const {
+    return frames > 0 ? process_seconds * 1e9 / static_cast<double>(frames) : 0.0;
+  }
+  [[nodiscard]] double getRealtimeFactor() const {
+    return process_seconds > 0 ? static_cast<double>(frames) / samplerate / process_seconds : 0.0;
+  }
+};
+
+MIMIUM_DLL_PUBLIC std::ostream& printBenchReport(std::ostream& out, BenchReport const& report,
+                                                 bool json);
+
 class MIMIUM_DLL_PUBLIC GenericApp {
  public:
   explicit GenericApp(std::unique_ptr<AppOption> options);
@@ -27,6 +57,16 @@ class MIMIUM_DLL_PUBLIC GenericApp {
   static volatile std::sig_atomic_t signal_status;  // NOLINT
   [[nodiscard]] const auto& getOption() const { return *option; };
 
+  // compiler with the precision and fast-math of the option.
+  static std::unique_ptr<Compiler> makeCompiler(const CompileOption& option);
+  // preprocesses and parses the input. The text of the input is used instead of the file if it is
+  // not empty, and includes are resolved from the directory of its path in either case.
+  static AstPtr loadSource(Compiler& compiler, const Source& input);
+  // runs the stages after parsing. Returns true with LLVM module of the compiler if the stage of
+  // the option is Run, or writes the result of the stage to out and returns false.
+  static bool compileAst(Compiler& compiler, const CompileOption& option, AstPtr ast,
+                         std::ostream& out);
+
  private:
   std::unique_ptr<Compiler> compiler;
   static void handleSignal(int signal);
@@ -37,7 +77,11 @@ class MIMIUM_DLL_PUBLIC GenericApp {
                               std::optional<fs::path>& output_path);
   int runtimeMainLoop(const RuntimeOption& option, const fs::path& input_path, FileType inputtype,
                       std::optional<fs::path>& output_path);
+  // renders the program offline for --bench and prints the report.
+  int benchMainLoop(Runtime& runtime, AudioDriverAPI& driver, const RuntimeOption& option,
+                    const fs::path& input_path) const;
   std::unique_ptr<AppOption> option;
+  double compile_seconds = 0;
 };
 
 }  // namespace mimium::app
\ No newline at end of file
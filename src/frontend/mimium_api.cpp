@@ -0,0 +1,110 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "frontend/mimium_api.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include "compiler/codegen/llvm_header.hpp"
+#include "compiler/compiler.hpp"
+#include "frontend/genericapp.hpp"
+#include "runtime/JIT/runtime_jit.hpp"
+#include "runtime/backend/api/driver_api.hpp"
+
+struct mimium_instance {
+  std::unique_ptr<mimium::Runtime_LLVM> runtime;
+  // owned by the runtime.
+  mimium::AudioDriverAPI* driver;
+};
+
+namespace {
+// instances are made and destroyed one at a time, as the initialization of LLVM is global.
+std::mutex instances_mtx;
+
+void writeError(char* error, size_t errorsize, std::string const& message) {
+  if (error == nullptr || errorsize == 0) { return; }
+  const size_t len = std::min(errorsize - 1, message.size());
+  std::memcpy(error, message.data(), len);
+  error[len] = '\0';
+}
+
+std::unique_ptr<mimium_instance> createInstance(const char* source, double samplerate,
+                                                int maxframes, const mimium_options& options) {
+  using namespace mimium;  // NOLINT
+  app::CompileOption option;
+  option.precision = options.float32 != 0 ? app::Precision::Float : app::Precision::Double;
+  option.fast_math = options.fast_math != 0;
+  auto compiler = app::GenericApp::makeCompiler(option);
+  const Source input{"embedded.mmm", FileType::MimiumSource, source};
+  auto ast = app::GenericApp::loadSource(*compiler, input);
+  app::GenericApp::compileAst(*compiler, option, ast, std::cout);
+  auto driver = std::make_unique<AudioDriverAPI>(samplerate, maxframes);
+  auto instance = std::make_unique<mimium_instance>();
+  instance->driver = driver.get();
+  instance->runtime =
+      std::make_unique<Runtime_LLVM>(compiler->moveLLVMCtx(), compiler->moveLLVMModule(),
+                                     fs::absolute(input.filepath).string(), std::move(driver));
+  instance->runtime->runMainFun();
+  auto& d = *instance->driver;
+  d.setup(d.getDefaultAudioParameter(std::nullopt, std::nullopt));
+  d.start();
+  return instance;
+}
+}  // namespace
+
+extern "C" {
+
+mimium_instance* mimium_create(const char* source, double samplerate, int maxframes,
+                               char* error, size_t errorsize) {
+  return mimium_create_with_options(source, samplerate, maxframes, nullptr, error, errorsize);
+}
+
+mimium_instance* mimium_create_with_options(const char* source, double samplerate, int maxframes,
+                                            const mimium_options* options, char* error,
+                                            size_t errorsize) {
+  std::lock_guard<std::mutex> lock(instances_mtx);
+  try {
+    if (source == nullptr || *source == '\0') { throw std::runtime_error("source is empty"); }
+    return createInstance(source, samplerate, maxframes,
+                          options != nullptr ? *options : mimium_options{})
+        .release();
+  } catch (std::exception& e) {
+    writeError(error, errorsize, e.what());
+  } catch (...) { writeError(error, errorsize, "caught unknown error."); }
+  return nullptr;
+}
+
+void mimium_destroy(mimium_instance* instance) {
+  if (instance == nullptr) { return; }
+  std::lock_guard<std::mutex> lock(instances_mtx);
+  instance->driver->stop();
+  delete instance;  // NOLINT
+}
+
+int mimium_get_num_inputs(const mimium_instance* instance) {
+  return instance->driver->getInNumChs();
+}
+
+int mimium_get_num_outputs(const mimium_instance* instance) {
+  return instance->driver->getOutNumChs();
+}
+
+int mimium_process(mimium_instance* instance, const float* const* input, float* const* output,
+                   int nframes) {
+  return instance->driver->processPlanar(input, output, nframes) ? 1 : 0;
+}
+
+int mimium_schedule_midi(mimium_instance* instance, int64_t time, const uint8_t* bytes,
+                         size_t size) {
+  return instance->driver->scheduleMidi(time, bytes, size) ? 1 : 0;
+}
+
+int64_t mimium_get_time(const mimium_instance* instance) {
+  return instance->driver->getProcessedTime();
+}
+
+int mimium_is_running(const mimium_instance* instance) {
+  return instance->driver->isRunning() ? 1 : 0;
+}
+}
@@ -0,0 +1,58 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "export.hpp"
+
+// C interface for embedding mimium in audio servers and plugin hosts, which own the realtime
+// thread and the buffers. A source is compiled into an instance, of which the host calls
+// mimium_process on its audio thread with any number of frames. mimium_process neither allocates
+// nor locks. The other functions may be called on any thread, but an instance must not be
+// destroyed while mimium_process runs on it.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mimium_instance mimium_instance;
+
+// the same as --precision and --fast-math of the command line. Zero initialized is the default.
+typedef struct mimium_options {
+  // nonzero compiles float as single precision.
+  int float32;
+  // nonzero replaces the math functions with their approximations.
+  int fast_math;
+} mimium_options;
+
+// compiles the source and runs its main function. Returns NULL on failure, with the message
+// written to error if it is not NULL. maxframes is the largest block processed at once, and
+// longer buffers are split. Includes are resolved from the current directory.
+MIMIUM_DLL_PUBLIC mimium_instance* mimium_create(const char* source, double samplerate,
+                                                 int maxframes, char* error, size_t errorsize);
+// mimium_create with the options, which may be NULL.
+MIMIUM_DLL_PUBLIC mimium_instance* mimium_create_with_options(const char* source,
+                                                              double samplerate, int maxframes,
+                                                              const mimium_options* options,
+                                                              char* error, size_t errorsize);
+MIMIUM_DLL_PUBLIC void mimium_destroy(mimium_instance* instance);
+// number of channels of the buffers given to mimium_process.
+MIMIUM_DLL_PUBLIC int mimium_get_num_inputs(const mimium_instance* instance);
+MIMIUM_DLL_PUBLIC int mimium_get_num_outputs(const mimium_instance* instance);
+// processes planar buffers of nframes for each channel. Returns 0 with silence once the program
+// has ended, which happens when it has neither dsp function nor pending tasks.
+MIMIUM_DLL_PUBLIC int mimium_process(mimium_instance* instance, const float* const* input,
+                                     float* const* output, int nframes);
+// passes a MIDI message to midiin function at the time in samples since creation, or at the
+// beginning of the next block if the time has passed. Returns 0 if the message was not queued.
+MIMIUM_DLL_PUBLIC int mimium_schedule_midi(mimium_instance* instance, int64_t time,
+                                           const uint8_t* bytes, size_t size);
+// number of samples processed since creation.
+MIMIUM_DLL_PUBLIC int64_t mimium_get_time(const mimium_instance* instance);
+MIMIUM_DLL_PUBLIC int mimium_is_running(const mimium_instance* instance);
+
+#ifdef __cplusplus
+}
+#endif
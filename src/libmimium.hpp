@@ -18,6 +18,8 @@
 
 #include "runtime/JIT/runtime_jit.hpp"
 #include "runtime/backend/rtaudio/driver_rtaudio.hpp"
+#include "runtime/backend/rtmidi/midi_rtmidi.hpp"
+#include "runtime/backend/api/driver_api.hpp"
 
 #include "frontend/genericapp.hpp"
 #include "frontend/cli.hpp"
\ No newline at end of file
@@ -3,61 +3,167 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "preprocessor.hpp"
-#include <numeric>
-#include <regex>
-#include <sstream>
+#include <algorithm>
 #include <utility>
+#include "basic/error_def.hpp"
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Read-only view of a whole file. Memory-mapped where available.
+class MappedFile {
+ public:
+  explicit MappedFile(const mimium::fs::path& path) {
+#ifdef _WIN32
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) { throw mimium::FileNotFound(path.string()); }
+    buffer.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    data = buffer.data();
+    size = buffer.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { throw mimium::FileNotFound(path.string()); }
+    struct stat st {};
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      size = static_cast<size_t>(st.st_size);
+      void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        ::close(fd);
+        throw mimium::PreprocessorError("failed to map file: " + path.string());
+      }
+      data = static_cast<const char*>(addr);
+    }
+    ::close(fd);
+#endif
+  }
+  ~MappedFile() {
+#ifndef _WIN32
+    if (data != nullptr) { ::munmap(const_cast<char*>(data), size); }  // NOLINT
+#endif
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  [[nodiscard]] std::string_view view() const { return {data, size}; }
+
+ private:
+#ifdef _WIN32
+  std::string buffer;
+#endif
+  const char* data = nullptr;
+  size_t size = 0;
+};
+
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+std::string_view trim(std::string_view str) {
+  while (!str.empty() && isSpace(str.front())) { str.remove_prefix(1); }
+  while (!str.empty() && isSpace(str.back())) { str.remove_suffix(1); }
+  return str;
+}
+
+}  // namespace
+
 namespace mimium {
 
 Preprocessor::Preprocessor(fs::path cwd) : cwd(std::move(cwd)) {}
 
-Source Preprocessor::loadFile(fs::path path) {
-  FileReader filereader(cwd);
-  return filereader.loadFile(path.string());
+std::optional<std::string_view> Preprocessor::parseIncludeLine(std::string_view line) {
+  constexpr std::string_view keyword = "include";
+  line = trim(line);
+  if (line.substr(0, keyword.size()) != keyword) { return std::nullopt; }
+  line.remove_prefix(keyword.size());
+  bool has_paren = false;
+  if (!line.empty() && line.front() == '(') {
+    has_paren = true;
+    line = trim(line.substr(1));
+  } else {
+    // keyword must be followed by space
+    if (line.empty() || !isSpace(line.front())) { return std::nullopt; }
+    line = trim(line);
+  }
+  if (has_paren) {
+    if (line.empty() || line.back() != ')') { return std::nullopt; }
+    line = trim(line.substr(0, line.size() - 1));
+  }
+  if (line.size() < 2 || line.front() != '"' || line.back() != '"') { return std::nullopt; }
+  return line.substr(1, line.size() - 2);
 }
 
-std::list<std::string> Preprocessor::splitSource(const std::string& str) {
-  std::list<std::string> res;
-  std::stringstream ss(str);
-  std::string tmpstr;
-  while (std::getline(ss, tmpstr, '\n')) {
-    if (!tmpstr.empty()) { res.emplace_back(tmpstr); }
-  }
-  return res;
-}
-void Preprocessor::replaceIncludeMacro(std::list<std::string>& src) {
-  const std::regex re(R"((include)(\s)+\"(.*)\")");
-  for (auto&& iter = src.begin(); iter != src.cend(); /*increment manually*/) {
-    const auto& line = *iter;
-    std::smatch matchres;
-    std::regex_match(line, matchres, re);
-    if (!matchres.empty()) {
-      const auto& filename = matchres[3];
-      fs::path newfilepath(filename.str());
-      std::list<std::string> newsrclist;
-      if (files.find(newfilepath.string()) == files.end()) {
-        auto new_src = this->loadFile(newfilepath);
-        newsrclist = splitSource(new_src.source);
-      }
-      auto nextiter = std::next(iter);
-      auto insertpoint = src.erase(iter);
-      src.splice(insertpoint, std::move(newsrclist));
-      iter = nextiter;
-    } else {
-      iter++;
+fs::path Preprocessor::resolveIncludePath(std::string_view filename,
+                                          fs::path const& includer_dir) const {
+  fs::path path(filename);
+  if (path.is_absolute()) { return path; }
+  auto relative_to_includer = includer_dir / path;
+  std::error_code ec;
+  if (fs::exists(relative_to_includer, ec)) { return relative_to_includer; }
+  return cwd / path;
+}
+
+void Preprocessor::reserveOutput(size_t additional) {
+  auto required = output.size() + additional;
+  if (required > output.capacity()) { output.reserve(std::max(required, output.capacity() * 2)); }
+}
+
+void Preprocessor::expandFile(fs::path const& path) {
+  if (path.extension() != mmm_ext) { throw UnknownExtension(path.string()); }
+  std::error_code ec;
+  auto canonical = fs::weakly_canonical(path, ec);
+  if (ec) { throw FileNotFound(path.string()); }
+  if (!files.emplace(canonical.string()).second) { return; }  // already included
+
+  MappedFile file(canonical);
+  expandText(file.view(), canonical);
+}
+
+void Preprocessor::expandText(std::string_view text, fs::path const& canonical) {
+  reserveOutput(text.size() + 1);
+  auto fileindex = sourcemap->addFile(canonical);
+  auto dir = canonical.parent_path();
+  size_t pos = 0;
+  int linenum = 1;
+  while (pos < text.size()) {
+    auto eol = text.find('\n', pos);
+    if (eol == std::string_view::npos) { eol = text.size(); }
+    auto line = text.substr(pos, eol - pos);
+    if (!line.empty() && line.back() == '\r') { line.remove_suffix(1); }
+    if (auto includefile = parseIncludeLine(line)) {
+      expandFile(resolveIncludePath(includefile.value(), dir));
+    } else if (!trim(line).empty()) {
+      output.append(line);
+      output.push_back('\n');
+      sourcemap->addLine(fileindex, linenum);
     }
+    pos = eol + 1;
+    ++linenum;
   }
 }
+
 Source Preprocessor::process(fs::path path) {
-  auto src = loadFile(path);
-  files.emplace(src.filepath.string());
-  auto src_list_by_line = splitSource(src.source);
-  replaceIncludeMacro(src_list_by_line);
-  std::string res;
-  src.source =
-      std::accumulate(src_list_by_line.begin(), src_list_by_line.end(), res,
-                      [&](std::string& acc, std::string& line) { return acc + "\n" + line; });
-  return src;
-}
-
-}  // namespace mimium
\ No newline at end of file
+  files.clear();
+  output.clear();
+  sourcemap = std::make_shared<SourceMap>();
+  auto rootpath = path.is_absolute() ? path : cwd / path;
+  expandFile(rootpath);
+  return Source{fs::absolute(rootpath), FileType::MimiumSource, std::move(output), sourcemap};
+}
+
+Source Preprocessor::process(std::string_view text, fs::path path) {
+  files.clear();
+  output.clear();
+  sourcemap = std::make_shared<SourceMap>();
+  auto rootpath = fs::weakly_canonical(path.is_absolute() ? path : cwd / path);
+  // the file of the same path included from the text is not expanded again.
+  files.emplace(rootpath.string());
+  expandText(text, rootpath);
+  return Source{rootpath, FileType::MimiumSource, std::move(output), sourcemap};
+}
+
+}  // namespace mimium
@@ -3,25 +3,37 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #pragma once
-#include <list>
+#include <optional>
+#include <string_view>
 #include <unordered_set>
 #include "basic/filereader.hpp"
 
 namespace mimium {
 namespace fs = std::filesystem;
 
-
-class Preprocessor {
+// Single-pass include expander. Each file is included only once, blank lines are dropped and the
+// origin of every emitted line is recorded into SourceMap of the result.
+class MIMIUM_DLL_PUBLIC Preprocessor {
  public:
   explicit Preprocessor(fs::path cwd);
   Source process(fs::path path);
+  // expands the text given in memory as if it were the content of the path, which does not need
+  // to exist. Includes are looked up from the directory of the path.
+  Source process(std::string_view text, fs::path path);
+
+  // returns filename if the line is an include directive, either of `include "file.mmm"` or
+  // `include("file.mmm")`.
+  static std::optional<std::string_view> parseIncludeLine(std::string_view line);
 
  private:
-  Source loadFile(fs::path path);
-  static std::list<std::string> splitSource(const std::string& str);
-  void replaceIncludeMacro(std::list<std::string>& src);
+  void expandFile(fs::path const& path);
+  void expandText(std::string_view text, fs::path const& canonical);
+  fs::path resolveIncludePath(std::string_view filename, fs::path const& includer_dir) const;
+  void reserveOutput(size_t additional);
   std::unordered_set<std::string> files;
+  std::string output;
+  std::shared_ptr<SourceMap> sourcemap;
   fs::path cwd;
 };
 
-}  // namespace mimium
\ No newline at end of file
+}  // namespace mimium
@@ -6,7 +6,13 @@
 #include <iostream>
 #include <memory>
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
 #include "llvm/ExecutionEngine/Orc/Core.h"
@@ -24,12 +30,16 @@
 #include "llvm/IR/LegacyPassManager.h"
 
 #include "llvm/Support/Error.h"
+#include "llvm/Support/Host.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Target/TargetMachine.h"
 
+#include "llvm/Transforms/IPO/AlwaysInliner.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
 #include "llvm/Transforms/Utils.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "llvm/Transforms/Vectorize.h"
 
 #include "basic/helper_functions.hpp"  //load NO_SANITIZE
@@ -52,12 +62,17 @@ class MimiumJIT {
 
   MangleAndInterner Mangle;
   ThreadSafeContext Ctx;
+  // vector math library which the loop vectorizer may call instead of scalar libm functions.
+  TargetLibraryInfoImpl::VectorLibrary veclib = TargetLibraryInfoImpl::NoLibrary;
 
  public:
   enum OptimizeLevel { NO = 0, NORMAL = 1 } optimize_level;
+  // if num_compile_threads is more than 0, modules are optimized and compiled concurrently on
+  // the thread pool of ExecutionSession.
   explicit MimiumJIT(std::unique_ptr<LLVMContext> ctx,
-                     OptimizeLevel optimizelevel = OptimizeLevel::NO)
-      : lllazyjit(createEngine()),
+                     OptimizeLevel optimizelevel = OptimizeLevel::NO,
+                     unsigned num_compile_threads = 0)
+      : lllazyjit(createEngine(num_compile_threads)),
         ES(lllazyjit->getExecutionSession()),
         DL(lllazyjit->getDataLayout()),
         MainJD(lllazyjit->getMainJITDylib()),
@@ -65,10 +80,13 @@ class MimiumJIT {
         Ctx(std::move(ctx)),
         optimize_level(optimizelevel) {
     if (optimize_level == OptimizeLevel::NORMAL) {
+      auto transform = [this](ThreadSafeModule M, const MaterializationResponsibility& R) {
+        return optimizeModule(std::move(M), R);
+      };
 #if LAZY_ENABLE
-      lllazyjit->setLazyCompileTransform(optimizeModule);
+      lllazyjit->setLazyCompileTransform(transform);
 #else
-      lllazyjit->getIRTransformLayer().setTransform(optimizeModule);
+      lllazyjit->getIRTransformLayer().setTransform(transform);
 #endif
     }
 // MainJD.getExecutionSession()
@@ -83,12 +101,13 @@ class MimiumJIT {
   // Creates LLJIT engine. Note that builder.create causes container overflow inside llvm library.
   // maybe in llvm::LLVMTargetMachine::initAsmInfo()?
 
-  NO_SANITIZE static std::unique_ptr<LLJITCLASS> createEngine() {
+  NO_SANITIZE static std::unique_ptr<LLJITCLASS> createEngine(unsigned num_compile_threads = 0) {
 #if LAZY_ENABLE
     auto builder = LLLazyJITBuilder();
 #else
     auto builder = LLJITBuilder();
 #endif
+    builder.setNumCompileThreads(num_compile_threads);
     auto jit = builder.create();
     if (!jit) { llvm::errs() << jit.takeError() << "\n"; }
     return std::move(jit.get());
@@ -100,6 +119,37 @@ class MimiumJIT {
     return lllazyjit->addIRModule(ThreadSafeModule(std::move(M), Ctx));
 #endif
   }
+  // Splits module into partitions of top-level functions. Each partition is moved into its own
+  // LLVMContext through bitcode so that they can be optimized and compiled in parallel. References
+  // across partitions are resolved through MainJD.
+  Error addModuleParallel(std::unique_ptr<Module> M, unsigned num_partitions) {
+    if (num_partitions <= 1) { return addModule(std::move(M)); }
+    std::vector<SmallVector<char, 0>> bitcodes;
+    auto writepartition = [&](std::unique_ptr<Module> part) {
+      auto& buf = bitcodes.emplace_back();
+      raw_svector_ostream os(buf);
+      WriteBitcodeToFile(*part, os);
+    };
+#if LLVM_VERSION_MAJOR >= 13
+    SplitModule(*M, num_partitions, writepartition);
+#else
+    SplitModule(std::move(M), num_partitions, writepartition);
+#endif
+    for (auto& bc : bitcodes) {
+      auto ctx = std::make_unique<LLVMContext>();
+      auto part = parseBitcodeFile(MemoryBufferRef(StringRef(bc.data(), bc.size()), "partition"),
+                                   *ctx);
+      if (!part) { return part.takeError(); }
+      ThreadSafeModule tsm(std::move(part.get()), std::move(ctx));
+#if LAZY_ENABLE
+      auto err = lllazyjit->addLazyIRModule(std::move(tsm));
+#else
+      auto err = lllazyjit->addIRModule(std::move(tsm));
+#endif
+      if (err) { return err; }
+    }
+    return Error::success();
+  }
   Expected<JITEvaluatedSymbol> lookup(StringRef name) { return lllazyjit->lookup(name); }
 
   Error addSymbol(StringRef name, void* ptr) {
@@ -117,32 +167,61 @@ class MimiumJIT {
     return res.takeError();
   }
 
-  static Expected<ThreadSafeModule> optimizeModule(ThreadSafeModule M,
-                                                   const MaterializationResponsibility& R) {
-// Create a function pass manager.
-#if LLVM_VERSION_MAJOR >= 10
-    auto FPM = std::make_unique<legacy::FunctionPassManager>(M.getModuleUnlocked());
-#else
-    auto FPM = std::make_unique<legacy::FunctionPassManager>(M.getModule());
-#endif
-    // Add some optimizations.
-    FPM->add(createPromoteMemoryToRegisterPass());  // mem2reg
-    FPM->add(createDeadStoreEliminationPass());
-    FPM->add(createInstructionCombiningPass());
-    FPM->add(createReassociatePass());
-    FPM->add(createGVNPass());
-    FPM->add(createCFGSimplificationPass());
-    FPM->add(createLoopInterchangePass());
-    FPM->add(createLoopVectorizePass());
-    FPM->doInitialization();
-
-// Run the optimizations over all functions in the module being added to
-// the JIT.
+  // target machine of the host, of which the cost model tells the vectorizers the vector width.
+  // Made for each module as optimizeModule may run on several compile threads.
+  static std::unique_ptr<TargetMachine> createHostTargetMachine() {
+    auto jtmb = JITTargetMachineBuilder::detectHost();
+    if (!jtmb) {
+      consumeError(jtmb.takeError());
+      return nullptr;
+    }
+    jtmb->setCPU(std::string(sys::getHostCPUName()));
+    auto tm = jtmb->createTargetMachine();
+    if (!tm) {
+      consumeError(tm.takeError());
+      return nullptr;
+    }
+    return std::move(tm.get());
+  }
+
+  // must be called before modules are added.
+  void setVectorLibrary(TargetLibraryInfoImpl::VectorLibrary lib) { veclib = lib; }
+
+  Expected<ThreadSafeModule> optimizeModule(ThreadSafeModule M,
+                                            const MaterializationResponsibility& R) {
+    auto optimize = [&](Module& m) {
+      // inline fast math approximations first so that they are vectorized within the callers.
+      legacy::PassManager MPM;
+      MPM.add(createAlwaysInlinerLegacyPass());
+      MPM.run(m);
+      // Create a function pass manager.
+      auto FPM = std::make_unique<legacy::FunctionPassManager>(&m);
+      TargetLibraryInfoImpl tlii(Triple(sys::getProcessTriple()));
+      tlii.addVectorizableFunctionsFromVecLib(veclib);
+      FPM->add(new TargetLibraryInfoWrapperPass(tlii));
+      auto tm = createHostTargetMachine();
+      if (tm != nullptr) {
+        FPM->add(createTargetTransformInfoWrapperPass(tm->getTargetIRAnalysis()));
+      }
+      // Add some optimizations.
+      FPM->add(createPromoteMemoryToRegisterPass());  // mem2reg
+      FPM->add(createDeadStoreEliminationPass());
+      FPM->add(createInstructionCombiningPass());
+      FPM->add(createReassociatePass());
+      FPM->add(createGVNPass());
+      // packs the same operations on adjacent memory, such as filters in a bank of states.
+      FPM->add(createSLPVectorizerPass());
+      FPM->add(createCFGSimplificationPass());
+      FPM->add(createLoopInterchangePass());
+      FPM->add(createLoopVectorizePass());
+      FPM->doInitialization();
+      // Run the optimizations over all functions in the module being added to the JIT.
+      for (auto& f : m.functions()) { FPM->run(f); }
+    };
 #if LLVM_VERSION_MAJOR >= 10
-    M.withModuleDo(
-        [&](Module& m) { std::for_each(m.begin(), m.end(), [&](auto& f) { FPM->run(f); }); });
+    M.withModuleDo(optimize);
 #else
-    for (auto& f : M.getModule()->functions()) { FPM->run(f); }
+    optimize(*M.getModule());
 #endif
     return M;
   }
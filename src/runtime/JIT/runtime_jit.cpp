@@ -3,9 +3,70 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include "runtime/JIT/runtime_jit.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
 #include <llvm/IRReader/IRReader.h>
+#include "compiler/ffi.hpp"
+#include "compiler/oscillators.hpp"
 #include "runtime/JIT/jit_engine.hpp"
 
+namespace {
+std::vector<double> getFirstChannel(mimium::Sample const& sample) {
+  std::vector<double> res(sample.frames);
+  for (int64_t i = 0; i < sample.frames; i++) { res[i] = sample.data[i * sample.channels]; }
+  return res;
+}
+// instances of convolve made for an impulse response, for dsp and each voice.
+int getNumConvolvers(mimium::Runtime& runtime) { return runtime.getNumVoices() + 1; }
+template <typename T>
+T convolve(void* runtimeptr, T in, T* ir, mimium::MmmConvolverT<T>* state) {
+  mimium::Convolver* instance = nullptr;
+  std::memcpy(&instance, state->handle, sizeof(instance));
+  if (instance == nullptr) {
+    // the first call in a new or cleared memory object, which takes an instance made by loadir.
+    auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+    instance = runtime->getConvolutionStore().getInstance(state, ir);
+    std::memcpy(state->handle, &instance, sizeof(instance));
+  }
+  return static_cast<T>(instance->process(in));
+}
+template <typename T>
+T lookupTable(mimium::WavetableMipmap const& table, T freq, T* phase) {
+  const T index = mimium::osc::advancePhase(freq, phase) * mimium::wavetable_size;
+  if constexpr (std::is_same_v<T, float>) {
+    return access_array_lin_interp_f32(const_cast<float*>(table.getTableFloat(freq)), index);
+  } else {
+    return access_array_lin_interp(const_cast<double*>(table.getTable(freq)), index);
+  }
+}
+template <typename T>
+T basicOsc(void* runtimeptr, mimium::BasicWave wave, T freq, T* phase) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  return lookupTable(runtime->getWavetableStore().getBasic(wave), freq, phase);
+}
+template <typename T>
+T tableOsc(void* runtimeptr, T freq, T* table, mimium::MmmWavetableOscT<T>* state) {
+  uintptr_t handle = 0;
+  std::memcpy(&handle, state->handle, sizeof(handle));
+  if (handle == 0 || (handle & 1U) != 0) {
+    // the first call in a new or cleared memory object, or a miss. A miss is looked up again
+    // only after tables are added.
+    const auto& store = static_cast<mimium::Runtime*>(runtimeptr)->getWavetableStore();
+    const auto miss = (static_cast<uintptr_t>(store.getNumKeys()) << 1U) | 1U;
+    if (handle == miss) { return T(0); }
+    const auto* mipmap = store.findTable(table);
+    handle = mipmap != nullptr ? reinterpret_cast<uintptr_t>(mipmap) : miss;  // NOLINT
+    std::memcpy(state->handle, &handle, sizeof(handle));
+    if (mipmap == nullptr) { return T(0); }
+  }
+  return lookupTable(*reinterpret_cast<const mimium::WavetableMipmap*>(handle),  // NOLINT
+                     freq, &state->phase);
+}
+}  // namespace
+
 extern "C" {
 void setDspParams(void* runtimeptr, void* dspfn, void* clsaddress, void* memobjaddress,
                   int in_numchs, int out_numchs) {
@@ -14,9 +75,233 @@ void setDspParams(void* runtimeptr, void* dspfn, void* clsaddress, void* memobja
   auto p = std::make_unique<mimium::DspFnInfos>(
       mimium::DspFnInfos{reinterpret_cast<mimium::DspFnPtr>(dspfn), clsaddress, memobjaddress,
                          in_numchs, out_numchs});  // NOLINT
+  if (memobjaddress != nullptr) {
+    mimium::registerRandomArena(memobjaddress, runtime->getMallocSize(memobjaddress),
+                                mimium::RandomArena::Dsp);
+  }
   audiodriver.setDspFnInfos(std::move(p));
 }
 
+void setVoiceParams(void* runtimeptr, void* voicefn, void* clsaddress, int64_t memobjsize,
+                    int in_numchs, int out_numchs) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  mimium::VoiceFnInfos info{reinterpret_cast<mimium::DspFnPtr>(voicefn), clsaddress,  // NOLINT
+                            static_cast<size_t>(memobjsize), in_numchs, out_numchs};
+  runtime->getAudioDriver().setVoicePool(
+      std::make_unique<mimium::VoicePool>(info, runtime->getNumVoices()));
+}
+
+void setSpectralParams(void* runtimeptr, void* spectralfn, void* clsaddress, int64_t memobjsize,
+                       int isfloat32) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  auto& audiodriver = runtime->getAudioDriver();
+  mimium::SpectralFnInfos info{reinterpret_cast<mimium::SpectralFnPtr>(spectralfn),  // NOLINT
+                               clsaddress, static_cast<size_t>(memobjsize), isfloat32 != 0};
+  audiodriver.setSpectralProcessor(std::make_unique<mimium::SpectralProcessor>(
+      info, runtime->getStftConfig(), audiodriver.getOutNumChs()));
+}
+
+void setMidiInHandler(void* runtimeptr, void* handlerfn, void* clsaddress, int isfloat32) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  auto* midiinput = runtime->getAudioDriver().getMidiInput();
+  if (midiinput == nullptr) {
+    mimium::Logger::debug_log("midiin function is not called as no MIDI input is opened",
+                              mimium::Logger::WARNING);
+    return;
+  }
+  midiinput->setHandler(handlerfn, clsaddress, isfloat32 != 0);
+}
+
+double mimium_voiceon(void* runtimeptr, double freq, double velocity) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  auto* voices = runtime->getAudioDriver().getVoicePool();
+  if (voices == nullptr) { return -1; }
+  const std::array<double, 2> params = {freq, velocity};
+  auto now = runtime->getAudioDriver().getScheduler().getTime();
+  return voices->noteOn(now, params.data(), params.size());
+}
+
+void mimium_voiceoff(void* runtimeptr, double voice) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  auto* voices = runtime->getAudioDriver().getVoicePool();
+  if (voices == nullptr) { return; }
+  auto now = runtime->getAudioDriver().getScheduler().getTime();
+  voices->noteOff(now, static_cast<int>(voice));
+}
+
+void mimium_midiout(void* runtimeptr, double status, double data1, double data2) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  auto tobyte = [](double v, double max) { return static_cast<uint8_t>(std::clamp(v, 0.0, max)); };
+  const std::array<uint8_t, 3> bytes = {tobyte(status, 255), tobyte(data1, 127),
+                                        tobyte(data2, 127)};
+  const auto size = mimium::MidiOutput::getMessageSize(bytes[0]);
+  if (size > 0) { runtime->getAudioDriver().sendMidi(bytes.data(), size); }
+}
+
+double mimium_oscparam(void* runtimeptr, char* address, double init) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  auto* server = runtime->getAudioDriver().getOscServer();
+  if (server == nullptr) {
+    mimium::Logger::debug_log("oscparam is not set as no OSC port is opened: " +
+                                  std::string(address),
+                              mimium::Logger::WARNING);
+    return -1;
+  }
+  try {
+    return server->addParam(address, init);
+  } catch (std::runtime_error& e) {
+    mimium::Logger::debug_log(e.what(), mimium::Logger::ERROR_);
+    return -1;
+  }
+}
+
+double mimium_oscvalue(void* runtimeptr, double slot) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  auto* server = runtime->getAudioDriver().getOscServer();
+  return server != nullptr ? server->getValue(static_cast<int>(slot)) : 0.0;
+}
+
+double* mimium_loadwav(void* runtimeptr, char* filename) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  try {
+    // compiled code keeps the pointer, so the sample is pinned until the runtime is destroyed.
+    return const_cast<double*>(runtime->getSampleStore().loadPinned(filename).data.data());
+  } catch (std::runtime_error& e) {
+    mimium::Logger::debug_log(e.what(), mimium::Logger::ERROR_);
+    return nullptr;
+  }
+}
+
+float* mimium_loadwav_f32(void* runtimeptr, char* filename) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  try {
+    return const_cast<float*>(runtime->getSampleStore().loadPinnedFloat(filename).data());
+  } catch (std::runtime_error& e) {
+    mimium::Logger::debug_log(e.what(), mimium::Logger::ERROR_);
+    return nullptr;
+  }
+}
+
+double mimium_loadwavsize(void* runtimeptr, char* filename) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  try {
+    return static_cast<double>(runtime->getSampleStore().loadPinned(filename).frames);
+  } catch (std::runtime_error& e) {
+    mimium::Logger::debug_log(e.what(), mimium::Logger::ERROR_);
+    return 0;
+  }
+}
+
+double* mimium_loadir(void* runtimeptr, char* filename) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  try {
+    const auto& sample = runtime->getSampleStore().loadPinned(filename);
+    runtime->getConvolutionStore().addKernel(getFirstChannel(sample), {sample.data.data()},
+                                             getNumConvolvers(*runtime));
+    return const_cast<double*>(sample.data.data());
+  } catch (std::runtime_error& e) {
+    mimium::Logger::debug_log(e.what(), mimium::Logger::ERROR_);
+    return nullptr;
+  }
+}
+
+float* mimium_loadir_f32(void* runtimeptr, char* filename) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  try {
+    const auto& sample = runtime->getSampleStore().loadPinned(filename);
+    const auto& data = runtime->getSampleStore().loadPinnedFloat(filename);
+    runtime->getConvolutionStore().addKernel(getFirstChannel(sample), {data.data()},
+                                             getNumConvolvers(*runtime));
+    return const_cast<float*>(data.data());
+  } catch (std::runtime_error& e) {
+    mimium::Logger::debug_log(e.what(), mimium::Logger::ERROR_);
+    return nullptr;
+  }
+}
+
+double mimium_convolve(void* runtimeptr, double in, double* ir,
+                       mimium::MmmConvolverT<double>* state) {
+  return convolve(runtimeptr, in, ir, state);
+}
+float mimium_convolve_f32(void* runtimeptr, float in, float* ir,
+                          mimium::MmmConvolverT<float>* state) {
+  return convolve(runtimeptr, in, ir, state);
+}
+
+double mimium_osc_saw(void* runtimeptr, double freq, double* phase) {
+  return basicOsc(runtimeptr, mimium::BasicWave::Saw, freq, phase);
+}
+float mimium_osc_saw_f32(void* runtimeptr, float freq, float* phase) {
+  return basicOsc(runtimeptr, mimium::BasicWave::Saw, freq, phase);
+}
+double mimium_osc_square(void* runtimeptr, double freq, double* phase) {
+  return basicOsc(runtimeptr, mimium::BasicWave::Square, freq, phase);
+}
+float mimium_osc_square_f32(void* runtimeptr, float freq, float* phase) {
+  return basicOsc(runtimeptr, mimium::BasicWave::Square, freq, phase);
+}
+double mimium_osc_tri(void* runtimeptr, double freq, double* phase) {
+  return basicOsc(runtimeptr, mimium::BasicWave::Triangle, freq, phase);
+}
+float mimium_osc_tri_f32(void* runtimeptr, float freq, float* phase) {
+  return basicOsc(runtimeptr, mimium::BasicWave::Triangle, freq, phase);
+}
+
+double* mimium_loadwavetable(void* runtimeptr, char* filename) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  try {
+    const auto& sample = runtime->getSampleStore().loadPinned(filename);
+    runtime->getWavetableStore().addTable(getFirstChannel(sample), {sample.data.data()});
+    return const_cast<double*>(sample.data.data());
+  } catch (std::runtime_error& e) {
+    mimium::Logger::debug_log(e.what(), mimium::Logger::ERROR_);
+    return nullptr;
+  }
+}
+
+float* mimium_loadwavetable_f32(void* runtimeptr, char* filename) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  try {
+    const auto& sample = runtime->getSampleStore().loadPinned(filename);
+    const auto& data = runtime->getSampleStore().loadPinnedFloat(filename);
+    runtime->getWavetableStore().addTable(getFirstChannel(sample), {data.data()});
+    return const_cast<float*>(data.data());
+  } catch (std::runtime_error& e) {
+    mimium::Logger::debug_log(e.what(), mimium::Logger::ERROR_);
+    return nullptr;
+  }
+}
+
+double mimium_osc_table(void* runtimeptr, double freq, double* table,
+                        mimium::MmmWavetableOscT<double>* state) {
+  return tableOsc(runtimeptr, freq, table, state);
+}
+float mimium_osc_table_f32(void* runtimeptr, float freq, float* table,
+                           mimium::MmmWavetableOscT<float>* state) {
+  return tableOsc(runtimeptr, freq, table, state);
+}
+
+double mimium_openstream(void* runtimeptr, char* filename) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  try {
+    return runtime->getSampleStore().openStream(filename);
+  } catch (std::runtime_error& e) {
+    mimium::Logger::debug_log(e.what(), mimium::Logger::ERROR_);
+    return -1;
+  }
+}
+
+double mimium_readstream(void* runtimeptr, double stream) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  return runtime->getSampleStore().readStream(static_cast<int>(stream));
+}
+
+double mimium_streamchannel(void* runtimeptr, double stream, double ch) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  return runtime->getSampleStore().getStreamChannel(static_cast<int>(stream),
+                                                    static_cast<int>(ch));
+}
+
 NO_SANITIZE void addTask(void* runtimeptr, double time, void* addresstofn, double arg) {
   auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
   mimium::Scheduler& sch = runtime->getAudioDriver().getScheduler();
@@ -28,6 +313,17 @@ NO_SANITIZE void addTask_cls(void* runtimeptr, double time, void* addresstofn, d
   mimium::Scheduler& sch = runtime->getAudioDriver().getScheduler();
   sch.addTask(time, addresstofn, arg, addresstocls);
 }
+NO_SANITIZE void addTask_f32(void* runtimeptr, double time, void* addresstofn, float arg) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  mimium::Scheduler& sch = runtime->getAudioDriver().getScheduler();
+  sch.addTask(time, addresstofn, arg, nullptr, true);
+}
+NO_SANITIZE void addTask_cls_f32(void* runtimeptr, double time, void* addresstofn, float arg,
+                                 void* addresstocls) {
+  auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+  mimium::Scheduler& sch = runtime->getAudioDriver().getScheduler();
+  sch.addTask(time, addresstofn, arg, addresstocls, true);
+}
 double mimium_getnow(void* runtimeptr) {
   auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
   return (double)runtime->getAudioDriver().getScheduler().getTime();
@@ -36,7 +332,13 @@ double mimium_getnow(void* runtimeptr) {
 // TODO(tomoya) ideally we need to move this to base runtime library
 void* mimium_malloc(void* runtimeptr, size_t size) {
   auto* runtime = static_cast<mimium::Runtime*>(runtimeptr);
+#ifdef _WIN32
   void* address = malloc(size);  // NOLINT
+#else
+  // memory objects are laid out assuming a cache-line aligned base address.
+  constexpr size_t alignment = 64;
+  void* address = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
   runtime->push_malloc(address, size);
   return address;
 }
@@ -45,21 +347,24 @@ void* mimium_malloc(void* runtimeptr, size_t size) {
 namespace mimium {
 Runtime_LLVM::Runtime_LLVM(std::unique_ptr<llvm::LLVMContext> ctx,
                            std::unique_ptr<llvm::Module> module, std::string const& /*filename_i*/,
-                           std::unique_ptr<AudioDriver> a, bool optimize)
-    : Runtime(std::move(a)), module(std::move(module)) {
+                           std::unique_ptr<AudioDriver> a, bool optimize,
+                           unsigned jit_threads)
+    : Runtime(std::move(a)), module(std::move(module)), jit_threads(jit_threads) {
   init(std::move(ctx), optimize);
 }
 
 Runtime_LLVM::Runtime_LLVM(std::string const& filepath, std::unique_ptr<AudioDriver> a,
-                           bool optimize)
-    : Runtime(std::move(a)) {
+                           bool optimize, unsigned jit_threads)
+    : Runtime(std::move(a)), jit_threads(jit_threads) {
   auto ctx = std::make_unique<llvm::LLVMContext>();
   llvm::SMDiagnostic errorreporter;
   module = llvm::parseIRFile(filepath, errorreporter, *ctx);
   init(std::move(ctx), optimize);
 }
 
-Runtime_LLVM::~Runtime_LLVM() = default;
+Runtime_LLVM::~Runtime_LLVM() {
+  for (auto&& [address, size] : malloc_container) { unregisterRandomArena(address); }
+}
 
 llvm::LLVMContext& Runtime_LLVM::getLLVMContext() { return jitengine->getContext(); }
 
@@ -70,11 +375,30 @@ void Runtime_LLVM::init(std::unique_ptr<llvm::LLVMContext> ctx, bool optimize) {
   llvm::InitializeNativeTargetDisassembler();
   using optlevel = llvm::orc::MimiumJIT::OptimizeLevel;
   auto opt = optimize ? optlevel::NORMAL : optlevel::NO;
-  jitengine = std::make_unique<llvm::orc::MimiumJIT>(std::move(ctx), opt);
+  jitengine = std::make_unique<llvm::orc::MimiumJIT>(std::move(ctx), opt, jit_threads);
+}
+void Runtime_LLVM::setVectorLibrary(std::string const& name) {
+  using veclib = llvm::TargetLibraryInfoImpl::VectorLibrary;
+  const std::unordered_map<std::string, veclib> libs = {
+      {"none", veclib::NoLibrary},
+      {"accelerate", veclib::Accelerate},
+      {"svml", veclib::SVML},
+      {"massv", veclib::MASSV},
+#if LLVM_VERSION_MAJOR >= 13
+      {"libmvec", veclib::LIBMVEC_X86},
+#endif
+  };
+  auto iter = libs.find(name);
+  if (iter == libs.end()) {
+    throw std::runtime_error("unknown or unsupported vector library: " + name);
+  }
+  jitengine->setVectorLibrary(iter->second);
 }
 void Runtime_LLVM::runMainFun() {
   assert(module != nullptr);
-  llvm::Error err = jitengine->addModule(std::move(this->module));
+  llvm::Error err = (jit_threads > 1)
+                        ? jitengine->addModuleParallel(std::move(this->module), jit_threads)
+                        : jitengine->addModule(std::move(this->module));
   if (err) { llvm::errs() << err << "\n"; };
   auto mainfun = jitengine->lookup("mimium_main");
 
@@ -94,6 +418,10 @@ void Runtime_LLVM::runMainFun() {
     Logger::debug_log("dsp function not found", Logger::INFO);
     llvm::consumeError(std::move(err));
   }
+  // voices keep the audio running like dsp.
+  if (audiodriver->getVoicePool() != nullptr) { hasdsp = true; }
+  auto* midiinput = audiodriver->getMidiInput();
+  if (midiinput != nullptr && midiinput->hasHandler()) { hasdsp = true; }
 }
 void Runtime_LLVM::start() {
   auto& sch = audiodriver->getScheduler();
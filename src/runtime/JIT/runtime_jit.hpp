@@ -20,13 +20,17 @@ class MIMIUM_DLL_PUBLIC Runtime_LLVM : public Runtime,
  public:
   explicit Runtime_LLVM(std::unique_ptr<llvm::LLVMContext> ctx, std::unique_ptr<llvm::Module>,
                         std::string const& filename = "untitled.mmm",
-                        std::unique_ptr<AudioDriver> a = nullptr, bool optimize = true);
+                        std::unique_ptr<AudioDriver> a = nullptr, bool optimize = true,
+                        unsigned jit_threads = 0);
   explicit Runtime_LLVM(std::string const& filepath, std::unique_ptr<AudioDriver> a = nullptr,
-                        bool optimize = true);
+                        bool optimize = true, unsigned jit_threads = 0);
   ~Runtime_LLVM() override;
   void start() override;
   void runMainFun() override;
 
+  // one of "none", "accelerate", "svml", "massv" and "libmvec"(LLVM 13 or later). Must be called
+  // before runMainFun.
+  void setVectorLibrary(std::string const& name);
   auto& getJitEngine() { return *jitengine; }
   llvm::LLVMContext& getLLVMContext();
 
@@ -34,14 +38,69 @@ class MIMIUM_DLL_PUBLIC Runtime_LLVM : public Runtime,
   // called by constructor.
   void init(std::unique_ptr<llvm::LLVMContext> ctx, bool optimize);
   std::unique_ptr<llvm::Module> module;
+  // number of module partitions compiled in parallel. 0 means a single module.
+  unsigned jit_threads;
   std::unique_ptr<llvm::orc::MimiumJIT> jitengine;
 };
 extern "C" {
 MIMIUM_DLL_PUBLIC void setDspParams(void* runtimeptr, void* dspfn, void* clsaddress,
                                     void* memobjaddress, int in_numchs, int out_numchs);
+MIMIUM_DLL_PUBLIC void setVoiceParams(void* runtimeptr, void* voicefn, void* clsaddress,
+                                      int64_t memobjsize, int in_numchs, int out_numchs);
+MIMIUM_DLL_PUBLIC void setSpectralParams(void* runtimeptr, void* spectralfn, void* clsaddress,
+                                         int64_t memobjsize, int isfloat32);
+// midiin function called with each message from the MIDI input of the audio driver, if any.
+MIMIUM_DLL_PUBLIC void setMidiInHandler(void* runtimeptr, void* handlerfn, void* clsaddress,
+                                        int isfloat32);
+// slot of the parameter at the address of the OSC server, or -1 if no server is opened. The slot
+// has the initial value until a message sets it.
+MIMIUM_DLL_PUBLIC double mimium_oscparam(void* runtimeptr, char* address, double init);
+// value of a slot, or 0 for unknown slots.
+MIMIUM_DLL_PUBLIC double mimium_oscvalue(void* runtimeptr, double slot);
+// returns id of allocated voice, or -1 if there is no voice function.
+MIMIUM_DLL_PUBLIC double mimium_voiceon(void* runtimeptr, double freq, double velocity);
+MIMIUM_DLL_PUBLIC void mimium_voiceoff(void* runtimeptr, double voice);
+// queues a message to the MIDI output of the audio driver, if any. Ignores system exclusive.
+MIMIUM_DLL_PUBLIC void mimium_midiout(void* runtimeptr, double status, double data1,
+                                      double data2);
+// decoded files shared in the sample store of the runtime. loadwav returns nullptr on failure.
+MIMIUM_DLL_PUBLIC double* mimium_loadwav(void* runtimeptr, char* filename);
+MIMIUM_DLL_PUBLIC float* mimium_loadwav_f32(void* runtimeptr, char* filename);
+MIMIUM_DLL_PUBLIC double mimium_loadwavsize(void* runtimeptr, char* filename);
+// returns id of the stream, or -1 on failure.
+MIMIUM_DLL_PUBLIC double mimium_openstream(void* runtimeptr, char* filename);
+MIMIUM_DLL_PUBLIC double mimium_readstream(void* runtimeptr, double stream);
+MIMIUM_DLL_PUBLIC double mimium_streamchannel(void* runtimeptr, double stream, double ch);
+// loads a file as loadwav and preprocesses its first channel for convolve.
+MIMIUM_DLL_PUBLIC double* mimium_loadir(void* runtimeptr, char* filename);
+MIMIUM_DLL_PUBLIC float* mimium_loadir_f32(void* runtimeptr, char* filename);
+// convolves with an impulse response returned by loadir. Others give silence.
+MIMIUM_DLL_PUBLIC double mimium_convolve(void* runtimeptr, double in, double* ir,
+                                         MmmConvolverT<double>* state);
+MIMIUM_DLL_PUBLIC float mimium_convolve_f32(void* runtimeptr, float in, float* ir,
+                                            MmmConvolverT<float>* state);
+// wavetable oscillators of the basic waveforms, of which the state is the phase.
+MIMIUM_DLL_PUBLIC double mimium_osc_saw(void* runtimeptr, double freq, double* phase);
+MIMIUM_DLL_PUBLIC float mimium_osc_saw_f32(void* runtimeptr, float freq, float* phase);
+MIMIUM_DLL_PUBLIC double mimium_osc_square(void* runtimeptr, double freq, double* phase);
+MIMIUM_DLL_PUBLIC float mimium_osc_square_f32(void* runtimeptr, float freq, float* phase);
+MIMIUM_DLL_PUBLIC double mimium_osc_tri(void* runtimeptr, double freq, double* phase);
+MIMIUM_DLL_PUBLIC float mimium_osc_tri_f32(void* runtimeptr, float freq, float* phase);
+// loads a file as loadwav and makes the mipmap of its first channel as one cycle for osc_table.
+MIMIUM_DLL_PUBLIC double* mimium_loadwavetable(void* runtimeptr, char* filename);
+MIMIUM_DLL_PUBLIC float* mimium_loadwavetable_f32(void* runtimeptr, char* filename);
+// plays a table returned by loadwavetable. Others give silence.
+MIMIUM_DLL_PUBLIC double mimium_osc_table(void* runtimeptr, double freq, double* table,
+                                          MmmWavetableOscT<double>* state);
+MIMIUM_DLL_PUBLIC float mimium_osc_table_f32(void* runtimeptr, float freq, float* table,
+                                             MmmWavetableOscT<float>* state);
 MIMIUM_DLL_PUBLIC void addTask(void* runtimeptr, double time, void* addresstofn, double arg);
 MIMIUM_DLL_PUBLIC void addTask_cls(void* runtimeptr, double time, void* addresstofn, double arg,
                                    void* addresstocls);
+// variants for the code compiled with Float as float. time is still given in double.
+MIMIUM_DLL_PUBLIC void addTask_f32(void* runtimeptr, double time, void* addresstofn, float arg);
+MIMIUM_DLL_PUBLIC void addTask_cls_f32(void* runtimeptr, double time, void* addresstofn,
+                                       float arg, void* addresstocls);
 MIMIUM_DLL_PUBLIC double mimium_getnow(void* runtimeptr);
 MIMIUM_DLL_PUBLIC void* mimium_malloc(void* runtimeptr, size_t size);
 }
@@ -0,0 +1,95 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "runtime/backend/api/driver_api.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace mimium {
+
+AudioDriverAPI::AudioDriverAPI(double samplerate, int maxframes, size_t capacity)
+    : AudioDriver(),
+      samplerate(samplerate),
+      maxframes(maxframes),
+      capacity(capacity),
+      scheduled(capacity) {
+  if (samplerate <= 0 || maxframes <= 0) {
+    throw std::runtime_error("sample rate and frame size must be positive");
+  }
+  setSampleFormat(SampleFormat::Float32);
+  task_capacity = capacity;
+  // messages of the host are passed to midiin function through the input.
+  setMidiInput(std::make_unique<MidiInput>(std::make_unique<MidiSourceInjected>(), capacity));
+}
+
+void AudioDriverAPI::setup(std::unique_ptr<AudioDriverParams> p) {
+  AudioDriver::setup(std::move(p));
+  in_ptrs.resize(params->in_numchs);
+  out_ptrs.resize(params->out_numchs);
+}
+
+std::unique_ptr<AudioDriverParams> AudioDriverAPI::getDefaultAudioParameter(
+    std::optional<int> samplerate, std::optional<int> framesize) const {
+  assert(dspfninfos != nullptr);
+  const double sr = samplerate ? static_cast<double>(samplerate.value()) : this->samplerate;
+  const int frames = framesize.value_or(maxframes);
+  auto bytes = static_cast<int>(frames * getSampleSize());
+  return std::make_unique<AudioDriverParams>(
+      AudioDriverParams{sr, bytes, frames, getInNumChs(), getOutNumChs()});
+}
+
+bool AudioDriverAPI::start() {
+  AudioDriver::start();
+  // MIDI input keeps the audio running like dsp.
+  bool hasdsp = dspfninfos->fn != nullptr || voices != nullptr || midiinput->hasHandler();
+  sch.start(hasdsp);
+  running.store(true);
+  return true;
+}
+
+bool AudioDriverAPI::stop() {
+  running.store(false);
+  sch.stop();
+  return true;
+}
+
+bool AudioDriverAPI::processPlanar(const float* const* input, float* const* output,
+                                   int nframes) {
+  if (params == nullptr) { return false; }
+  int offset = 0;
+  bool res = running.load();
+  for (; res && offset < nframes; offset += params->audioframesize) {
+    const int frames = std::min(nframes - offset, params->audioframesize);
+    for (size_t ch = 0; ch < in_ptrs.size(); ch++) { in_ptrs[ch] = input[ch] + offset; }
+    for (size_t ch = 0; ch < out_ptrs.size(); ch++) { out_ptrs[ch] = output[ch] + offset; }
+    dispatchScheduled();
+    res = process(in_ptrs.data(), out_ptrs.data(), frames);
+  }
+  if (!res) {
+    running.store(false);
+    const int from = std::max(0, offset - params->audioframesize);
+    for (size_t ch = 0; ch < out_ptrs.size(); ch++) {
+      std::fill(output[ch] + from, output[ch] + nframes, 0.0F);
+    }
+  }
+  processed.store(sch.getTime());
+  return res;
+}
+
+bool AudioDriverAPI::scheduleMidi(int64_t time, const uint8_t* bytes, size_t size) {
+  if (size == 0 || size > 3 || bytes[0] < 0x80 || bytes[0] == 0xF0) { return false; }
+  ScheduledMidi message{time, {}, static_cast<uint8_t>(size)};
+  std::copy(bytes, bytes + size, message.bytes.begin());
+  std::lock_guard<std::mutex> lock(schedule_mtx);
+  return scheduled.tryPush(message);
+}
+
+void AudioDriverAPI::dispatchScheduled() {
+  while (auto message = scheduled.tryPop()) {
+    midiinput->schedule(sch, std::max(message->time, sch.getTime()), message->bytes.data(),
+                        message->size);
+  }
+}
+
+}  // namespace mimium
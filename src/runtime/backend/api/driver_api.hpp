@@ -0,0 +1,60 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "runtime/backend/audiodriver.hpp"
+
+namespace mimium {
+
+// Driver for embedding mimium in audio servers and plugin hosts. It opens no device and no
+// thread: the host calls processPlanar on its own realtime thread with its own buffers, which
+// may have any number of frames. Blocks longer than the maximum frame size are split, and
+// nothing is allocated or locked while processing.
+class MIMIUM_DLL_PUBLIC AudioDriverAPI : public AudioDriver {
+ public:
+  // capacity is the number of MIDI messages and of tasks which can be pending without
+  // allocation.
+  AudioDriverAPI(double samplerate, int maxframes, size_t capacity = 1024);
+  void setup(std::unique_ptr<AudioDriverParams> p) override;
+  bool start() override;
+  bool stop() override;
+  // the buffers have the channels of dsp function for input, and of getOutNumChs for output.
+  [[nodiscard]] std::unique_ptr<AudioDriverParams> getDefaultAudioParameter(
+      std::optional<int> samplerate, std::optional<int> framesize) const override;
+  // called on the audio thread of the host. Returns false with silence once the scheduler has
+  // stopped or before start.
+  bool processPlanar(const float* const* input, float* const* output, int nframes);
+  // called on any thread. The message is passed to midiin function at the time in samples since
+  // start, or at the beginning of the next block if the time has passed. Returns false if the
+  // message is not a channel or system common message, or if the queue is full.
+  bool scheduleMidi(int64_t time, const uint8_t* bytes, size_t size);
+  // called on any thread. Number of samples processed since start.
+  [[nodiscard]] int64_t getProcessedTime() const { return processed.load(); }
+  [[nodiscard]] bool isRunning() const { return running.load(); }
+
+ private:
+  struct ScheduledMidi {
+    int64_t time;
+    std::array<uint8_t, 3> bytes;
+    uint8_t size;
+  };
+  void dispatchScheduled();
+  double samplerate;
+  int maxframes;
+  size_t capacity;
+  // the queue takes a single producer, so producers are serialized by the mutex.
+  std::mutex schedule_mtx;
+  SpscQueue<ScheduledMidi> scheduled;
+  // channels of the current split of the host buffers.
+  std::vector<const float*> in_ptrs;
+  std::vector<float*> out_ptrs;
+  std::atomic<int64_t> processed{0};
+  std::atomic<bool> running{false};
+};
+
+}  // namespace mimium
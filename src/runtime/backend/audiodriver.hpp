@@ -4,7 +4,15 @@
 
 #pragma once
 #include <memory>
+#include <type_traits>
+#include "runtime/backend/channel_mapping.hpp"
+#include "runtime/dsp_thread_pool.hpp"
+#include "runtime/midi_input.hpp"
+#include "runtime/midi_output.hpp"
+#include "runtime/osc_server.hpp"
 #include "runtime/runtime.hpp"
+#include "runtime/stft.hpp"
+#include "runtime/voice_pool.hpp"
 
 namespace mimium {
 
@@ -12,7 +20,15 @@ class MIMIUM_DLL_PUBLIC AudioDriver {
  protected:
   std::unique_ptr<AudioDriverParams> params;
   std::unique_ptr<DspFnInfos> dspfninfos;
+  std::unique_ptr<VoicePool> voices;
+  std::unique_ptr<SpectralProcessor> spectral;
+  std::unique_ptr<DspThreadPool> workers;
+  std::unique_ptr<MidiInput> midiinput;
+  std::unique_ptr<MidiOutput> midioutput;
+  std::unique_ptr<OscServer> oscserver;
+  HostClock hostclock;
   Scheduler sch;
+  SampleFormat sampleformat = SampleFormat::Float64;
 
  public:
   AudioDriver()
@@ -28,15 +44,78 @@ class MIMIUM_DLL_PUBLIC AudioDriver {
                           std::to_string(dspfninfos->out_numchs) + " output",
                       Logger::INFO);
   }
+  void setVoicePool(std::unique_ptr<VoicePool> p) {
+    voices = std::move(p);
+    Logger::debug_log("voice function:" + std::to_string(voices->getNumVoices()) + " voices, " +
+                          std::to_string(voices->getInfo().out_numchs) + " output",
+                      Logger::INFO);
+    prepareWorkers();
+  }
+  VoicePool* getVoicePool() { return voices.get(); }
+  void setSpectralProcessor(std::unique_ptr<SpectralProcessor> p) {
+    spectral = std::move(p);
+    Logger::debug_log("spectral function:" + std::to_string(spectral->getNumChannels()) +
+                          " channels, latency " + std::to_string(spectral->getLatency()) +
+                          " samples",
+                      Logger::INFO);
+  }
+  SpectralProcessor* getSpectralProcessor() { return spectral.get(); }
+  // messages are dispatched to the handler set by the main function. must be set before it runs.
+  void setMidiInput(std::unique_ptr<MidiInput> p) { midiinput = std::move(p); }
+  MidiInput* getMidiInput() { return midiinput.get(); }
+  void setMidiOutput(std::unique_ptr<MidiOutput> p) {
+    midioutput = std::move(p);
+    prepareWorkers();
+  }
+  MidiOutput* getMidiOutput() { return midioutput.get(); }
+  // parameters are added by the main function. must be set before it runs.
+  void setOscServer(std::unique_ptr<OscServer> p) { oscserver = std::move(p); }
+  OscServer* getOscServer() { return oscserver.get(); }
+  // called on the audio thread, on the workers rendering voices, or before the audio starts. The
+  // message is due after the latency of one block from the sample sending it, when the output of
+  // the sample is heard. Messages sent during a block are pushed after the voices, see MidiOutput.
+  void sendMidi(const uint8_t* bytes, size_t size) {
+    if (!midioutput) { return; }
+    if (rendering_block) {
+      // times of the scheduler are ahead of the current sample by 1.
+      auto const& voice = VoicePool::getRenderingVoice();
+      if (voice.worker >= 0) {
+        midioutput->collect(voice.worker, voice.time - 1, voice.voice, bytes, size);
+      } else {
+        midioutput->collect(0, sch.getTime() - 1, -1, bytes, size);
+      }
+      return;
+    }
+    midioutput->push(getMidiOutTime(sch.getTime() - 1), bytes, size);
+  }
+  // evaluates voices on the given number of threads including the audio thread. 0 or 1 disables.
+  void setDspThreads(int numthreads) {
+    workers = numthreads > 1 ? std::make_unique<DspThreadPool>(numthreads) : nullptr;
+    prepareWorkers();
+  }
+  // device buffers are converted from/to double frames of dsp function.
+  void setSampleFormat(SampleFormat format) { sampleformat = format; }
+  [[nodiscard]] SampleFormat getSampleFormat() const { return sampleformat; }
+  [[nodiscard]] size_t getSampleSize() const {
+    return sampleformat == SampleFormat::Float32 ? sizeof(float) : sizeof(double);
+  }
+  [[nodiscard]] int getInNumChs() const { return dspfninfos->in_numchs; }
+  // voices are mixed into the output of dsp, so the wider one decides the number of outputs.
+  [[nodiscard]] int getOutNumChs() const {
+    return voices ? std::max(dspfninfos->out_numchs, voices->getInfo().out_numchs)
+                  : dspfninfos->out_numchs;
+  }
   virtual void setup(std::unique_ptr<AudioDriverParams> p) {
     params = std::move(p);
     interleaved_in.resize(params->audioframesize * dspfninfos->in_numchs);
-    interleaved_out.resize(params->audioframesize * dspfninfos->out_numchs);
-    if (dspfninfos->in_numchs > params->in_numchs || dspfninfos->out_numchs > params->out_numchs) {
+    interleaved_out.resize(params->audioframesize * getOutNumChs());
+    if (dspfninfos->in_numchs > params->in_numchs || getOutNumChs() > params->out_numchs) {
       Logger::debug_log(
           "Number of inputs/outputs is bigger than number of the audio driver's inputs/outputs.",
           Logger::WARNING);
     }
+    sch.reserve(task_capacity);
+    prepareWorkers();
   }
 
   virtual bool start() {
@@ -49,12 +128,28 @@ class MIMIUM_DLL_PUBLIC AudioDriver {
       std::optional<int> samplerate, std::optional<int> framesize) const = 0;
   // Main dsp process function
   bool process(const double** input, double** output, int framesize) {
-    if (dspfninfos->fn != nullptr) { return processInternal<true>(input, output, framesize); }
+    dispatchExternalEvents(framesize);
+    if (hasDspOrVoices()) { return processInternal<true>(input, output, framesize); }
+    return processInternal<false>(input, output, framesize);
+  }
+  // Planar version for single precision hosts.
+  bool process(const float* const* input, float* const* output, int framesize) {
+    dispatchExternalEvents(framesize);
+    if (hasDspOrVoices()) { return processInternal<true>(input, output, framesize); }
     return processInternal<false>(input, output, framesize);
   }
   // Interleaved version of main dsp process.
   bool process(const double* input, double* output, int framesize) {
-    if (dspfninfos->fn != nullptr) {
+    dispatchExternalEvents(framesize);
+    if (hasDspOrVoices()) {
+      return processInternalInterleaved<true>(input, output, framesize);
+    }
+    return processInternalInterleaved<false>(input, output, framesize);
+  }
+  // Interleaved version for single precision devices.
+  bool process(const float* input, float* output, int framesize) {
+    dispatchExternalEvents(framesize);
+    if (hasDspOrVoices()) {
       return processInternalInterleaved<true>(input, output, framesize);
     }
     return processInternalInterleaved<false>(input, output, framesize);
@@ -62,49 +157,73 @@ class MIMIUM_DLL_PUBLIC AudioDriver {
 
  protected:
   inline static constexpr int default_framesize = 256;
+  // number of tasks which can be pending without allocation on the audio thread, including the
+  // ones made from MIDI and OSC messages.
+  size_t task_capacity = 1024;
 
  private:
-  std::vector<double> interleaved_in;
-  std::vector<double> interleaved_out;
-  // buffer copy into vector from pointer of poitner
-  static void interleaveSamples(const double** src, std::vector<double>& dest, int framesize,
-                                int dsp_chans, int device_chans) {
-    for (int ch = 0; ch < dsp_chans; ch++) {
-      const auto* samples_ch = *std::next(src, ch);
-      if (ch < device_chans) {
-        for (int count = 0; count < framesize; count++) {
-          dest.at(count + count * ch) = *std::next(samples_ch, count);
-        }
-      } else {
-        for (int count = 0; count < framesize; count++) { dest.at(count + count * ch) = 0; }
-      }
+  [[nodiscard]] bool hasDspOrVoices() const { return dspfninfos->fn != nullptr || voices; }
+  // events of MIDI and OSC become tasks. The host clock is followed only when they are used, as
+  // it reads the system clock.
+  void dispatchExternalEvents(int framesize) {
+    if (!midiinput && !midioutput && !oscserver) { return; }
+    hostclock.update(sch.getTime(), framesize, params->samplerate, HostClock::getHostTime());
+    if (midiinput && midiinput->hasHandler()) {
+      midiinput->dispatch(sch, hostclock, sch.getTime(), framesize);
     }
+    if (oscserver) { oscserver->dispatch(sch, hostclock, sch.getTime(), framesize); }
   }
-  // buffer copy into pointer of poitner from vector
-  static void deinterleaveSamples(std::vector<double> const& src, double** dest, int framesize,
-                                  int dsp_chans, int device_chans) {
-    for (int ch = 0; ch < dsp_chans; ch++) {
-      auto* dest_ch = *std::next(dest, ch);
-      if (ch < device_chans) {
-        for (int count = 0; count < framesize; count++) {
-          *std::next(dest_ch, count) = src.at(count + count * ch);
-        }
-      } else {
-        std::fill(dest_ch, std::next(dest_ch, framesize), 0);
-      }
+  // buffers of the workers are sized once the block size and the threads are known, and the
+  // release of voices once the sample rate is.
+  void prepareWorkers() {
+    const int numworkers = workers ? workers->getNumWorkers() : 1;
+    if (midioutput) { midioutput->prepareWorkers(numworkers); }
+    if (!voices || !params) { return; }
+    voices->prepare(numworkers, params->audioframesize, getOutNumChs());
+    voices->setSampleRate(params->samplerate);
+  }
+  // host time when a message sent at the sample is due.
+  double getMidiOutTime(int64_t time) {
+    if (!hostclock.isAnchored()) { return HostClock::getHostTime(); }
+    return hostclock.toHost(static_cast<double>(time + params->audioframesize));
+  }
+  // voices start from zero for the channels which dsp does not write.
+  void beginBlock(double* output, int framesize) {
+    rendering_block = midioutput != nullptr;
+    if (!voices) { return; }
+    std::fill(output, std::next(output, framesize * getOutNumChs()), 0.0);
+    voices->beginBlock(sch.getTime() + 1);
+  }
+  // voices are mixed before the spectral stage, which replaces the whole output.
+  void endBlock(double* output, int framesize) {
+    if (voices) { voices->process(output, getOutNumChs(), framesize, workers.get()); }
+    if (spectral) { spectral->process(output, getOutNumChs(), framesize); }
+    if (rendering_block) {
+      midioutput->flush([this](int64_t time) { return getMidiOutTime(time); });
+      rendering_block = false;
     }
   }
+  std::vector<double> interleaved_in;
+  std::vector<double> interleaved_out;
+  // MIDI messages are collected between beginBlock and endBlock.
+  bool rendering_block = false;
 
-  template <bool HASDSP>
-  bool processInternal(const double** input, double** output, int framesize) {
-    assert(framesize == params->audioframesize);
+  // framesize may be smaller than the one of setup, for hosts which split blocks.
+  template <bool HASDSP, typename T>
+  bool processInternal(const T* const* input, T* const* output, int framesize) {
+    assert(framesize <= params->audioframesize);
     bool res = true;
-    interleaveSamples(input, interleaved_in, framesize, dspfninfos->in_numchs, params->in_numchs);
+    const int dsp_ins = dspfninfos->in_numchs;
+    const int dsp_outs = getOutNumChs();
+    channels::interleave(input, params->in_numchs, interleaved_in.data(), dsp_ins, framesize);
+    beginBlock(interleaved_out.data(), framesize);
     for (int count = 0; count < framesize; count++) {
-      res &= this->processSample<HASDSP>(interleaved_in.data(), interleaved_out.data());
+      res &= this->processSample<HASDSP>(std::next(interleaved_in.data(), count * dsp_ins),
+                                         std::next(interleaved_out.data(), count * dsp_outs));
     }
-    deinterleaveSamples(interleaved_out, output, framesize, dspfninfos->out_numchs,
-                        params->out_numchs);
+    endBlock(interleaved_out.data(), framesize);
+    channels::deinterleave(interleaved_out.data(), dsp_outs, output, params->out_numchs,
+                           framesize);
     return res;
   }
   template <bool HASDSP>
@@ -115,46 +234,45 @@ class MIMIUM_DLL_PUBLIC AudioDriver {
       return false;
     }
     if constexpr (HASDSP) {
-      dspfninfos->fn(output, input, dspfninfos->cls_address, dspfninfos->memobj_address);
+      if (dspfninfos->fn != nullptr) {
+        dspfninfos->fn(output, input, dspfninfos->cls_address, dspfninfos->memobj_address);
+      }
     }
     return true;
   }
 
-  template <bool HASDSP>
-  bool processInternalInterleaved(const double* input, double* output, int framesize) {
+  template <bool HASDSP, typename T>
+  bool processInternalInterleaved(const T* input, T* output, int framesize) {
     if constexpr (HASDSP) {
-      int dsp_ins = dspfninfos->in_numchs;
-      int device_ins = params->in_numchs;
-      int dsp_outs = dspfninfos->out_numchs;
-      int device_outs = params->out_numchs;
-      for (int ch = 0; ch < dsp_ins; ch++) {
-        for (int count = 0; count < framesize; count++) {
-          if (ch > device_ins) {
-            interleaved_in[ch + dsp_ins * count] = input[ch + device_ins * count];
-          } else {
-            interleaved_in[ch + dsp_ins * count] = 0;
-          }
-        }
+      const int dsp_ins = dspfninfos->in_numchs;
+      const int device_ins = params->in_numchs;
+      const int dsp_outs = getOutNumChs();
+      const int device_outs = params->out_numchs;
+      // dsp reads and writes the device buffers directly when the layouts match.
+      const double* inbuf = interleaved_in.data();
+      double* outbuf = interleaved_out.data();
+      if constexpr (std::is_same_v<T, double>) {
+        if (dsp_ins == device_ins && input != nullptr) { inbuf = input; }
+        if (dsp_outs == device_outs) { outbuf = output; }
+      }
+      if (inbuf == interleaved_in.data()) {
+        channels::remap(input, device_ins, interleaved_in.data(), dsp_ins, framesize);
       }
       bool res = true;
+      beginBlock(outbuf, framesize);
       for (int count = 0; count < framesize; count++) {
-        res &= processSample<true>(std::next(interleaved_in.data(), count * dsp_ins),
-                                   std::next(interleaved_out.data(), count * dsp_outs));
+        res &= processSample<true>(std::next(inbuf, count * dsp_ins),
+                                   std::next(outbuf, count * dsp_outs));
       }
-      for (int ch = 0; ch < dsp_outs; ch++) {
-        for (int count = 0; count < framesize; count++) {
-          if (ch < device_outs) {
-            output[ch + device_outs * count] = interleaved_out[ch + dsp_outs * count];
-          } else {
-            output[ch + device_outs * count] = 0;
-          }
-        }
+      endBlock(outbuf, framesize);
+      if (outbuf == interleaved_out.data()) {
+        channels::remap(interleaved_out.data(), dsp_outs, output, device_outs, framesize);
       }
       return res;
     } else {
       bool res = true;
       for (int count = 0; count < framesize; count++) {
-        res |= processSample<false>(input, output);
+        res |= processSample<false>(nullptr, nullptr);
       }
       return res;
     }
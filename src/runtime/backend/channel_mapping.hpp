@@ -0,0 +1,101 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <algorithm>
+
+// Conversion of audio frames between the layout of dsp function and of audio devices.
+// A mono source is copied to all the channels of the destination (upmix). Otherwise the channels
+// which the source does not have are filled with zero, and extra channels of the source are
+// dropped. Sample types may differ, e.g. float buffers of a device and double frames of dsp.
+// Loops run over contiguous non-aliasing pointers, with fixed channel counts for the common
+// layouts, so that compilers can vectorize them.
+namespace mimium::channels {
+
+// index of the source channel for a channel of the destination, or -1 for silence.
+constexpr int getSourceChannel(int ch, int src_chs) {
+  if (src_chs == 1) { return 0; }
+  return ch < src_chs ? ch : -1;
+}
+
+// planar to interleaved.
+template <typename S, typename D>
+void interleave(const S* const* src, int src_chs, D* dst, int dst_chs, int frames) {
+  if (dst_chs == 2 && src_chs > 0) {
+    const S* __restrict left = src[0];
+    const S* __restrict right = src[getSourceChannel(1, src_chs)];
+    D* __restrict out = dst;
+    for (int i = 0; i < frames; i++) {
+      out[2 * i] = static_cast<D>(left[i]);
+      out[2 * i + 1] = static_cast<D>(right[i]);
+    }
+    return;
+  }
+  for (int ch = 0; ch < dst_chs; ch++) {
+    const int src_ch = getSourceChannel(ch, src_chs);
+    D* __restrict out = dst + ch;
+    if (src_ch < 0) {
+      for (int i = 0; i < frames; i++) { out[i * dst_chs] = 0; }
+      continue;
+    }
+    const S* __restrict in = src[src_ch];
+    for (int i = 0; i < frames; i++) { out[i * dst_chs] = static_cast<D>(in[i]); }
+  }
+}
+
+// interleaved to planar.
+template <typename S, typename D>
+void deinterleave(const S* src, int src_chs, D* const* dst, int dst_chs, int frames) {
+  if (src_chs == 2 && dst_chs == 2) {
+    const S* __restrict in = src;
+    D* __restrict left = dst[0];
+    D* __restrict right = dst[1];
+    for (int i = 0; i < frames; i++) {
+      left[i] = static_cast<D>(in[2 * i]);
+      right[i] = static_cast<D>(in[2 * i + 1]);
+    }
+    return;
+  }
+  for (int ch = 0; ch < dst_chs; ch++) {
+    const int src_ch = getSourceChannel(ch, src_chs);
+    D* __restrict out = dst[ch];
+    if (src_ch < 0) {
+      std::fill(out, out + frames, D{0});
+      continue;
+    }
+    const S* __restrict in = src + src_ch;
+    for (int i = 0; i < frames; i++) { out[i] = static_cast<D>(in[i * src_chs]); }
+  }
+}
+
+// interleaved to interleaved with a different number of channels or sample type.
+template <typename S, typename D>
+void remap(const S* src, int src_chs, D* dst, int dst_chs, int frames) {
+  D* __restrict out = dst;
+  if (src_chs == dst_chs) {
+    const S* __restrict in = src;
+    const int len = frames * dst_chs;
+    for (int i = 0; i < len; i++) { out[i] = static_cast<D>(in[i]); }
+    return;
+  }
+  if (src_chs == 1 && dst_chs == 2) {
+    const S* __restrict in = src;
+    for (int i = 0; i < frames; i++) {
+      out[2 * i] = static_cast<D>(in[i]);
+      out[2 * i + 1] = static_cast<D>(in[i]);
+    }
+    return;
+  }
+  for (int ch = 0; ch < dst_chs; ch++) {
+    const int src_ch = getSourceChannel(ch, src_chs);
+    if (src_ch < 0) {
+      for (int i = 0; i < frames; i++) { out[ch + i * dst_chs] = 0; }
+      continue;
+    }
+    const S* __restrict in = src + src_ch;
+    for (int i = 0; i < frames; i++) { out[ch + i * dst_chs] = static_cast<D>(in[i * src_chs]); }
+  }
+}
+
+}  // namespace mimium::channels
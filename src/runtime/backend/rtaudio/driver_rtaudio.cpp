@@ -11,8 +11,13 @@ const RtAudioCallback callback = [](void* output, void* input, unsigned int n_fr
                                     void* userdata) -> int {
   auto* driver = static_cast<mimium::AudioDriverRtAudio*>(userdata);
   // Process interleaved audio data.
-  driver->process(static_cast<const double*>(input), static_cast<double*>(output),
-                  static_cast<int>(n_frames));
+  if (driver->getSampleFormat() == mimium::SampleFormat::Float32) {
+    driver->process(static_cast<const float*>(input), static_cast<float*>(output),
+                    static_cast<int>(n_frames));
+  } else {
+    driver->process(static_cast<const double*>(input), static_cast<double*>(output),
+                    static_cast<int>(n_frames));
+  }
   if (status > 0) {
     mimium::Logger::debug_log("Stream underflow detected!", mimium::Logger::WARNING);
   }
@@ -86,12 +91,14 @@ std::unique_ptr<AudioDriverParams> AudioDriverRtAudio::getDefaultAudioParameter(
   assert(rtaudio != nullptr && dspfninfos != nullptr);
   auto in_chs = std::min(static_cast<int>(rtaudio_params_input->get().nChannels),
                          this->dspfninfos->in_numchs);
+  // mono output is copied to both channels of a stereo device.
   auto out_chs = std::min(static_cast<int>(rtaudio_params_output->get().nChannels),
-                          this->dspfninfos->out_numchs);
+                          getOutNumChs() == 1 ? 2 : getOutNumChs());
   int sr = samplerate.value_or(getPreferredSampleRate());
   int frames = framesize.value_or(AudioDriver::default_framesize);
-  return std::make_unique<AudioDriverParams>(AudioDriverParams{
-      static_cast<double>(sr), static_cast<int>(frames * sizeof(double)), frames, in_chs, out_chs});
+  auto bytes = static_cast<int>(frames * getSampleSize());
+  return std::make_unique<AudioDriverParams>(
+      AudioDriverParams{static_cast<double>(sr), bytes, frames, in_chs, out_chs});
 }
 
 bool AudioDriverRtAudio::start() {
@@ -109,12 +116,15 @@ bool AudioDriverRtAudio::start() {
     }
     // check parameter are valid
     unsigned int framesize = params->audioframesize;
-    rtaudio->openStream(oparam, iparam, RTAUDIO_FLOAT64, params->samplerate, &framesize, callback,
-                        this, &rtaudio_options->get(), nullptr);
+    auto format = sampleformat == SampleFormat::Float32 ? RTAUDIO_FLOAT32 : RTAUDIO_FLOAT64;
+    rtaudio->openStream(oparam, iparam, format, params->samplerate, &framesize, callback, this,
+                        &rtaudio_options->get(), nullptr);
     printStreamInfo();
     params->audioframesize = framesize;
 
-    bool hasdsp = dspfninfos->fn != nullptr;
+    // MIDI input keeps the audio running like dsp.
+    bool hasdsp = dspfninfos->fn != nullptr || voices != nullptr ||
+                  (midiinput != nullptr && midiinput->hasHandler());
     sch.start(hasdsp);
     rtaudio->startStream();
   } catch (RtAudioError& e) {
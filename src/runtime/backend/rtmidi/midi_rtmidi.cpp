@@ -0,0 +1,88 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "runtime/backend/rtmidi/midi_rtmidi.hpp"
+#include "RtMidi.h"
+#include "basic/helper_functions.hpp"
+
+namespace {
+// accumulated time behind the host time more than this is regarded as a drift of the clocks.
+constexpr double max_delay = 0.01;
+
+void callback(double deltatime, std::vector<unsigned char>* message, void* userdata) {
+  auto* source = static_cast<mimium::MidiSourceRtMidi*>(userdata);
+  source->receive(deltatime, message->data(), message->size());
+}
+}  // namespace
+
+namespace mimium {
+
+MidiSourceRtMidi::MidiSourceRtMidi(std::optional<unsigned int> port) : port(port) {
+  try {
+    midiin = std::make_unique<RtMidiIn>(RtMidi::Api::UNSPECIFIED, "mimium");
+  } catch (RtMidiError& e) { throw std::runtime_error("MIDI input: " + e.getMessage()); }
+  if (port && port.value() >= midiin->getPortCount()) {
+    throw std::runtime_error("MIDI input port number out of range: " +
+                             std::to_string(port.value()));
+  }
+}
+MidiSourceRtMidi::~MidiSourceRtMidi() { close(); }
+
+void MidiSourceRtMidi::open(Callback cb) {
+  callback = std::move(cb);
+  lasttime = std::nullopt;
+  // system exclusive, timing and active sensing messages are not delivered.
+  midiin->ignoreTypes(true, true, true);
+  midiin->setCallback(::callback, this);
+  try {
+    if (port) {
+      midiin->openPort(port.value());
+      Logger::debug_log("MIDI input: " + midiin->getPortName(port.value()), Logger::INFO);
+    } else {
+      midiin->openVirtualPort("mimium-midi-in");
+    }
+  } catch (RtMidiError& e) { throw std::runtime_error("MIDI input: " + e.getMessage()); }
+}
+
+void MidiSourceRtMidi::close() {
+  if (midiin == nullptr) { return; }
+  if (midiin->isPortOpen()) { midiin->closePort(); }
+  midiin->cancelCallback();
+}
+
+void MidiSourceRtMidi::receive(double deltatime, const uint8_t* bytes, size_t size) {
+  const double now = HostClock::getHostTime();
+  double time = lasttime ? lasttime.value() + deltatime : now;
+  // the driver's clock can not be ahead of the arrival, and should not fall far behind it.
+  if (time > now || now - time > max_delay) { time = now; }
+  lasttime = time;
+  if (callback) { callback(time, bytes, size); }
+}
+
+MidiSinkRtMidi::MidiSinkRtMidi(std::optional<unsigned int> port) {
+  try {
+    midiout = std::make_unique<RtMidiOut>(RtMidi::Api::UNSPECIFIED, "mimium");
+    if (!port) {
+      midiout->openVirtualPort("mimium-midi-out");
+      return;
+    }
+    if (port.value() >= midiout->getPortCount()) {
+      throw std::runtime_error("MIDI output port number out of range: " +
+                               std::to_string(port.value()));
+    }
+    midiout->openPort(port.value());
+    Logger::debug_log("MIDI output: " + midiout->getPortName(port.value()), Logger::INFO);
+  } catch (RtMidiError& e) { throw std::runtime_error("MIDI output: " + e.getMessage()); }
+}
+MidiSinkRtMidi::~MidiSinkRtMidi() {
+  if (midiout->isPortOpen()) { midiout->closePort(); }
+}
+
+void MidiSinkRtMidi::send(const uint8_t* bytes, size_t size) {
+  try {
+    midiout->sendMessage(bytes, size);
+  } catch (RtMidiError& e) { Logger::debug_log("MIDI output: " + e.getMessage(), Logger::ERROR_); }
+}
+
+}  // namespace mimium
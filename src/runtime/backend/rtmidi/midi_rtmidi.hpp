@@ -0,0 +1,44 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <optional>
+#include "runtime/midi_output.hpp"
+
+class RtMidiIn;
+class RtMidiOut;
+namespace mimium {
+
+// MIDI input from a port of RtMidi, or from a virtual port named "mimium-midi-in" when the port
+// is not given.
+class MIMIUM_DLL_PUBLIC MidiSourceRtMidi : public MidiSource {
+ public:
+  explicit MidiSourceRtMidi(std::optional<unsigned int> port = std::nullopt);
+  ~MidiSourceRtMidi() override;
+  void open(Callback cb) override;
+  void close() override;
+  // called by RtMidi with the seconds since the previous message.
+  void receive(double deltatime, const uint8_t* bytes, size_t size);
+
+ private:
+  std::unique_ptr<RtMidiIn> midiin;
+  std::optional<unsigned int> port;
+  Callback callback;
+  // the deltas given by the driver are accumulated on the host time of the first message, so
+  // that messages keep their distances even if the thread of RtMidi wakes up late.
+  std::optional<double> lasttime;
+};
+
+// MIDI output to a port of RtMidi, or to a virtual port named "mimium-midi-out" when the port is
+// not given.
+class MIMIUM_DLL_PUBLIC MidiSinkRtMidi : public MidiSink {
+ public:
+  explicit MidiSinkRtMidi(std::optional<unsigned int> port = std::nullopt);
+  ~MidiSinkRtMidi() override;
+  void send(const uint8_t* bytes, size_t size) override;
+
+ private:
+  std::unique_ptr<RtMidiOut> midiout;
+};
+}  // namespace mimium
@@ -0,0 +1,219 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "runtime/convolver.hpp"
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace mimium {
+namespace {
+int64_t roundUpToPow2(int64_t n) {
+  int64_t res = 1;
+  while (res < n) { res <<= 1; }
+  return res;
+}
+}  // namespace
+
+ConvolutionKernel::ConvolutionKernel(std::vector<double> const& ir, int head_size,
+                                     int max_partition)
+    : length(static_cast<int64_t>(ir.size())) {
+  assert(head_size > 0 && head_size <= max_partition);
+  head.assign(ir.begin(), ir.begin() + std::min<int64_t>(head_size, length));
+  int64_t offset = head_size;
+  int partition = head_size;
+  while (offset < length) {
+    const int next = std::min(partition * 4, max_partition);
+    const int64_t remaining = (length - offset + partition - 1) / partition;
+    // fill the gap up to the offset where the next stage can start with its delay.
+    const int64_t nextoffset = next + next / 2;
+    const int64_t gap = std::max<int64_t>(1, (nextoffset - offset + partition - 1) / partition);
+    const int64_t numpartitions = partition == max_partition ? remaining : std::min(remaining, gap);
+    const int delay = offset >= partition + partition / 2 ? partition / 2 : 0;
+    Stage stage{partition, offset, delay, {}};
+    RealFFT fft(2 * partition);
+    std::vector<double> buf(2 * partition);
+    for (int64_t p = 0; p < numpartitions; p++) {
+      std::fill(buf.begin(), buf.end(), 0.0);
+      const int64_t from = offset + p * partition;
+      const int64_t to = std::min<int64_t>(from + partition, length);
+      std::copy(ir.begin() + from, ir.begin() + to, buf.begin());
+      auto& spectrum = stage.spectra.emplace_back(fft.getNumBins());
+      fft.forward(buf.data(), spectrum.data());
+    }
+    stages.emplace_back(std::move(stage));
+    offset += numpartitions * partition;
+    partition = next;
+  }
+}
+
+Convolver::Convolver(const ConvolutionKernel& kernel) : kernel(kernel) {
+  int64_t maxpartition = static_cast<int64_t>(kernel.getHead().size());
+  int64_t maxwindow = maxpartition;
+  int64_t maxdelay = 1;
+  for (auto& stage : kernel.getStages()) {
+    maxpartition = std::max<int64_t>(maxpartition, stage.partition);
+    maxwindow = std::max<int64_t>(maxwindow, stage.partition + stage.delay);
+    maxdelay = std::max(maxdelay, stage.offset + stage.partition);
+    auto& state = states.emplace_back(stage.partition);
+    state.fdl.assign(stage.spectra.size(),
+                     std::vector<std::complex<double>>(stage.partition + 1));
+    state.acc.assign(stage.partition + 1, 0.0);
+  }
+  input_size = roundUpToPow2(std::max<int64_t>(maxwindow, 1));
+  input.assign(2 * input_size, 0.0);
+  output.assign(roundUpToPow2(maxdelay), 0.0);
+  output_mask = static_cast<int64_t>(output.size()) - 1;
+  block.resize(2 * maxpartition);
+  scratch.resize(maxpartition + 1);
+}
+
+void Convolver::reset() {
+  std::fill(input.begin(), input.end(), 0.0);
+  std::fill(output.begin(), output.end(), 0.0);
+  for (auto& state : states) {
+    for (auto& spectrum : state.fdl) { std::fill(spectrum.begin(), spectrum.end(), 0.0); }
+    state.pos = 0;
+    std::fill(state.acc.begin(), state.acc.end(), 0.0);
+    state.accbin = 0;
+  }
+  count = 0;
+}
+
+double Convolver::process(double in) {
+  if (kernel.isEmpty()) { return 0.0; }
+  const int64_t pos = count & (input_size - 1);
+  input[pos] = in;
+  input[pos + input_size] = in;
+  // head, with the newest sample at the end of the window.
+  const auto& head = kernel.getHead();
+  const int64_t headlen = static_cast<int64_t>(head.size());
+  const double* window = &input[pos + input_size - headlen + 1];
+  double res = 0.0;
+  for (int64_t k = 0; k < headlen; k++) { res += head[k] * window[headlen - 1 - k]; }
+  const int64_t now = count++;
+  for (size_t i = 0; i < states.size(); i++) {
+    const auto& stage = kernel.getStages()[i];
+    accumulateStage(i);
+    if ((count - stage.delay) % stage.partition == 0) { processStage(i); }
+  }
+  auto& out = output[now & output_mask];
+  res += out;
+  out = 0.0;
+  return res;
+}
+
+// accumulates a slice of bins of the products for the next block, so that all the bins are done
+// within the block period.
+void Convolver::accumulateStage(size_t index) {
+  const auto& stage = kernel.getStages()[index];
+  auto& state = states[index];
+  const int numbins = stage.partition + 1;
+  if (state.accbin >= numbins) { return; }
+  const int from = state.accbin;
+  const int to = std::min(numbins, from + (numbins + stage.partition - 1) / stage.partition);
+  // the next block is written at pos+1, and the partition k is multiplied with the k-th older.
+  const size_t numparts = state.fdl.size();
+  for (size_t k = 1; k < numparts; k++) {
+    const auto& x = state.fdl[(state.pos + 1 + numparts - k) % numparts];
+    const auto& h = stage.spectra[k];
+    for (int bin = from; bin < to; bin++) { state.acc[bin] += x[bin] * h[bin]; }
+  }
+  state.accbin = to;
+}
+
+// convolves the block of partition size samples filled delay samples ago with the stage, and adds
+// the result to the output starting at (start of the block + offset).
+void Convolver::processStage(size_t index) {
+  const auto& stage = kernel.getStages()[index];
+  auto& state = states[index];
+  const int p = stage.partition;
+  const int64_t blockstart = count - stage.delay - p;
+  const double* in = &input[(blockstart & (input_size - 1))];
+  std::copy(in, in + p, block.begin());
+  std::fill(block.begin() + p, block.begin() + 2 * p, 0.0);
+  const size_t numparts = state.fdl.size();
+  state.pos = (state.pos + 1) % numparts;
+  auto& x = state.fdl[state.pos];
+  state.fft.forward(block.data(), x.data());
+  const auto& h = stage.spectra[0];
+  for (int bin = 0; bin <= p; bin++) {
+    scratch[bin] = state.acc[bin] + x[bin] * h[bin];
+    state.acc[bin] = 0.0;
+  }
+  state.accbin = 0;
+  state.fft.inverse(scratch.data(), block.data());
+  const double scale = 1.0 / (2.0 * p);
+  const int64_t outstart = blockstart + stage.offset;
+  for (int i = 0; i < 2 * p - 1; i++) { output[(outstart + i) & output_mask] += block[i] * scale; }
+}
+
+ConvolutionStore::Entry::Entry(std::vector<double> const& ir, int num_instances)
+    : kernel(ir), owners(std::make_unique<std::atomic<const void*>[]>(num_instances)) {
+  for (int i = 0; i < num_instances; i++) {
+    instances.emplace_back(std::make_unique<Convolver>(kernel));
+    owners[i] = nullptr;
+  }
+}
+
+void ConvolutionStore::addKernel(std::vector<double> const& ir,
+                                 std::vector<const void*> const& keys, int num_instances) {
+  std::lock_guard<std::mutex> lock(mtx);
+  if (std::all_of(keys.begin(), keys.end(), [&](auto* k) { return findEntry(k) != nullptr; })) {
+    return;
+  }
+  const size_t n = num_keys.load(std::memory_order_relaxed);
+  if (n + keys.size() > max_keys) { throw std::runtime_error("too many impulse responses"); }
+  auto& entry = entries.emplace_back(std::make_unique<Entry>(ir, std::max(num_instances, 1)));
+  for (size_t i = 0; i < keys.size(); i++) {
+    this->keys[n + i] = keys[i];
+    key_entries[n + i] = entry.get();
+  }
+  num_keys.store(n + keys.size(), std::memory_order_release);
+}
+
+// the newest entry for the key, as the address of a freed impulse response can be reused.
+ConvolutionStore::Entry* ConvolutionStore::findEntry(const void* key) const {
+  for (size_t i = num_keys.load(std::memory_order_acquire); i > 0; i--) {
+    if (keys[i - 1] == key) { return key_entries[i - 1]; }
+  }
+  return nullptr;
+}
+
+const ConvolutionKernel* ConvolutionStore::findKernel(const void* key) const {
+  auto* entry = findEntry(key);
+  return entry != nullptr ? &entry->kernel : nullptr;
+}
+
+Convolver* ConvolutionStore::getInstance(const void* state, const void* key) {
+  auto* entry = findEntry(key);
+  if (entry == nullptr) { return &silent; }
+  const size_t size = entry->instances.size();
+  for (size_t i = 0; i < size; i++) {
+    if (entry->owners[i].load(std::memory_order_relaxed) == state) {
+      entry->instances[i]->reset();
+      return entry->instances[i].get();
+    }
+  }
+  for (size_t i = 0; i < size; i++) {
+    const void* expected = nullptr;
+    if (entry->owners[i].compare_exchange_strong(expected, state)) {
+      return entry->instances[i].get();
+    }
+  }
+  return &silent;
+}
+
+size_t ConvolutionStore::getNumInstances() const {
+  std::lock_guard<std::mutex> lock(mtx);
+  size_t res = 0;
+  for (auto const& entry : entries) {
+    for (size_t i = 0; i < entry->instances.size(); i++) {
+      if (entry->owners[i].load() != nullptr) { res++; }
+    }
+  }
+  return res;
+}
+
+}  // namespace mimium
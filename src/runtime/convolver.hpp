@@ -0,0 +1,134 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "export.hpp"
+#include "runtime/fft.hpp"
+
+namespace mimium {
+
+// Impulse response preprocessed for the partitioned convolution, shared by the instances.
+// The first head_size taps are convolved directly in time domain, so that there is no latency.
+// The rest is split into stages of uniform partitions, of which the size grows by 4 times up to
+// max_partition. Each stage starts at an offset not less than its partition size plus its delay,
+// so its result is ready before it is needed. The last stage takes all the remaining taps.
+class MIMIUM_DLL_PUBLIC ConvolutionKernel {
+ public:
+  struct Stage {
+    int partition;
+    int64_t offset;
+    // samples by which the stage computes its block later than the block is filled. The stages
+    // after the first are delayed by half of their partitions, so that no two of them compute at
+    // the same sample.
+    int delay;
+    // real spectra of the partitions zero-padded to 2*partition, of partition+1 bins.
+    std::vector<std::vector<std::complex<double>>> spectra;
+  };
+  explicit ConvolutionKernel(std::vector<double> const& ir, int head_size = 64,
+                             int max_partition = 8192);
+  [[nodiscard]] int64_t getLength() const { return length; }
+  [[nodiscard]] bool isEmpty() const { return length == 0; }
+  [[nodiscard]] std::vector<double> const& getHead() const { return head; }
+  [[nodiscard]] std::vector<Stage> const& getStages() const { return stages; }
+
+ private:
+  int64_t length;
+  std::vector<double> head;
+  std::vector<Stage> stages;
+};
+
+// state of convolution for an instance, processed sample by sample. A stage computes its
+// partition when a block of its size is filled and its delay has passed. The products with the
+// older input spectra are accumulated a few bins per sample during the block period before, so
+// that only the transforms and the product with the newest spectrum remain at that sample.
+// The transforms of the largest partition are still computed in one sample, which is a known
+// limitation: a 16384-point real FFT and its inverse in a single callback.
+class MIMIUM_DLL_PUBLIC Convolver {
+ public:
+  explicit Convolver(const ConvolutionKernel& kernel);
+  double process(double in);
+  // clears the signals for a new instance, without allocation.
+  void reset();
+  [[nodiscard]] const ConvolutionKernel& getKernel() const { return kernel; }
+
+ private:
+  void processStage(size_t index);
+  void accumulateStage(size_t index);
+  struct StageState {
+    explicit StageState(int partition) : fft(2 * partition) {}
+    RealFFT fft;
+    // frequency-domain delay line of the input blocks.
+    std::vector<std::vector<std::complex<double>>> fdl;
+    size_t pos = 0;
+    // sum of the products of the partitions after the first with the input spectra, for the next
+    // block. The bins below accbin are done.
+    std::vector<std::complex<double>> acc;
+    int accbin = 0;
+  };
+  const ConvolutionKernel& kernel;
+  // input written twice with distance of input_size, so that windows are contiguous.
+  std::vector<double> input;
+  int64_t input_size;
+  // overlap-added output of the stages.
+  std::vector<double> output;
+  int64_t output_mask;
+  std::vector<StageState> states;
+  std::vector<double> block;
+  std::vector<std::complex<double>> scratch;
+  int64_t count = 0;
+};
+
+// state of `convolve` in a memory object, which holds the pointer to the instance. It has 2
+// Floats so that a pointer fits also in single precision.
+template <typename T>
+struct MmmConvolverT {
+  T handle[2];
+};
+static_assert(sizeof(void*) <= sizeof(MmmConvolverT<float>));
+
+// Kernels and instances of convolve used by a runtime. Kernels are made by loadir in the main
+// function or in tasks, outside the dsp, together with their instances. The first call of
+// convolve in a memory object takes a free instance without locks and allocation, and keeps it
+// for the memory object, so that a cleared voice reuses its instance.
+// Everything is freed when the store, owned by Runtime, is destroyed.
+class MIMIUM_DLL_PUBLIC ConvolutionStore {
+ public:
+  static constexpr size_t max_keys = 256;
+  // preprocesses an impulse response and makes the instances for num_instances memory objects.
+  // convolve finds it with any of the keys. Keys already registered are not preprocessed again.
+  void addKernel(std::vector<double> const& ir, std::vector<const void*> const& keys,
+                 int num_instances = 1);
+  [[nodiscard]] const ConvolutionKernel* findKernel(const void* key) const;
+  // instance for the state in a memory object, cleared. An unknown key, or a kernel of which all
+  // the instances are taken, gives an instance which outputs silence.
+  Convolver* getInstance(const void* state, const void* key);
+  // number of the instances taken by memory objects.
+  [[nodiscard]] size_t getNumInstances() const;
+
+ private:
+  struct Entry {
+    Entry(std::vector<double> const& ir, int num_instances);
+    ConvolutionKernel kernel;
+    std::vector<std::unique_ptr<Convolver>> instances;
+    // states of the memory objects which took the instances, or null for free ones.
+    std::unique_ptr<std::atomic<const void*>[]> owners;
+  };
+  [[nodiscard]] Entry* findEntry(const void* key) const;
+  // taken only by writers. convolve reads the keys below num_keys, which is published last.
+  mutable std::mutex mtx;
+  std::vector<std::unique_ptr<Entry>> entries;
+  std::array<const void*, max_keys> keys{};
+  std::array<Entry*, max_keys> key_entries{};
+  std::atomic<size_t> num_keys = 0;
+  ConvolutionKernel empty_kernel{{}};
+  Convolver silent{empty_kernel};
+};
+
+}  // namespace mimium
@@ -0,0 +1,157 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "runtime/dsp_thread_pool.hpp"
+#include <stdexcept>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace mimium {
+namespace {
+// roughly some tens of microseconds before falling asleep
+constexpr int spin_limit = 4096;
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+  _mm_pause();
+#else
+  std::this_thread::yield();
+#endif
+}
+}  // namespace
+
+DspThreadPool::DspThreadPool(int numworkers, bool pin_threads)
+    : numworkers(numworkers), ranges(numworkers) {
+  if (numworkers <= 0) { throw std::runtime_error("number of dsp threads must be positive"); }
+  threads.reserve(numworkers - 1);
+  for (int w = 1; w < numworkers; w++) {
+    threads.emplace_back([this, w, pin_threads]() {
+      if (pin_threads) { pinCurrentThread(w); }
+      workerLoop(w);
+    });
+  }
+}
+
+DspThreadPool::~DspThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping = true;
+  }
+  cv.notify_all();
+  for (auto& t : threads) { t.join(); }
+}
+
+void DspThreadPool::pinCurrentThread(int cpu) {
+#if defined(__linux__)
+  const auto ncpu = static_cast<int>(std::thread::hardware_concurrency());
+  if (ncpu == 0) { return; }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu % ncpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)cpu;
+#endif
+}
+
+// generation is odd while a dispatch is being set up. workers which have not entered runTasks
+// before that point back off without touching the task, so it can be rewritten safely.
+void DspThreadPool::parallelFor(int count, TaskFn fn, void* ctx) {
+  if (count <= 0) { return; }
+  generation.fetch_add(1);
+  while (active.load() > 0) { cpuRelax(); }
+  task = fn;
+  task_ctx = ctx;
+  remaining.store(count, std::memory_order_relaxed);
+  const auto n = static_cast<uint32_t>(count);
+  const auto nw = static_cast<uint32_t>(numworkers);
+  for (uint32_t w = 0; w < nw; w++) {
+    ranges[w].range.store(pack(n * w / nw, n * (w + 1) / nw), std::memory_order_relaxed);
+  }
+  generation.fetch_add(1);
+  if (sleepers.load() > 0) {
+    std::lock_guard<std::mutex> lock(mtx);
+    cv.notify_all();
+  }
+  runTasks(0);
+  // barrier: wait for units taken by other workers
+  while (remaining.load(std::memory_order_acquire) > 0) { cpuRelax(); }
+}
+
+void DspThreadPool::workerLoop(int worker) {
+  uint64_t seen = 0;
+  auto isready = [&](uint64_t gen) { return gen != seen && gen % 2 == 0; };
+  while (true) {
+    int spins = 0;
+    uint64_t gen = 0;
+    while (!isready(gen = generation.load())) {
+      if (stopping) { return; }
+      if (++spins < spin_limit) {
+        cpuRelax();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mtx);
+      sleepers.fetch_add(1);
+      cv.wait(lock, [&]() { return isready(generation.load()) || stopping; });
+      sleepers.fetch_sub(1);
+      spins = 0;
+    }
+    active.fetch_add(1);
+    if (generation.load() == gen) {
+      seen = gen;
+      runTasks(worker);
+    }
+    active.fetch_sub(1);
+  }
+}
+
+bool DspThreadPool::popLocal(int worker, uint32_t& index) {
+  auto& r = ranges[worker].range;
+  auto cur = r.load(std::memory_order_acquire);
+  while (getBegin(cur) < getEnd(cur)) {
+    if (r.compare_exchange_weak(cur, pack(getBegin(cur) + 1, getEnd(cur)),
+                                std::memory_order_acq_rel)) {
+      index = getBegin(cur);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DspThreadPool::steal(int worker) {
+  for (int i = 1; i < numworkers; i++) {
+    auto& victim = ranges[(worker + i) % numworkers].range;
+    auto cur = victim.load(std::memory_order_acquire);
+    while (getBegin(cur) < getEnd(cur)) {
+      const auto begin = getBegin(cur);
+      const auto end = getEnd(cur);
+      const auto mid = end - (end - begin + 1) / 2;
+      if (victim.compare_exchange_weak(cur, pack(begin, mid), std::memory_order_acq_rel)) {
+        // own range is empty here, so nobody else can be modifying it.
+        ranges[worker].range.store(pack(mid, end), std::memory_order_release);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void DspThreadPool::runTasks(int worker) {
+  auto fn = task;
+  auto* ctx = task_ctx;
+  uint32_t index = 0;
+  do {
+    while (popLocal(worker, index)) {
+      fn(ctx, static_cast<int>(index), worker);
+      remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+  } while (steal(worker));
+}
+
+}  // namespace mimium
@@ -0,0 +1,74 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "export.hpp"
+
+namespace mimium {
+
+// Worker threads to evaluate independent dsp units (e.g. voices) in parallel within a block.
+// Each worker owns a range of unit indices and steals half of another range when it runs out.
+// Idle workers spin for a while before sleeping, so that consecutive blocks avoid wakeup latency.
+class MIMIUM_DLL_PUBLIC DspThreadPool {
+ public:
+  // fn(context, unit index, worker index)
+  using TaskFn = void (*)(void*, int, int);
+  // numworkers includes the calling thread, which works as worker 0.
+  explicit DspThreadPool(int numworkers, bool pin_threads = true);
+  ~DspThreadPool();
+  DspThreadPool(const DspThreadPool&) = delete;
+  DspThreadPool& operator=(const DspThreadPool&) = delete;
+
+  // runs fn(index, worker) for each index in [0, count) and returns after all of them have
+  // finished. fn is called through a plain function pointer, so nothing is allocated here.
+  template <typename F>
+  void parallelFor(int count, F&& fn) {
+    using FnType = std::remove_reference_t<F>;
+    parallelFor(
+        count, [](void* ctx, int i, int w) { (*static_cast<FnType*>(ctx))(i, w); },
+        static_cast<void*>(&fn));
+  }
+  void parallelFor(int count, TaskFn fn, void* ctx);
+  [[nodiscard]] int getNumWorkers() const { return numworkers; }
+
+ private:
+  // [begin, end) packed into 64bit so that it can be updated with a single CAS.
+  struct alignas(64) WorkRange {
+    std::atomic<uint64_t> range{0};
+  };
+  static uint64_t pack(uint32_t begin, uint32_t end) {
+    return (static_cast<uint64_t>(begin) << 32U) | end;
+  }
+  static uint32_t getBegin(uint64_t r) { return static_cast<uint32_t>(r >> 32U); }
+  static uint32_t getEnd(uint64_t r) { return static_cast<uint32_t>(r); }
+
+  void workerLoop(int worker);
+  void runTasks(int worker);
+  bool popLocal(int worker, uint32_t& index);
+  bool steal(int worker);
+  static void pinCurrentThread(int cpu);
+
+  int numworkers;
+  std::vector<WorkRange> ranges;
+  std::vector<std::thread> threads;
+  TaskFn task = nullptr;
+  void* task_ctx = nullptr;
+  alignas(64) std::atomic<uint64_t> generation{0};
+  alignas(64) std::atomic<int> remaining{0};
+  std::atomic<int> active{0};
+  std::atomic<int> sleepers{0};
+  std::atomic<bool> stopping{false};
+  std::mutex mtx;
+  std::condition_variable cv;
+};
+
+}  // namespace mimium
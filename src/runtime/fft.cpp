@@ -0,0 +1,104 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "runtime/fft.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace mimium {
+namespace {
+constexpr double pi = 3.14159265358979323846;
+}  // namespace
+
+FFT::FFT(int size)
+    : size(size),
+      bitreversed(size),
+      twiddles_re(std::max(size - 1, 0)),
+      twiddles_im(std::max(size - 1, 0)) {
+  assert(size > 0 && (size & (size - 1)) == 0);
+  int bits = 0;
+  while ((1 << bits) < size) { bits++; }
+  for (int i = 0; i < size; i++) {
+    int rev = 0;
+    for (int b = 0; b < bits; b++) { rev |= ((i >> b) & 1) << (bits - 1 - b); }
+    bitreversed[i] = rev;
+  }
+  for (int len = 2; len <= size; len <<= 1) {
+    const int half = len / 2;
+    for (int k = 0; k < half; k++) {
+      twiddles_re[half - 1 + k] = std::cos(-2.0 * pi * k / len);
+      twiddles_im[half - 1 + k] = std::sin(-2.0 * pi * k / len);
+    }
+  }
+}
+
+void FFT::transform(std::complex<double>* data, bool isinverse) const {
+  for (int i = 0; i < size; i++) {
+    if (i < bitreversed[i]) { std::swap(data[i], data[bitreversed[i]]); }
+  }
+  // std::complex is layout compatible with double[2].
+  auto* d = reinterpret_cast<double*>(data);  // NOLINT
+  const double sign = isinverse ? -1.0 : 1.0;
+  for (int len = 2; len <= size; len <<= 1) {
+    const int half = len / 2;
+    const double* wre = &twiddles_re[half - 1];
+    const double* wim = &twiddles_im[half - 1];
+    for (int start = 0; start < size; start += len) {
+      double* a = d + 2 * start;
+      double* b = a + 2 * half;
+      for (int k = 0; k < half; k++) {
+        const double wr = wre[k];
+        const double wi = sign * wim[k];
+        const double tr = b[2 * k] * wr - b[2 * k + 1] * wi;
+        const double ti = b[2 * k] * wi + b[2 * k + 1] * wr;
+        b[2 * k] = a[2 * k] - tr;
+        b[2 * k + 1] = a[2 * k + 1] - ti;
+        a[2 * k] += tr;
+        a[2 * k + 1] += ti;
+      }
+    }
+  }
+}
+
+RealFFT::RealFFT(int size)
+    : size(size), half(std::max(size / 2, 1)), twiddles(size / 2 + 1), buffer(size / 2 + 1) {
+  assert(size >= 2 && (size & (size - 1)) == 0);
+  for (int k = 0; k <= size / 2; k++) { twiddles[k] = std::polar(1.0, -2.0 * pi * k / size); }
+}
+
+// the even and odd samples are packed into the real and imaginary parts, and the spectrum of each
+// is separated from the half size transform.
+void RealFFT::forward(const double* in, std::complex<double>* out) {
+  const int m = size / 2;
+  for (int k = 0; k < m; k++) { buffer[k] = {in[2 * k], in[2 * k + 1]}; }
+  half.forward(buffer.data());
+  buffer[m] = buffer[0];
+  for (int k = 0; k <= m; k++) {
+    const auto z = buffer[k];
+    const auto zc = std::conj(buffer[m - k]);
+    const auto even = (z + zc) * 0.5;
+    const auto odd = (z - zc) * std::complex<double>(0.0, -0.5);
+    out[k] = even + twiddles[k] * odd;
+  }
+}
+
+void RealFFT::inverse(const std::complex<double>* in, double* out) {
+  const int m = size / 2;
+  // scaled by 2 so that the result is scaled by size, as the complex inverse.
+  for (int k = 0; k < m; k++) {
+    const auto x = k == 0 ? std::complex<double>(in[0].real()) : in[k];
+    const auto xc = k == 0 ? std::complex<double>(in[m].real()) : std::conj(in[m - k]);
+    const auto even = x + xc;
+    const auto odd = (x - xc) * std::conj(twiddles[k]);
+    buffer[k] = even + std::complex<double>(0.0, 1.0) * odd;
+  }
+  half.inverse(buffer.data());
+  for (int k = 0; k < m; k++) {
+    out[2 * k] = buffer[k].real();
+    out[2 * k + 1] = buffer[k].imag();
+  }
+}
+
+}  // namespace mimium
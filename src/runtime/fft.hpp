@@ -0,0 +1,50 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <complex>
+#include <vector>
+#include "export.hpp"
+
+namespace mimium {
+
+// in-place radix-2 complex FFT of a fixed power of 2 size. The inverse is not scaled.
+// Twiddles of each stage are precomputed contiguously and the butterflies use plain real
+// arithmetic, so that the inner loop is vectorized by the compiler.
+class MIMIUM_DLL_PUBLIC FFT {
+ public:
+  explicit FFT(int size);
+  void forward(std::complex<double>* data) const { transform(data, false); }
+  void inverse(std::complex<double>* data) const { transform(data, true); }
+  [[nodiscard]] int getSize() const { return size; }
+
+ private:
+  void transform(std::complex<double>* data, bool isinverse) const;
+  int size;
+  std::vector<int> bitreversed;
+  // exp(-2pi*i*k/len) for k < len/2 of the stage of length len, stored from len/2-1.
+  std::vector<double> twiddles_re;
+  std::vector<double> twiddles_im;
+};
+
+// FFT of a real signal of a power of 2 size, computed with a complex FFT of the half size.
+// Only size/2+1 bins are used, as the others are their conjugates. The inverse is not scaled.
+class MIMIUM_DLL_PUBLIC RealFFT {
+ public:
+  explicit RealFFT(int size);
+  void forward(const double* in, std::complex<double>* out);
+  // the imaginary parts of the first and last bins are ignored.
+  void inverse(const std::complex<double>* in, double* out);
+  [[nodiscard]] int getSize() const { return size; }
+  [[nodiscard]] int getNumBins() const { return size / 2 + 1; }
+
+ private:
+  int size;
+  FFT half;
+  // exp(-2pi*i*k/size) for k <= size/2.
+  std::vector<std::complex<double>> twiddles;
+  std::vector<std::complex<double>> buffer;
+};
+
+}  // namespace mimium
@@ -0,0 +1,54 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace mimium {
+
+// Mapping between the scheduler time and the monotonic clock of the host, updated by the audio
+// thread at the beginning of each block. The host time of a block is predicted from the number of
+// samples since the anchor, and the error against the host clock is corrected slowly. So the
+// jitter of the audio callbacks does not reach the mapping, while the drift of the clocks does.
+class HostClock {
+ public:
+  // monotonic clock of the host in seconds, which external events are stamped with.
+  static double getHostTime() {
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+  }
+  // blockstart is the scheduler time before the first sample of the block, and hostnow is the
+  // host time when the audio thread started the block.
+  void update(int64_t blockstart, int framesize, double samplerate, double hostnow) {
+    this->samplerate = samplerate;
+    const double error = hostnow - toHost(static_cast<double>(blockstart));
+    if (!anchored || std::abs(error) * samplerate > framesize) {
+      // first block, or the audio stopped or the clocks jumped.
+      anchored = true;
+      anchor_sample = blockstart;
+      anchor_host = hostnow;
+    } else {
+      anchor_host += error * correction;
+    }
+  }
+  [[nodiscard]] bool isAnchored() const { return anchored; }
+  [[nodiscard]] double toHost(double time) const {
+    return anchor_host + (time - static_cast<double>(anchor_sample)) / samplerate;
+  }
+  [[nodiscard]] int64_t toSample(double hosttime) const {
+    return anchor_sample + std::llround((hosttime - anchor_host) * samplerate);
+  }
+
+ private:
+  // ratio of the error corrected per block, small enough to average out the jitter.
+  static constexpr double correction = 1.0 / 64;
+  bool anchored = false;
+  int64_t anchor_sample = 0;
+  double anchor_host = 0.0;
+  double samplerate = 48000.0;
+};
+
+}  // namespace mimium
@@ -0,0 +1,52 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "runtime/midi_input.hpp"
+#include <algorithm>
+
+namespace mimium {
+MidiInput::MidiInput(std::unique_ptr<MidiSource> source, size_t capacity)
+    : source(std::move(source)), queue(capacity) {
+  this->source->open([this](double hosttime, const uint8_t* bytes, size_t size) {
+    push(hosttime, bytes, size);
+  });
+}
+MidiInput::~MidiInput() { source->close(); }
+
+void MidiInput::setHandler(void* addresstofn, void* addresstocls, bool isfloat32) {
+  handler = addresstofn;
+  handler_cls = addresstocls;
+  this->isfloat32 = isfloat32;
+}
+
+void MidiInput::push(double hosttime, const uint8_t* bytes, size_t size) {
+  if (size == 0 || size > 3 || bytes[0] == 0xF0) { return; }
+  MidiEvent event{hosttime, {}, static_cast<uint8_t>(size)};
+  std::copy(bytes, bytes + size, event.bytes.begin());
+  if (!queue.tryPush(event)) { dropped++; }
+}
+
+void MidiInput::dispatch(Scheduler& sch, HostClock const& clock, int64_t blockstart,
+                         int framesize) {
+  while (auto event = queue.tryPop()) {
+    if (handler == nullptr) { continue; }
+    // messages stamped before the previous block, which the source delivered late, play at once.
+    const int64_t time = std::max<int64_t>(clock.toSample(event->hosttime) + framesize, blockstart);
+    schedule(sch, time, event->bytes.data(), event->size);
+  }
+}
+
+void MidiInput::schedule(Scheduler& sch, int64_t time, const uint8_t* bytes, size_t size) const {
+  if (handler == nullptr) { return; }
+  sch.addTask(static_cast<double>(time), handler, packMessage(bytes, size), handler_cls,
+              isfloat32);
+}
+
+double MidiInput::packMessage(const uint8_t* bytes, size_t size) {
+  int res = 0;
+  for (size_t i = 0; i < 3; i++) { res = res * 256 + (i < size ? bytes[i] : 0); }
+  return static_cast<double>(res);
+}
+
+}  // namespace mimium
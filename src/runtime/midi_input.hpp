@@ -0,0 +1,81 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include "export.hpp"
+#include "runtime/host_clock.hpp"
+#include "runtime/scheduler.hpp"
+#include "runtime/spsc_queue.hpp"
+
+namespace mimium {
+
+// message of up to 3 bytes with the host time in seconds when it arrived or is to be sent, see
+// HostClock.
+struct MidiEvent {
+  double hosttime = 0.0;
+  std::array<uint8_t, 3> bytes{};
+  uint8_t size = 0;
+};
+
+// device which calls the callback on its own thread for each incoming message.
+class MIMIUM_DLL_PUBLIC MidiSource {
+ public:
+  using Callback = std::function<void(double hosttime, const uint8_t* bytes, size_t size)>;
+  virtual ~MidiSource() = default;
+  virtual void open(Callback callback) = 0;
+  virtual void close() = 0;
+};
+
+// source of the messages given to inject, for tests and for hosts receiving MIDI by themselves.
+class MIMIUM_DLL_PUBLIC MidiSourceInjected : public MidiSource {
+ public:
+  void open(Callback cb) override { callback = std::move(cb); }
+  void close() override { callback = nullptr; }
+  void inject(double hosttime, const uint8_t* bytes, size_t size) {
+    if (callback) { callback(hosttime, bytes, size); }
+  }
+
+ private:
+  Callback callback;
+};
+
+// MIDI input delivered to the handler function at the sample of arrival. The source timestamps
+// messages on its thread and passes them to the audio thread by a lock-free queue. At the
+// beginning of each block, the audio thread maps the host times to the scheduler time and adds
+// tasks calling the handler. The mapping has a constant latency of one block, so messages of the
+// previous block keep their distances in the current block without jitter.
+class MIMIUM_DLL_PUBLIC MidiInput {
+ public:
+  explicit MidiInput(std::unique_ptr<MidiSource> source, size_t capacity = 1024);
+  ~MidiInput();
+  // handler takes a message packed into a Float as status*65536 + data1*256 + data2. Must be
+  // set before the audio starts.
+  void setHandler(void* addresstofn, void* addresstocls, bool isfloat32);
+  [[nodiscard]] bool hasHandler() const { return handler != nullptr; }
+  // called on the thread of the source. System exclusive and longer messages are ignored, and
+  // messages are dropped while the queue is full.
+  void push(double hosttime, const uint8_t* bytes, size_t size);
+  // called on the audio thread before the first sample of a block, after the clock is updated.
+  // blockstart is the time of the scheduler before the block.
+  void dispatch(Scheduler& sch, HostClock const& clock, int64_t blockstart, int framesize);
+  // adds a task calling the handler at the time, for hosts which give messages in samples.
+  void schedule(Scheduler& sch, int64_t time, const uint8_t* bytes, size_t size) const;
+  [[nodiscard]] size_t getNumDropped() const { return dropped.load(); }
+  static double packMessage(const uint8_t* bytes, size_t size);
+
+ private:
+  std::unique_ptr<MidiSource> source;
+  SpscQueue<MidiEvent> queue;
+  std::atomic<size_t> dropped{0};
+  void* handler = nullptr;
+  void* handler_cls = nullptr;
+  bool isfloat32 = false;
+};
+
+}  // namespace mimium
@@ -0,0 +1,97 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "runtime/midi_output.hpp"
+#include <algorithm>
+#include <chrono>
+#include <tuple>
+
+namespace mimium {
+namespace {
+// longest sleep of the thread, so that it notices new messages and the destruction.
+constexpr double poll_interval = 0.001;
+}  // namespace
+
+MidiOutput::MidiOutput(std::unique_ptr<MidiSink> sink, size_t capacity)
+    : sink(std::move(sink)), queue(capacity), thread([this]() { run(); }) {
+  prepareWorkers(1);
+}
+
+MidiOutput::~MidiOutput() {
+  running.store(false);
+  thread.join();
+}
+
+void MidiOutput::push(double hosttime, const uint8_t* bytes, size_t size) {
+  if (size == 0 || size > 3) { return; }
+  MidiEvent event{hosttime, {}, static_cast<uint8_t>(size)};
+  std::copy(bytes, bytes + size, event.bytes.begin());
+  if (!queue.tryPush(event)) { dropped++; }
+}
+
+void MidiOutput::prepareWorkers(int numworkers, size_t capacity) {
+  collected.assign(std::max(numworkers, 1), {});
+  for (auto& c : collected) { c.reserve(capacity); }
+  merged.reserve(collected.size() * capacity);
+}
+
+void MidiOutput::collect(int worker, int64_t time, int voice, const uint8_t* bytes, size_t size) {
+  if (size == 0 || size > 3) { return; }
+  if (worker < 0 || static_cast<size_t>(worker) >= collected.size()) {
+    dropped++;
+    return;
+  }
+  auto& c = collected[worker];
+  if (c.size() == c.capacity()) {
+    dropped++;
+    return;
+  }
+  Collected m{time, voice, static_cast<uint32_t>(c.size()), {}, static_cast<uint8_t>(size)};
+  std::copy(bytes, bytes + size, m.bytes.begin());
+  c.push_back(m);
+}
+
+// messages of a voice are collected by one worker, so the order does not depend on the workers.
+void MidiOutput::mergeCollected() {
+  for (auto& c : collected) {
+    merged.insert(merged.end(), c.begin(), c.end());
+    c.clear();
+  }
+  std::sort(merged.begin(), merged.end(), [](Collected const& a, Collected const& b) {
+    return std::tie(a.time, a.voice, a.order) < std::tie(b.time, b.voice, b.order);
+  });
+}
+
+void MidiOutput::run() {
+  while (running.load()) {
+    auto next = queue.peek();
+    const double wait = next ? next->hosttime - HostClock::getHostTime() : poll_interval;
+    if (wait > 0) {
+      std::this_thread::sleep_for(std::chrono::duration<double>(std::min(wait, poll_interval)));
+      continue;
+    }
+    const double now = HostClock::getHostTime();
+    while (next && next->hosttime <= now) {
+      sink->send(next->bytes.data(), next->size);
+      queue.tryPop();
+      next = queue.peek();
+    }
+  }
+  while (auto event = queue.tryPop()) { sink->send(event->bytes.data(), event->size); }
+}
+
+size_t MidiOutput::getMessageSize(uint8_t status) {
+  if (status < 0x80) { return 0; }
+  if (status < 0xF0) { return (status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0 ? 2 : 3; }
+  switch (status) {
+    case 0xF0:
+    case 0xF7: return 0;
+    case 0xF1:
+    case 0xF3: return 2;
+    case 0xF2: return 3;
+    default: return 1;
+  }
+}
+
+}  // namespace mimium
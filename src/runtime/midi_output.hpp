@@ -0,0 +1,71 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "runtime/midi_input.hpp"
+
+namespace mimium {
+
+// device which sends messages. Called only on the thread of MidiOutput, so it may block.
+class MIMIUM_DLL_PUBLIC MidiSink {
+ public:
+  virtual ~MidiSink() = default;
+  virtual void send(const uint8_t* bytes, size_t size) = 0;
+};
+
+// MIDI output which never blocks the audio thread. The audio thread pushes messages with the host
+// time when they are due into a lock-free queue, and a dedicated thread sends them to the sink at
+// that time. All the messages due at a wakeup are sent at once, in the order they were pushed.
+// Messages sent while a block is rendered, also by the workers of voices, are collected for each
+// worker and pushed by the audio thread in the order of their times when the block ends.
+class MIMIUM_DLL_PUBLIC MidiOutput {
+ public:
+  explicit MidiOutput(std::unique_ptr<MidiSink> sink, size_t capacity = 1024);
+  // messages remaining in the queue are sent before the thread stops.
+  ~MidiOutput();
+  // called on the audio thread, or before it starts. Messages are dropped while the queue is full.
+  void push(double hosttime, const uint8_t* bytes, size_t size);
+  // called before the audio starts. capacity is the number of messages of a worker in a block.
+  void prepareWorkers(int numworkers, size_t capacity = 256);
+  // called on the worker, the audio thread being worker 0. time is in samples. Messages at the
+  // same time are ordered by the voice, -1 for the ones outside of voices, and then by the calls.
+  void collect(int worker, int64_t time, int voice, const uint8_t* bytes, size_t size);
+  // called on the audio thread after the workers finished the block. tohost maps the time of a
+  // message to the host time when it is due.
+  template <typename F>
+  void flush(F&& tohost) {
+    mergeCollected();
+    for (auto const& m : merged) { push(tohost(m.time), m.bytes.data(), m.size); }
+    merged.clear();
+  }
+  [[nodiscard]] size_t getNumDropped() const { return dropped.load(); }
+  // number of bytes of a message from its status byte, or 0 for system exclusive and data bytes.
+  static size_t getMessageSize(uint8_t status);
+
+ private:
+  struct Collected {
+    int64_t time;
+    int voice;
+    uint32_t order;
+    std::array<uint8_t, 3> bytes;
+    uint8_t size;
+  };
+  void run();
+  // sorts the collected messages into merged, without allocation.
+  void mergeCollected();
+  std::vector<std::vector<Collected>> collected;
+  std::vector<Collected> merged;
+  std::unique_ptr<MidiSink> sink;
+  SpscQueue<MidiEvent> queue;
+  std::atomic<size_t> dropped{0};
+  std::atomic<bool> running{true};
+  // started after the other members are initialized.
+  std::thread thread;
+};
+
+}  // namespace mimium
@@ -0,0 +1,279 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "runtime/osc_server.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace mimium {
+namespace {
+constexpr size_t max_packet_size = 65536;
+constexpr size_t max_messages_per_packet = 64;
+constexpr int max_bundle_depth = 8;
+constexpr uint64_t immediate_timetag = 1;
+// seconds from 1900, the epoch of NTP, to 1970.
+constexpr double ntp_to_unix = 2208988800.0;
+
+#ifdef _WIN32
+using socket_type = SOCKET;
+void closeSocket(socket_type s) { closesocket(s); }
+#else
+using socket_type = int;
+void closeSocket(socket_type s) { close(s); }
+#endif
+
+// called by the scheduler with the slot as the closure.
+void setParamValue(double value, void* slot) { *static_cast<double*>(slot) = value; }
+
+uint32_t readU32(const char* p) {
+  uint32_t res = 0;
+  for (int i = 0; i < 4; i++) { res = (res << 8U) | static_cast<uint8_t>(p[i]); }
+  return res;
+}
+uint64_t readU64(const char* p) { return (uint64_t(readU32(p)) << 32U) | readU32(p + 4); }
+
+// size of an OSC-string including the terminator and the padding to 4 bytes, or 0 if it is not
+// terminated within the size.
+size_t getStringSize(const char* data, size_t size) {
+  const auto* end = static_cast<const char*>(std::memchr(data, '\0', size));
+  if (end == nullptr) { return 0; }
+  const size_t res = (static_cast<size_t>(end - data) / 4 + 1) * 4;
+  return res <= size ? res : 0;
+}
+
+class PacketParser {
+ public:
+  PacketParser(OscMessageView* messages, size_t maxmessages)
+      : messages(messages), maxmessages(maxmessages) {}
+  bool parse(const char* data, size_t size, std::optional<uint64_t> timetag, int depth) {
+    if (size < 4 || size % 4 != 0) { return false; }
+    if (data[0] == '/') { return parseMessage(data, size, timetag); }
+    if (size < 16 || std::memcmp(data, "#bundle", 8) != 0 || depth >= max_bundle_depth) {
+      return false;
+    }
+    const uint64_t tag = readU64(data + 8);
+    const auto innertag = tag == immediate_timetag ? std::nullopt : std::optional(tag);
+    for (size_t pos = 16; pos < size;) {
+      if (pos + 4 > size) { return false; }
+      const size_t elemsize = readU32(data + pos);
+      pos += 4;
+      if (elemsize > size - pos || !parse(data + pos, elemsize, innertag, depth + 1)) {
+        return false;
+      }
+      pos += elemsize;
+    }
+    return true;
+  }
+  [[nodiscard]] size_t getCount() const { return count; }
+
+ private:
+  bool parseMessage(const char* data, size_t size, std::optional<uint64_t> timetag) {
+    const size_t addresssize = getStringSize(data, size);
+    if (addresssize == 0) { return false; }
+    OscMessageView message{std::string_view(data), std::nullopt, timetag};
+    const char* tags = data + addresssize;
+    const size_t tagssize = getStringSize(tags, size - addresssize);
+    // messages without type tags are accepted without values, as old senders omit them.
+    if (tagssize > 0 && tags[0] == ',') {
+      message.value = findValue(tags + 1, tags + tagssize, data + size);
+    }
+    if (count < maxmessages) { messages[count++] = message; }
+    return true;
+  }
+  // the first numeric argument, skipping the others.
+  static std::optional<double> findValue(const char* tag, const char* args, const char* end) {
+    for (; *tag != '\0'; tag++) {
+      const auto remaining = static_cast<size_t>(end - args);
+      switch (*tag) {
+        case 'f':
+        case 'i': {
+          if (remaining < 4) { return std::nullopt; }
+          const uint32_t bits = readU32(args);
+          if (*tag == 'i') { return static_cast<int32_t>(bits); }
+          float res = 0;
+          std::memcpy(&res, &bits, sizeof(res));
+          return res;
+        }
+        case 'd':
+        case 'h': {
+          if (remaining < 8) { return std::nullopt; }
+          const uint64_t bits = readU64(args);
+          if (*tag == 'h') { return static_cast<double>(static_cast<int64_t>(bits)); }
+          double res = 0;
+          std::memcpy(&res, &bits, sizeof(res));
+          return res;
+        }
+        case 'T': return 1.0;
+        case 'F': return 0.0;
+        case 'N':
+        case 'I': break;
+        case 'c':
+        case 'r':
+        case 'm': args += 4; break;
+        case 't': args += 8; break;
+        case 's':
+        case 'S': {
+          const size_t strsize = getStringSize(args, remaining);
+          if (strsize == 0) { return std::nullopt; }
+          args += strsize;
+        } break;
+        case 'b': {
+          if (remaining < 4) { return std::nullopt; }
+          const size_t blobsize = 4 + (static_cast<size_t>(readU32(args)) + 3) / 4 * 4;
+          if (blobsize > remaining) { return std::nullopt; }
+          args += blobsize;
+        } break;
+        default: return std::nullopt;
+      }
+      if (args > end) { return std::nullopt; }
+    }
+    return std::nullopt;
+  }
+  OscMessageView* messages;
+  size_t maxmessages;
+  size_t count = 0;
+};
+}  // namespace
+
+OscServer::OscServer(int port, size_t capacity) : port(port), queue(capacity) {
+#ifdef _WIN32
+  WSADATA wsadata;
+  WSAStartup(MAKEWORD(2, 2), &wsadata);
+#endif
+  auto s = ::socket(AF_INET, SOCK_DGRAM, 0);
+#ifdef _WIN32
+  if (s == INVALID_SOCKET) { throw std::runtime_error("OSC: failed to open a socket"); }
+#else
+  if (s < 0) { throw std::runtime_error("OSC: failed to open a socket"); }
+#endif
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {  // NOLINT
+    closeSocket(s);
+    throw std::runtime_error("OSC: failed to open UDP port " + std::to_string(port));
+  }
+  socklen_t addrlen = sizeof(addr);
+  ::getsockname(s, reinterpret_cast<sockaddr*>(&addr), &addrlen);  // NOLINT
+  this->port = ntohs(addr.sin_port);
+  // the thread wakes up regularly to notice the destruction.
+#ifdef _WIN32
+  DWORD timeout = 100;
+#else
+  timeval timeout{0, 100000};
+#endif
+  setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout),  // NOLINT
+             sizeof(timeout));
+  // bursts of thousands of messages are kept until the thread reads them.
+  int bufsize = 1 << 20;
+  setsockopt(s, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&bufsize),  // NOLINT
+             sizeof(bufsize));
+  sock = static_cast<std::intptr_t>(s);
+  values.reserve(max_params);
+  thread = std::thread([this]() { run(); });
+}
+
+OscServer::~OscServer() {
+  running.store(false);
+  thread.join();
+  closeSocket(static_cast<socket_type>(sock));
+#ifdef _WIN32
+  WSACleanup();
+#endif
+}
+
+int OscServer::addParam(std::string const& address, double init) {
+  std::lock_guard<std::mutex> lock(params_mtx);
+  if (auto slot = findParam(address)) { return slot.value(); }
+  if (values.size() >= max_params) { throw std::runtime_error("OSC: too many parameters"); }
+  const int slot = static_cast<int>(values.size());
+  values.push_back(init);
+  auto iter = std::lower_bound(params.begin(), params.end(), address,
+                               [](auto const& p, auto const& a) { return p.first < a; });
+  params.emplace(iter, address, slot);
+  return slot;
+}
+
+std::optional<int> OscServer::findParam(std::string_view address) const {
+  auto iter = std::lower_bound(params.begin(), params.end(), address,
+                               [](auto const& p, auto const& a) { return p.first < a; });
+  if (iter == params.end() || iter->first != address) { return std::nullopt; }
+  return iter->second;
+}
+
+void OscServer::dispatch(Scheduler& sch, HostClock const& clock, int64_t blockstart,
+                         int framesize) {
+  while (auto event = queue.tryPop()) {
+    const int64_t sample = clock.toSample(event->hosttime) + (event->hastimetag ? 0 : framesize);
+    sch.addTask(static_cast<double>(std::max(sample, blockstart)),
+                reinterpret_cast<void*>(setParamValue), event->value,  // NOLINT
+                &values[event->slot]);
+  }
+}
+
+void OscServer::run() {
+  std::vector<char> buffer(max_packet_size);
+  while (running.load()) {
+    const auto size = ::recv(static_cast<socket_type>(sock), buffer.data(),
+                             static_cast<int>(buffer.size()), 0);
+    // timeout, or an error which the next call reports again.
+    if (size <= 0) { continue; }
+    receive(buffer.data(), static_cast<size_t>(size));
+  }
+}
+
+void OscServer::receive(const char* data, size_t size) {
+  const double now = HostClock::getHostTime();
+  std::array<OscMessageView, max_messages_per_packet> messages;
+  auto count = parsePacket(data, size, messages.data(), messages.size());
+  if (!count) {
+    ignored++;
+    return;
+  }
+  std::lock_guard<std::mutex> lock(params_mtx);
+  for (size_t i = 0; i < count.value(); i++) {
+    received++;
+    const auto& m = messages[i];
+    auto slot = findParam(m.address);
+    if (!slot || !m.value) {
+      ignored++;
+      continue;
+    }
+    const double hosttime = m.timetag ? toHostTime(m.timetag.value()) : now;
+    if (!queue.tryPush(Event{hosttime, m.timetag.has_value(), slot.value(), m.value.value()})) {
+      ignored++;
+    }
+  }
+}
+
+std::optional<size_t> OscServer::parsePacket(const char* data, size_t size,
+                                             OscMessageView* messages, size_t maxmessages) {
+  PacketParser parser(messages, maxmessages);
+  if (!parser.parse(data, size, std::nullopt, 0)) { return std::nullopt; }
+  return parser.getCount();
+}
+
+double OscServer::toHostTime(uint64_t timetag) {
+  const double ntp = static_cast<double>(timetag >> 32U) +
+                     static_cast<double>(timetag & 0xFFFFFFFFU) / 4294967296.0;
+  const double systemnow = std::chrono::duration<double>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count() +
+                           ntp_to_unix;
+  return HostClock::getHostTime() + (ntp - systemnow);
+}
+
+}  // namespace mimium
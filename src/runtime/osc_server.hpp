@@ -0,0 +1,90 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "export.hpp"
+#include "runtime/host_clock.hpp"
+#include "runtime/scheduler.hpp"
+#include "runtime/spsc_queue.hpp"
+
+namespace mimium {
+
+// message of an OSC packet, referring to the bytes of the packet. value is the first argument of
+// type f, d, i, h, T or F, if any. timetag is the NTP time of the enclosing bundle, absent for
+// messages outside bundles and for the immediate timetag.
+struct OscMessageView {
+  std::string_view address;
+  std::optional<double> value;
+  std::optional<uint64_t> timetag;
+};
+
+// Server of OSC on a UDP port of localhost, which sets parameter slots read by mimium. The
+// receiving thread parses packets without allocation and passes the values to the audio thread
+// by a lock-free queue. At the beginning of each block, the audio thread adds tasks setting the
+// slots. Messages in a bundle with a timetag are set at the sample of the timetag, and the others
+// at the sample of arrival with the latency of one block, as MidiInput does.
+class MIMIUM_DLL_PUBLIC OscServer {
+ public:
+  // port 0 takes a free port, see getPort.
+  explicit OscServer(int port, size_t capacity = 4096);
+  ~OscServer();
+  // slot of the address, made with the initial value on the first call. Must not be called
+  // while the audio is running, as the slots are read by the audio thread without locks.
+  int addParam(std::string const& address, double init);
+  // 0 for unknown slots.
+  [[nodiscard]] double getValue(int slot) const {
+    return slot >= 0 && static_cast<size_t>(slot) < values.size() ? values[slot] : 0.0;
+  }
+  // called on the audio thread before the first sample of a block, after the clock is updated.
+  // blockstart is the time of the scheduler before the block.
+  void dispatch(Scheduler& sch, HostClock const& clock, int64_t blockstart, int framesize);
+  [[nodiscard]] int getPort() const { return port; }
+  [[nodiscard]] size_t getNumReceived() const { return received.load(); }
+  // messages of unknown addresses or without values, malformed packets, and messages dropped
+  // while the queue is full.
+  [[nodiscard]] size_t getNumIgnored() const { return ignored.load(); }
+  // parses a packet into at most maxmessages messages and returns the number of them, or
+  // nullopt if the packet is malformed.
+  static std::optional<size_t> parsePacket(const char* data, size_t size, OscMessageView* messages,
+                                           size_t maxmessages);
+  // host time of NTP time, which is seconds since 1900 in fixed point of 32 bits fraction.
+  static double toHostTime(uint64_t timetag);
+  static constexpr size_t max_params = 1024;
+
+ private:
+  struct Event {
+    // host time in seconds when the value is set, or when it arrived without timetag.
+    double hosttime;
+    bool hastimetag;
+    int slot;
+    double value;
+  };
+  void run();
+  void receive(const char* data, size_t size);
+  [[nodiscard]] std::optional<int> findParam(std::string_view address) const;
+  std::intptr_t sock;
+  int port;
+  // addresses sorted for binary search with string_view, so lookups do not allocate.
+  std::vector<std::pair<std::string, int>> params;
+  mutable std::mutex params_mtx;
+  // reserved for max_params, so that the addresses of the slots do not change.
+  std::vector<double> values;
+  SpscQueue<Event> queue;
+  std::atomic<size_t> received{0};
+  std::atomic<size_t> ignored{0};
+  std::atomic<bool> running{true};
+  // started after the other members are initialized.
+  std::thread thread;
+};
+
+}  // namespace mimium
@@ -8,8 +8,12 @@
 #include "export.hpp"
 
 #include "basic/helper_functions.hpp"
+#include "runtime/convolver.hpp"
 #include "runtime/runtime_defs.hpp"
+#include "runtime/sample_store.hpp"
 #include "runtime/scheduler.hpp"
+#include "runtime/stft.hpp"
+#include "runtime/wavetable.hpp"
 
 namespace mimium {
 class AudioDriver;
@@ -28,11 +32,44 @@ class MIMIUM_DLL_PUBLIC Runtime {
   [[nodiscard]] bool hasDsp() const { return hasdsp; }
   [[nodiscard]] bool hasDspCls() const { return hasdspcls; }
   void push_malloc(void* address, size_t size) { malloc_container.emplace_back(address, size); }
+  // bytes allocated by the compiled code for memory objects and global values. They are kept
+  // until the runtime is destroyed, so this is also the peak.
+  [[nodiscard]] size_t getMallocSize() const {
+    size_t res = 0;
+    for (auto&& [address, size] : malloc_container) { res += size; }
+    return res;
+  }
+  // bytes of an allocation made by push_malloc, or 0 for other addresses.
+  [[nodiscard]] size_t getMallocSize(const void* address) const {
+    for (auto&& [a, size] : malloc_container) {
+      if (a == address) { return size; }
+    }
+    return 0;
+  }
+  // number of instances made for voice function.
+  void setNumVoices(int n) { num_voices = n; }
+  [[nodiscard]] int getNumVoices() const { return num_voices; }
+  // analysis of spectral function. must be set before running the main function.
+  void setStftConfig(StftConfig const& config) { stft_config = config; }
+  [[nodiscard]] StftConfig const& getStftConfig() const { return stft_config; }
+  auto& getSampleStore() { return *samplestore; }
+  auto& getConvolutionStore() { return *convolutionstore; }
+  auto& getWavetableStore() { return *wavetablestore; }
+  // replaces the sample store. must be called before running the main function.
+  void setSampleStoreConfig(SampleStoreConfig config) {
+    samplestore = std::make_unique<SampleStore>(std::move(config));
+  }
 
  protected:
+  // declared before the audio driver, so that the samples are freed after the audio stopped.
+  std::unique_ptr<SampleStore> samplestore = std::make_unique<SampleStore>();
+  std::unique_ptr<ConvolutionStore> convolutionstore = std::make_unique<ConvolutionStore>();
+  std::unique_ptr<WavetableStore> wavetablestore = std::make_unique<WavetableStore>();
   std::unique_ptr<AudioDriver> audiodriver;
   bool hasdsp = false;
   bool hasdspcls = false;
+  int num_voices = 16;
+  StftConfig stft_config;
   std::list<std::pair<void*, size_t>> malloc_container{};
 };
 
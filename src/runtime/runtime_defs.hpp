@@ -3,6 +3,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <cstddef>
 namespace mimium {
 
 // outputresult,input, clsaddress,memobjaddress
@@ -19,6 +20,31 @@ struct DspFnInfos {
   int out_numchs = 0;
 };
 
+// Information set by definition of voice function, which has the same signature as dsp.
+// Its memory object is instantiated for each voice by VoicePool.
+struct VoiceFnInfos {
+ public:
+  DspFnPtr fn = nullptr;
+  void* cls_address = nullptr;
+  size_t memobj_size = 0;
+  int in_numchs = 0;
+  int out_numchs = 0;
+};
+
+// magnitude, phase, clsaddress, memobjaddress
+using SpectralFnPtr = void (*)(void*, void*, void*, void*);
+// Information set by definition of spectral function, which is called on each STFT frame with
+// arrays of magnitudes and phases. They are float arrays when compiled in single precision.
+struct SpectralFnInfos {
+ public:
+  SpectralFnPtr fn = nullptr;
+  void* cls_address = nullptr;
+  size_t memobj_size = 0;
+  bool isfloat32 = false;
+};
+// Sample type of buffers exchanged with the audio device.
+enum class SampleFormat { Float64, Float32 };
+
 // Information of AudioDriver(e.g. Hardware Device).
 // number of in&out channels are determined by logical number of device and may be different from
 // DspFnInfos.
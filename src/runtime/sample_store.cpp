@@ -0,0 +1,230 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "runtime/sample_store.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include "sndfile.h"
+
+namespace mimium {
+namespace fs = std::filesystem;
+
+namespace {
+class SndFileReader : public SampleReader {
+ public:
+  explicit SndFileReader(SNDFILE* file, SF_INFO info) : file(file), info(info) {}
+  ~SndFileReader() override { sf_close(file); }
+  SndFileReader(const SndFileReader&) = delete;
+  SndFileReader& operator=(const SndFileReader&) = delete;
+  [[nodiscard]] int64_t getFrames() const override { return info.frames; }
+  [[nodiscard]] int getChannels() const override { return info.channels; }
+  int64_t read(double* dst, int64_t frames) override { return sf_readf_double(file, dst, frames); }
+
+ private:
+  SNDFILE* file;
+  SF_INFO info;
+};
+
+int64_t roundUpToPow2(int64_t n) {
+  int64_t res = 1;
+  while (res < n) { res <<= 1; }
+  return res;
+}
+}  // namespace
+
+std::unique_ptr<SampleReader> openSndFile(std::string const& path) {
+  SF_INFO info{};
+  auto* file = sf_open(path.c_str(), SFM_READ, &info);
+  if (file == nullptr) { return nullptr; }
+  return std::make_unique<SndFileReader>(file, info);
+}
+
+struct SampleStore::Stream {
+  // released at the end of the file.
+  std::unique_ptr<SampleReader> reader;
+  int channels = 1;
+  int64_t capacity = 1;
+  std::vector<double> ring;
+  // frame last read by the audio thread
+  std::vector<double> frame;
+  // positions are total numbers of frames, written only by the reader and the audio thread.
+  alignas(64) std::atomic<int64_t> writepos{0};
+  alignas(64) std::atomic<int64_t> readpos{0};
+  std::atomic<bool> eof{false};
+  std::atomic<int64_t> underruns{0};
+};
+
+SampleStore::SampleStore(SampleStoreConfig config)
+    : config(std::move(config)),
+      stream_table(std::make_unique<std::atomic<Stream*>[]>(this->config.max_streams)) {}
+
+SampleStore::~SampleStore() {
+  {
+    std::lock_guard<std::mutex> lock(reader_mtx);
+    reader_running = false;
+  }
+  reader_cv.notify_all();
+  if (reader_thread.joinable()) { reader_thread.join(); }
+}
+
+std::shared_ptr<const Sample> SampleStore::load(std::string const& path) {
+  std::error_code ec;
+  auto key = fs::weakly_canonical(path, ec).string();
+  if (ec) { key = path; }
+  auto mtime = fs::last_write_time(path, ec);
+  if (ec) { mtime = fs::file_time_type{}; }
+  {
+    std::lock_guard<std::mutex> lock(cache_mtx);
+    auto iter = cache.find(key);
+    if (iter != cache.end() && iter->second.mtime == mtime) { return iter->second.sample; }
+  }
+  auto reader = config.open(path);
+  if (reader == nullptr) { throw std::runtime_error("failed to open audio file " + path); }
+  auto sample = std::make_shared<Sample>();
+  sample->channels = reader->getChannels();
+  sample->data.resize(reader->getFrames() * sample->channels);
+  int64_t frames = 0;
+  while (frames < reader->getFrames()) {
+    auto n = reader->read(sample->data.data() + frames * sample->channels,
+                          std::min(config.chunk_frames, reader->getFrames() - frames));
+    if (n <= 0) { break; }
+    frames += n;
+  }
+  sample->frames = frames;
+  sample->data.resize(frames * sample->channels);
+
+  std::lock_guard<std::mutex> lock(cache_mtx);
+  auto [iter, isnew] = cache.try_emplace(key, CacheEntry{mtime, sample});
+  // the previous version is freed when no one refers to it.
+  if (!isnew && iter->second.mtime != mtime) { iter->second = CacheEntry{mtime, sample}; }
+  return iter->second.sample;
+}
+
+const Sample& SampleStore::loadPinned(std::string const& path) {
+  auto sample = load(path);
+  std::lock_guard<std::mutex> lock(cache_mtx);
+  pinned.try_emplace(sample.get(), sample);
+  return *sample;
+}
+
+const std::vector<float>& SampleStore::loadPinnedFloat(std::string const& path) {
+  const auto& sample = loadPinned(path);
+  std::lock_guard<std::mutex> lock(cache_mtx);
+  auto [iter, isnew] = pinned_f32.try_emplace(&sample);
+  if (isnew) { iter->second.assign(sample.data.begin(), sample.data.end()); }
+  return iter->second;
+}
+
+size_t SampleStore::getNumCachedFiles() const {
+  std::lock_guard<std::mutex> lock(cache_mtx);
+  return cache.size();
+}
+
+int SampleStore::openStream(std::string const& path) {
+  auto newreader = config.open(path);
+  if (newreader == nullptr) { throw std::runtime_error("failed to open audio file " + path); }
+  auto s = std::make_unique<Stream>();
+  s->channels = std::max(1, newreader->getChannels());
+  s->capacity = roundUpToPow2(std::max<int64_t>(config.ring_frames, 1));
+  s->ring.resize(s->capacity * s->channels);
+  s->frame.assign(s->channels, 0.0);
+  s->reader = std::move(newreader);
+  fillStream(*s, std::min(config.preload_frames, s->capacity));
+
+  int id = 0;
+  {
+    std::lock_guard<std::mutex> lock(open_mtx);
+    id = numstreams.load(std::memory_order_relaxed);
+    if (id >= config.max_streams) { throw std::runtime_error("too many streams: " + path); }
+    stream_table[id].store(s.get(), std::memory_order_release);
+    streams.emplace_back(std::move(s));
+    numstreams.store(id + 1, std::memory_order_release);
+  }
+  std::lock_guard<std::mutex> lock(reader_mtx);
+  if (!reader_running) {
+    reader_running = true;
+    reader_thread = std::thread([this]() { readerLoop(); });
+  }
+  return id;
+}
+
+SampleStore::Stream* SampleStore::getStream(int id) const {
+  if (id < 0 || id >= numstreams.load(std::memory_order_acquire)) { return nullptr; }
+  return stream_table[id].load(std::memory_order_acquire);
+}
+
+bool SampleStore::fillStream(Stream& s, int64_t maxframes) {
+  if (s.eof.load(std::memory_order_relaxed)) { return false; }
+  auto w = s.writepos.load(std::memory_order_relaxed);
+  auto r = s.readpos.load(std::memory_order_acquire);
+  auto n = std::min(s.capacity - (w - r), maxframes);
+  if (n <= 0) { return false; }
+  auto pos = w & (s.capacity - 1);
+  auto first = std::min(n, s.capacity - pos);
+  auto got = s.reader->read(s.ring.data() + pos * s.channels, first);
+  if (got == first && n > first) { got += s.reader->read(s.ring.data(), n - first); }
+  got = std::max<int64_t>(got, 0);
+  s.writepos.store(w + got, std::memory_order_release);
+  if (got < n) {
+    // no one reads the file after eof, which is checked first.
+    s.reader.reset();
+    s.eof.store(true, std::memory_order_release);
+  }
+  return got > 0;
+}
+
+double SampleStore::readStream(int id) {
+  auto* s = getStream(id);
+  if (s == nullptr) { return 0.0; }
+  auto r = s->readpos.load(std::memory_order_relaxed);
+  if (r == s->writepos.load(std::memory_order_acquire)) {
+    // frames written just before eof are visible once eof is.
+    bool ended = s->eof.load(std::memory_order_acquire) &&
+                 r == s->writepos.load(std::memory_order_acquire);
+    if (!ended) { s->underruns.fetch_add(1, std::memory_order_relaxed); }
+    std::fill(s->frame.begin(), s->frame.end(), 0.0);
+    return 0.0;
+  }
+  const auto* src = s->ring.data() + (r & (s->capacity - 1)) * s->channels;
+  std::copy(src, src + s->channels, s->frame.begin());
+  s->readpos.store(r + 1, std::memory_order_release);
+  return s->frame[0];
+}
+
+double SampleStore::getStreamChannel(int id, int ch) const {
+  auto* s = getStream(id);
+  if (s == nullptr || ch < 0 || ch >= s->channels) { return 0.0; }
+  return s->frame[ch];
+}
+
+int64_t SampleStore::getBufferedFrames(int id) const {
+  auto* s = getStream(id);
+  if (s == nullptr) { return 0; }
+  return s->writepos.load(std::memory_order_acquire) -
+         s->readpos.load(std::memory_order_acquire);
+}
+
+int64_t SampleStore::getUnderruns(int id) const {
+  auto* s = getStream(id);
+  return s == nullptr ? 0 : s->underruns.load(std::memory_order_relaxed);
+}
+
+void SampleStore::readerLoop() {
+  std::unique_lock<std::mutex> lock(reader_mtx);
+  while (reader_running) {
+    lock.unlock();
+    bool busy = false;
+    const int n = numstreams.load(std::memory_order_acquire);
+    for (int i = 0; i < n; i++) {
+      busy |= fillStream(*stream_table[i].load(std::memory_order_acquire), config.chunk_frames);
+    }
+    lock.lock();
+    if (!busy) {
+      reader_cv.wait_for(lock, std::chrono::milliseconds(2), [&]() { return !reader_running; });
+    }
+  }
+}
+
+}  // namespace mimium
@@ -0,0 +1,113 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "export.hpp"
+
+namespace mimium {
+
+// decoder of an audio file. The default one is implemented with libsndfile.
+class MIMIUM_DLL_PUBLIC SampleReader {
+ public:
+  virtual ~SampleReader() = default;
+  [[nodiscard]] virtual int64_t getFrames() const = 0;
+  [[nodiscard]] virtual int getChannels() const = 0;
+  // reads interleaved frames from the current position. returns the number of frames read.
+  virtual int64_t read(double* dst, int64_t frames) = 0;
+};
+using SampleReaderFactory = std::function<std::unique_ptr<SampleReader>(std::string const&)>;
+// returns nullptr if the file cannot be opened.
+MIMIUM_DLL_PUBLIC std::unique_ptr<SampleReader> openSndFile(std::string const& path);
+
+// a whole file decoded in memory, interleaved.
+struct Sample {
+  std::vector<double> data;
+  int64_t frames = 0;
+  int channels = 0;
+};
+
+struct SampleStoreConfig {
+  // frames read into a new stream before openStream returns.
+  int64_t preload_frames = 1 << 15;
+  // capacity of the ring buffer of each stream in frames, rounded up to a power of 2.
+  int64_t ring_frames = 1 << 17;
+  // frames read from a file at once by the reader thread.
+  int64_t chunk_frames = 1 << 12;
+  int max_streams = 1024;
+  SampleReaderFactory open = openSndFile;
+};
+
+// Audio files used by a runtime, in two modes.
+// Short files are decoded once into a cache keyed by path and modification time, which shares
+// one decoded copy between all the loads of a file. Long files are streamed: a background
+// reader thread keeps a lock-free ring buffer per stream filled, and the audio thread consumes
+// it frame by frame. The reader of a stream is owned by the store and closed by the reader thread
+// once the end of the file is reached. Everything else is freed when the store, owned by Runtime,
+// is destroyed.
+class MIMIUM_DLL_PUBLIC SampleStore {
+ public:
+  explicit SampleStore(SampleStoreConfig config = {});
+  ~SampleStore();
+  SampleStore(const SampleStore&) = delete;
+  SampleStore& operator=(const SampleStore&) = delete;
+
+  // throws std::runtime_error if the file cannot be read.
+  std::shared_ptr<const Sample> load(std::string const& path);
+  // same as load, but the sample is kept until the store is destroyed, for compiled code which
+  // cannot release it.
+  const Sample& loadPinned(std::string const& path);
+  // pinned copy of the samples in single precision, for code compiled with Float as float.
+  const std::vector<float>& loadPinnedFloat(std::string const& path);
+  [[nodiscard]] size_t getNumCachedFiles() const;
+
+  // returns id of the stream. throws std::runtime_error if the file cannot be opened.
+  int openStream(std::string const& path);
+  // called from the audio thread. advances the stream by a frame and returns its first channel.
+  // returns 0 at the end of the file, or when the reader thread could not catch up.
+  double readStream(int id);
+  // a channel of the frame last read by readStream.
+  [[nodiscard]] double getStreamChannel(int id, int ch) const;
+  [[nodiscard]] int64_t getBufferedFrames(int id) const;
+  [[nodiscard]] int64_t getUnderruns(int id) const;
+
+ private:
+  struct CacheEntry {
+    std::filesystem::file_time_type mtime;
+    std::shared_ptr<const Sample> sample;
+  };
+  struct Stream;
+  Stream* getStream(int id) const;
+  // returns true if any frame was read.
+  bool fillStream(Stream& s, int64_t maxframes);
+  void readerLoop();
+
+  SampleStoreConfig config;
+  mutable std::mutex cache_mtx;
+  std::unordered_map<std::string, CacheEntry> cache;
+  std::unordered_map<const Sample*, std::shared_ptr<const Sample>> pinned;
+  std::unordered_map<const Sample*, std::vector<float>> pinned_f32;
+
+  std::mutex open_mtx;
+  std::vector<std::unique_ptr<Stream>> streams;
+  // published streams, read by the audio thread and the reader thread without locks.
+  std::unique_ptr<std::atomic<Stream*>[]> stream_table;
+  std::atomic<int> numstreams{0};
+
+  std::thread reader_thread;
+  std::mutex reader_mtx;
+  std::condition_variable reader_cv;
+  bool reader_running = false;
+};
+
+}  // namespace mimium
@@ -7,7 +7,7 @@
 namespace mimium {
 
 bool Scheduler::Greater::operator()(const key_type& l, const key_type& r) const {
-  return l.first > r.first;
+  return l.time > r.time || (l.time == r.time && l.order > r.order);
 }
 
 // return value: shouldstop
@@ -17,31 +17,43 @@ bool Scheduler::incrementTime() {
   if (!shouldplay) { return true; }
 
   time += 1;
-  if (hastask && time > tasks.top().first) { executeTask(tasks.top().second); }
+  // runs all the due tasks, including the ones added by them for the same time.
+  while (!tasks.empty() && time > tasks.top().time) { executeTask(tasks.top().task); }
   return false;
 }
-void Scheduler::addTask(double time, void* addresstofn, double arg, void* addresstocls) {
-  tasks.emplace(static_cast<int64_t>(time), TaskType{addresstofn, arg, addresstocls});
+void Scheduler::addTask(double time, void* addresstofn, double arg, void* addresstocls,
+                        bool isfloat32) {
+  tasks.push(key_type{static_cast<int64_t>(time), numadded++,
+                      TaskType{addresstofn, arg, addresstocls, isfloat32}});
+}
+
+void Scheduler::reserve(size_t n) {
+  std::vector<key_type> container;
+  container.reserve(n);
+  for (; !tasks.empty(); tasks.pop()) { container.push_back(tasks.top()); }
+  tasks = queue_type(Greater{}, std::move(container));
 }
 
 void Scheduler::executeTask(const TaskType& task) {
-  // todo
-  const auto& [addresstofn, arg, addresstocls] = task;
+  // copied and removed before the call, as the function may add tasks.
+  const auto [addresstofn, arg, addresstocls, isfloat32] = task;
+  tasks.pop();
 
-  if (addresstocls == nullptr) {
+  if (isfloat32) {
+    auto farg = static_cast<float>(arg);
+    if (addresstocls == nullptr) {
+      reinterpret_cast<void (*)(float)>(addresstofn)(farg);  // NOLINT
+    } else {
+      reinterpret_cast<void (*)(float, void*)>(addresstofn)(farg, addresstocls);  // NOLINT
+    }
+  } else if (addresstocls == nullptr) {
     auto fn = reinterpret_cast<void (*)(double)>(addresstofn);//NOLINT
     fn(arg);
   } else {
     auto fn = reinterpret_cast<void (*)(double, void*)>(addresstofn);//NOLINT
     fn(arg, addresstocls);
   }
-  tasks.pop();
-  if (tasks.empty() && !hasdsp) {
-    stop();
-  } else {
-    // recursive call until all tasks have been done!
-    if (time >= tasks.top().first) { this->executeTask(tasks.top().second); }
-  }
+  if (tasks.empty() && !hasdsp) { stop(); }
 }
 
 void Scheduler::start(bool hasdsp) { this->hasdsp = hasdsp; }
@@ -16,6 +16,8 @@ struct TaskType {
   // int64_t tasktypeid;
   double arg;
   void* addresstocls;
+  // function compiled with Float as float takes the argument in single precision.
+  bool isfloat32 = false;
 };
 
 class MIMIUM_DLL_PUBLIC Scheduler {  // scheduler interface
@@ -27,12 +29,15 @@ class MIMIUM_DLL_PUBLIC Scheduler {  // scheduler interface
   virtual void stop();
 
   bool hasTask() { return !tasks.empty(); }
+  // keeps the memory for n tasks, so that adding them on the audio thread does not allocate.
+  void reserve(size_t n);
 
   // tick the time and return if scheduler should be stopped
   bool incrementTime();
 
   // time,address to fun, arg(double), addresstoclosure,
-  void addTask(double time, void* addresstofn, double arg, void* addresstocls);
+  void addTask(double time, void* addresstofn, double arg, void* addresstocls,
+               bool isfloat32 = false);
 
   // if dsp function exists
   bool hasdsp = false;
@@ -40,13 +45,19 @@ class MIMIUM_DLL_PUBLIC Scheduler {  // scheduler interface
   auto& getWaitController() { return wc; }
 
  protected:
-  using key_type = std::pair<int64_t, TaskType>;
+  struct key_type {
+    int64_t time;
+    // tasks at the same time run in the order they were added.
+    uint64_t order;
+    TaskType task;
+  };
   struct Greater {
     bool operator()(const key_type& l, const key_type& r) const;
   };
   WaitController wc;
   using queue_type = std::priority_queue<key_type, std::vector<key_type>, Greater>;
   int64_t time = 0;
+  uint64_t numadded = 0;
   queue_type tasks;
   virtual void executeTask(const TaskType& task);
 };
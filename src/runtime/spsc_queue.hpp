@@ -0,0 +1,60 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace mimium {
+
+// Lock-free queue between a single producer thread and a single consumer thread. The buffer is
+// allocated at construction with the capacity rounded up to a power of 2, so neither side
+// allocates or blocks afterwards.
+template <typename T>
+class SpscQueue {
+ public:
+  explicit SpscQueue(size_t capacity) : buffer(roundUpToPow2(capacity)), mask(buffer.size() - 1) {}
+  // returns false without pushing if the queue is full.
+  bool tryPush(const T& value) {
+    const size_t w = write.load(std::memory_order_relaxed);
+    if (w - read.load(std::memory_order_acquire) == buffer.size()) { return false; }
+    buffer[w & mask] = value;
+    write.store(w + 1, std::memory_order_release);
+    return true;
+  }
+  std::optional<T> tryPop() {
+    const size_t r = read.load(std::memory_order_relaxed);
+    if (r == write.load(std::memory_order_acquire)) { return std::nullopt; }
+    T res = buffer[r & mask];
+    read.store(r + 1, std::memory_order_release);
+    return res;
+  }
+  // value which tryPop would return, without removing it. Only for the consumer.
+  [[nodiscard]] std::optional<T> peek() const {
+    const size_t r = read.load(std::memory_order_relaxed);
+    if (r == write.load(std::memory_order_acquire)) { return std::nullopt; }
+    return buffer[r & mask];
+  }
+  [[nodiscard]] bool empty() const {
+    return read.load(std::memory_order_acquire) == write.load(std::memory_order_acquire);
+  }
+  [[nodiscard]] size_t capacity() const { return buffer.size(); }
+
+ private:
+  static size_t roundUpToPow2(size_t n) {
+    size_t res = 1;
+    while (res < n) { res <<= 1; }
+    return res;
+  }
+  std::vector<T> buffer;
+  size_t mask;
+  // indices keep increasing and are wrapped by the mask. They are on separate cache lines so that
+  // the threads do not invalidate each other's line on every operation.
+  alignas(64) std::atomic<size_t> write{0};
+  alignas(64) std::atomic<size_t> read{0};
+};
+
+}  // namespace mimium
@@ -0,0 +1,175 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "runtime/stft.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include "compiler/ffi.hpp"
+
+namespace mimium {
+namespace {
+constexpr double pi = 3.14159265358979323846;
+
+void checkConfig(StftConfig const& config) {
+  const int size = config.fft_size;
+  if (size < 2 || (size & (size - 1)) != 0) {
+    throw std::runtime_error("FFT size must be a power of 2: " + std::to_string(size));
+  }
+  if (config.hop <= 0 || config.hop > size) {
+    throw std::runtime_error("hop size must be between 1 and FFT size: " +
+                             std::to_string(config.hop));
+  }
+}
+}  // namespace
+
+WindowType getWindowType(std::string_view name) {
+  static const std::unordered_map<std::string_view, WindowType> names = {
+      {"rect", WindowType::Rectangular},
+      {"hann", WindowType::Hann},
+      {"hamming", WindowType::Hamming},
+      {"blackman", WindowType::Blackman}};
+  auto iter = names.find(name);
+  if (iter == names.end()) { throw std::runtime_error("unknown window: " + std::string(name)); }
+  return iter->second;
+}
+
+std::vector<double> makeWindow(WindowType type, int size) {
+  std::vector<double> res(size, 1.0);
+  for (int n = 0; n < size; n++) {
+    const double x = 2.0 * pi * n / size;
+    switch (type) {
+      case WindowType::Rectangular: break;
+      case WindowType::Hann: res[n] = 0.5 - 0.5 * std::cos(x); break;
+      case WindowType::Hamming: res[n] = 0.54 - 0.46 * std::cos(x); break;
+      case WindowType::Blackman:
+        res[n] = 0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x);
+        break;
+    }
+  }
+  return res;
+}
+
+Stft::Stft(StftConfig const& config, FrameFn fn)
+    : config((checkConfig(config), config)),
+      fn(std::move(fn)),
+      fft(config.fft_size),
+      analysis_window(makeWindow(config.window, config.fft_size)),
+      synthesis_window(config.fft_size),
+      input(config.fft_size, 0.0),
+      output(config.fft_size, 0.0),
+      frame(config.fft_size),
+      spectrum(fft.getNumBins()),
+      magnitude(fft.getNumBins()),
+      phase(fft.getNumBins()) {
+  const int size = config.fft_size;
+  const int hop = config.hop;
+  // the window is applied twice, so each sample is divided by the sum of the squared windows of
+  // the frames overlapping on it.
+  for (int n = 0; n < size; n++) {
+    double sum = 0.0;
+    for (int m = n % hop; m < size; m += hop) { sum += analysis_window[m] * analysis_window[m]; }
+    synthesis_window[n] = sum > 1e-9 ? analysis_window[n] / (sum * size) : 0.0;
+  }
+}
+
+void Stft::reset() {
+  std::fill(input.begin(), input.end(), 0.0);
+  std::fill(output.begin(), output.end(), 0.0);
+  pos = 0;
+  hopcount = 0;
+}
+
+double Stft::process(double in) {
+  const double res = output[pos];
+  output[pos] = 0.0;
+  input[pos] = in;
+  pos = (pos + 1) % config.fft_size;
+  if (++hopcount == config.hop) {
+    hopcount = 0;
+    processFrame();
+  }
+  return res;
+}
+
+// the oldest sample of the frame is at pos, of which the result is output after fft_size samples.
+void Stft::processFrame() {
+  const int size = config.fft_size;
+  const int wrapped = size - pos;
+  for (int n = 0; n < wrapped; n++) { frame[n] = input[pos + n] * analysis_window[n]; }
+  for (int n = wrapped; n < size; n++) { frame[n] = input[n - wrapped] * analysis_window[n]; }
+  fft.forward(frame.data(), spectrum.data());
+  const int numbins = fft.getNumBins();
+  for (int k = 0; k < numbins; k++) {
+    magnitude[k] = std::abs(spectrum[k]);
+    phase[k] = std::arg(spectrum[k]);
+  }
+  if (fn) { fn(magnitude.data(), phase.data()); }
+  for (int k = 0; k < numbins; k++) { spectrum[k] = std::polar(magnitude[k], phase[k]); }
+  fft.inverse(spectrum.data(), frame.data());
+  for (int n = 0; n < wrapped; n++) { output[pos + n] += frame[n] * synthesis_window[n]; }
+  for (int n = wrapped; n < size; n++) {
+    output[n - wrapped] += frame[n] * synthesis_window[n];
+  }
+}
+
+SpectralProcessor::SpectralProcessor(SpectralFnInfos const& info, StftConfig const& config,
+                                     int numchs)
+    : info(info),
+      memobj_stride((std::max<size_t>(info.memobj_size, 1) + alignment - 1) / alignment *
+                    alignment) {
+  auto size = memobj_stride * std::max(numchs, 1);
+#ifdef _WIN32
+  arena = malloc(size);  // NOLINT
+#else
+  arena = std::aligned_alloc(alignment, size);
+#endif
+  if (arena == nullptr) { throw std::bad_alloc(); }
+  std::memset(arena, 0, size);
+  channels.reserve(numchs);
+  for (int ch = 0; ch < numchs; ch++) {
+    channels.emplace_back(config, [this, ch](double* mag, double* ph) { callFn(ch, mag, ph); });
+  }
+  if (info.isfloat32 && numchs > 0) {
+    magnitude_f32.resize(channels[0].getNumBins());
+    phase_f32.resize(channels[0].getNumBins());
+  }
+  registerRandomArena(arena, size, RandomArena::Spectral);
+}
+
+SpectralProcessor::~SpectralProcessor() {
+  unregisterRandomArena(arena);
+  free(arena);  // NOLINT
+}
+
+void SpectralProcessor::process(double* buffer, int numchs, int framesize) {
+  const int chs = std::min(numchs, getNumChannels());
+  for (int ch = 0; ch < chs; ch++) {
+    auto& stft = channels[ch];
+    for (int i = 0; i < framesize; i++) {
+      auto& v = buffer[i * numchs + ch];
+      v = stft.process(v);
+    }
+  }
+}
+
+void SpectralProcessor::callFn(int ch, double* magnitude, double* phase) {
+  if (info.fn == nullptr) { return; }
+  if (!info.isfloat32) {
+    info.fn(magnitude, phase, info.cls_address, getMemObj(ch));
+    return;
+  }
+  const size_t numbins = magnitude_f32.size();
+  std::copy(magnitude, magnitude + numbins, magnitude_f32.begin());
+  std::copy(phase, phase + numbins, phase_f32.begin());
+  info.fn(magnitude_f32.data(), phase_f32.data(), info.cls_address, getMemObj(ch));
+  std::copy(magnitude_f32.begin(), magnitude_f32.end(), magnitude);
+  std::copy(phase_f32.begin(), phase_f32.end(), phase);
+}
+
+}  // namespace mimium
@@ -0,0 +1,93 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <complex>
+#include <functional>
+#include <string_view>
+#include <vector>
+#include "export.hpp"
+#include "runtime/fft.hpp"
+#include "runtime/runtime_defs.hpp"
+
+namespace mimium {
+
+enum class WindowType { Rectangular, Hann, Hamming, Blackman };
+// throws std::runtime_error for an unknown name.
+MIMIUM_DLL_PUBLIC WindowType getWindowType(std::string_view name);
+// periodic window, which sums to a constant when overlapped with a hop dividing the size.
+MIMIUM_DLL_PUBLIC std::vector<double> makeWindow(WindowType type, int size);
+
+struct StftConfig {
+  // power of 2.
+  int fft_size = 1024;
+  // frames are analyzed every hop samples. must not be bigger than fft_size.
+  int hop = 256;
+  WindowType window = WindowType::Hann;
+};
+
+// Short-time Fourier transform of a signal processed sample by sample. Every hop samples, the
+// latest fft_size samples are windowed and transformed, the function is called with magnitudes
+// and phases of fft_size/2+1 bins, which it may modify in place, and the frame is resynthesized
+// by weighted overlap-add. The synthesis window is normalized so that an unmodified spectrum
+// reconstructs the input exactly, delayed by fft_size samples.
+class MIMIUM_DLL_PUBLIC Stft {
+ public:
+  using FrameFn = std::function<void(double* magnitude, double* phase)>;
+  // throws std::runtime_error for an invalid config.
+  Stft(StftConfig const& config, FrameFn fn);
+  double process(double in);
+  void reset();
+  [[nodiscard]] int getNumBins() const { return fft.getNumBins(); }
+  [[nodiscard]] int getLatency() const { return config.fft_size; }
+
+ private:
+  void processFrame();
+  StftConfig config;
+  FrameFn fn;
+  RealFFT fft;
+  std::vector<double> analysis_window;
+  // includes the scaling of the inverse transform.
+  std::vector<double> synthesis_window;
+  // ring buffers of fft_size, sharing the position.
+  std::vector<double> input;
+  std::vector<double> output;
+  int pos = 0;
+  int hopcount = 0;
+  std::vector<double> frame;
+  std::vector<std::complex<double>> spectrum;
+  std::vector<double> magnitude;
+  std::vector<double> phase;
+};
+
+// STFT stage applied to the output of dsp by AudioDriver. Each channel has its own Stft and an
+// instance of the memory object of the spectral function, while the closure is shared.
+class MIMIUM_DLL_PUBLIC SpectralProcessor {
+ public:
+  static constexpr size_t alignment = 64;
+  SpectralProcessor(SpectralFnInfos const& info, StftConfig const& config, int numchs);
+  ~SpectralProcessor();
+  SpectralProcessor(const SpectralProcessor&) = delete;
+  SpectralProcessor& operator=(const SpectralProcessor&) = delete;
+  // replaces interleaved channels with their resynthesized signals.
+  void process(double* buffer, int numchs, int framesize);
+  [[nodiscard]] int getNumChannels() const { return static_cast<int>(channels.size()); }
+  [[nodiscard]] int getLatency() const { return channels.empty() ? 0 : channels[0].getLatency(); }
+  [[nodiscard]] SpectralFnInfos const& getInfo() const { return info; }
+  // bytes of the memory objects of all the channels.
+  [[nodiscard]] size_t getMemObjsSize() const { return memobj_stride * channels.size(); }
+
+ private:
+  void callFn(int ch, double* magnitude, double* phase);
+  void* getMemObj(int ch) { return static_cast<char*>(arena) + ch * memobj_stride; }
+  SpectralFnInfos info;
+  size_t memobj_stride;
+  void* arena = nullptr;
+  std::vector<Stft> channels;
+  // arrays passed to a function compiled in single precision.
+  std::vector<float> magnitude_f32;
+  std::vector<float> phase_f32;
+};
+
+}  // namespace mimium
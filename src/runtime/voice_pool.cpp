@@ -0,0 +1,207 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "runtime/voice_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include "compiler/ffi.hpp"
+#include "runtime/dsp_thread_pool.hpp"
+
+namespace mimium {
+namespace {
+thread_local VoicePool::RenderingVoice rendering_voice;
+}  // namespace
+
+VoicePool::RenderingVoice const& VoicePool::getRenderingVoice() { return rendering_voice; }
+
+VoicePool::VoicePool(VoiceFnInfos const& info, int numvoices, double max_release_seconds)
+    : info(info),
+      numvoices(numvoices),
+      max_release_seconds(max_release_seconds),
+      memobj_stride((std::max<size_t>(info.memobj_size, 1) + alignment - 1) / alignment *
+                    alignment),
+      states(numvoices, State::Idle),
+      onset_times(numvoices, 0),
+      release_times(numvoices, 0),
+      sounding(numvoices, 0),
+      inputs(static_cast<size_t>(numvoices) * info.in_numchs, 0.0),
+      voice_out(info.out_numchs, 0.0),
+      generations(numvoices, 0) {
+  if (numvoices <= 0) { throw std::runtime_error("number of voices must be positive"); }
+  setSampleRate(48000.0);
+  auto size = memobj_stride * numvoices;
+#ifdef _WIN32
+  arena = malloc(size);  // NOLINT
+#else
+  arena = std::aligned_alloc(alignment, size);
+#endif
+  if (arena == nullptr) { throw std::bad_alloc(); }
+  std::memset(arena, 0, size);
+  // avoid allocation on audio thread as long as a block has less events than this.
+  events.reserve(numvoices * 4);
+  event_params.reserve(numvoices * 4 * std::max(info.in_numchs - 1, 0));
+  registerRandomArena(arena, size, RandomArena::Voice, memobj_stride, generations.data());
+}
+
+VoicePool::~VoicePool() {
+  unregisterRandomArena(arena);
+  free(arena);  // NOLINT
+}
+
+void VoicePool::beginBlock(int64_t time) { block_start = time; }
+
+int VoicePool::getNumActiveVoices() const {
+  return static_cast<int>(
+      std::count_if(states.begin(), states.end(), [](State s) { return s != State::Idle; }));
+}
+
+int VoicePool::findVoiceToAllocate() const {
+  auto idle = std::find(states.begin(), states.end(), State::Idle);
+  if (idle != states.end()) { return static_cast<int>(std::distance(states.begin(), idle)); }
+  // steal the voice released earliest, or the oldest one if none is releasing
+  int res = -1;
+  for (int v = 0; v < numvoices; v++) {
+    if (states[v] == State::Releasing && (res < 0 || release_times[v] < release_times[res])) {
+      res = v;
+    }
+  }
+  if (res >= 0) { return res; }
+  return static_cast<int>(std::distance(
+      onset_times.begin(), std::min_element(onset_times.begin(), onset_times.end())));
+}
+
+int VoicePool::noteOn(int64_t time, const double* params, int numparams) {
+  const int voice = findVoiceToAllocate();
+  states[voice] = State::Active;
+  onset_times[voice] = time;
+  const size_t offset = event_params.size();
+  const int nparams = std::max(info.in_numchs - 1, 0);
+  for (int i = 0; i < nparams; i++) { event_params.push_back(i < numparams ? params[i] : 0.0); }
+  events.push_back({time, voice, true, offset});
+  return voice;
+}
+
+void VoicePool::noteOff(int64_t time, int voice) {
+  if (voice < 0 || voice >= numvoices || states[voice] != State::Active) { return; }
+  states[voice] = State::Releasing;
+  release_times[voice] = time;
+  events.push_back({time, voice, false, 0});
+}
+
+void VoicePool::applyEvent(Event const& e) {
+  auto* in = std::next(inputs.data(), static_cast<ptrdiff_t>(e.voice) * info.in_numchs);
+  if (e.ison) {
+    // both of new and stolen voices start from cleared memory objects
+    std::memset(getMemObj(e.voice), 0, info.memobj_size);
+    generations[e.voice]++;
+    sounding[e.voice] = 1;
+    if (info.in_numchs > 0) {
+      in[0] = 1.0;
+      std::copy_n(std::next(event_params.data(), e.params_offset), info.in_numchs - 1,
+                  std::next(in, 1));
+    }
+  } else if (info.in_numchs > 0) {
+    in[0] = 0.0;
+  }
+}
+
+double VoicePool::renderVoice(int voice, double* output, double* scratch, int outchs, int from,
+                              int to) {
+  const auto* in = std::next(inputs.data(), static_cast<ptrdiff_t>(voice) * info.in_numchs);
+  auto* mem = getMemObj(voice);
+  const int chs = std::min(outchs, info.out_numchs);
+  double peak = 0.0;
+  auto& rendering = rendering_voice;
+  for (int frame = from; frame < to; frame++) {
+    rendering.time = block_start + frame;
+    info.fn(scratch, in, info.cls_address, mem);
+    auto* out = std::next(output, static_cast<ptrdiff_t>(frame) * outchs);
+    for (int ch = 0; ch < chs; ch++) {
+      out[ch] += scratch[ch];
+      peak = std::max(peak, std::abs(scratch[ch]));
+    }
+  }
+  return peak;
+}
+
+// touches only the state of the given voice, so that voices can be processed concurrently.
+void VoicePool::processVoice(int v, int worker, double* output, double* scratch, int outchs,
+                             int framesize) {
+  rendering_voice.worker = worker;
+  rendering_voice.voice = v;
+  processVoiceEvents(v, output, scratch, outchs, framesize);
+  rendering_voice.worker = -1;
+  rendering_voice.voice = -1;
+}
+
+void VoicePool::processVoiceEvents(int v, double* output, double* scratch, int outchs,
+                                   int framesize) {
+  int frame = 0;
+  double peak = 0.0;
+  bool hasevent = false;
+  for (auto const& e : events) {
+    if (e.voice != v) { continue; }
+    auto eventframe = static_cast<int>(std::clamp<int64_t>(e.time - block_start, 0, framesize));
+    if (sounding[v] != 0) {
+      peak = std::max(peak, renderVoice(v, output, scratch, outchs, frame, eventframe));
+    }
+    frame = std::max(frame, eventframe);
+    applyEvent(e);
+    hasevent = true;
+  }
+  if (sounding[v] == 0) { return; }
+  peak = std::max(peak, renderVoice(v, output, scratch, outchs, frame, framesize));
+  const bool release_end = block_start + framesize - release_times[v] >= max_release_frames;
+  if (states[v] == State::Releasing && !hasevent && (peak < silence_threshold || release_end)) {
+    states[v] = State::Idle;
+    sounding[v] = 0;
+  }
+}
+
+void VoicePool::prepare(int numworkers, int maxframes, int outchs) {
+  const auto nbufs = static_cast<size_t>(std::max(numworkers - 1, 0));
+  worker_outs.assign(nbufs, std::vector<double>(static_cast<size_t>(maxframes) * outchs, 0.0));
+  worker_scratches.assign(nbufs, std::vector<double>(info.out_numchs, 0.0));
+}
+
+void VoicePool::setSampleRate(double samplerate) {
+  max_release_frames = static_cast<int64_t>(std::ceil(max_release_seconds * samplerate));
+}
+
+void VoicePool::process(double* output, int outchs, int framesize, DspThreadPool* pool) {
+  if (pool == nullptr || pool->getNumWorkers() == 1) {
+    for (int v = 0; v < numvoices; v++) {
+      processVoice(v, 0, output, voice_out.data(), outchs, framesize);
+    }
+  } else {
+    // the calling thread writes into output directly, the others into their own buffers, which
+    // are allocated here only if the pool was not prepared for this size.
+    const auto nworkers = static_cast<size_t>(pool->getNumWorkers());
+    const auto bufsize = static_cast<size_t>(framesize) * outchs;
+    if (worker_outs.size() + 1 < nworkers || worker_outs[0].size() < bufsize) {
+      prepare(pool->getNumWorkers(), framesize, outchs);
+    }
+    for (size_t w = 0; w + 1 < nworkers; w++) { std::fill_n(worker_outs[w].data(), bufsize, 0.0); }
+    pool->parallelFor(numvoices, [&](int v, int worker) {
+      if (worker == 0) {
+        processVoice(v, 0, output, voice_out.data(), outchs, framesize);
+      } else {
+        processVoice(v, worker, worker_outs[worker - 1].data(),
+                     worker_scratches[worker - 1].data(), outchs, framesize);
+      }
+    });
+    for (size_t w = 0; w + 1 < nworkers; w++) {
+      const auto& buf = worker_outs[w];
+      for (size_t i = 0; i < bufsize; i++) { output[i] += buf[i]; }
+    }
+  }
+  block_start += framesize;
+  events.clear();
+  event_params.clear();
+}
+
+}  // namespace mimium
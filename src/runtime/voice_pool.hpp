@@ -0,0 +1,106 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "export.hpp"
+#include "runtime/runtime_defs.hpp"
+
+namespace mimium {
+class DspThreadPool;
+
+// Polyphonic instances of a voice function. All voices share its closure, while memory objects are
+// placed in one cache-line aligned arena with a fixed stride. The first input channel of a voice
+// is its gate and the rest are parameters given by noteOn.
+// Note events are registered by the scheduler during a block and applied sample-accurately when
+// the block is rendered, voice by voice.
+class MIMIUM_DLL_PUBLIC VoicePool {
+ public:
+  static constexpr size_t alignment = 64;
+  // releasing voices are freed once their output stays below this level for a whole block.
+  static constexpr double silence_threshold = 1e-5;
+  // voice rendered on the calling thread, for builtins called from voice function. worker is -1
+  // outside of voices, and time is the one of the scheduler at the sample being rendered.
+  struct RenderingVoice {
+    int worker = -1;
+    int voice = -1;
+    int64_t time = 0;
+  };
+  static RenderingVoice const& getRenderingVoice();
+
+  // a releasing voice is freed after max_release_seconds even if it still sounds.
+  VoicePool(VoiceFnInfos const& info, int numvoices, double max_release_seconds = 1.0);
+  ~VoicePool();
+  VoicePool(const VoicePool&) = delete;
+  VoicePool& operator=(const VoicePool&) = delete;
+
+  // time of the first frame of the block to be rendered next. events registered earlier than
+  // this are applied at the beginning of the block.
+  void beginBlock(int64_t time);
+  // allocates a voice, stealing the oldest one if all voices are busy. returns voice id.
+  int noteOn(int64_t time, const double* params, int numparams);
+  void noteOff(int64_t time, int voice);
+  // renders all the sounding voices for the block and adds them to interleaved output.
+  // voices are distributed over the workers when a thread pool is given.
+  void process(double* output, int outchs, int framesize, DspThreadPool* pool = nullptr);
+  // allocates the buffers of the workers of a pool beforehand, so that process does not allocate
+  // on the audio thread.
+  void prepare(int numworkers, int maxframes, int outchs);
+  // sample rate of the driver, by which max_release_seconds is counted. 48000 until it is set.
+  void setSampleRate(double samplerate);
+  [[nodiscard]] int64_t getMaxReleaseFrames() const { return max_release_frames; }
+
+  [[nodiscard]] int getNumVoices() const { return numvoices; }
+  [[nodiscard]] int getNumActiveVoices() const;
+  [[nodiscard]] VoiceFnInfos const& getInfo() const { return info; }
+  // bytes of the memory objects of all the voices.
+  [[nodiscard]] size_t getMemObjsSize() const {
+    return memobj_stride * static_cast<size_t>(numvoices);
+  }
+
+ private:
+  enum class State : uint8_t { Idle, Active, Releasing };
+  struct Event {
+    int64_t time;
+    int voice;
+    bool ison;
+    size_t params_offset;
+  };
+  int findVoiceToAllocate() const;
+  void applyEvent(Event const& e);
+  // sets the rendering voice of the thread around processVoiceEvents.
+  void processVoice(int voice, int worker, double* output, double* scratch, int outchs,
+                    int framesize);
+  void processVoiceEvents(int voice, double* output, double* scratch, int outchs, int framesize);
+  double renderVoice(int voice, double* output, double* scratch, int outchs, int from, int to);
+  void* getMemObj(int voice) { return static_cast<char*>(arena) + voice * memobj_stride; }
+
+  VoiceFnInfos info;
+  int numvoices;
+  double max_release_seconds;
+  int64_t max_release_frames = 0;
+  size_t memobj_stride;
+  void* arena = nullptr;
+  int64_t block_start = 0;
+
+  // state seen by allocation, updated as soon as an event is registered
+  std::vector<State> states;
+  std::vector<int64_t> onset_times;
+  std::vector<int64_t> release_times;
+  // state used for rendering, updated when an event is applied
+  std::vector<uint8_t> sounding;
+  std::vector<double> inputs;
+  std::vector<double> voice_out;
+  // number of note-ons of each voice, so that random takes new streams in a retriggered voice.
+  std::vector<uint64_t> generations;
+  // output and scratch buffers of the workers other than the calling thread
+  std::vector<std::vector<double>> worker_outs;
+  std::vector<std::vector<double>> worker_scratches;
+
+  std::vector<Event> events;
+  std::vector<double> event_params;
+};
+
+}  // namespace mimium
@@ -0,0 +1,108 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include "runtime/wavetable.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "runtime/fft.hpp"
+
+namespace mimium {
+namespace {
+constexpr double pi = 3.14159265358979323846;
+
+WavetableMipmap makeBasic(BasicWave wave) {
+  return WavetableMipmap::fromHarmonics([wave](int k) {
+    switch (wave) {
+      // 2*phase-1
+      case BasicWave::Saw: return -2.0 / (pi * k);
+      // 1 in the first half and -1 in the second.
+      case BasicWave::Square: return k % 2 == 1 ? 4.0 / (pi * k) : 0.0;
+      // 0 at phase 0, rising to 1 at phase 0.25.
+      case BasicWave::Triangle:
+        return k % 2 == 1 ? ((k / 2) % 2 == 0 ? 1.0 : -1.0) * 8.0 / (pi * pi * k * k) : 0.0;
+    }
+    return 0.0;
+  });
+}
+}  // namespace
+
+WavetableMipmap::WavetableMipmap(std::vector<std::complex<double>> const& spectrum) {
+  RealFFT fft(wavetable_size);
+  std::vector<std::complex<double>> bins(fft.getNumBins());
+  for (int level = 0; level < wavetable_num_levels; level++) {
+    const int numharmonics = wavetable_max_harmonics >> level;
+    std::fill(bins.begin(), bins.end(), 0.0);
+    std::copy(spectrum.begin(), spectrum.begin() + numharmonics + 1, bins.begin());
+    auto& table = levels.emplace_back(wavetable_size + 1);
+    fft.inverse(bins.data(), table.data());
+    table[wavetable_size] = table[0];
+    levels_f32.emplace_back(table.begin(), table.end());
+  }
+}
+
+WavetableMipmap::WavetableMipmap(std::vector<double> const& cycle)
+    : WavetableMipmap([&] {
+        std::vector<std::complex<double>> spectrum(wavetable_max_harmonics + 1);
+        const auto len = static_cast<int64_t>(cycle.size());
+        if (len == 0) { return spectrum; }
+        std::vector<std::complex<double>> twiddles(len);
+        for (int64_t n = 0; n < len; n++) { twiddles[n] = std::polar(1.0, -2.0 * pi * n / len); }
+        // a cycle shorter than the table has no harmonics above the half of its length.
+        const int64_t maxbin = std::min<int64_t>(wavetable_max_harmonics, len / 2);
+        for (int64_t k = 0; k <= maxbin; k++) {
+          std::complex<double> sum = 0.0;
+          for (int64_t n = 0; n < len; n++) { sum += cycle[n] * twiddles[(k * n) % len]; }
+          spectrum[k] = sum / static_cast<double>(len);
+        }
+        return spectrum;
+      }()) {}
+
+WavetableMipmap WavetableMipmap::fromHarmonics(std::function<double(int)> const& amplitude) {
+  std::vector<std::complex<double>> spectrum(wavetable_max_harmonics + 1);
+  // a*sin(x) = -i*a/2*exp(ix) + conjugate.
+  for (int k = 1; k <= wavetable_max_harmonics; k++) {
+    spectrum[k] = std::complex<double>(0.0, -amplitude(k) / 2.0);
+  }
+  return WavetableMipmap(spectrum);
+}
+
+int WavetableMipmap::getLevel(double freq) {
+  const double f = std::abs(freq);
+  int level = 0;
+  while (level < wavetable_num_levels - 1 && (wavetable_max_harmonics >> level) * f >= 0.5) {
+    level++;
+  }
+  return level;
+}
+
+WavetableStore::WavetableStore()
+    : basics({makeBasic(BasicWave::Saw), makeBasic(BasicWave::Square),
+              makeBasic(BasicWave::Triangle)}) {}
+
+void WavetableStore::addTable(std::vector<double> const& cycle,
+                              std::vector<const void*> const& keys) {
+  std::lock_guard<std::mutex> lock(mtx);
+  if (std::all_of(keys.begin(), keys.end(), [&](auto* k) { return findTable(k) != nullptr; })) {
+    return;
+  }
+  const size_t n = num_keys.load(std::memory_order_relaxed);
+  if (n + keys.size() > max_keys) { throw std::runtime_error("too many wavetables"); }
+  auto& table = tables.emplace_back(std::make_unique<WavetableMipmap>(cycle));
+  for (size_t i = 0; i < keys.size(); i++) {
+    this->keys[n + i] = keys[i];
+    key_tables[n + i] = table.get();
+  }
+  num_keys.store(n + keys.size(), std::memory_order_release);
+}
+
+// the newest table for the key, as the address of a freed array can be reused.
+const WavetableMipmap* WavetableStore::findTable(const void* key) const {
+  for (size_t i = num_keys.load(std::memory_order_acquire); i > 0; i--) {
+    if (keys[i - 1] == key) { return key_tables[i - 1]; }
+  }
+  return nullptr;
+}
+
+}  // namespace mimium
@@ -0,0 +1,89 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <complex>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "export.hpp"
+
+namespace mimium {
+
+constexpr int wavetable_size = 2048;
+// harmonics kept in the first level of a mipmap, halved in each of the next levels down to 1.
+constexpr int wavetable_max_harmonics = wavetable_size / 4;
+constexpr int wavetable_num_levels = 10;
+static_assert(wavetable_max_harmonics >> (wavetable_num_levels - 1) == 1);
+
+// One cycle of a waveform band-limited for each octave of the frequency. The tables are made
+// once at load time, and an oscillator picks the one of which the highest harmonic is below
+// Nyquist frequency, then interpolates it linearly with access_array_lin_interp.
+class MIMIUM_DLL_PUBLIC WavetableMipmap {
+ public:
+  // from one cycle of any length, of which the harmonics are taken by DFT.
+  explicit WavetableMipmap(std::vector<double> const& cycle);
+  // from the amplitudes of the sine components of the harmonics, starting from the 1st.
+  static WavetableMipmap fromHarmonics(std::function<double(int)> const& amplitude);
+  // level for a frequency in cycles per sample.
+  static int getLevel(double freq);
+  // table of wavetable_size+1 points, of which the last one equals the first.
+  [[nodiscard]] const double* getTable(double freq) const { return levels[getLevel(freq)].data(); }
+  [[nodiscard]] const float* getTableFloat(double freq) const {
+    return levels_f32[getLevel(freq)].data();
+  }
+  [[nodiscard]] const double* getLevelTable(int level) const { return levels[level].data(); }
+
+ private:
+  // spectrum of bins 0 to wavetable_max_harmonics, normalized by the length.
+  explicit WavetableMipmap(std::vector<std::complex<double>> const& spectrum);
+  std::vector<std::vector<double>> levels;
+  std::vector<std::vector<float>> levels_f32;
+};
+
+enum class BasicWave { Saw, Square, Triangle };
+
+// Mipmaps of the basic waveforms, made when the store is created, and the ones of the tables
+// loaded by loadwavetable, which an oscillator finds with the pointer to the loaded array.
+// Everything is freed when the store, owned by Runtime, is destroyed.
+class MIMIUM_DLL_PUBLIC WavetableStore {
+ public:
+  static constexpr size_t max_keys = 256;
+  WavetableStore();
+  [[nodiscard]] const WavetableMipmap& getBasic(BasicWave wave) const {
+    return basics[static_cast<int>(wave)];
+  }
+  // makes the mipmap of a cycle, which findTable finds with any of the keys. Keys already
+  // registered are not made again. Throws std::runtime_error beyond max_keys keys.
+  void addTable(std::vector<double> const& cycle, std::vector<const void*> const& keys);
+  // lock-free, for the audio thread.
+  [[nodiscard]] const WavetableMipmap* findTable(const void* key) const;
+  // grows whenever tables are added, so that a key not found is looked up again only then.
+  [[nodiscard]] size_t getNumKeys() const { return num_keys.load(std::memory_order_acquire); }
+
+ private:
+  std::array<WavetableMipmap, 3> basics;
+  // taken only by writers. findTable reads the keys below num_keys, which is published last.
+  mutable std::mutex mtx;
+  std::vector<std::unique_ptr<WavetableMipmap>> tables;
+  std::array<const void*, max_keys> keys{};
+  std::array<const WavetableMipmap*, max_keys> key_tables{};
+  std::atomic<size_t> num_keys = 0;
+};
+
+// state of osc_table in a memory object: the phase and the pointer to the mipmap, which is
+// looked up on the first call. A miss is kept as an odd number with the number of keys at that
+// time instead. It has 2 Floats for the handle so that it fits also in single precision.
+template <typename T>
+struct MmmWavetableOscT {
+  T phase;
+  T handle[2];
+};
+static_assert(sizeof(void*) <= 2 * sizeof(float));
+
+}  // namespace mimium
@@ -0,0 +1,97 @@
+#include "runtime/dsp_thread_pool.hpp"
+#include <atomic>
+#include <vector>
+#include "compiler/prng.hpp"
+#include "gtest/gtest.h"
+#include "runtime/voice_pool.hpp"
+
+extern "C" {
+uint64_t mimium_random_seed(const void* state);
+}
+
+namespace mimium {
+namespace {
+// sine-like recurrence so that the output depends on the whole history of the memory object.
+void testVoiceFn(double* out, const double* in, void* /*cls*/, void* mem) {
+  auto* phase = static_cast<double*>(mem);
+  *phase += in[1] * 0.001;
+  out[0] = in[0] * (*phase - static_cast<int>(*phase));
+  out[1] = in[0] * in[2];
+}
+// same as the code emitted for random().
+void randomVoiceFn(double* out, const double* in, void* /*cls*/, void* mem) {
+  auto* state = static_cast<uint64_t*>(mem);
+  if (*state == 0) { *state = mimium_random_seed(mem); }
+  out[0] = in[0] * prng::next<double>(*state);
+  out[1] = in[0] * in[2];
+}
+std::vector<double> renderVoices(DspThreadPool* workers, bool prepare = false,
+                                 DspFnPtr fn = testVoiceFn) {
+  VoicePool pool(VoiceFnInfos{fn, nullptr, sizeof(double), 3, 2}, 32);
+  const int framesize = 64;
+  if (prepare) { pool.prepare(workers->getNumWorkers(), framesize, 2); }
+  std::vector<double> out(framesize * 2 * 8, 0.0);
+  pool.beginBlock(0);
+  for (int i = 0; i < 32; i++) {
+    const double params[] = {100.0 + i, 0.01 * i};
+    pool.noteOn(i * 7, params, 2);
+  }
+  for (int block = 0; block < 8; block++) {
+    if (block == 4) {
+      for (int v = 0; v < 32; v += 3) { pool.noteOff(block * framesize + v, v); }
+    }
+    pool.process(std::next(out.data(), block * framesize * 2), 2, framesize, workers);
+  }
+  return out;
+}
+}  // namespace
+
+TEST(dspthreadpool, covers_all_indices) {  // NOLINT
+  DspThreadPool workers(4);
+  for (int count : {1, 3, 4, 17, 1000}) {
+    std::vector<std::atomic<int>> visited(count);
+    workers.parallelFor(count, [&](int i, int w) {
+      EXPECT_LT(w, 4);
+      visited[i].fetch_add(1);
+    });
+    for (auto const& v : visited) { EXPECT_EQ(v.load(), 1); }
+  }
+}
+
+TEST(dspthreadpool, repeated_dispatch) {  // NOLINT
+  DspThreadPool workers(3, false);
+  std::atomic<int> sum = 0;
+  for (int i = 0; i < 2000; i++) {
+    workers.parallelFor(8, [&](int idx, int /*w*/) { sum.fetch_add(idx); });
+  }
+  EXPECT_EQ(sum.load(), 2000 * 28);
+}
+
+TEST(dspthreadpool, voices_match_serial) {  // NOLINT
+  auto serial = renderVoices(nullptr);
+  DspThreadPool workers(4);
+  auto parallel = renderVoices(&workers);
+  ASSERT_EQ(serial.size(), parallel.size());
+  // sums of voices may differ only by the order of floating point additions.
+  for (size_t i = 0; i < serial.size(); i++) { EXPECT_NEAR(serial[i], parallel[i], 1e-9); }
+}
+
+TEST(dspthreadpool, prepared_voices_match_serial) {  // NOLINT
+  auto serial = renderVoices(nullptr);
+  DspThreadPool workers(3);
+  auto parallel = renderVoices(&workers, true);
+  ASSERT_EQ(serial.size(), parallel.size());
+  for (size_t i = 0; i < serial.size(); i++) { EXPECT_NEAR(serial[i], parallel[i], 1e-9); }
+}
+
+TEST(dspthreadpool, random_voices_match_serial) {  // NOLINT
+  auto serial = renderVoices(nullptr, false, randomVoiceFn);
+  DspThreadPool workers(4);
+  // voices take the streams of random by their places, not by the order of the first calls.
+  auto parallel = renderVoices(&workers, true, randomVoiceFn);
+  ASSERT_EQ(serial.size(), parallel.size());
+  for (size_t i = 0; i < serial.size(); i++) { EXPECT_NEAR(serial[i], parallel[i], 1e-9); }
+  EXPECT_NE(serial, renderVoices(nullptr, false, testVoiceFn));
+}
+
+}  // namespace mimium
@@ -0,0 +1,53 @@
+#include "basic/mir.hpp"
+#include "compiler/ast_loader.hpp"
+#include "compiler/control_rate.hpp"
+#include "compiler/mirgenerator.hpp"
+#include "compiler/scanner.hpp"
+#include "compiler/symbolrenamer.hpp"
+#include "compiler/type_infer_visitor.hpp"
+#include "gtest/gtest.h"
+#include "mimium_parser.hpp"
+
+#define PREP(FILENAME)                                                          \
+  Driver driver{};                                                              \
+  ast::Statements& ast = *driver.parseFile(TEST_ROOT_DIR "/" #FILENAME ".mmm"); \
+  SymbolRenamer renamer;                                                        \
+  auto newast = renamer.rename(ast);                                            \
+  TypeInferer inferer;                                                          \
+  auto& env = inferer.infer(*newast);                                           \
+  MirGenerator mirgenerator(env);                                               \
+  auto mir = mirgenerator.generate(*newast);
+
+namespace mimium {
+
+std::string dumpFunBody(mir::blockptr toplevel, std::string const& prefix) {
+  for (auto& inst : toplevel->instructions) {
+    if (mir::isInstA<minst::Function>(inst) && mir::getName(*inst).rfind(prefix, 0) == 0) {
+      return mir::toString(mir::getInstRef<minst::Function>(inst).body);
+    }
+  }
+  return "";
+}
+
+TEST(controlrate, hoist_coefficient) {  // NOLINT
+  PREP(test_control_rate)
+  ControlRateHoister hoister;
+  // exp(...) and (1-coeff)
+  EXPECT_EQ(hoister.process(mir), 2);
+  auto dsp = dumpFunBody(mir, "dsp");
+  EXPECT_EQ(dsp.find("appext exp"), std::string::npos);
+  EXPECT_NE(dsp.find("appext sin"), std::string::npos);
+  // recomputed when the task changes cutoff
+  auto task = dumpFunBody(mir, "setcutoff");
+  EXPECT_NE(task.find("appext exp"), std::string::npos);
+  EXPECT_NE(task.find(".ctrl"), std::string::npos);
+}
+
+TEST(controlrate, skip_written_in_dsp) {  // NOLINT
+  PREP(test_control_rate_written)
+  ControlRateHoister hoister;
+  EXPECT_EQ(hoister.process(mir), 0);
+  EXPECT_NE(dumpFunBody(mir, "dsp").find("appext exp"), std::string::npos);
+}
+
+}  // namespace mimium
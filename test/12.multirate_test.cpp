@@ -0,0 +1,138 @@
+#include <cmath>
+#include "basic/mir.hpp"
+#include "compiler/ast_loader.hpp"
+#include "compiler/closure_convert.hpp"
+#include "compiler/collect_memoryobjs.hpp"
+#include "compiler/ffi.hpp"
+#include "compiler/mirgenerator.hpp"
+#include "compiler/multirate.hpp"
+#include "compiler/scanner.hpp"
+#include "compiler/symbolrenamer.hpp"
+#include "compiler/type_infer_visitor.hpp"
+#include "gtest/gtest.h"
+#include "mimium_parser.hpp"
+
+#define PREP(FILENAME)                                                          \
+  Driver driver{};                                                              \
+  ast::Statements& ast = *driver.parseFile(TEST_ROOT_DIR "/" #FILENAME ".mmm"); \
+  SymbolRenamer renamer;                                                        \
+  auto newast = renamer.rename(ast);                                            \
+  TypeInferer inferer;                                                          \
+  auto& env = inferer.infer(*newast);                                           \
+  MirGenerator mirgenerator(env);                                               \
+  auto mir = mirgenerator.generate(*newast);
+
+namespace mimium {
+
+constexpr int sidetaps = static_cast<int>(types::halfband_sidetaps);
+constexpr double pi = 3.14159265358979323846;
+
+// runs one sample through the same polyphase structure as the oversampled functions.
+struct Resampler {
+  MmmHalfband up_fir, up_delay, down_fir, down_delay;
+  double last = 0.0;
+  double process(double in) {
+    auto even = 2 * mimium_halfband_fir(in, &up_fir);
+    auto odd = mimium_halfband_delay(in, &up_delay);
+    auto res = mimium_halfband_fir(even, &down_fir) + 0.5 * last;
+    last = mimium_halfband_delay(odd, &down_delay);
+    return res;
+  }
+};
+
+mir::valueptr findFun(mir::blockptr toplevel, std::string const& name) {
+  for (auto& inst : toplevel->instructions) {
+    if (mir::isInstA<minst::Function>(inst) && mir::getName(*inst) == name) { return inst; }
+  }
+  return nullptr;
+}
+
+std::shared_ptr<FunObjTree> findTree(funobjmap const& funobjs, std::string const& name) {
+  for (auto& [fn, tree] : funobjs) {
+    if (mir::isInstA<minst::Function>(fn) && mir::getName(*fn) == name) { return tree; }
+  }
+  return nullptr;
+}
+
+TEST(multirate, halfband_dc_gain) {  // NOLINT
+  MmmHalfband fir;
+  double res = 0.0;
+  for (int i = 0; i < 64; i++) { res = mimium_halfband_fir(1.0, &fir); }
+  EXPECT_NEAR(res, 0.5, 1e-12);
+}
+
+TEST(multirate, halfband_interpolates) {  // NOLINT
+  // the even phase lies halfway between the input samples, and the odd phase on them.
+  MmmHalfband fir;
+  MmmHalfband delay;
+  const double w = 0.3;
+  for (int i = 0; i < 256; i++) {
+    auto even = 2 * mimium_halfband_fir(std::sin(i * w), &fir);
+    auto odd = mimium_halfband_delay(std::sin(i * w), &delay);
+    if (i < 4 * sidetaps) { continue; }
+    EXPECT_NEAR(even, std::sin((i - sidetaps + 0.5) * w), 1e-3);
+    EXPECT_NEAR(odd, std::sin((i - sidetaps + 1) * w), 1e-12);
+  }
+}
+
+TEST(multirate, decimation_rejects_aliases) {  // NOLINT
+  // a component above the nyquist frequency of the output is removed before decimation.
+  MmmHalfband fir;
+  MmmHalfband delay;
+  double last = 0.0;
+  double maxval = 0.0;
+  const double w = 0.8 * pi;
+  for (int i = 0; i < 256; i++) {
+    auto res = mimium_halfband_fir(std::cos(2 * i * w), &fir) + 0.5 * last;
+    last = mimium_halfband_delay(std::cos((2 * i + 1) * w), &delay);
+    if (i > 4 * sidetaps) { maxval = std::max(maxval, std::abs(res)); }
+  }
+  EXPECT_LT(maxval, 1e-3);
+}
+
+TEST(multirate, resampling_is_delay) {  // NOLINT
+  Resampler r;
+  std::vector<double> in(512);
+  std::vector<double> out(512);
+  for (size_t i = 0; i < in.size(); i++) {
+    in[i] = std::sin(i * 0.2) + 0.5 * std::sin(i * 0.05);
+    out[i] = r.process(in[i]);
+  }
+  const int latency = 2 * sidetaps - 1;
+  for (size_t i = 64; i < in.size(); i++) { EXPECT_NEAR(out[i], in[i - latency], 2e-3); }
+}
+
+TEST(multirate, expand) {  // NOLINT
+  PREP(test_multirate)
+  MultirateExpander expander;
+  EXPECT_EQ(expander.process(mir), 2);
+  ASSERT_NE(findFun(mir, "lfo.inner"), nullptr);
+  ASSERT_NE(findFun(mir, "lfo.counter"), nullptr);
+  ASSERT_NE(findFun(mir, "shaper.inner"), nullptr);
+  auto shaper = mir::toString(mir::getInstRef<minst::Function>(findFun(mir, "shaper")).body);
+  EXPECT_NE(shaper.find("appext halfband_fir"), std::string::npos);
+  EXPECT_NE(shaper.find("shaper.inner"), std::string::npos);
+
+  ClosureConverter closureconverter(env);
+  auto mir_cc = closureconverter.convert(mir);
+  MemoryObjsCollector collector;
+  auto funobjs = collector.process(mir_cc);
+  // counter and the decimated body, and self holding the last value.
+  auto lfo = findTree(funobjs, "lfo");
+  ASSERT_NE(lfo, nullptr);
+  EXPECT_TRUE(lfo->hasself);
+  EXPECT_EQ(lfo->memobjs.size(), 2);
+  // interpolation of the argument and decimation of the result.
+  auto oversampled = findTree(funobjs, "shaper");
+  ASSERT_NE(oversampled, nullptr);
+  EXPECT_FALSE(oversampled->hasself);
+  EXPECT_EQ(oversampled->memobjs.size(), 5);
+}
+
+TEST(multirate, reject_stateful_oversampling) {  // NOLINT
+  PREP(test_multirate_stateful)
+  MultirateExpander expander;
+  EXPECT_THROW(expander.process(mir), std::runtime_error);
+}
+
+}  // namespace mimium
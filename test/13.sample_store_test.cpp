@@ -0,0 +1,116 @@
+#include "runtime/sample_store.hpp"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include "gtest/gtest.h"
+
+namespace mimium {
+namespace {
+namespace fs = std::filesystem;
+// stereo file of which frame i is {v, -v} for v = i + 0.1, which is not exact in float, decoded
+// by a fake reader instead of libsndfile.
+double getRampValue(int64_t i) { return static_cast<double>(i) + 0.1; }
+class RampReader : public SampleReader {
+ public:
+  RampReader(int64_t frames, std::atomic<int>* numopened) : frames(frames), numopened(numopened) {}
+  ~RampReader() override { (*numopened)--; }
+  RampReader(const RampReader&) = delete;
+  RampReader& operator=(const RampReader&) = delete;
+  [[nodiscard]] int64_t getFrames() const override { return frames; }
+  [[nodiscard]] int getChannels() const override { return 2; }
+  int64_t read(double* dst, int64_t n) override {
+    n = std::min(n, frames - pos);
+    for (int64_t i = 0; i < n; i++, pos++) {
+      dst[2 * i] = getRampValue(pos);
+      dst[2 * i + 1] = -getRampValue(pos);
+    }
+    return n;
+  }
+
+ private:
+  int64_t frames;
+  int64_t pos = 0;
+  std::atomic<int>* numopened;
+};
+
+// numopened counts readers alive, and numloaded counts all the readers opened.
+SampleStoreConfig makeConfig(int64_t frames, int* numloaded, std::atomic<int>* numopened) {
+  SampleStoreConfig config;
+  config.preload_frames = 16;
+  config.ring_frames = 64;
+  config.chunk_frames = 8;
+  config.open = [=](std::string const& path) -> std::unique_ptr<SampleReader> {
+    if (path == "missing.wav") { return nullptr; }
+    (*numloaded)++;
+    (*numopened)++;
+    return std::make_unique<RampReader>(frames, numopened);
+  };
+  return config;
+}
+}  // namespace
+
+TEST(samplestore, load_once) {  // NOLINT
+  int numloaded = 0;
+  std::atomic<int> numopened = 0;
+  SampleStore store(makeConfig(100, &numloaded, &numopened));
+  auto s1 = store.load("ramp.wav");
+  auto s2 = store.load("ramp.wav");
+  EXPECT_EQ(s1, s2);
+  EXPECT_EQ(numloaded, 1);
+  EXPECT_EQ(numopened, 0);
+  EXPECT_EQ(store.getNumCachedFiles(), 1);
+  EXPECT_EQ(s1->frames, 100);
+  EXPECT_EQ(s1->channels, 2);
+  // decoded in double precision.
+  EXPECT_EQ(s1->data[2 * 42], 42.1);
+  EXPECT_EQ(s1->data[2 * 42 + 1], -42.1);
+  EXPECT_EQ(&store.loadPinned("ramp.wav"), s1.get());
+  EXPECT_THROW(store.load("missing.wav"), std::runtime_error);  // NOLINT
+}
+
+TEST(samplestore, reload_modified) {  // NOLINT
+  auto path = fs::temp_directory_path() / "mimium_samplestore_test.wav";
+  std::ofstream(path) << "dummy";
+  int numloaded = 0;
+  std::atomic<int> numopened = 0;
+  SampleStore store(makeConfig(10, &numloaded, &numopened));
+  auto old = store.load(path.string());
+  fs::last_write_time(path, fs::last_write_time(path) + std::chrono::seconds(10));
+  auto updated = store.load(path.string());
+  EXPECT_NE(old, updated);
+  EXPECT_EQ(numloaded, 2);
+  EXPECT_EQ(store.getNumCachedFiles(), 1);
+  // the previous version is still valid for its owners.
+  EXPECT_EQ(old->frames, 10);
+  fs::remove(path);
+}
+
+TEST(samplestore, stream_all_frames) {  // NOLINT
+  const int64_t frames = 1000;
+  int numloaded = 0;
+  std::atomic<int> numopened = 0;
+  SampleStore store(makeConfig(frames, &numloaded, &numopened));
+  auto id = store.openStream("ramp.wav");
+  EXPECT_GE(store.getBufferedFrames(id), 16);
+  for (int64_t i = 0; i < frames; i++) {
+    while (store.getBufferedFrames(id) == 0) { std::this_thread::yield(); }
+    ASSERT_EQ(store.readStream(id), getRampValue(i));
+    ASSERT_EQ(store.getStreamChannel(id, 1), -getRampValue(i));
+  }
+  EXPECT_EQ(store.getUnderruns(id), 0);
+  // reading past the end outputs silence.
+  while (store.getBufferedFrames(id) > 0) { store.readStream(id); }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_DOUBLE_EQ(store.readStream(id), 0.0);
+  EXPECT_EQ(store.getUnderruns(id), 0);
+  // the reader is closed by the reader thread at the end of the file.
+  for (int i = 0; i < 100 && numopened > 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  EXPECT_EQ(numopened, 0);
+  EXPECT_DOUBLE_EQ(store.readStream(id + 1), 0.0);
+  EXPECT_THROW(store.openStream("missing.wav"), std::runtime_error);  // NOLINT
+}
+
+}  // namespace mimium
@@ -0,0 +1,101 @@
+#include "runtime/backend/channel_mapping.hpp"
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace mimium {
+namespace {
+// sample value which identifies the channel and the frame.
+double sampleOf(int ch, int frame) { return ch * 1000.0 + frame; }
+
+std::vector<std::vector<double>> makePlanar(int chs, int frames) {
+  std::vector<std::vector<double>> res(chs, std::vector<double>(frames));
+  for (int ch = 0; ch < chs; ch++) {
+    for (int i = 0; i < frames; i++) { res[ch][i] = sampleOf(ch, i); }
+  }
+  return res;
+}
+std::vector<const double*> getPtrs(std::vector<std::vector<double>> const& planar) {
+  std::vector<const double*> res;
+  for (auto& ch : planar) { res.emplace_back(ch.data()); }
+  return res;
+}
+}  // namespace
+
+TEST(channelmapping, interleave_multichannel) {  // NOLINT
+  for (int chs : {1, 2, 3, 8}) {
+    const int frames = 37;
+    auto planar = makePlanar(chs, frames);
+    auto ptrs = getPtrs(planar);
+    std::vector<double> dst(frames * chs, -1.0);
+    channels::interleave(ptrs.data(), chs, dst.data(), chs, frames);
+    for (int i = 0; i < frames; i++) {
+      for (int ch = 0; ch < chs; ch++) { EXPECT_EQ(dst[i * chs + ch], sampleOf(ch, i)); }
+    }
+  }
+}
+
+TEST(channelmapping, deinterleave_roundtrip) {  // NOLINT
+  for (int chs : {1, 2, 5}) {
+    const int frames = 19;
+    auto planar = makePlanar(chs, frames);
+    auto ptrs = getPtrs(planar);
+    std::vector<double> interleaved(frames * chs);
+    channels::interleave(ptrs.data(), chs, interleaved.data(), chs, frames);
+    std::vector<std::vector<double>> res(chs, std::vector<double>(frames, -1.0));
+    std::vector<double*> resptrs;
+    for (auto& ch : res) { resptrs.emplace_back(ch.data()); }
+    channels::deinterleave(interleaved.data(), chs, resptrs.data(), chs, frames);
+    EXPECT_EQ(res, planar);
+  }
+}
+
+TEST(channelmapping, upmix_mono) {  // NOLINT
+  const int frames = 16;
+  auto planar = makePlanar(1, frames);
+  auto ptrs = getPtrs(planar);
+  std::vector<double> stereo(frames * 2);
+  channels::interleave(ptrs.data(), 1, stereo.data(), 2, frames);
+  std::vector<float> remapped(frames * 3);
+  channels::remap(planar[0].data(), 1, remapped.data(), 3, frames);
+  for (int i = 0; i < frames; i++) {
+    EXPECT_EQ(stereo[2 * i], sampleOf(0, i));
+    EXPECT_EQ(stereo[2 * i + 1], sampleOf(0, i));
+    for (int ch = 0; ch < 3; ch++) { EXPECT_EQ(remapped[3 * i + ch], sampleOf(0, i)); }
+  }
+}
+
+TEST(channelmapping, zero_fill_and_drop) {  // NOLINT
+  const int frames = 10;
+  auto planar = makePlanar(2, frames);
+  std::vector<double> src(frames * 2);
+  auto ptrs = getPtrs(planar);
+  channels::interleave(ptrs.data(), 2, src.data(), 2, frames);
+  std::vector<double> wide(frames * 4, -1.0);
+  channels::remap(src.data(), 2, wide.data(), 4, frames);
+  std::vector<double> narrow(frames, -1.0);
+  channels::remap(src.data(), 2, narrow.data(), 1, frames);
+  std::vector<double> silent(frames * 2, -1.0);
+  channels::remap<double, double>(nullptr, 0, silent.data(), 2, frames);
+  for (int i = 0; i < frames; i++) {
+    EXPECT_EQ(wide[4 * i], sampleOf(0, i));
+    EXPECT_EQ(wide[4 * i + 1], sampleOf(1, i));
+    EXPECT_EQ(wide[4 * i + 2], 0.0);
+    EXPECT_EQ(wide[4 * i + 3], 0.0);
+    EXPECT_EQ(narrow[i], sampleOf(0, i));
+    EXPECT_EQ(silent[2 * i], 0.0);
+    EXPECT_EQ(silent[2 * i + 1], 0.0);
+  }
+}
+
+TEST(channelmapping, converts_sample_type) {  // NOLINT
+  const int frames = 8;
+  std::vector<float> device(frames * 2);
+  for (int i = 0; i < frames * 2; i++) { device[i] = 0.25F * i; }
+  std::vector<double> frame(frames * 2);
+  channels::remap(device.data(), 2, frame.data(), 2, frames);
+  std::vector<float> back(frames * 2);
+  channels::remap(frame.data(), 2, back.data(), 2, frames);
+  EXPECT_EQ(back, device);
+}
+
+}  // namespace mimium
@@ -0,0 +1,75 @@
+#include "compiler/fast_math.hpp"
+#include <cmath>
+#include <functional>
+#include "gtest/gtest.h"
+
+namespace mimium {
+namespace {
+// maximum error over evenly spaced points in [from, to]. relative error is used where |expected|
+// exceeds 1.
+template <typename T>
+double getMaxError(std::function<T(T)> const& approx,
+                   std::function<double(double)> const& expected, double from, double to) {
+  const int num_points = 100000;
+  double res = 0.0;
+  for (int i = 0; i <= num_points; i++) {
+    const auto x = static_cast<T>(from + (to - from) * i / num_points);
+    const double ref = expected(static_cast<double>(x));
+    const double err = std::abs(static_cast<double>(approx(x)) - ref);
+    res = std::max(res, std::abs(ref) > 1.0 ? err / std::abs(ref) : err);
+  }
+  return res;
+}
+double refSin(double x) { return std::sin(x); }
+double refCos(double x) { return std::cos(x); }
+double refExp(double x) { return std::exp(x); }
+double refLog(double x) { return std::log(x); }
+double refTanh(double x) { return std::tanh(x); }
+}  // namespace
+
+TEST(fastmath, approximated_name) {  // NOLINT
+  EXPECT_TRUE(fastmath::hasApproximation("sin"));
+  EXPECT_FALSE(fastmath::hasApproximation("atan2"));
+  EXPECT_EQ(fastmath::getApproximatedName("fastsin"), "sin");
+  EXPECT_EQ(fastmath::getApproximatedName("fastpow"), "pow");
+  EXPECT_EQ(fastmath::getApproximatedName("fastatan"), "");
+  EXPECT_EQ(fastmath::getApproximatedName("sin"), "");
+}
+
+TEST(fastmath, double_precision) {  // NOLINT
+  EXPECT_LT(getMaxError<double>(fastmath::sin<double>, refSin, -1e4, 1e4), 1e-13);
+  EXPECT_LT(getMaxError<double>(fastmath::cos<double>, refCos, -1e4, 1e4), 1e-13);
+  EXPECT_LT(getMaxError<double>(fastmath::exp<double>, refExp, -700.0, 700.0), 1e-15);
+  EXPECT_LT(getMaxError<double>(fastmath::log<double>, refLog, 1e-300, 1e300), 3e-14);
+  EXPECT_LT(getMaxError<double>(fastmath::log<double>, refLog, 1e-3, 10.0), 3e-14);
+  EXPECT_LT(getMaxError<double>(fastmath::tanh<double>, refTanh, -30.0, 30.0), 1e-15);
+  auto pow = [](double x) { return fastmath::pow(x, 2.5); };
+  auto refpow = [](double x) { return std::pow(x, 2.5); };
+  EXPECT_LT(getMaxError<double>(pow, refpow, 1e-3, 100.0), 1e-12);
+}
+
+TEST(fastmath, single_precision) {  // NOLINT
+  EXPECT_LT(getMaxError<float>(fastmath::sin<float>, refSin, -100.0, 100.0), 1e-5);
+  EXPECT_LT(getMaxError<float>(fastmath::cos<float>, refCos, -100.0, 100.0), 1e-5);
+  EXPECT_LT(getMaxError<float>(fastmath::exp<float>, refExp, -80.0, 80.0), 1e-6);
+  EXPECT_LT(getMaxError<float>(fastmath::log<float>, refLog, 1e-3, 1e3), 1e-6);
+  EXPECT_LT(getMaxError<float>(fastmath::tanh<float>, refTanh, -30.0, 30.0), 1e-6);
+}
+
+TEST(fastmath, special_values) {  // NOLINT
+  const double inf = std::numeric_limits<double>::infinity();
+  EXPECT_EQ(fastmath::log(0.0), -inf);
+  EXPECT_EQ(fastmath::log(inf), inf);
+  EXPECT_TRUE(std::isnan(fastmath::log(-1.0)));
+  EXPECT_LT(fastmath::exp(-1000.0), 1e-300);
+  EXPECT_TRUE(std::isfinite(fastmath::exp(1000.0)));
+  EXPECT_EQ(fastmath::pow(0.0, 2.0), 0.0);
+  EXPECT_EQ(fastmath::pow(0.0, -1.0), inf);
+  EXPECT_EQ(fastmath::pow(3.0, 0.0), 1.0);
+  EXPECT_EQ(fastmath::tanh(100.0), 1.0);
+  EXPECT_EQ(fastmath::tanh(-100.0), -1.0);
+  EXPECT_EQ(fastmath::sin(0.0), 0.0);
+  EXPECT_NEAR(fastmath::cos(0.0), 1.0, 1e-11);
+}
+
+}  // namespace mimium
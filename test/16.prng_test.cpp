@@ -0,0 +1,101 @@
+#include "compiler/prng.hpp"
+#include <array>
+#include <set>
+#include <vector>
+#include "compiler/ffi.hpp"
+#include "gtest/gtest.h"
+
+extern "C" {
+uint64_t mimium_random_seed(const void* state);
+double mimium_random();
+float mimium_random_f32();
+}
+
+namespace mimium {
+namespace {
+template <typename T>
+std::vector<T> generate(prng::state_t<T> state, int len) {
+  std::vector<T> res;
+  for (int i = 0; i < len; i++) { res.emplace_back(prng::next<T>(state)); }
+  return res;
+}
+}  // namespace
+
+TEST(prng, range_and_mean) {  // NOLINT
+  const int len = 100000;
+  auto check = [&](auto const& values) {
+    double sum = 0.0;
+    for (auto v : values) {
+      EXPECT_GE(v, -1.0);
+      EXPECT_LT(v, 1.0);
+      sum += v;
+    }
+    EXPECT_NEAR(sum / len, 0.0, 0.01);
+  };
+  check(generate<double>(prng::getStreamSeed(0, 0), len));
+  check(generate<float>(static_cast<uint32_t>(prng::getStreamSeed(0, 0)), len));
+}
+
+TEST(prng, extremes) {  // NOLINT
+  EXPECT_EQ(prng::toFloat<double>(0), -1.0);
+  EXPECT_LT(prng::toFloat<double>(~uint64_t(0)), 1.0);
+  EXPECT_EQ(prng::toFloat<float>(0), -1.0F);
+  EXPECT_LT(prng::toFloat<float>(~uint32_t(0)), 1.0F);
+}
+
+TEST(prng, streams_differ) {  // NOLINT
+  std::set<uint64_t> seeds;
+  for (uint64_t n = 0; n < 1000; n++) { seeds.emplace(prng::getStreamSeed(42, n)); }
+  EXPECT_EQ(seeds.size(), 1000);
+  EXPECT_NE(generate<double>(prng::getStreamSeed(42, 0), 16),
+            generate<double>(prng::getStreamSeed(42, 1), 16));
+  EXPECT_NE(prng::getStreamSeed(1, 0), prng::getStreamSeed(2, 0));
+}
+
+TEST(prng, reproducible_with_seed) {  // NOLINT
+  auto run = [](uint64_t seed) {
+    setRandomSeed(seed);
+    std::vector<double> res = {static_cast<double>(mimium_random_seed(nullptr)),
+                               static_cast<double>(mimium_random_seed(nullptr))};
+    for (int i = 0; i < 8; i++) {
+      res.emplace_back(mimium_random());
+      res.emplace_back(mimium_random_f32());
+    }
+    return res;
+  };
+  EXPECT_EQ(run(1234), run(1234));
+  EXPECT_NE(run(1234), run(5678));
+  setRandomSeed(7);
+  EXPECT_EQ(mimium_random_seed(nullptr), prng::getStreamSeed(7, 0));
+  EXPECT_EQ(mimium_random_seed(nullptr), prng::getStreamSeed(7, 1));
+}
+
+TEST(prng, streams_by_offset) {  // NOLINT
+  setRandomSeed(3);
+  // 4 memory objects of 16 bytes.
+  std::array<uint64_t, 8> mem{};
+  std::array<uint64_t, 4> generations{};
+  registerRandomArena(mem.data(), sizeof(mem), RandomArena::Voice, 16, generations.data());
+  auto getExpected = [](uint64_t offset, uint64_t generation) {
+    const auto id = static_cast<uint64_t>(RandomArena::Voice);
+    return prng::getStreamSeed(3, prng::getStreamIndex(id, offset, generation));
+  };
+  // independent of the order of the first calls.
+  const auto third = mimium_random_seed(&mem[5]);
+  const auto first = mimium_random_seed(&mem[0]);
+  EXPECT_EQ(first, getExpected(0, 0));
+  EXPECT_EQ(third, getExpected(40, 0));
+  EXPECT_EQ(mimium_random_seed(&mem[0]), first);
+  EXPECT_NE(mimium_random_seed(&mem[1]), first);
+  // a reused object takes a new stream.
+  generations[2]++;
+  EXPECT_EQ(mimium_random_seed(&mem[5]), getExpected(40, 1));
+  EXPECT_EQ(mimium_random_seed(&mem[0]), first);
+  unregisterRandomArena(mem.data());
+  // outside of the registered memory, the streams are given in order.
+  setRandomSeed(3);
+  EXPECT_EQ(mimium_random_seed(&mem[0]), prng::getStreamSeed(3, 0));
+  EXPECT_EQ(mimium_random_seed(&mem[0]), prng::getStreamSeed(3, 1));
+}
+
+}  // namespace mimium
@@ -0,0 +1,120 @@
+#include "runtime/convolver.hpp"
+#include <cmath>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace mimium {
+namespace {
+std::vector<double> makeNoise(size_t len, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::vector<double> res(len);
+  for (auto& v : res) { v = dist(gen); }
+  return res;
+}
+std::vector<double> convolveDirect(std::vector<double> const& in, std::vector<double> const& ir) {
+  std::vector<double> res(in.size(), 0.0);
+  for (size_t n = 0; n < in.size(); n++) {
+    for (size_t k = 0; k < ir.size() && k <= n; k++) { res[n] += ir[k] * in[n - k]; }
+  }
+  return res;
+}
+double getMaxDiff(std::vector<double> const& a, std::vector<double> const& b) {
+  double res = 0.0;
+  for (size_t i = 0; i < a.size(); i++) { res = std::max(res, std::abs(a[i] - b[i])); }
+  return res;
+}
+std::vector<double> process(Convolver& conv, std::vector<double> const& in) {
+  std::vector<double> res;
+  for (auto v : in) { res.emplace_back(conv.process(v)); }
+  return res;
+}
+}  // namespace
+
+TEST(convolver, fft_roundtrip) {  // NOLINT
+  FFT fft(64);
+  auto signal = makeNoise(64, 1);
+  std::vector<std::complex<double>> data(signal.begin(), signal.end());
+  fft.forward(data.data());
+  // DC bin is the sum.
+  double sum = 0.0;
+  for (auto v : signal) { sum += v; }
+  EXPECT_NEAR(data[0].real(), sum, 1e-12);
+  fft.inverse(data.data());
+  for (size_t i = 0; i < signal.size(); i++) { EXPECT_NEAR(data[i].real() / 64, signal[i], 1e-12); }
+}
+
+TEST(convolver, matches_direct_convolution) {  // NOLINT
+  auto in = makeNoise(6000, 2);
+  for (size_t irlen : {1, 10, 64, 65, 300, 1500, 5000}) {
+    auto ir = makeNoise(irlen, 3 + irlen);
+    // small partitions, so that several stages and the uniform tail are used.
+    ConvolutionKernel kernel(ir, 16, 256);
+    Convolver conv(kernel);
+    EXPECT_LT(getMaxDiff(process(conv, in), convolveDirect(in, ir)), 1e-9) << irlen;
+  }
+}
+
+TEST(convolver, partitions_cover_ir) {  // NOLINT
+  ConvolutionKernel kernel(makeNoise(100000, 4));
+  int64_t offset = static_cast<int64_t>(kernel.getHead().size());
+  for (auto& stage : kernel.getStages()) {
+    EXPECT_EQ(stage.offset, offset);
+    // a stage starts after its first block is complete and delayed.
+    EXPECT_GE(stage.offset, stage.partition + stage.delay);
+    offset += static_cast<int64_t>(stage.spectra.size()) * stage.partition;
+  }
+  EXPECT_GE(offset, kernel.getLength());
+  EXPECT_EQ(kernel.getStages().back().partition, 8192);
+}
+
+TEST(convolver, stages_spread) {  // NOLINT
+  ConvolutionKernel kernel(makeNoise(100000, 4));
+  auto const& stages = kernel.getStages();
+  ASSERT_GT(stages.size(), 2);
+  // except the first one, no two stages compute their blocks at the same sample.
+  for (int64_t count = 1; count <= 4 * 8192; count++) {
+    int computed = 0;
+    for (size_t i = 1; i < stages.size(); i++) {
+      if ((count - stages[i].delay) % stages[i].partition == 0) { computed++; }
+    }
+    EXPECT_LE(computed, 1) << count;
+  }
+}
+
+TEST(convolver, reset_restarts) {  // NOLINT
+  auto ir = makeNoise(700, 5);
+  ConvolutionKernel kernel(ir, 16, 128);
+  Convolver conv(kernel);
+  auto in = makeNoise(1000, 6);
+  auto first = process(conv, in);
+  conv.reset();
+  EXPECT_EQ(process(conv, in), first);
+}
+
+TEST(convolver, store_instances) {  // NOLINT
+  ConvolutionStore store;
+  auto ir = makeNoise(200, 7);
+  int key = 0;
+  store.addKernel(ir, {&key}, 2);
+  ASSERT_NE(store.findKernel(&key), nullptr);
+  double state1 = 0;
+  double state2 = 0;
+  auto* conv1 = store.getInstance(&state1, &key);
+  auto* conv2 = store.getInstance(&state2, &key);
+  EXPECT_NE(conv1, conv2);
+  // a cleared memory object takes the same instance again.
+  conv1->process(1.0);
+  EXPECT_EQ(store.getInstance(&state1, &key), conv1);
+  EXPECT_EQ(conv1->process(1.0), ir[0]);
+  EXPECT_EQ(store.getNumInstances(), 2);
+  // instances are made by addKernel, and more memory objects give silence.
+  double state3 = 0;
+  EXPECT_EQ(store.getInstance(&state3, &key)->process(1.0), 0.0);
+  // unknown impulse response gives silence.
+  int unknown = 0;
+  EXPECT_EQ(store.getInstance(&state1, &unknown)->process(1.0), 0.0);
+}
+
+}  // namespace mimium
@@ -0,0 +1,93 @@
+#include "runtime/stft.hpp"
+#include <cmath>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace mimium {
+namespace {
+std::vector<double> makeNoise(size_t len, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::vector<double> res(len);
+  for (auto& v : res) { v = dist(gen); }
+  return res;
+}
+// halves magnitudes and counts frames in its memory object.
+void testSpectralFn(void* mag, void* /*phase*/, void* /*cls*/, void* mem) {
+  auto* m = static_cast<double*>(mag);
+  for (int k = 0; k < 33; k++) { m[k] *= 0.5; }
+  *static_cast<double*>(mem) += 1;
+}
+void testSpectralFnF32(void* mag, void* /*phase*/, void* /*cls*/, void* mem) {
+  auto* m = static_cast<float*>(mag);
+  for (int k = 0; k < 33; k++) { m[k] *= 0.5F; }
+  *static_cast<float*>(mem) += 1;
+}
+}  // namespace
+
+TEST(stft, realfft_matches_complex) {  // NOLINT
+  const int size = 128;
+  auto signal = makeNoise(size, 1);
+  FFT fft(size);
+  std::vector<std::complex<double>> expected(signal.begin(), signal.end());
+  fft.forward(expected.data());
+  RealFFT rfft(size);
+  std::vector<std::complex<double>> bins(rfft.getNumBins());
+  rfft.forward(signal.data(), bins.data());
+  for (int k = 0; k < rfft.getNumBins(); k++) {
+    EXPECT_NEAR(std::abs(bins[k] - expected[k]), 0.0, 1e-12) << k;
+  }
+  std::vector<double> res(size);
+  rfft.inverse(bins.data(), res.data());
+  for (int i = 0; i < size; i++) { EXPECT_NEAR(res[i] / size, signal[i], 1e-12); }
+}
+
+TEST(stft, identity_reconstruction) {  // NOLINT
+  auto in = makeNoise(8192, 2);
+  for (auto window : {"hann", "hamming", "blackman", "rect"}) {
+    for (int hop : {64, 256, 100}) {
+      StftConfig config{1024, hop, getWindowType(window)};
+      Stft stft(config, nullptr);
+      const int latency = stft.getLatency();
+      std::vector<double> out;
+      for (auto v : in) { out.emplace_back(stft.process(v)); }
+      double maxdiff = 0.0;
+      // the first frame overlaps with less frames.
+      for (size_t i = 2 * latency; i < in.size(); i++) {
+        maxdiff = std::max(maxdiff, std::abs(out[i] - in[i - latency]));
+      }
+      EXPECT_LT(maxdiff, 1e-9) << window << " " << hop;
+    }
+  }
+}
+
+TEST(stft, invalid_config) {  // NOLINT
+  EXPECT_THROW(Stft(StftConfig{1000, 250, WindowType::Hann}, nullptr), std::runtime_error);
+  EXPECT_THROW(Stft(StftConfig{1024, 2048, WindowType::Hann}, nullptr), std::runtime_error);
+  EXPECT_THROW(getWindowType("kaiser"), std::runtime_error);
+}
+
+TEST(stft, spectral_processor) {  // NOLINT
+  const int frames = 1024;
+  const StftConfig config{64, 16, WindowType::Hann};
+  for (bool isfloat32 : {false, true}) {
+    SpectralFnInfos info{isfloat32 ? testSpectralFnF32 : testSpectralFn, nullptr, sizeof(double),
+                         isfloat32};
+    SpectralProcessor processor(info, config, 2);
+    std::vector<double> buffer(frames * 2);
+    auto in = makeNoise(frames, 3);
+    for (int i = 0; i < frames; i++) {
+      buffer[i * 2] = in[i];
+      buffer[i * 2 + 1] = -in[i];
+    }
+    processor.process(buffer.data(), 2, frames);
+    const int latency = processor.getLatency();
+    for (int i = 2 * latency; i < frames; i++) {
+      EXPECT_NEAR(buffer[i * 2], in[i - latency] * 0.5, 1e-5);
+      EXPECT_NEAR(buffer[i * 2 + 1], -in[i - latency] * 0.5, 1e-5);
+    }
+  }
+}
+
+}  // namespace mimium
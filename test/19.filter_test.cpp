@@ -0,0 +1,90 @@
+#include "compiler/filters.hpp"
+#include <cmath>
+#include <vector>
+#include "compiler/ffi.hpp"
+#include "gtest/gtest.h"
+
+namespace mimium {
+
+TEST(filter, biquad_impulse_response) {  // NOLINT
+  // y[n] = b0x[n] + b1x[n-1] + b2x[n-2] - a1y[n-1] - a2y[n-2]
+  const double b0 = 0.3, b1 = 0.2, b2 = 0.1, a1 = -0.6, a2 = 0.2;
+  std::vector<double> expected;
+  for (int n = 0; n < 32; n++) {
+    const double x = n == 0 ? 1.0 : 0.0;
+    double y = b0 * x + (n == 1 ? b1 : 0.0) + (n == 2 ? b2 : 0.0);
+    if (n >= 1) { y -= a1 * expected[n - 1]; }
+    if (n >= 2) { y -= a2 * expected[n - 2]; }
+    expected.emplace_back(y);
+  }
+  double state[2] = {0.0, 0.0};
+  for (int n = 0; n < 32; n++) {
+    EXPECT_NEAR(mimium_biquad(n == 0 ? 1.0 : 0.0, b0, b1, b2, a1, a2, state, 1), expected[n],
+                1e-12);
+  }
+}
+
+TEST(filter, svf_dc_gain) {  // NOLINT
+  const double g = std::tan(M_PI * 1000.0 / 48000.0);
+  const double k = 1.0 / 0.707;
+  double lp[2] = {0.0, 0.0};
+  double bp[2] = {0.0, 0.0};
+  double hp[2] = {0.0, 0.0};
+  double lpout = 0.0, bpout = 0.0, hpout = 0.0;
+  for (int n = 0; n < 48000; n++) {
+    lpout = mimium_svf_lp(1.0, g, k, lp, 1);
+    bpout = mimium_svf_bp(1.0, g, k, bp, 1);
+    hpout = mimium_svf_hp(1.0, g, k, hp, 1);
+  }
+  EXPECT_NEAR(lpout, 1.0, 1e-9);
+  EXPECT_NEAR(bpout, 0.0, 1e-9);
+  EXPECT_NEAR(hpout, 0.0, 1e-9);
+  // float version converges to the same.
+  float lpf[2] = {0.0F, 0.0F};
+  float lpfout = 0.0F;
+  for (int n = 0; n < 48000; n++) {
+    lpfout = mimium_svf_lp_f32(1.0F, static_cast<float>(g), static_cast<float>(k), lpf, 1);
+  }
+  EXPECT_NEAR(lpfout, 1.0F, 1e-4F);
+}
+
+TEST(filter, onepole_step) {  // NOLINT
+  double state = 0.0;
+  for (int n = 1; n <= 10; n++) {
+    EXPECT_NEAR(mimium_onepole(1.0, 0.9, &state, 1), 1.0 - std::pow(0.9, n), 1e-12);
+  }
+}
+
+TEST(filter, bank_lanes_match_single) {  // NOLINT
+  // 4 lanes of which each state variable is an array, as laid out in a memory object.
+  const int lanes = 4;
+  double bank[2][lanes] = {};
+  std::vector<std::vector<double>> singles(lanes, std::vector<double>(2, 0.0));
+  for (int n = 0; n < 64; n++) {
+    const double in = std::sin(0.1 * n);
+    for (int l = 0; l < lanes; l++) {
+      const double g = 0.05 * (l + 1);
+      auto banked = mimium_svf_hp(in, g, 1.0, &bank[0][l], lanes);
+      auto single = mimium_svf_hp(in, g, 1.0, singles[l].data(), 1);
+      EXPECT_EQ(banked, single);
+    }
+  }
+}
+
+TEST(filter, kinds) {  // NOLINT
+  EXPECT_EQ(filters::getKind("biquad"), filters::Kind::Biquad);
+  EXPECT_EQ(filters::getKind("svf_bp"), filters::Kind::Svf);
+  EXPECT_EQ(filters::getKind("onepole"), filters::Kind::OnePole);
+  EXPECT_EQ(filters::getKind("delay"), filters::Kind::None);
+  for (const auto* name : {"biquad", "svf_lp", "svf_bp", "svf_hp", "onepole"}) {
+    const auto kind = filters::getKind(name);
+    auto memobj = LLVMBuiltin::getMemobjType(name);
+    ASSERT_TRUE(memobj.has_value());
+    auto& tuple = rv::get<types::Tuple>(rv::get<types::Alias>(memobj.value()).target);
+    EXPECT_EQ(tuple.arg_types.size(), static_cast<size_t>(filters::getStateSize(kind)));
+    auto& fn = rv::get<types::Function>(LLVMBuiltin::ftable.at(name).mmmtype);
+    EXPECT_EQ(fn.arg_types.size(), static_cast<size_t>(filters::getNumArgs(kind)));
+  }
+}
+
+}  // namespace mimium
@@ -0,0 +1,138 @@
+#include "runtime/wavetable.hpp"
+#include <cmath>
+#include <vector>
+#include "compiler/ffi.hpp"
+#include "runtime/fft.hpp"
+#include "gtest/gtest.h"
+
+namespace mimium {
+namespace {
+// magnitude of the harmonics of a level, normalized so that a sine of amplitude 1 gives 1.
+std::vector<double> getHarmonics(const double* table) {
+  RealFFT fft(wavetable_size);
+  std::vector<std::complex<double>> bins(fft.getNumBins());
+  fft.forward(table, bins.data());
+  std::vector<double> res;
+  for (auto& b : bins) { res.emplace_back(2.0 * std::abs(b) / wavetable_size); }
+  return res;
+}
+}  // namespace
+
+TEST(oscillator, level_below_nyquist) {  // NOLINT
+  EXPECT_EQ(WavetableMipmap::getLevel(0.0), 0);
+  EXPECT_EQ(WavetableMipmap::getLevel(1.0 / 2048), 0);
+  EXPECT_EQ(WavetableMipmap::getLevel(-1.0 / 2048), 0);
+  for (double freq : {0.001, 0.01, 0.1, 0.3}) {
+    const int level = WavetableMipmap::getLevel(freq);
+    EXPECT_LT((wavetable_max_harmonics >> level) * freq, 0.5) << freq;
+    if (level > 0) { EXPECT_GE((wavetable_max_harmonics >> (level - 1)) * freq, 0.5) << freq; }
+  }
+  EXPECT_EQ(WavetableMipmap::getLevel(0.6), wavetable_num_levels - 1);
+}
+
+TEST(oscillator, basic_waves_bandlimited) {  // NOLINT
+  WavetableStore store;
+  const auto& saw = store.getBasic(BasicWave::Saw);
+  for (int level = 0; level < wavetable_num_levels; level++) {
+    auto harmonics = getHarmonics(saw.getLevelTable(level));
+    const int limit = wavetable_max_harmonics >> level;
+    EXPECT_NEAR(harmonics[1], 2.0 / M_PI, 1e-9);
+    EXPECT_NEAR(harmonics[limit], 2.0 / (M_PI * limit), 1e-9);
+    for (size_t k = limit + 1; k < harmonics.size(); k++) { EXPECT_LT(harmonics[k], 1e-9); }
+  }
+  // the first level is close to the naive waveforms away from the steps.
+  const double* sawtable = saw.getLevelTable(0);
+  const double* square = store.getBasic(BasicWave::Square).getLevelTable(0);
+  const double* tri = store.getBasic(BasicWave::Triangle).getLevelTable(0);
+  for (int i = 256; i < wavetable_size - 256; i += 64) {
+    const double phase = static_cast<double>(i) / wavetable_size;
+    EXPECT_NEAR(sawtable[i], 2.0 * phase - 1.0, 0.01);
+    if (std::abs(phase - 0.5) > 0.1) { EXPECT_NEAR(square[i], phase < 0.5 ? 1.0 : -1.0, 0.01); }
+    const double naivetri = phase < 0.25 ? 4 * phase : phase < 0.75 ? 2 - 4 * phase : 4 * phase - 4;
+    EXPECT_NEAR(tri[i], naivetri, 0.01);
+  }
+  EXPECT_EQ(sawtable[wavetable_size], sawtable[0]);
+}
+
+TEST(oscillator, table_from_cycle) {  // NOLINT
+  // a cycle of any length is resampled.
+  std::vector<double> cycle(100);
+  for (size_t i = 0; i < cycle.size(); i++) {
+    cycle[i] = 0.5 * std::sin(2 * M_PI * i / 100.0) + 0.25 * std::sin(2 * M_PI * 3 * i / 100.0);
+  }
+  WavetableMipmap mipmap(cycle);
+  const double* table = mipmap.getLevelTable(0);
+  for (int i = 0; i < wavetable_size; i += 16) {
+    const double t = static_cast<double>(i) / wavetable_size;
+    EXPECT_NEAR(table[i], 0.5 * std::sin(2 * M_PI * t) + 0.25 * std::sin(2 * M_PI * 3 * t), 1e-9);
+  }
+  // the level with only the fundamental drops the 3rd harmonic.
+  auto harmonics = getHarmonics(mipmap.getLevelTable(wavetable_num_levels - 1));
+  EXPECT_NEAR(harmonics[1], 0.5, 1e-9);
+  EXPECT_LT(harmonics[3], 1e-9);
+}
+
+TEST(oscillator, store_tables) {  // NOLINT
+  WavetableStore store;
+  int key = 0;
+  EXPECT_EQ(store.findTable(&key), nullptr);
+  store.addTable(std::vector<double>(64, 0.5), {&key});
+  const auto* table = store.findTable(&key);
+  ASSERT_NE(table, nullptr);
+  EXPECT_NEAR(table->getTable(0.01)[100], 0.5, 1e-12);
+  store.addTable(std::vector<double>(64, 0.0), {&key});
+  EXPECT_EQ(store.findTable(&key), table);
+  EXPECT_EQ(store.getNumKeys(), 1);
+}
+
+TEST(oscillator, store_capacity) {  // NOLINT
+  WavetableStore store;
+  std::vector<int> keys(WavetableStore::max_keys + 1);
+  const std::vector<double> cycle(16, 0.25);
+  std::vector<const void*> half;
+  for (size_t i = 0; i < keys.size() / 2; i++) { half.push_back(&keys[i]); }
+  store.addTable(cycle, half);
+  EXPECT_EQ(store.getNumKeys(), half.size());
+  for (size_t i = half.size(); i < WavetableStore::max_keys; i++) {
+    store.addTable(cycle, {&keys[i]});
+  }
+  EXPECT_EQ(store.getNumKeys(), WavetableStore::max_keys);
+  EXPECT_NE(store.findTable(&keys[0]), nullptr);
+  EXPECT_NE(store.findTable(&keys[0]), store.findTable(&keys.back() - 1));
+  EXPECT_THROW(store.addTable(cycle, {&keys.back()}), std::runtime_error);  // NOLINT
+  EXPECT_EQ(store.findTable(&keys.back()), nullptr);
+}
+
+TEST(oscillator, polyblep) {  // NOLINT
+  const double freq = 440.0 / 48000.0;
+  double sawphase = 0.0;
+  double squarephase = 0.0;
+  double sawsum = 0.0;
+  double squaresum = 0.0;
+  double prev = mimium_osc_saw_blep(freq, &sawphase);
+  double maxjump = 0.0;
+  const int len = 48000;
+  for (int n = 1; n < len; n++) {
+    const double phase = sawphase;
+    const double saw = mimium_osc_saw_blep(freq, &sawphase);
+    const double square = mimium_osc_square_blep(freq, &squarephase);
+    EXPECT_LE(std::abs(saw), 1.0 + 1e-9);
+    EXPECT_LE(std::abs(square), 1.0 + 1e-9);
+    // the naive waveform except around the steps.
+    if (phase > freq && phase < 1.0 - freq) { EXPECT_NEAR(saw, 2.0 * phase - 1.0, 1e-12); }
+    maxjump = std::max(maxjump, std::abs(saw - prev));
+    prev = saw;
+    sawsum += saw;
+    squaresum += square;
+  }
+  EXPECT_NEAR(sawsum / len, 0.0, 0.01);
+  EXPECT_NEAR(squaresum / len, 0.0, 0.01);
+  // the step of 2 is spread over 2 samples.
+  EXPECT_LT(maxjump, 1.5);
+  // the midpoint of the step at phase 0.
+  float phasef = 0.0F;
+  EXPECT_EQ(mimium_osc_saw_blep_f32(0.25F, &phasef), 0.0F);
+  EXPECT_EQ(phasef, 0.25F);
+}
+
+}  // namespace mimium
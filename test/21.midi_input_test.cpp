@@ -0,0 +1,163 @@
+#include "runtime/midi_input.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace mimium {
+namespace {
+constexpr double samplerate = 48000.0;
+constexpr int framesize = 64;
+constexpr double start = 100.0;
+
+struct Received {
+  int64_t time;
+  double message;
+};
+Scheduler* current_scheduler = nullptr;
+std::vector<Received> received;
+void recordMessage(double message) {
+  received.push_back({current_scheduler->getTime() - 1, message});
+}
+
+// runs blocks of the scheduler as the audio driver does, at the given host times.
+class MidiInputTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    received.clear();
+    current_scheduler = &sch;
+    sch.start(true);
+    input.setHandler(reinterpret_cast<void*>(recordMessage), nullptr, false);  // NOLINT
+  }
+  void runBlock(double hostnow) {
+    clock.update(sch.getTime(), framesize, samplerate, hostnow);
+    input.dispatch(sch, clock, sch.getTime(), framesize);
+    for (int i = 0; i < framesize; i++) { sch.incrementTime(); }
+  }
+  void send(double hosttime, uint8_t status, uint8_t data1 = 0, uint8_t data2 = 0) {
+    const uint8_t bytes[] = {status, data1, data2};
+    source->inject(hosttime, bytes, 3);
+  }
+  static double toHost(double samples) { return start + samples / samplerate; }
+  Scheduler sch;
+  HostClock clock;
+  MidiSourceInjected* source = new MidiSourceInjected();
+  MidiInput input{std::unique_ptr<MidiSource>(source), 16};
+};
+}  // namespace
+
+TEST(midiinput, pack_message) {  // NOLINT
+  const uint8_t noteon[] = {0x90, 60, 100};
+  EXPECT_EQ(MidiInput::packMessage(noteon, 3), 0x90 * 65536 + 60 * 256 + 100);
+  const uint8_t program[] = {0xC0, 5};
+  EXPECT_EQ(MidiInput::packMessage(program, 2), 0xC0 * 65536 + 5 * 256);
+  // the largest message is exact also in single precision.
+  const uint8_t largest[] = {0xFF, 0xFF, 0xFF};
+  const auto packed = MidiInput::packMessage(largest, 3);
+  EXPECT_EQ(static_cast<double>(static_cast<float>(packed)), packed);
+}
+
+TEST(midiinput, spsc_queue_order) {  // NOLINT
+  SpscQueue<int> queue(100);
+  EXPECT_EQ(queue.capacity(), 128);
+  constexpr int num = 10000;
+  std::thread producer([&]() {
+    for (int i = 0; i < num; i++) {
+      while (!queue.tryPush(i)) { std::this_thread::yield(); }
+    }
+  });
+  int expected = 0;
+  while (expected < num) {
+    if (auto v = queue.tryPop()) {
+      ASSERT_EQ(v.value(), expected++);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(MidiInputTest, constant_latency_with_jitter) {  // NOLINT
+  // callbacks come early or late by up to 8 samples, while messages keep their distances with
+  // the latency of one block.
+  const std::vector<double> jitter = {0, 8, -8, 5, -3, 8, 0, -7, 2, 6};
+  const std::vector<double> messages = {1, 30, 63, 64, 65, 200, 201, 300, 450, 511};
+  size_t next = 0;
+  for (size_t n = 0; n < jitter.size(); n++) {
+    const double now = toHost(n * framesize + jitter[n]);
+    for (; next < messages.size() && toHost(messages[next]) <= now; next++) {
+      send(toHost(messages[next]), 0x90, next, 100);
+    }
+    runBlock(now);
+  }
+  ASSERT_EQ(received.size(), next);
+  for (size_t i = 0; i < received.size(); i++) {
+    EXPECT_EQ(received[i].time, static_cast<int64_t>(messages[i]) + framesize) << i;
+    EXPECT_EQ(received[i].message, 0x90 * 65536 + i * 256 + 100);
+  }
+}
+
+TEST_F(MidiInputTest, late_message_plays_at_once) {  // NOLINT
+  runBlock(toHost(0));
+  runBlock(toHost(framesize));
+  // stamped in the first block, but delivered after the second one started.
+  send(toHost(10), 0x80, 60);
+  runBlock(toHost(2 * framesize));
+  ASSERT_EQ(received.size(), 1);
+  EXPECT_EQ(received[0].time, 2 * framesize);
+}
+
+TEST_F(MidiInputTest, reanchor_after_dropout) {  // NOLINT
+  runBlock(toHost(0));
+  // the audio stopped for a while, so the host time jumps ahead of the samples.
+  const double resumed = 100000;
+  runBlock(toHost(resumed));
+  send(toHost(resumed + 20), 0xB0, 1, 64);
+  runBlock(toHost(resumed + framesize));
+  ASSERT_EQ(received.size(), 1);
+  EXPECT_EQ(received[0].time, framesize + 20 + framesize);
+}
+
+TEST_F(MidiInputTest, ignored_and_dropped_messages) {  // NOLINT
+  const uint8_t sysex[] = {0xF0, 0x7E, 0xF7};
+  source->inject(toHost(0), sysex, 3);
+  const uint8_t longer[] = {0x90, 60, 100, 0};
+  source->inject(toHost(0), longer, 4);
+  for (int i = 0; i < 20; i++) { send(toHost(0), 0x90, i, 100); }
+  EXPECT_EQ(input.getNumDropped(), 4);
+  runBlock(toHost(0));
+  runBlock(toHost(framesize));
+  EXPECT_EQ(received.size(), 16);
+}
+
+TEST_F(MidiInputTest, injected_from_another_thread) {  // NOLINT
+  // a source thread sends a message every 10 samples. The messages of block n-1 are sent while
+  // block n-1 is running, as they are on a device.
+  constexpr int numblocks = 50;
+  constexpr int interval = 10;
+  std::atomic<int> started{0};
+  std::atomic<int> delivered{0};
+  std::thread sender([&]() {
+    int sample = 0;
+    for (int n = 1; n < numblocks; n++) {
+      while (started.load() < n) { std::this_thread::yield(); }
+      for (; sample < n * framesize; sample += interval) {
+        send(toHost(sample), 0x90, (sample / interval) % 128, 1);
+      }
+      delivered.store(n);
+    }
+  });
+  for (int n = 0; n < numblocks; n++) {
+    while (delivered.load() < n) { std::this_thread::yield(); }
+    runBlock(toHost(n * framesize));
+    started.store(n + 1);
+  }
+  sender.join();
+  ASSERT_EQ(received.size(), ((numblocks - 1) * framesize + interval - 1) / interval);
+  for (size_t i = 0; i < received.size(); i++) {
+    EXPECT_EQ(received[i].time, static_cast<int64_t>(i * interval + framesize)) << i;
+  }
+}
+
+}  // namespace mimium
@@ -0,0 +1,144 @@
+#include "runtime/midi_output.hpp"
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace mimium {
+namespace {
+struct Sent {
+  double hosttime;
+  std::vector<uint8_t> bytes;
+  std::thread::id thread;
+};
+struct SentLog {
+  std::mutex mtx;
+  std::vector<Sent> sent;
+  auto get() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return sent;
+  }
+};
+// records the messages, optionally taking time like a slow device.
+class RecordingSink : public MidiSink {
+ public:
+  explicit RecordingSink(SentLog& log, double delay = 0.0) : log(log), delay(delay) {}
+  void send(const uint8_t* bytes, size_t size) override {
+    if (delay > 0) { std::this_thread::sleep_for(std::chrono::duration<double>(delay)); }
+    std::lock_guard<std::mutex> lock(log.mtx);
+    log.sent.push_back(
+        {HostClock::getHostTime(), {bytes, bytes + size}, std::this_thread::get_id()});
+  }
+
+ private:
+  SentLog& log;
+  double delay;
+};
+void push(MidiOutput& output, double hosttime, uint8_t status, uint8_t data1, uint8_t data2) {
+  const uint8_t bytes[] = {status, data1, data2};
+  output.push(hosttime, bytes, MidiOutput::getMessageSize(status));
+}
+}  // namespace
+
+TEST(midioutput, message_size) {  // NOLINT
+  EXPECT_EQ(MidiOutput::getMessageSize(0x90), 3);
+  EXPECT_EQ(MidiOutput::getMessageSize(0xB5), 3);
+  EXPECT_EQ(MidiOutput::getMessageSize(0xC0), 2);
+  EXPECT_EQ(MidiOutput::getMessageSize(0xDF), 2);
+  EXPECT_EQ(MidiOutput::getMessageSize(0xF2), 3);
+  EXPECT_EQ(MidiOutput::getMessageSize(0xF8), 1);
+  EXPECT_EQ(MidiOutput::getMessageSize(0xF0), 0);
+  EXPECT_EQ(MidiOutput::getMessageSize(0x40), 0);
+}
+
+TEST(midioutput, sent_at_due_time) {  // NOLINT
+  SentLog log;
+  const double start = HostClock::getHostTime();
+  {
+    MidiOutput output(std::make_unique<RecordingSink>(log));
+    push(output, start + 0.02, 0x90, 60, 100);
+    push(output, start + 0.04, 0x80, 60, 0);
+    push(output, start + 0.04, 0x90, 64, 100);
+    while (log.get().size() < 3 && HostClock::getHostTime() < start + 1.0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  const auto sent = log.get();
+  ASSERT_EQ(sent.size(), 3);
+  const std::vector<double> due = {start + 0.02, start + 0.04, start + 0.04};
+  for (size_t i = 0; i < sent.size(); i++) {
+    EXPECT_GE(sent[i].hosttime, due[i]);
+    // generous for loaded machines. The thread sleeps until the due time.
+    EXPECT_LT(sent[i].hosttime, due[i] + 0.015);
+    EXPECT_NE(sent[i].thread, std::this_thread::get_id());
+  }
+  EXPECT_EQ(sent[1].bytes, (std::vector<uint8_t>{0x80, 60, 0}));
+  EXPECT_EQ(sent[2].bytes, (std::vector<uint8_t>{0x90, 64, 100}));
+}
+
+TEST(midioutput, slow_sink_does_not_block) {  // NOLINT
+  SentLog log;
+  constexpr int num = 100;
+  size_t dropped = 0;
+  {
+    MidiOutput output(std::make_unique<RecordingSink>(log, 0.001), 16);
+    const double start = HostClock::getHostTime();
+    for (int i = 0; i < num; i++) { push(output, start, 0x90, i, 100); }
+    // pushing does not wait for the sink.
+    EXPECT_LT(HostClock::getHostTime() - start, 0.01);
+    dropped = output.getNumDropped();
+    EXPECT_GT(dropped, 0);
+  }
+  const auto sent = log.get();
+  EXPECT_EQ(sent.size() + dropped, num);
+  for (size_t i = 1; i < sent.size(); i++) { EXPECT_LT(sent[i - 1].bytes[1], sent[i].bytes[1]); }
+}
+
+TEST(midioutput, flushed_on_destruction) {  // NOLINT
+  SentLog log;
+  {
+    MidiOutput output(std::make_unique<RecordingSink>(log));
+    push(output, HostClock::getHostTime() + 100.0, 0xB0, 123, 0);
+  }
+  const auto sent = log.get();
+  ASSERT_EQ(sent.size(), 1);
+  EXPECT_EQ(sent[0].bytes, (std::vector<uint8_t>{0xB0, 123, 0}));
+}
+
+TEST(midioutput, collected_in_time_order) {  // NOLINT
+  SentLog log;
+  constexpr int numworkers = 3;
+  constexpr int permessages = 20;
+  std::vector<int64_t> hosttimes;
+  {
+    MidiOutput output(std::make_unique<RecordingSink>(log));
+    output.prepareWorkers(numworkers, permessages);
+    std::vector<std::thread> threads;
+    for (int w = 0; w < numworkers; w++) {
+      threads.emplace_back([&, w]() {
+        // descending, so that only the merge puts them in order.
+        for (int i = permessages - 1; i >= 0; i--) {
+          const int64_t time = i * numworkers + w;
+          const uint8_t bytes[] = {0x90, static_cast<uint8_t>(time), 100};
+          output.collect(w, time, w, bytes, 3);
+        }
+      });
+    }
+    for (auto& th : threads) { th.join(); }
+    const uint8_t bytes[] = {0x90, 0, 0};
+    output.collect(0, 0, -1, bytes, 3);
+    EXPECT_EQ(output.getNumDropped(), 1);
+    output.flush([&](int64_t time) {
+      hosttimes.push_back(time);
+      return 0.0;
+    });
+  }
+  const auto sent = log.get();
+  ASSERT_EQ(sent.size(), numworkers * permessages);
+  for (size_t i = 0; i < sent.size(); i++) {
+    EXPECT_EQ(sent[i].bytes[1], i);
+    EXPECT_EQ(hosttimes[i], i);
+  }
+}
+
+}  // namespace mimium
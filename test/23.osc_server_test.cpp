@@ -0,0 +1,247 @@
+#include "runtime/osc_server.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace mimium {
+namespace {
+constexpr double samplerate = 48000.0;
+constexpr int framesize = 64;
+
+// builds OSC packets in big endian with strings padded to 4 bytes.
+class Packet {
+ public:
+  Packet& str(std::string const& s) {
+    bytes.insert(bytes.end(), s.begin(), s.end());
+    do { bytes.push_back('\0'); } while (bytes.size() % 4 != 0);
+    return *this;
+  }
+  Packet& u32(uint32_t v) {
+    for (int i = 3; i >= 0; i--) { bytes.push_back(static_cast<char>((v >> (i * 8U)) & 0xFFU)); }
+    return *this;
+  }
+  Packet& u64(uint64_t v) { return u32(static_cast<uint32_t>(v >> 32U)).u32(v & 0xFFFFFFFFU); }
+  Packet& f32(float v) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return u32(bits);
+  }
+  Packet& f64(double v) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return u64(bits);
+  }
+  Packet& element(Packet const& p) {
+    u32(static_cast<uint32_t>(p.bytes.size()));
+    bytes.insert(bytes.end(), p.bytes.begin(), p.bytes.end());
+    return *this;
+  }
+  std::vector<char> bytes;
+};
+Packet message(std::string const& address, float value) {
+  return Packet().str(address).str(",f").f32(value);
+}
+Packet bundle(uint64_t timetag) { return Packet().str("#bundle").u64(timetag); }
+
+uint64_t toNtp(double unixtime) {
+  const double ntp = unixtime + 2208988800.0;
+  const auto seconds = static_cast<uint64_t>(ntp);
+  const auto fraction = static_cast<uint64_t>((ntp - static_cast<double>(seconds)) * 4294967296.0);
+  return (seconds << 32U) | fraction;
+}
+double getSystemTime() {
+  return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::vector<OscMessageView> parse(Packet const& p) {
+  std::vector<OscMessageView> res(8);
+  auto count = OscServer::parsePacket(p.bytes.data(), p.bytes.size(), res.data(), res.size());
+  if (!count) { return {}; }
+  res.resize(count.value());
+  return res;
+}
+
+// runs blocks of the scheduler as the audio driver does, sending packets from a local socket.
+class OscServerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    sch.start(true);
+    sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sender, 0);
+  }
+  void TearDown() override { close(sender); }
+  void send(Packet const& p) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(server.getPort()));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::sendto(sender, p.bytes.data(), p.bytes.size(), 0,
+             reinterpret_cast<sockaddr*>(&addr), sizeof(addr));  // NOLINT
+  }
+  bool waitReceived(size_t num) {
+    const double limit = HostClock::getHostTime() + 2.0;
+    while (server.getNumReceived() < num && HostClock::getHostTime() < limit) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return server.getNumReceived() >= num;
+  }
+  // calls onsample with the time of each sample and the value of the slot.
+  template <typename F>
+  void runBlock(double hostnow, int slot, F&& onsample) {
+    clock.update(sch.getTime(), framesize, samplerate, hostnow);
+    server.dispatch(sch, clock, sch.getTime(), framesize);
+    for (int i = 0; i < framesize; i++) {
+      sch.incrementTime();
+      onsample(sch.getTime() - 1, server.getValue(slot));
+    }
+  }
+  Scheduler sch;
+  HostClock clock;
+  OscServer server{0};
+  int sender = -1;
+};
+}  // namespace
+
+TEST(oscserver, parse_message_types) {  // NOLINT
+  // the views refer to the packets, which are kept alive.
+  const auto freq = message("/freq", 440.0F);
+  auto m = parse(freq);
+  ASSERT_EQ(m.size(), 1);
+  EXPECT_EQ(m[0].address, "/freq");
+  EXPECT_EQ(m[0].value, 440.0);
+  EXPECT_FALSE(m[0].timetag);
+  EXPECT_EQ(parse(Packet().str("/a").str(",i").u32(static_cast<uint32_t>(-3))).at(0).value, -3.0);
+  EXPECT_EQ(parse(Packet().str("/a").str(",d").f64(0.25)).at(0).value, 0.25);
+  EXPECT_EQ(parse(Packet().str("/a").str(",T")).at(0).value, 1.0);
+  // non-numeric arguments before the value are skipped.
+  const auto skipped = Packet().str("/a").str(",sbf").str("name").u32(5).str("abcd").f32(2.0F);
+  EXPECT_EQ(parse(skipped).at(0).value, 2.0);
+  EXPECT_FALSE(parse(Packet().str("/a").str(",s").str("name")).at(0).value);
+  // without type tags.
+  EXPECT_FALSE(parse(Packet().str("/a")).at(0).value);
+}
+
+TEST(oscserver, parse_nested_bundles) {  // NOLINT
+  auto inner = bundle(1000).element(message("/b", 2.0F));
+  auto immediate = bundle(1).element(message("/c", 3.0F));
+  auto outer = bundle(500).element(message("/a", 1.0F)).element(inner).element(immediate);
+  const auto m = parse(outer);
+  ASSERT_EQ(m.size(), 3);
+  EXPECT_EQ(m[0].address, "/a");
+  EXPECT_EQ(m[0].timetag, 500U);
+  EXPECT_EQ(m[1].address, "/b");
+  EXPECT_EQ(m[1].timetag, 1000U);
+  EXPECT_EQ(m[2].address, "/c");
+  EXPECT_FALSE(m[2].timetag);
+}
+
+TEST(oscserver, parse_malformed) {  // NOLINT
+  auto invalid = [](Packet const& p) {
+    OscMessageView m;
+    return !OscServer::parsePacket(p.bytes.data(), p.bytes.size(), &m, 1);
+  };
+  // not aligned, unterminated address, neither a message nor a bundle.
+  EXPECT_TRUE(invalid(Packet().u32(0).u32(0).u32(0).str("/a").str(",f").u32(0)));
+  EXPECT_TRUE(invalid(Packet{{'/', 'a', 'b', 'c'}}));
+  EXPECT_TRUE(invalid(Packet{{'/', 'a', '\0'}}));
+  EXPECT_TRUE(invalid(Packet().str("abc")));
+  // element larger than the bundle.
+  auto p = bundle(1).u32(100).str("/a");
+  EXPECT_TRUE(invalid(p));
+  // blob larger than the message gives no value, and a missing argument too.
+  EXPECT_FALSE(parse(Packet().str("/a").str(",bf").u32(0xFFFFFFFF)).at(0).value);
+  EXPECT_FALSE(parse(Packet().str("/a").str(",f")).at(0).value);
+  // too deep bundles.
+  Packet deep = bundle(1).element(message("/a", 1.0F));
+  for (int i = 0; i < 10; i++) { deep = bundle(1).element(deep); }
+  EXPECT_TRUE(invalid(deep));
+}
+
+TEST(oscserver, ntp_to_host_time) {  // NOLINT
+  const double host = HostClock::getHostTime();
+  const double converted = OscServer::toHostTime(toNtp(getSystemTime() + 0.5));
+  EXPECT_NEAR(converted - host, 0.5, 0.002);
+}
+
+TEST_F(OscServerTest, params) {  // NOLINT
+  const int freq = server.addParam("/freq", 440.0);
+  const int gain = server.addParam("/gain", 0.5);
+  EXPECT_EQ(server.addParam("/freq", 0.0), freq);
+  EXPECT_NE(freq, gain);
+  EXPECT_EQ(server.getValue(freq), 440.0);
+  EXPECT_EQ(server.getValue(gain), 0.5);
+  EXPECT_EQ(server.getValue(-1), 0.0);
+  EXPECT_EQ(server.getValue(100), 0.0);
+  EXPECT_GT(server.getPort(), 0);
+}
+
+TEST_F(OscServerTest, loopback_message) {  // NOLINT
+  const int freq = server.addParam("/freq", 440.0);
+  send(message("/unknown", 1.0F));
+  send(message("/freq", 880.0F));
+  ASSERT_TRUE(waitReceived(2));
+  EXPECT_EQ(server.getNumIgnored(), 1);
+  // set in the next block as the arrival is in the past of the clock.
+  const double start = HostClock::getHostTime();
+  double last = 0;
+  for (int n = 0; n < 3; n++) {
+    runBlock(start + n * framesize / samplerate, freq, [&](int64_t, double v) { last = v; });
+  }
+  EXPECT_EQ(last, 880.0);
+}
+
+TEST_F(OscServerTest, timetag_sets_at_sample) {  // NOLINT
+  const int freq = server.addParam("/freq", 440.0);
+  const double hoststart = HostClock::getHostTime();
+  const double systemstart = getSystemTime();
+  constexpr int64_t target = 480;
+  const auto tag = toNtp(systemstart + target / samplerate);
+  send(bundle(tag).element(message("/freq", 220.0F)));
+  ASSERT_TRUE(waitReceived(1));
+  int64_t changed = -1;
+  for (int n = 0; n < 20; n++) {
+    runBlock(hoststart + n * framesize / samplerate, freq, [&](int64_t t, double v) {
+      if (changed < 0 && v == 220.0) { changed = t; }
+    });
+  }
+  EXPECT_NEAR(static_cast<double>(changed), static_cast<double>(target), 2.0);
+}
+
+TEST_F(OscServerTest, high_rate_keeps_order) {  // NOLINT
+  const int slot = server.addParam("/x", -1.0);
+  constexpr int num = 5000;
+  std::atomic<bool> done{false};
+  std::thread th([&]() {
+    for (int i = 0; i < num; i++) { send(message("/x", static_cast<float>(i))); }
+    done.store(true);
+  });
+  double last = -1.0;
+  bool ordered = true;
+  auto onsample = [&](int64_t, double v) {
+    ordered = ordered && v >= last;
+    last = v;
+  };
+  const double limit = HostClock::getHostTime() + 5.0;
+  while (!done.load() ||
+         (server.getNumReceived() < num && HostClock::getHostTime() < limit)) {
+    runBlock(HostClock::getHostTime(), slot, onsample);
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+  }
+  th.join();
+  // the values of the last block are set in the following ones.
+  for (int n = 0; n < 4; n++) { runBlock(HostClock::getHostTime(), slot, onsample); }
+  EXPECT_TRUE(ordered);
+  // the kernel may drop datagrams under load, but the last received value wins.
+  EXPECT_GT(server.getNumReceived(), 0);
+  if (server.getNumReceived() == num) { EXPECT_EQ(last, num - 1); }
+}
+
+}  // namespace mimium
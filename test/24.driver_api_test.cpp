@@ -0,0 +1,261 @@
+#include "runtime/backend/api/driver_api.hpp"
+#include <array>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace mimium {
+namespace {
+constexpr double samplerate = 48000.0;
+constexpr int maxframes = 64;
+
+// mono input to stereo output.
+void gainDsp(double* out, const double* in, void* /*cls*/, void* /*memobj*/) {
+  out[0] = in[0] * 2.0;
+  out[1] = -in[0];
+}
+
+struct Received {
+  int64_t time;
+  double message;
+};
+Scheduler* current_scheduler = nullptr;
+std::vector<Received> received;
+void recordMessage(double message) {
+  received.push_back({current_scheduler->getTime() - 1, message});
+}
+
+std::unique_ptr<AudioDriverAPI> makeDriver(DspFnPtr fn, int inchs, int outchs,
+                                           size_t capacity = 1024) {
+  auto driver = std::make_unique<AudioDriverAPI>(samplerate, maxframes, capacity);
+  driver->setDspFnInfos(
+      std::make_unique<DspFnInfos>(DspFnInfos{fn, nullptr, nullptr, inchs, outchs}));
+  return driver;
+}
+void start(AudioDriverAPI& driver) {
+  driver.setup(driver.getDefaultAudioParameter(std::nullopt, std::nullopt));
+  driver.start();
+}
+
+// planar buffers of a block as a host gives them.
+struct Block {
+  Block(int inchs, int outchs, int frames)
+      : in(inchs, std::vector<float>(frames)), out(outchs, std::vector<float>(frames, 1.0F)) {
+    for (auto& ch : in) { inptrs.push_back(ch.data()); }
+    for (auto& ch : out) { outptrs.push_back(ch.data()); }
+  }
+  std::vector<std::vector<float>> in;
+  std::vector<std::vector<float>> out;
+  std::vector<const float*> inptrs;
+  std::vector<float*> outptrs;
+};
+
+class DriverApiTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    received.clear();
+    current_scheduler = &driver->getScheduler();
+    driver->getMidiInput()->setHandler(reinterpret_cast<void*>(recordMessage),  // NOLINT
+                                       nullptr, false);
+    start(*driver);
+  }
+  bool process(int frames) {
+    Block block(1, 2, frames);
+    return driver->processPlanar(block.inptrs.data(), block.outptrs.data(), frames);
+  }
+  std::unique_ptr<AudioDriverAPI> driver = makeDriver(gainDsp, 1, 2, 8);
+};
+
+class RecordingSink : public MidiSink {
+ public:
+  explicit RecordingSink(std::vector<std::vector<uint8_t>>& log) : log(log) {}
+  void send(const uint8_t* bytes, size_t size) override {
+    std::lock_guard<std::mutex> lock(mtx);
+    log.emplace_back(bytes, bytes + size);
+  }
+
+ private:
+  std::mutex mtx;
+  std::vector<std::vector<uint8_t>>& log;
+};
+
+int num_tasks_run = 0;
+void countTask(double /*arg*/) { num_tasks_run++; }
+
+constexpr int midi_voices = 8;
+constexpr int midi_interval = 16;
+AudioDriver* midi_driver = nullptr;
+// times of the scheduler when the voices sent their k-th messages, each written by one thread.
+std::array<std::array<int64_t, 64>, midi_voices> midi_times{};
+// sends the count of its samples every interval, with the key given by noteOn.
+void midiVoice(double* out, const double* in, void* /*cls*/, void* memobj) {
+  auto* count = static_cast<double*>(memobj);
+  const auto n = static_cast<int64_t>(*count);
+  if (n % midi_interval == 0) {
+    const auto key = static_cast<uint8_t>(in[1]);
+    const uint8_t message[] = {0x90, key, static_cast<uint8_t>(n / midi_interval)};
+    midi_times[key][n / midi_interval] = VoicePool::getRenderingVoice().time;
+    midi_driver->sendMidi(message, 3);
+  }
+  *count += 1.0;
+  out[0] = 0.0;
+  out[1] = 0.0;
+}
+// messages sent by the voices on the threads, in the order given to the device.
+std::vector<std::vector<uint8_t>> renderMidiVoices(int numthreads, int blocks) {
+  std::vector<std::vector<uint8_t>> log;
+  {
+    auto driver = makeDriver(gainDsp, 1, 2);
+    midi_driver = driver.get();
+    driver->setVoicePool(std::make_unique<VoicePool>(
+        VoiceFnInfos{midiVoice, nullptr, sizeof(double), 2, 2}, midi_voices));
+    driver->setDspThreads(numthreads);
+    driver->setMidiOutput(std::make_unique<MidiOutput>(std::make_unique<RecordingSink>(log)));
+    start(*driver);
+    for (int v = 0; v < midi_voices; v++) {
+      const double key = v;
+      driver->getVoicePool()->noteOn(1 + v * 5, &key, 1);
+    }
+    Block block(1, 2, maxframes);
+    for (int b = 0; b < blocks; b++) {
+      driver->processPlanar(block.inptrs.data(), block.outptrs.data(), maxframes);
+    }
+    // the rest of the messages are sent when the output is destroyed.
+  }
+  return log;
+}
+}  // namespace
+
+TEST_F(DriverApiTest, any_block_size) {  // NOLINT
+  EXPECT_EQ(driver->getInNumChs(), 1);
+  EXPECT_EQ(driver->getOutNumChs(), 2);
+  int64_t total = 0;
+  for (int frames : {1, 100, 64, 300, 7}) {
+    Block block(1, 2, frames);
+    for (int i = 0; i < frames; i++) { block.in[0][i] = static_cast<float>(i) / 1000.0F; }
+    ASSERT_TRUE(driver->processPlanar(block.inptrs.data(), block.outptrs.data(), frames));
+    for (int i = 0; i < frames; i++) {
+      EXPECT_FLOAT_EQ(block.out[0][i], 2.0F * block.in[0][i]);
+      EXPECT_FLOAT_EQ(block.out[1][i], -block.in[0][i]);
+    }
+    total += frames;
+    EXPECT_EQ(driver->getProcessedTime(), total);
+  }
+}
+
+TEST_F(DriverApiTest, midi_at_sample) {  // NOLINT
+  const uint8_t noteon[] = {0x90, 60, 100};
+  const uint8_t noteoff[] = {0x80, 60, 0};
+  EXPECT_TRUE(driver->scheduleMidi(100, noteon, 3));
+  EXPECT_TRUE(driver->scheduleMidi(130, noteoff, 3));
+  // split across the blocks of the driver.
+  process(300);
+  // the time has passed, so it plays at the beginning of the next block.
+  EXPECT_TRUE(driver->scheduleMidi(10, noteon, 3));
+  process(16);
+  ASSERT_EQ(received.size(), 3);
+  EXPECT_EQ(received[0].time, 100);
+  EXPECT_EQ(received[0].message, MidiInput::packMessage(noteon, 3));
+  EXPECT_EQ(received[1].time, 130);
+  EXPECT_EQ(received[2].time, 300);
+}
+
+TEST_F(DriverApiTest, invalid_and_full_queue) {  // NOLINT
+  const uint8_t sysex[] = {0xF0, 0x7E, 0xF7};
+  EXPECT_FALSE(driver->scheduleMidi(0, sysex, 3));
+  const uint8_t data[] = {0x40, 0x40};
+  EXPECT_FALSE(driver->scheduleMidi(0, data, 2));
+  const uint8_t noteon[] = {0x90, 60, 100};
+  for (int i = 0; i < 8; i++) { EXPECT_TRUE(driver->scheduleMidi(i, noteon, 3)); }
+  EXPECT_FALSE(driver->scheduleMidi(8, noteon, 3));
+  process(maxframes);
+  EXPECT_EQ(received.size(), 8);
+}
+
+TEST_F(DriverApiTest, scheduled_from_threads) {  // NOLINT
+  constexpr int numthreads = 4;
+  constexpr int permessages = 100;
+  std::vector<std::thread> threads;
+  std::atomic<int> accepted{0};
+  for (int t = 0; t < numthreads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < permessages; i++) {
+        const uint8_t message[] = {0x90, static_cast<uint8_t>(t), static_cast<uint8_t>(i)};
+        // retries while the audio thread has not taken the queued messages.
+        while (!driver->scheduleMidi(0, message, 3)) { std::this_thread::yield(); }
+        accepted++;
+      }
+    });
+  }
+  while (accepted.load() < numthreads * permessages) { process(maxframes); }
+  for (auto& th : threads) { th.join(); }
+  process(maxframes);
+  EXPECT_EQ(received.size(), numthreads * permessages);
+}
+
+TEST(driverapi, stops_without_dsp) {  // NOLINT
+  auto driver = makeDriver(nullptr, 0, 1);
+  Block block(0, 1, 16);
+  // not started yet.
+  EXPECT_FALSE(driver->processPlanar(block.inptrs.data(), block.outptrs.data(), 16));
+  start(*driver);
+  EXPECT_TRUE(driver->isRunning());
+  EXPECT_FALSE(driver->processPlanar(block.inptrs.data(), block.outptrs.data(), 16));
+  EXPECT_FALSE(driver->isRunning());
+  for (float v : block.out[0]) { EXPECT_EQ(v, 0.0F); }
+}
+
+TEST(driverapi, voice_release_by_samplerate) {  // NOLINT
+  auto driver = std::make_unique<AudioDriverAPI>(96000.0, maxframes);
+  driver->setDspFnInfos(
+      std::make_unique<DspFnInfos>(DspFnInfos{gainDsp, nullptr, nullptr, 1, 2}));
+  driver->setVoicePool(
+      std::make_unique<VoicePool>(VoiceFnInfos{gainDsp, nullptr, sizeof(double), 1, 2}, 1));
+  start(*driver);
+  // a second of release at the sample rate of the driver.
+  EXPECT_EQ(driver->getVoicePool()->getMaxReleaseFrames(), 96000);
+}
+
+TEST(driverapi, invalid_config) {  // NOLINT
+  EXPECT_THROW(AudioDriverAPI(0.0, 64), std::runtime_error);
+  EXPECT_THROW(AudioDriverAPI(48000.0, 0), std::runtime_error);
+}
+
+TEST(driverapi, midiout_from_voice_threads) {  // NOLINT
+  constexpr int blocks = 8;
+  const auto parallel = renderMidiVoices(4, blocks);
+  const auto parallel_times = midi_times;
+  const auto serial = renderMidiVoices(1, blocks);
+  EXPECT_EQ(parallel, serial);
+  EXPECT_EQ(parallel_times, midi_times);
+  // each voice sends every interval from its onset until the end.
+  size_t expected = 0;
+  for (int v = 0; v < midi_voices; v++) {
+    const int64_t frames = blocks * maxframes - v * 5;
+    expected += (frames + midi_interval - 1) / midi_interval;
+  }
+  ASSERT_EQ(parallel.size(), expected);
+  // in the order of the samples which sent them.
+  for (size_t i = 1; i < parallel.size(); i++) {
+    EXPECT_LE(midi_times[parallel[i - 1][1]][parallel[i - 1][2]],
+              midi_times[parallel[i][1]][parallel[i][2]]);
+  }
+}
+
+TEST(driverapi, many_tasks_at_same_time) {  // NOLINT
+  auto driver = makeDriver(gainDsp, 1, 2);
+  start(*driver);
+  // due tasks run in a loop, so their number is not limited by the stack.
+  constexpr int numtasks = 200000;
+  num_tasks_run = 0;
+  for (int i = 0; i < numtasks; i++) {
+    driver->getScheduler().addTask(0, reinterpret_cast<void*>(countTask), 0, nullptr);  // NOLINT
+  }
+  Block block(1, 2, 1);
+  driver->processPlanar(block.inptrs.data(), block.outptrs.data(), 1);
+  EXPECT_EQ(num_tasks_run, numtasks);
+  EXPECT_FALSE(driver->getScheduler().hasTask());
+}
+
+}  // namespace mimium
@@ -0,0 +1,277 @@
+#include <array>
+#include <cmath>
+#include <sstream>
+#include "compiler/codegen/llvm_header.hpp"
+#include "compiler/compiler.hpp"
+#include "compiler/fast_math.hpp"
+#include "compiler/ffi.hpp"
+#include "compiler/filters.hpp"
+#include "compiler/prng.hpp"
+#include "gtest/gtest.h"
+#include "runtime/JIT/runtime_jit.hpp"
+#include "runtime/backend/api/driver_api.hpp"
+
+namespace mimium {
+namespace {
+constexpr int framesize = 64;
+
+struct JitOption {
+  bool float32 = false;
+  bool fastmath = false;
+  // partitions of the module compiled in parallel.
+  unsigned jit_threads = 0;
+};
+
+std::unique_ptr<Compiler> compile(std::string const& src, JitOption option) {
+  auto compiler = std::make_unique<Compiler>();
+  compiler->setFilePath("/jit_test");
+  compiler->setFloat32(option.float32);
+  compiler->setFastMath(option.fastmath);
+  auto ast = compiler->renameSymbols(compiler->loadSource(src));
+  compiler->typeInfer(ast);
+  auto mir = compiler->closureConvert(
+      compiler->hoistControlRate(compiler->expandMultirate(compiler->generateMir(ast))));
+  auto funobjs = compiler->collectMemoryObjs(mir);
+  compiler->generateLLVMIr(mir, funobjs);
+  return compiler;
+}
+
+std::string emitIr(std::string const& src, JitOption option) {
+  std::ostringstream ss;
+  compile(src, option)->dumpLLVMModule(ss);
+  return ss.str();
+}
+
+// runs dsp of the source on the mono input, and returns its interleaved output.
+std::vector<double> render(std::string const& src, std::vector<double> const& input,
+                           JitOption option = {}) {
+  auto compiler = compile(src, option);
+  auto driver = std::make_unique<AudioDriverAPI>(48000.0, framesize);
+  auto& d = *driver;
+  Runtime_LLVM runtime(compiler->moveLLVMCtx(), compiler->moveLLVMModule(), "jit_test.mmm",
+                       std::move(driver), true, option.jit_threads);
+  runtime.runMainFun();
+  d.setup(d.getDefaultAudioParameter(std::nullopt, std::nullopt));
+  d.start();
+  const int outchs = d.getOutNumChs();
+  std::vector<double> output(input.size() * outchs);
+  for (size_t offset = 0; offset < input.size(); offset += framesize) {
+    const auto frames = static_cast<int>(std::min<size_t>(framesize, input.size() - offset));
+    d.process(std::next(input.data(), offset), std::next(output.data(), offset * outchs), frames);
+  }
+  return output;
+}
+
+std::vector<double> makeRamp(size_t size, double from, double to) {
+  std::vector<double> res(size);
+  for (size_t i = 0; i < size; i++) {
+    res[i] = from + (to - from) * static_cast<double>(i) / static_cast<double>(size - 1);
+  }
+  return res;
+}
+
+// the level is set by tasks at 100 and 200 samples.
+constexpr auto src_tasks = R"(
+level = 0
+fn setlevel(v){
+  level = v
+}
+setlevel(0.5)@100
+setlevel(0.25)@200
+fn dsp(input:float)->float{
+  return input*level+sin(input)
+}
+)";
+template <typename T>
+T getTaskLevel(size_t i) {
+  return i >= 200 ? T(0.25) : i >= 100 ? T(0.5) : T(0);
+}
+
+constexpr auto src_fastmath = R"(
+fn dsp(x:float)->(float,float,float,float,float,float,float){
+  return (fastsin(x),fastcos(x),fasttan(x),fastexp(x),fastlog(x),fasttanh(x),fastpow(x,2.5))
+}
+)";
+// the same functions replaced by --fast-math.
+constexpr auto src_libm = R"(
+fn dsp(x:float)->(float,float,float,float,float,float,float){
+  return (sin(x),cos(x),tan(x),exp(x),log(x),tanh(x),pow(x,2.5))
+}
+)";
+template <typename T>
+std::array<T, 7> getFastMathReference(T x) {
+  namespace fm = fastmath;
+  return {fm::sin(x), fm::cos(x), fm::tan(x), fm::exp(x), fm::log(x), fm::tanh(x),
+          fm::pow(x, T(2.5))};
+}
+// the inline IR of FastMathEmitter computes the same as the templates in fast_math.hpp.
+template <typename T>
+void checkFastMath(std::vector<double> const& input, std::vector<double> const& output) {
+  ASSERT_EQ(output.size(), input.size() * 7);
+  for (size_t i = 0; i < input.size(); i++) {
+    const auto ref = getFastMathReference(static_cast<T>(input[i]));
+    for (size_t ch = 0; ch < ref.size(); ch++) {
+      const auto res = static_cast<T>(output[i * 7 + ch]);
+      if constexpr (std::is_same_v<T, float>) {
+        EXPECT_FLOAT_EQ(res, ref[ch]) << "channel " << ch << " at " << input[i];
+      } else {
+        EXPECT_DOUBLE_EQ(res, ref[ch]) << "channel " << ch << " at " << input[i];
+      }
+    }
+  }
+}
+
+// the state of random is the only memory object of dsp.
+constexpr auto src_random = R"(
+fn dsp(input:float)->float{
+  return random()
+}
+)";
+// the inline IR of PrngEmitter generates the same sequence as prng.hpp, from the stream of the
+// offset of the state in the memory object.
+template <typename T>
+void checkRandom(std::vector<double> const& output) {
+  const auto id = static_cast<uint64_t>(RandomArena::Dsp);
+  auto state = static_cast<prng::state_t<T>>(
+      prng::getStreamSeed(0, prng::getStreamIndex(id, 0, 0)));
+  for (size_t i = 0; i < output.size(); i++) {
+    EXPECT_EQ(static_cast<T>(output[i]), prng::next<T>(state)) << "at " << i;
+  }
+}
+
+// biquads and svfs called twice in dsp share banks of states, whose lanes are stride apart.
+constexpr auto src_filterbank = R"(
+fn dsp(x:float)->(float,float,float,float){
+  a = biquad(x,0.2,0.1,0.05,-0.4,0.1)
+  b = biquad(x,0.5,-0.2,0.3,0.2,0.05)
+  return (a,b,svf_lp(x,0.1,1.4),svf_hp(x,0.2,0.7))
+}
+)";
+// the same filters with their own memory objects.
+constexpr auto src_filters = R"(
+fn bq1(x){
+  return biquad(x,0.2,0.1,0.05,-0.4,0.1)
+}
+fn bq2(x){
+  return biquad(x,0.5,-0.2,0.3,0.2,0.05)
+}
+fn lp(x){
+  return svf_lp(x,0.1,1.4)
+}
+fn hp(x){
+  return svf_hp(x,0.2,0.7)
+}
+fn dsp(x:float)->(float,float,float,float){
+  return (bq1(x),bq2(x),lp(x),hp(x))
+}
+)";
+// separate filters of filters.hpp, interleaved.
+template <typename T>
+std::vector<T> getFilterReference(std::vector<double> const& input) {
+  std::array<std::array<T, 2>, 4> states{};
+  std::vector<T> res;
+  for (auto v : input) {
+    const auto x = static_cast<T>(v);
+    namespace fl = filters;
+    res.emplace_back(fl::biquad<T>(x, 0.2, 0.1, 0.05, -0.4, 0.1, states[0].data(), 1));
+    res.emplace_back(fl::biquad<T>(x, 0.5, -0.2, 0.3, 0.2, 0.05, states[1].data(), 1));
+    res.emplace_back(fl::svf<T>(x, 0.1, 1.4, states[2].data(), 1, fl::SvfMode::Low));
+    res.emplace_back(fl::svf<T>(x, 0.2, 0.7, states[3].data(), 1, fl::SvfMode::High));
+  }
+  return res;
+}
+template <typename T>
+void checkFilters(std::vector<double> const& input, std::vector<double> const& output) {
+  const auto ref = getFilterReference<T>(input);
+  ASSERT_EQ(output.size(), ref.size());
+  for (size_t i = 0; i < ref.size(); i++) {
+    const auto res = static_cast<T>(output[i]);
+    if constexpr (std::is_same_v<T, float>) {
+      EXPECT_FLOAT_EQ(res, ref[i]) << "channel " << i % 4 << " at " << i / 4;
+    } else {
+      EXPECT_DOUBLE_EQ(res, ref[i]) << "channel " << i % 4 << " at " << i / 4;
+    }
+  }
+}
+}  // namespace
+
+TEST(jit, tasks) {  // NOLINT
+  const auto input = makeRamp(300, -3.0, 3.0);
+  const auto output = render(src_tasks, input);
+  ASSERT_EQ(output.size(), input.size());
+  for (size_t i = 0; i < input.size(); i++) {
+    EXPECT_DOUBLE_EQ(output[i], input[i] * getTaskLevel<double>(i) + std::sin(input[i]));
+  }
+}
+
+TEST(jit, float32_ir) {  // NOLINT
+  const auto ir = emitIr(src_tasks, {true});
+  // dsp keeps double frames around the single precision body.
+  EXPECT_NE(ir.find("@dsp.f32("), std::string::npos);
+  const auto entry = ir.find("@dsp(");
+  ASSERT_NE(entry, std::string::npos);
+  const auto linestart = ir.rfind('\n', entry) + 1;
+  const auto line = ir.substr(linestart, ir.find('\n', entry) - linestart);
+  EXPECT_NE(line.find("double*"), std::string::npos) << line;
+  EXPECT_NE(ir.find("@sinf("), std::string::npos);
+  EXPECT_EQ(ir.find("@sin("), std::string::npos);
+  EXPECT_NE(ir.find("@addTask_f32("), std::string::npos);
+  EXPECT_EQ(ir.find("@addTask("), std::string::npos);
+}
+
+TEST(jit, float32_tasks) {  // NOLINT
+  const auto input = makeRamp(300, -3.0, 3.0);
+  const auto output = render(src_tasks, input, {true});
+  const auto output_f64 = render(src_tasks, input);
+  ASSERT_EQ(output.size(), input.size());
+  int differs = 0;
+  for (size_t i = 0; i < input.size(); i++) {
+    const auto x = static_cast<float>(input[i]);
+    EXPECT_FLOAT_EQ(static_cast<float>(output[i]), x * getTaskLevel<float>(i) + std::sin(x));
+    if (output[i] != output_f64[i]) { differs++; }
+  }
+  // the body really runs in single precision.
+  EXPECT_GT(differs, 0);
+}
+
+TEST(jit, fastmath) {  // NOLINT
+  // positive, as log and pow are defined only there.
+  const auto input = makeRamp(1000, 0.05, 9.95);
+  checkFastMath<double>(input, render(src_fastmath, input));
+  checkFastMath<double>(input, render(src_libm, input, {false, true}));
+  checkFastMath<float>(input, render(src_fastmath, input, {true}));
+}
+
+TEST(jit, random) {  // NOLINT
+  const std::vector<double> input(300, 0.0);
+  setRandomSeed(0);
+  checkRandom<double>(render(src_random, input));
+  setRandomSeed(0);
+  checkRandom<float>(render(src_random, input, {true}));
+}
+
+TEST(jit, filter_banks) {  // NOLINT
+  // the states are banked only when the filters are called in the same function.
+  EXPECT_NE(emitIr(src_filterbank, {}).find(".bank"), std::string::npos);
+  EXPECT_EQ(emitIr(src_filters, {}).find(".bank"), std::string::npos);
+  std::vector<double> input(500);
+  for (size_t i = 0; i < input.size(); i++) { input[i] = std::sin(0.37 * static_cast<double>(i)); }
+  checkFilters<double>(input, render(src_filterbank, input));
+  checkFilters<double>(input, render(src_filters, input));
+  checkFilters<float>(input, render(src_filterbank, input, {true}));
+  checkFilters<float>(input, render(src_filters, input, {true}));
+}
+
+TEST(jit, parallel_partitions) {  // NOLINT
+  // functions split into partitions call each other through the main dylib.
+  std::vector<double> input(500);
+  for (size_t i = 0; i < input.size(); i++) { input[i] = std::sin(0.37 * static_cast<double>(i)); }
+  for (const auto* src : {src_filters, src_tasks}) {
+    const auto output = render(src, input);
+    ASSERT_FALSE(output.empty());
+    EXPECT_EQ(render(src, input, {false, false, 4}), output);
+    EXPECT_EQ(render(src, input, {true, false, 4}), render(src, input, {true}));
+  }
+}
+
+}  // namespace mimium
@@ -0,0 +1,117 @@
+#include <array>
+#include <cmath>
+#include <vector>
+#include "compiler/fast_math.hpp"
+#include "frontend/mimium_api.h"
+#include "gtest/gtest.h"
+
+namespace {
+constexpr int maxframes = 64;
+constexpr double samplerate = 48000.0;
+
+constexpr auto src_sin = R"(
+fn dsp(input:float)->float{
+  return sin(input)
+}
+)";
+
+std::vector<float> makeRamp(size_t size) {
+  std::vector<float> res(size);
+  for (size_t i = 0; i < size; i++) { res[i] = -3.0F + 6.0F * static_cast<float>(i) / size; }
+  return res;
+}
+
+// processes the mono input at once, which is longer than maxframes.
+std::vector<float> process(mimium_instance* instance, std::vector<float> const& input) {
+  EXPECT_EQ(mimium_get_num_inputs(instance), 1);
+  EXPECT_EQ(mimium_get_num_outputs(instance), 1);
+  std::vector<float> output(input.size());
+  const float* in = input.data();
+  float* out = output.data();
+  EXPECT_EQ(mimium_process(instance, &in, &out, static_cast<int>(input.size())), 1);
+  return output;
+}
+
+std::vector<float> render(const char* source, std::vector<float> const& input,
+                          mimium_options const& options) {
+  std::array<char, 256> error{};
+  auto* instance = mimium_create_with_options(source, samplerate, maxframes, &options,
+                                              error.data(), error.size());
+  EXPECT_NE(instance, nullptr) << error.data();
+  if (instance == nullptr) { return {}; }
+  auto output = process(instance, input);
+  EXPECT_EQ(mimium_get_time(instance), static_cast<int64_t>(input.size()));
+  mimium_destroy(instance);
+  return output;
+}
+}  // namespace
+
+TEST(mimium_api, process) {  // NOLINT
+  const auto input = makeRamp(300);
+  std::array<char, 256> error{};
+  auto* instance = mimium_create(src_sin, samplerate, maxframes, error.data(), error.size());
+  ASSERT_NE(instance, nullptr) << error.data();
+  EXPECT_EQ(mimium_is_running(instance), 1);
+  const auto output = process(instance, input);
+  for (size_t i = 0; i < input.size(); i++) {
+    EXPECT_FLOAT_EQ(output[i], static_cast<float>(std::sin(static_cast<double>(input[i]))));
+  }
+  EXPECT_EQ(mimium_get_time(instance), 300);
+  mimium_destroy(instance);
+}
+
+TEST(mimium_api, options) {  // NOLINT
+  namespace fm = mimium::fastmath;
+  const auto input = makeRamp(300);
+  const auto output_f64 = render(src_sin, input, {0, 0});
+  const auto output_f32 = render(src_sin, input, {1, 0});
+  const auto fast_f64 = render(src_sin, input, {0, 1});
+  const auto fast_f32 = render(src_sin, input, {1, 1});
+  ASSERT_EQ(fast_f32.size(), input.size());
+  int differs = 0;
+  for (size_t i = 0; i < input.size(); i++) {
+    EXPECT_FLOAT_EQ(output_f32[i], std::sin(input[i]));
+    EXPECT_FLOAT_EQ(fast_f64[i], static_cast<float>(fm::sin(static_cast<double>(input[i]))));
+    EXPECT_FLOAT_EQ(fast_f32[i], fm::sin(input[i]));
+    if (output_f32[i] != output_f64[i]) { differs++; }
+  }
+  EXPECT_GT(differs, 0);
+}
+
+TEST(mimium_api, include) {  // NOLINT
+  // resolved from the working directory of the test.
+  constexpr auto src = R"(
+include "preprocessor/includee.mmm"
+fn dsp(input:float)->float{
+  return addone(variable)+input
+}
+)";
+  const std::vector<float> input(100, 0.0F);
+  for (auto v : render(src, input, {})) { EXPECT_EQ(v, 101.0F); }
+}
+
+TEST(mimium_api, ends) {  // NOLINT
+  std::array<char, 256> error{};
+  auto* instance = mimium_create("x = 1\n", samplerate, maxframes, error.data(), error.size());
+  ASSERT_NE(instance, nullptr) << error.data();
+  // neither dsp function nor tasks.
+  EXPECT_EQ(mimium_get_num_outputs(instance), 0);
+  EXPECT_EQ(mimium_process(instance, nullptr, nullptr, maxframes), 0);
+  EXPECT_EQ(mimium_is_running(instance), 0);
+  mimium_destroy(instance);
+}
+
+TEST(mimium_api, errors) {  // NOLINT
+  std::array<char, 256> error{};
+  EXPECT_EQ(mimium_create("fn dsp(", samplerate, maxframes, error.data(), error.size()), nullptr);
+  EXPECT_NE(error[0], '\0');
+  error.fill('\0');
+  EXPECT_EQ(mimium_create(nullptr, samplerate, maxframes, error.data(), error.size()), nullptr);
+  EXPECT_STREQ(error.data(), "source is empty");
+  // the message is truncated to the buffer.
+  std::array<char, 4> small{};
+  EXPECT_EQ(mimium_create("", samplerate, maxframes, small.data(), small.size()), nullptr);
+  EXPECT_STREQ(small.data(), "sou");
+  EXPECT_EQ(mimium_create("fn dsp(", samplerate, maxframes, nullptr, 0), nullptr);
+  mimium_destroy(nullptr);
+}
@@ -4,6 +4,7 @@
 
 #include "frontend/cli.hpp"
 #include "frontend/errors.hpp"
+#include "frontend/genericapp.hpp"
 
 namespace mmmcli = mimium::app::cli;
 
@@ -52,3 +53,55 @@ TEST(cli, optionstage) {  // NOLINT
   EXPECT_EQ(appoption.output_path, std::nullopt);
   EXPECT_FALSE(appoption.is_verbose);
 }
+
+TEST(cli, bench) {  // NOLINT
+  std::vector<const char*> args = {"/usr/local/mimium", "test_tuple.mmm", "--bench", "2.5",
+                                   "--bench-rate", "44100", "--bench-block", "64", "--bench-json"};
+  auto [appoption, climode] = mmmcli::CliApp::OptionParser()(args.size(), args.data());
+  EXPECT_EQ(climode, mmmcli::CliAppMode::Run);
+  EXPECT_EQ(appoption.input.value().filepath, "test_tuple.mmm");
+  EXPECT_EQ(appoption.runtime_option.bench_seconds, 2.5);
+  EXPECT_EQ(appoption.runtime_option.bench_samplerate, 44100);
+  EXPECT_EQ(appoption.runtime_option.bench_framesize, 64);
+  EXPECT_TRUE(appoption.runtime_option.bench_json);
+  std::vector<const char*> invalid = {"/usr/local/mimium", "test_tuple.mmm", "--bench", "0"};
+  EXPECT_THROW(mmmcli::CliApp::OptionParser()(invalid.size(), invalid.data()),  // NOLINT
+               mimium::CliAppError);
+}
+
+TEST(cli, jit_threads) {  // NOLINT
+  std::vector<const char*> args = {"/usr/local/mimium", "test_tuple.mmm", "--jit-threads", "4"};
+  auto [appoption, climode] = mmmcli::CliApp::OptionParser()(args.size(), args.data());
+  EXPECT_EQ(appoption.runtime_option.jit_threads, 4);
+  for (const auto* val : {"-1", "65", "many"}) {
+    std::vector<const char*> invalid = {"/usr/local/mimium", "test_tuple.mmm", "--jit-threads",
+                                        val};
+    EXPECT_THROW(mmmcli::CliApp::OptionParser()(invalid.size(), invalid.data()),  // NOLINT
+                 mimium::CliAppError);
+  }
+}
+
+TEST(cli, bench_report_json) {  // NOLINT
+  mimium::app::BenchReport report;
+  report.source = "dir/\"a\\b\"\n\t\x01.mmm";
+  report.samplerate = 48000;
+  report.framesize = 256;
+  report.frames = 96000;
+  report.compile_seconds = 0.0125;
+  report.jit_seconds = 0.002;
+  report.process_seconds = 0.5;
+  report.memobj_bytes = 1024;
+  std::ostringstream ss;
+  mimium::app::printBenchReport(ss, report, true);
+  // one object in a line, in which control characters of the source are escaped.
+  EXPECT_EQ(ss.str(),
+            "{\"source\": \"dir/\\\"a\\\\b\\\"\\u000a\\u0009\\u0001.mmm\", "
+            "\"samplerate\": 48000.000, \"framesize\": 256, \"frames\": 96000, "
+            "\"compile_ms\": 12.500, \"jit_ms\": 2.000, \"process_ms\": 500.000, "
+            "\"ns_per_sample\": 5208.333, \"realtime_factor\": 4.000, "
+            "\"memobj_bytes\": 1024}\n");
+  // the flags of the stream are restored.
+  ss.str("");
+  ss << 0.5;
+  EXPECT_EQ(ss.str(), "0.5");
+}
@@ -0,0 +1,109 @@
+#include <sstream>
+#include "basic/error_def.hpp"
+#include "basic/mir.hpp"
+#include "compiler/ast_loader.hpp"
+#include "compiler/closure_convert.hpp"
+#include "compiler/collect_memoryobjs.hpp"
+#include "compiler/mir_serializer.hpp"
+#include "compiler/mirgenerator.hpp"
+#include "compiler/scanner.hpp"
+#include "compiler/symbolrenamer.hpp"
+#include "compiler/type_infer_visitor.hpp"
+#include "gtest/gtest.h"
+#include "mimium_parser.hpp"
+
+#define PREP(FILENAME)                                                          \
+  Driver driver{};                                                              \
+  ast::Statements& ast = *driver.parseFile(TEST_ROOT_DIR "/" #FILENAME ".mmm"); \
+  SymbolRenamer renamer;                                                        \
+  auto newast = renamer.rename(ast);                                            \
+  TypeInferer inferer;                                                          \
+  auto& env = inferer.infer(*newast);                                           \
+  MirGenerator mirgenerator(env);                                               \
+  auto mir = mirgenerator.generate(*newast);                                    \
+  ClosureConverter closureconverter(env);                                       \
+  auto mir_cc = closureconverter.convert(mir);                                  \
+  MemoryObjsCollector collector;                                                \
+  auto funobjs = collector.process(mir_cc);
+
+namespace mimium {
+
+MirBinary roundTrip(MirBinary const& src) {
+  std::stringstream ss;
+  writeMirBinary(ss, src);
+  return readMirBinary(ss, src.float32);
+}
+
+TEST(mirserialize, closure) {  // NOLINT
+  PREP(test_closure)
+  auto res = roundTrip({mir_cc, funobjs});
+  EXPECT_EQ(mir::toString(res.toplevel), mir::toString(mir_cc));
+  EXPECT_EQ(res.funobjs.size(), funobjs.size());
+}
+
+TEST(mirserialize, memobjs) {  // NOLINT
+  PREP(test_delay)
+  auto res = roundTrip({mir_cc, funobjs});
+  EXPECT_EQ(mir::toString(res.toplevel), mir::toString(mir_cc));
+  ASSERT_EQ(res.funobjs.size(), funobjs.size());
+  std::unordered_map<std::string, std::string> objtypes;
+  for (auto& [fn, tree] : funobjs) {
+    objtypes.emplace(mir::getName(*fn), types::toString(tree->objtype, true));
+  }
+  for (auto& [fn, tree] : res.funobjs) {
+    // keys must be the deserialized instructions themselves, not copies of them
+    EXPECT_EQ(fn, tree->fname);
+    EXPECT_EQ(types::toString(tree->objtype, true), objtypes.at(mir::getName(*fn)));
+  }
+}
+
+TEST(mirserialize, invalid) {  // NOLINT
+  std::stringstream ss("NOTMIR");
+  EXPECT_THROW(readMirBinary(ss, false), CompileError);  // NOLINT
+}
+
+TEST(mirserialize, precision) {  // NOLINT
+  PREP(test_delay)
+  EXPECT_TRUE(roundTrip({mir_cc, funobjs, true}).float32);
+  std::stringstream ss;
+  writeMirBinary(ss, {mir_cc, funobjs, true});
+  EXPECT_THROW(readMirBinary(ss, false), CompileError);  // NOLINT
+}
+
+// an alias type whose name claims more bytes than the file has.
+TEST(mirserialize, invalid_string_size) {  // NOLINT
+  auto makeBinary = [](uint64_t size) {
+    std::string res(mir_binary_magic);
+    res += static_cast<char>(mir_binary_version);
+    res += '\x00';  // double precision
+    res += '\x01';  // size of type table
+    res += '\x0c';  // alias
+    for (; size >= 0x80; size >>= 7U) { res += static_cast<char>((size & 0x7fU) | 0x80U); }
+    res += static_cast<char>(size);
+    return res;
+  };
+  for (uint64_t size : {1ULL << 31U, 1ULL << 40U}) {
+    std::stringstream ss(makeBinary(size));
+    EXPECT_THROW(readMirBinary(ss, false), CompileError);  // NOLINT
+  }
+}
+
+// counts of the tables are checked against the rest of the file before they are allocated.
+TEST(mirserialize, invalid_count) {  // NOLINT
+  using namespace std::string_literals;  // NOLINT
+  auto makeBinary = [](std::string const& counts) {
+    std::string res(mir_binary_magic);
+    res += static_cast<char>(mir_binary_version);
+    res += '\x00';  // double precision
+    return res + counts;
+  };
+  // 2^31 types, then empty type table with 2^31 values.
+  for (const auto& counts : {"\x80\x80\x80\x80\x08"s, "\x00\x80\x80\x80\x80\x08"s}) {
+    std::stringstream ss(makeBinary(counts));
+    EXPECT_THROW(readMirBinary(ss, false), CompileError);  // NOLINT
+  }
+  // a tuple type claiming a list of 2^31 types.
+  std::stringstream ss(makeBinary("\x01\x0b\x80\x80\x80\x80\x08"s));
+  EXPECT_THROW(readMirBinary(ss, false), CompileError);  // NOLINT
+}
+}  // namespace mimium
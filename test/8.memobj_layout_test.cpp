@@ -0,0 +1,166 @@
+#include <sstream>
+#include "basic/mir.hpp"
+#include "compiler/ast_loader.hpp"
+#include "compiler/closure_convert.hpp"
+#include "compiler/collect_memoryobjs.hpp"
+#include "compiler/memobj_layout.hpp"
+#include "compiler/mirgenerator.hpp"
+#include "compiler/scanner.hpp"
+#include "compiler/symbolrenamer.hpp"
+#include "compiler/type_infer_visitor.hpp"
+#include "gtest/gtest.h"
+#include "mimium_parser.hpp"
+
+#define PREP(FILENAME) PREP_WITH_FLOAT_SIZE(FILENAME, sizeof(double))
+
+#define PREP_WITH_FLOAT_SIZE(FILENAME, FLOAT_SIZE)                              \
+  Driver driver{};                                                              \
+  ast::Statements& ast = *driver.parseFile(TEST_ROOT_DIR "/" #FILENAME ".mmm"); \
+  SymbolRenamer renamer;                                                        \
+  auto newast = renamer.rename(ast);                                            \
+  TypeInferer inferer;                                                          \
+  auto& env = inferer.infer(*newast);                                           \
+  MirGenerator mirgenerator(env);                                               \
+  auto mir = mirgenerator.generate(*newast);                                    \
+  ClosureConverter closureconverter(env);                                       \
+  auto mir_cc = closureconverter.convert(mir);                                  \
+  MemoryObjsCollector collector;                                                \
+  collector.setFloatSize(FLOAT_SIZE);                                           \
+  auto funobjs = collector.process(mir_cc);
+
+namespace mimium {
+
+std::shared_ptr<FunObjTree> findTree(funobjmap const& funobjs, std::string const& name) {
+  for (auto& [fn, tree] : funobjs) {
+    if (mir::isInstA<minst::Function>(fn) && mir::getName(*fn) == name) { return tree; }
+  }
+  return nullptr;
+}
+
+TEST(memobjlayout, self_first_buffer_aligned) {  // NOLINT
+  PREP(test_delay)
+  auto tree = findTree(funobjs, "fbdelay");
+  ASSERT_NE(tree, nullptr);
+  ASSERT_TRUE(tree->hasself);
+  EXPECT_EQ(tree->self_field, 0);
+  ASSERT_EQ(tree->memobj_fields.size(), 1);
+  auto& fields = MemoryObjsCollector::CollectMemVisitor::getTupleFromAlias(tree->objtype).arg_types;
+  auto offsets = getMemobjFieldOffsets(fields);
+  EXPECT_EQ(offsets[tree->memobj_fields[0]] % memobj_cacheline_size, 0);
+  EXPECT_EQ(getMemobjByteSize(fields[tree->memobj_fields[0]]),
+            getMemobjByteSize(types::getDelayStruct()));
+}
+
+TEST(memobjlayout, float_size) {  // NOLINT
+  PREP_WITH_FLOAT_SIZE(test_delay, sizeof(float))
+  auto tree = findTree(funobjs, "fbdelay");
+  ASSERT_NE(tree, nullptr);
+  EXPECT_EQ(tree->self_field, 0);
+  auto& fields = MemoryObjsCollector::CollectMemVisitor::getTupleFromAlias(tree->objtype).arg_types;
+  // self, padding to the cache line and the delay.
+  ASSERT_EQ(fields.size(), 3);
+  auto offsets = getMemobjFieldOffsets(fields, sizeof(float));
+  EXPECT_EQ(offsets[1], sizeof(float));
+  EXPECT_EQ(offsets[2], memobj_cacheline_size);
+  EXPECT_EQ(getMemobjByteSize(fields[2], sizeof(float)),
+            getMemobjByteSize(types::getDelayStruct()) / 2);
+  std::ostringstream ss;
+  dumpMemobjLayout(ss, funobjs, sizeof(float));
+  const auto size = memobj_cacheline_size + getMemobjByteSize(fields[2], sizeof(float));
+  EXPECT_NE(ss.str().find("fbdelay: " + std::to_string(size) + " bytes"), std::string::npos);
+}
+
+TEST(memobjlayout, aligned_fields) {  // NOLINT
+  // a pointer after a single precision Float is aligned to 8 bytes as in llvm structs.
+  std::vector<types::Value> fields{types::Float{}, types::Pointer{types::Float{}}, types::Float{}};
+  EXPECT_EQ(getMemobjFieldOffsets(fields, sizeof(float)), (std::vector<size_t>{0, 8, 16}));
+  EXPECT_EQ(getMemobjByteSize(types::Tuple{fields}, sizeof(float)), 24);
+  EXPECT_EQ(getMemobjFieldOffsets(fields), (std::vector<size_t>{0, 8, 16}));
+  EXPECT_EQ(getMemobjByteSize(types::Array{types::Float{}, 3}, sizeof(float)), 12);
+}
+
+TEST(memobjlayout, nested_buffer_last) {  // NOLINT
+  PREP(test_delay)
+  auto tree = findTree(funobjs, "dsp");
+  ASSERT_NE(tree, nullptr);
+  auto& fields = MemoryObjsCollector::CollectMemVisitor::getTupleFromAlias(tree->objtype).arg_types;
+  // seek only holds self, so it comes before fbdelay_mix which contains a delay.
+  auto iter = tree->memobjs.begin();
+  std::unordered_map<std::string, int> indices;
+  for (auto index : tree->memobj_fields) {
+    indices.emplace(mir::getName(*(*iter++)->fname), index);
+  }
+  EXPECT_LT(indices.at("seek"), indices.at("fbdelay_mix"));
+  EXPECT_EQ(indices.at("seek"), 0);
+  EXPECT_EQ(static_cast<size_t>(indices.at("fbdelay_mix")), fields.size() - 1);
+}
+
+TEST(memobjlayout, random_state_only_in_dsp) {  // NOLINT
+  PREP(test_random)
+  auto dsp = findTree(funobjs, "dsp");
+  ASSERT_NE(dsp, nullptr);
+  EXPECT_TRUE(dsp->random_has_state);
+  // a call of noise and a call of random.
+  EXPECT_EQ(dsp->memobjs.size(), 2);
+  auto noise = findTree(funobjs, "noise");
+  ASSERT_NE(noise, nullptr);
+  EXPECT_TRUE(noise->random_has_state);
+  EXPECT_EQ(noise->memobjs.size(), 1);
+  // the event loop called from main uses the shared state.
+  EXPECT_EQ(findTree(funobjs, "loop"), nullptr);
+}
+
+TEST(memobjlayout, random_state_in_spectral) {  // NOLINT
+  PREP(test_spectral)
+  // spectral is dsp-like, so random in it has a state in its memory object.
+  auto spectral = findTree(funobjs, "spectral");
+  ASSERT_NE(spectral, nullptr);
+  EXPECT_TRUE(spectral->random_has_state);
+  EXPECT_EQ(spectral->memobjs.size(), 1);
+  auto dsp = findTree(funobjs, "dsp");
+  ASSERT_NE(dsp, nullptr);
+  EXPECT_EQ(dsp->memobjs.size(), 1);
+}
+
+TEST(memobjlayout, filter_banks) {  // NOLINT
+  PREP(test_filterbank)
+  auto dsp = findTree(funobjs, "dsp");
+  ASSERT_NE(dsp, nullptr);
+  auto& fields = MemoryObjsCollector::CollectMemVisitor::getTupleFromAlias(dsp->objtype).arg_types;
+  std::unordered_map<std::string, std::vector<std::pair<int, int>>> placed;
+  auto iter = dsp->memobjs.begin();
+  for (size_t i = 0; i < dsp->memobjs.size(); i++) {
+    placed[mir::getName(*(*iter++)->fname)].emplace_back(dsp->memobj_fields[i],
+                                                          dsp->memobj_lanes[i]);
+  }
+  // biquads called in dsp share a bank of 2 lanes, while the one in peak has its own field.
+  auto& biquads = placed.at("biquad");
+  ASSERT_EQ(biquads.size(), 2);
+  EXPECT_EQ(biquads[0].first, biquads[1].first);
+  EXPECT_EQ(biquads[0].second, 0);
+  EXPECT_EQ(biquads[1].second, 1);
+  EXPECT_EQ(getMemobjByteSize(fields[biquads[0].first]), 2 * 2 * 8);
+  // svf_lp and svf_hp have the same states.
+  EXPECT_EQ(placed.at("svf_lp")[0].first, placed.at("svf_hp")[0].first);
+  EXPECT_EQ(placed.at("onepole")[0].second, -1);
+  auto peak = findTree(funobjs, "peak");
+  ASSERT_NE(peak, nullptr);
+  EXPECT_EQ(peak->memobj_lanes, std::vector<int>{-1});
+
+  std::ostringstream ss;
+  dumpMemobjLayout(ss, funobjs);
+  EXPECT_NE(ss.str().find("biquad x2"), std::string::npos);
+  EXPECT_NE(ss.str().find("svf_hp x2"), std::string::npos);
+}
+
+TEST(memobjlayout, report) {  // NOLINT
+  PREP(test_delay)
+  std::ostringstream ss;
+  dumpMemobjLayout(ss, funobjs);
+  auto report = ss.str();
+  EXPECT_NE(report.find("fbdelay: "), std::string::npos);
+  EXPECT_NE(report.find("self"), std::string::npos);
+  EXPECT_NE(report.find("(padding)"), std::string::npos);
+}
+
+}  // namespace mimium
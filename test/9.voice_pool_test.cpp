@@ -0,0 +1,86 @@
+#include "runtime/voice_pool.hpp"
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace mimium {
+namespace {
+// outputs gate*freq while counting processed frames in its memory object.
+void testVoiceFn(double* out, const double* in, void* /*cls*/, void* mem) {
+  auto* count = static_cast<double*>(mem);
+  *count += 1;
+  out[0] = in[0] * in[1];
+}
+VoiceFnInfos makeInfo() { return VoiceFnInfos{testVoiceFn, nullptr, sizeof(double), 3, 1}; }
+// keeps sounding after note-off, like a long release tail.
+void sustainVoiceFn(double* out, const double* in, void* /*cls*/, void* /*mem*/) {
+  out[0] = in[1];
+}
+}  // namespace
+
+TEST(voicepool, sample_accurate_onset) {  // NOLINT
+  VoicePool pool(makeInfo(), 4);
+  std::vector<double> out(8, 0.0);
+  pool.beginBlock(100);
+  const double params[] = {2.0, 1.0};
+  auto voice = pool.noteOn(103, params, 2);
+  EXPECT_EQ(voice, 0);
+  pool.process(out.data(), 1, 8);
+  EXPECT_EQ(out, (std::vector<double>{0, 0, 0, 2, 2, 2, 2, 2}));
+  EXPECT_EQ(pool.getNumActiveVoices(), 1);
+}
+
+TEST(voicepool, steal_oldest) {  // NOLINT
+  VoicePool pool(makeInfo(), 2);
+  std::vector<double> out(4, 0.0);
+  pool.beginBlock(0);
+  const double params[] = {1.0, 1.0};
+  EXPECT_EQ(pool.noteOn(0, params, 2), 0);
+  EXPECT_EQ(pool.noteOn(1, params, 2), 1);
+  EXPECT_EQ(pool.noteOn(2, params, 2), 0);
+  pool.noteOff(3, 1);
+  // releasing voice is stolen before the active one
+  EXPECT_EQ(pool.noteOn(3, params, 2), 1);
+  pool.process(out.data(), 1, 4);
+  EXPECT_EQ(pool.getNumActiveVoices(), 2);
+}
+
+TEST(voicepool, release_to_idle) {  // NOLINT
+  VoicePool pool(makeInfo(), 2);
+  std::vector<double> out(4, 0.0);
+  pool.beginBlock(0);
+  const double params[] = {1.0, 1.0};
+  auto voice = pool.noteOn(0, params, 2);
+  pool.process(out.data(), 1, 4);
+  pool.noteOff(4, voice);
+  std::fill(out.begin(), out.end(), 0.0);
+  pool.process(out.data(), 1, 4);
+  EXPECT_EQ(out, (std::vector<double>{0, 0, 0, 0}));
+  // freed after a silent block without events
+  std::fill(out.begin(), out.end(), 0.0);
+  pool.process(out.data(), 1, 4);
+  EXPECT_EQ(pool.getNumActiveVoices(), 0);
+}
+
+TEST(voicepool, release_by_samplerate) {  // NOLINT
+  // 1ms of release is 8 frames at 8kHz, and 48 frames before the sample rate is set.
+  VoicePool pool(VoiceFnInfos{sustainVoiceFn, nullptr, sizeof(double), 2, 1}, 1, 0.001);
+  EXPECT_EQ(pool.getMaxReleaseFrames(), 48);
+  pool.setSampleRate(96000.0);
+  EXPECT_EQ(pool.getMaxReleaseFrames(), 96);
+  pool.setSampleRate(8000.0);
+  std::vector<double> out(4, 0.0);
+  const double params[] = {1.0};
+  pool.beginBlock(0);
+  auto voice = pool.noteOn(0, params, 1);
+  pool.process(out.data(), 1, 4);
+  pool.beginBlock(4);
+  pool.noteOff(4, voice);
+  pool.process(out.data(), 1, 4);
+  EXPECT_EQ(pool.getNumActiveVoices(), 1);
+  // the tail is cut at the end of the block reaching 8 frames of release.
+  pool.beginBlock(8);
+  pool.process(out.data(), 1, 4);
+  EXPECT_EQ(pool.getNumActiveVoices(), 0);
+}
+
+}  // namespace mimium
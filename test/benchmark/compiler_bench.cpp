@@ -0,0 +1,180 @@
+#include <cmath>
+#include <string>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "compiler/codegen/llvm_header.hpp"
+#include "compiler/compiler.hpp"
+#include "runtime/JIT/runtime_jit.hpp"
+#include "runtime/backend/api/driver_api.hpp"
+
+namespace mimium {
+namespace {
+enum class Stage {
+  Parse = 0,
+  SymbolRename,
+  TypeInfer,
+  MirGen,
+  ClosureConvert,
+  MemobjCollect,
+  Codegen,
+  Jit
+};
+
+// stateful functions called from dsp, each of which has its own memory object. The sum is split
+// into local variables so that the depth of the AST does not grow with the size.
+std::string makeSource(int64_t nfuns) {
+  std::string src;
+  for (int64_t i = 0; i < nfuns; i++) {
+    src += "fn osc" + std::to_string(i) + "(freq)->float{\n  return (freq*0.0001+self)%1\n}\n";
+  }
+  src += "fn dsp(){\n  s0 = osc0(440.0)\n";
+  for (int64_t i = 1; i < nfuns; i++) {
+    const auto idx = std::to_string(i);
+    src += "  s" + idx + " = s" + std::to_string(i - 1) + "+osc" + idx + "(" + idx + ".0)\n";
+  }
+  src += "  return s" + std::to_string(nfuns - 1) + "*0.001\n}\n";
+  return src;
+}
+
+// biquads called in dsp, whose states share a bank, or called through their own functions, whose
+// states are in separate memory objects.
+std::string makeFilterSource(int64_t nfilters, bool banked) {
+  std::string src;
+  auto call = [](int64_t i) {
+    const auto b0 = std::to_string(0.1 + 0.01 * static_cast<double>(i));
+    return "biquad(x," + b0 + ",0.1,0.05,-0.4,0.1)";
+  };
+  for (int64_t i = 0; !banked && i < nfilters; i++) {
+    src += "fn bq" + std::to_string(i) + "(x){\n  return " + call(i) + "\n}\n";
+  }
+  auto callAt = [&](int64_t i) { return banked ? call(i) : "bq" + std::to_string(i) + "(x)"; };
+  src += "fn dsp(x:float)->float{\n  s0 = " + callAt(0) + "\n";
+  for (int64_t i = 1; i < nfilters; i++) {
+    const auto idx = std::to_string(i);
+    src += "  s" + idx + " = s" + std::to_string(i - 1) + "+" + callAt(i) + "\n";
+  }
+  src += "  return s" + std::to_string(nfilters - 1) + "*0.1\n}\n";
+  return src;
+}
+
+// results of the stages so far, kept by the compiler which made them.
+struct Pipeline {
+  std::unique_ptr<Compiler> compiler = std::make_unique<Compiler>();
+  AstPtr ast;
+  AstPtr ast_u;
+  mir::blockptr mir;
+  mir::blockptr mir_cc;
+  funobjmap funobjs;
+  std::unique_ptr<Runtime_LLVM> runtime;
+};
+
+void runStage(Pipeline& p, Stage stage, std::string const& src) {
+  switch (stage) {
+    case Stage::Parse: p.ast = p.compiler->loadSource(src); break;
+    case Stage::SymbolRename: p.ast_u = p.compiler->renameSymbols(p.ast); break;
+    case Stage::TypeInfer: p.compiler->typeInfer(p.ast_u); break;
+    case Stage::MirGen: p.mir = p.compiler->generateMir(p.ast_u); break;
+    case Stage::ClosureConvert:
+      p.mir_cc = p.compiler->closureConvert(
+          p.compiler->hoistControlRate(p.compiler->expandMultirate(p.mir)));
+      break;
+    case Stage::MemobjCollect: p.funobjs = p.compiler->collectMemoryObjs(p.mir_cc); break;
+    case Stage::Codegen: p.compiler->generateLLVMIr(p.mir_cc, p.funobjs); break;
+    case Stage::Jit:
+      p.runtime = std::make_unique<Runtime_LLVM>(
+          p.compiler->moveLLVMCtx(), p.compiler->moveLLVMModule(), "bench.mmm",
+          std::make_unique<AudioDriverAPI>(48000.0, 256));
+      p.runtime->runMainFun();
+      break;
+  }
+}
+
+// measures a stage, running the stages before it without timing in each iteration, as the
+// passes modify their input.
+void runStageBench(benchmark::State& state, Stage stage) {
+  const auto src = makeSource(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto p = std::make_unique<Pipeline>();
+    p->compiler->setFilePath("bench.mmm");
+    for (int s = 0; s < static_cast<int>(stage); s++) {
+      runStage(*p, static_cast<Stage>(s), src);
+    }
+    state.ResumeTiming();
+    runStage(*p, stage, src);
+    state.PauseTiming();
+    p.reset();
+    state.ResumeTiming();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// measures rendering blocks of the dsp of the filters, compiled in double or single precision.
+void runFilterBench(benchmark::State& state, bool banked, bool isfloat32 = false) {
+  constexpr int framesize = 256;
+  Pipeline p;
+  p.compiler->setFilePath("bench.mmm");
+  p.compiler->setFloat32(isfloat32);
+  const auto src = makeFilterSource(state.range(0), banked);
+  for (int s = 0; s <= static_cast<int>(Stage::Jit); s++) {
+    runStage(p, static_cast<Stage>(s), src);
+  }
+  auto& driver = static_cast<AudioDriverAPI&>(p.runtime->getAudioDriver());
+  driver.setup(driver.getDefaultAudioParameter(std::nullopt, std::nullopt));
+  driver.start();
+  std::vector<double> input(framesize);
+  for (int i = 0; i < framesize; i++) { input[i] = std::sin(0.37 * i); }
+  std::vector<double> output(framesize);
+  for (auto _ : state) {
+    driver.process(input.data(), output.data(), framesize);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(state.iterations() * framesize * state.range(0));
+}
+}  // namespace
+
+static void BM_Parse(benchmark::State& state) { runStageBench(state, Stage::Parse); }
+static void BM_SymbolRename(benchmark::State& state) {
+  runStageBench(state, Stage::SymbolRename);
+}
+static void BM_TypeInfer(benchmark::State& state) { runStageBench(state, Stage::TypeInfer); }
+static void BM_MirGen(benchmark::State& state) { runStageBench(state, Stage::MirGen); }
+static void BM_ClosureConvert(benchmark::State& state) {
+  runStageBench(state, Stage::ClosureConvert);
+}
+static void BM_MemobjCollect(benchmark::State& state) {
+  runStageBench(state, Stage::MemobjCollect);
+}
+static void BM_Codegen(benchmark::State& state) { runStageBench(state, Stage::Codegen); }
+static void BM_Jit(benchmark::State& state) { runStageBench(state, Stage::Jit); }
+
+// small, medium and synthetic huge programs.
+#define MIMIUM_STAGE_BENCHMARK(fn) \
+  BENCHMARK(fn)->Arg(4)->Arg(64)->Arg(4096)->Complexity()->Unit(benchmark::kMillisecond)
+
+MIMIUM_STAGE_BENCHMARK(BM_Parse);
+MIMIUM_STAGE_BENCHMARK(BM_SymbolRename);
+MIMIUM_STAGE_BENCHMARK(BM_TypeInfer);
+MIMIUM_STAGE_BENCHMARK(BM_MirGen);
+MIMIUM_STAGE_BENCHMARK(BM_ClosureConvert);
+MIMIUM_STAGE_BENCHMARK(BM_MemobjCollect);
+MIMIUM_STAGE_BENCHMARK(BM_Codegen);
+// JIT of the huge program takes seconds for each iteration, so it stops at 512 functions.
+BENCHMARK(BM_Jit)->Arg(4)->Arg(64)->Arg(512)->Complexity()->Unit(benchmark::kMillisecond);
+
+// biquads sharing a bank, which the SLP vectorizer can process together, against the same number
+// of biquads with their own memory objects.
+static void BM_FilterBank(benchmark::State& state) { runFilterBench(state, true); }
+static void BM_SeparateFilters(benchmark::State& state) { runFilterBench(state, false); }
+BENCHMARK(BM_FilterBank)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK(BM_SeparateFilters)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+
+// the same filters with `--precision float`, to compare the throughput with the ones above.
+static void BM_FilterBankFloat32(benchmark::State& state) { runFilterBench(state, true, true); }
+static void BM_SeparateFiltersFloat32(benchmark::State& state) {
+  runFilterBench(state, false, true);
+}
+BENCHMARK(BM_FilterBankFloat32)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK(BM_SeparateFiltersFloat32)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+
+}  // namespace mimium
@@ -0,0 +1,56 @@
+#include <sstream>
+#include <string>
+#include "benchmark/benchmark.h"
+#include "compiler/ast_loader.hpp"
+#include "compiler/scanner.hpp"
+#include "mimium_parser.hpp"
+
+namespace mimium {
+namespace {
+// synthetic score-like source, roughly the given size in bytes.
+std::string makeSyntheticSource(int64_t bytes) {
+  std::string src;
+  src.reserve(bytes + 256);
+  for (int64_t i = 0; static_cast<int64_t>(src.size()) < bytes; i++) {
+    auto idx = std::to_string(i);
+    src += "// voice " + idx + "\n";
+    src += "fn osc" + idx + "(freq){\n  return sin(now*freq*0.0001+" + idx + ".0)*0.5\n}\n";
+    src += "amp" + idx + " = osc" + idx + "(440.0)*0.5\n";
+  }
+  return src;
+}
+
+void setThroughput(benchmark::State& state, std::string const& src) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(src.size()));
+}
+}  // namespace
+
+static void BM_ParseStream(benchmark::State& state) {
+  auto src = makeSyntheticSource(state.range(0));
+  for (auto _ : state) {
+    Driver driver{};
+    std::istringstream is(src);
+    benchmark::DoNotOptimize(driver.parse(is));
+  }
+  setThroughput(state, src);
+}
+static void BM_ParseBuffer(benchmark::State& state) {
+  auto src = makeSyntheticSource(state.range(0));
+  for (auto _ : state) {
+    Driver driver{};
+    benchmark::DoNotOptimize(driver.parseBuffer(src));
+  }
+  setThroughput(state, src);
+}
+
+BENCHMARK(BM_ParseStream)
+    ->RangeMultiplier(8)
+    ->Range(1 << 16, 1 << 25)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParseBuffer)
+    ->RangeMultiplier(8)
+    ->Range(1 << 16, 1 << 25)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace mimium
@@ -0,0 +1,97 @@
+#include <random>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "runtime/backend/api/driver_api.hpp"
+
+namespace mimium {
+namespace {
+double task_sum = 0;
+void stubTask(double arg) { task_sum += arg; }
+
+// stereo output of a stateful function of the mono input, as small as a compiled dsp can be.
+void stubDsp(double* out, const double* in, void* /*cls*/, void* memobj) {
+  auto* state = static_cast<double*>(memobj);
+  *state = *state * 0.99 + in[0] * 0.01;
+  out[0] = *state;
+  out[1] = -*state;
+}
+
+std::vector<double> makeRandomTimes(int64_t num) {
+  std::mt19937_64 engine(0);
+  std::uniform_int_distribution<int64_t> dist(0, num);
+  std::vector<double> res(num);
+  for (auto& t : res) { t = static_cast<double>(dist(engine)); }
+  return res;
+}
+
+std::unique_ptr<AudioDriverAPI> makeDriver(int framesize, double* memobj) {
+  auto driver = std::make_unique<AudioDriverAPI>(48000.0, framesize);
+  driver->setDspFnInfos(std::make_unique<DspFnInfos>(
+      DspFnInfos{stubDsp, nullptr, static_cast<void*>(memobj), 1, 2}));
+  driver->setup(driver->getDefaultAudioParameter(std::nullopt, std::nullopt));
+  driver->start();
+  return driver;
+}
+}  // namespace
+
+static void BM_SchedulerInsert(benchmark::State& state) {
+  const auto times = makeRandomTimes(state.range(0));
+  for (auto _ : state) {
+    Scheduler sch;
+    for (double t : times) { sch.addTask(t, reinterpret_cast<void*>(stubTask), t, nullptr); }
+    benchmark::DoNotOptimize(sch.hasTask());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+  state.SetComplexityN(state.range(0));
+}
+
+// tasks expire one per sample in order of time.
+static void BM_SchedulerExpiry(benchmark::State& state) {
+  const auto times = makeRandomTimes(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    Scheduler sch;
+    sch.start(true);
+    for (double t : times) { sch.addTask(t, reinterpret_cast<void*>(stubTask), t, nullptr); }
+    state.ResumeTiming();
+    while (sch.hasTask()) { sch.incrementTime(); }
+  }
+  benchmark::DoNotOptimize(task_sum);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+  state.SetComplexityN(state.range(0));
+}
+
+static void BM_AudioDriverProcessInterleaved(benchmark::State& state) {
+  const auto framesize = static_cast<int>(state.range(0));
+  double memobj = 0;
+  auto driver = makeDriver(framesize, &memobj);
+  std::vector<double> input(framesize, 0.5);
+  std::vector<double> output(framesize * 2);
+  for (auto _ : state) {
+    driver->process(input.data(), output.data(), framesize);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * framesize);
+}
+
+static void BM_AudioDriverProcessPlanar(benchmark::State& state) {
+  const auto framesize = static_cast<int>(state.range(0));
+  double memobj = 0;
+  auto driver = makeDriver(framesize, &memobj);
+  std::vector<float> input(framesize, 0.5F);
+  std::vector<std::vector<float>> output(2, std::vector<float>(framesize));
+  const float* inptrs[] = {input.data()};
+  float* outptrs[] = {output[0].data(), output[1].data()};
+  for (auto _ : state) {
+    driver->processPlanar(inptrs, outptrs, framesize);
+    benchmark::DoNotOptimize(output[0].data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * framesize);
+}
+
+BENCHMARK(BM_SchedulerInsert)->RangeMultiplier(8)->Range(1 << 6, 1 << 18)->Complexity();
+BENCHMARK(BM_SchedulerExpiry)->RangeMultiplier(8)->Range(1 << 6, 1 << 18)->Complexity();
+BENCHMARK(BM_AudioDriverProcessInterleaved)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK(BM_AudioDriverProcessPlanar)->RangeMultiplier(4)->Range(64, 4096);
+
+}  // namespace mimium
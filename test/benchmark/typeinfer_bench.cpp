@@ -0,0 +1,45 @@
+#include <string>
+#include "benchmark/benchmark.h"
+#include "compiler/ast_loader.hpp"
+#include "compiler/scanner.hpp"
+#include "compiler/symbolrenamer.hpp"
+#include "compiler/type_infer_visitor.hpp"
+#include "mimium_parser.hpp"
+
+namespace mimium {
+namespace {
+// synthetic program with a long call chain. if passthrough is true, types of all the functions
+// stay unresolved until the last call, which makes long chain of type variables.
+std::string makeSyntheticProgram(int64_t nfuns, bool passthrough) {
+  std::string src = passthrough ? "fn f0(x){\n return x\n}\n" : "fn f0(x){\n return x+1\n}\n";
+  for (int64_t i = 1; i < nfuns; i++) {
+    auto name = "f" + std::to_string(i);
+    auto prev = "f" + std::to_string(i - 1);
+    src += "fn " + name + "(x){\n return " + prev + (passthrough ? "(x)" : "(x)*x") + "\n}\n";
+  }
+  src += "main = f" + std::to_string(nfuns - 1) + "(1)\n";
+  return src;
+}
+
+void runTypeInference(benchmark::State& state, bool passthrough) {
+  Driver driver{};
+  auto ast = driver.parseString(makeSyntheticProgram(state.range(0), passthrough));
+  SymbolRenamer renamer;
+  auto newast = renamer.rename(*ast);
+  for (auto _ : state) {
+    TypeInferer inferer;
+    benchmark::DoNotOptimize(&inferer.infer(*newast));
+  }
+  state.SetComplexityN(state.range(0));
+}
+}  // namespace
+
+static void BM_TypeInference(benchmark::State& state) { runTypeInference(state, false); }
+static void BM_TypeInferenceTypeVarChain(benchmark::State& state) {
+  runTypeInference(state, true);
+}
+
+BENCHMARK(BM_TypeInference)->RangeMultiplier(4)->Range(1 << 10, 1 << 14)->Complexity();
+BENCHMARK(BM_TypeInferenceTypeVarChain)->RangeMultiplier(4)->Range(1 << 10, 1 << 14)->Complexity();
+
+}  // namespace mimium
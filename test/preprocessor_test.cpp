@@ -16,4 +16,46 @@ TEST(preprocessor, include) {//NOLINT
   auto target = preprocessor.process(includer);
   auto answer = preprocessor.process(answerpath);
   EXPECT_TRUE(target.source==answer.source);
-}
\ No newline at end of file
+}
+TEST(preprocessor, include_once) {  // NOLINT
+  fs::path pptest_path = fs::path(TEST_ROOT_DIR) / "preprocessor";
+  mimium::Preprocessor preprocessor(pptest_path);
+  auto target = preprocessor.process(pptest_path / "include_twice.mmm");
+  auto answer = preprocessor.process(pptest_path / "include_answer.mmm");
+  EXPECT_EQ(target.source, answer.source);
+}
+
+TEST(preprocessor, include_directive) {  // NOLINT
+  using mimium::Preprocessor;
+  EXPECT_EQ(Preprocessor::parseIncludeLine("include \"a.mmm\"").value(), "a.mmm");
+  EXPECT_EQ(Preprocessor::parseIncludeLine("  include(\"a.mmm\") \r").value(), "a.mmm");
+  EXPECT_FALSE(Preprocessor::parseIncludeLine("included = 1").has_value());
+  EXPECT_FALSE(Preprocessor::parseIncludeLine("include(\"a.mmm\"").has_value());
+}
+
+TEST(preprocessor, sourcemap) {  // NOLINT
+  fs::path pptest_path = fs::path(TEST_ROOT_DIR) / "preprocessor";
+  mimium::Preprocessor preprocessor(pptest_path);
+  auto target = preprocessor.process(pptest_path / "includer.mmm");
+  ASSERT_TRUE(target.sourcemap != nullptr);
+  EXPECT_EQ(target.sourcemap->size(), 7);
+  auto first = target.sourcemap->resolve(1).value();
+  EXPECT_EQ(first.filepath.filename(), "includee.mmm");
+  EXPECT_EQ(first.line, 1);
+  auto expect_line = target.sourcemap->resolve(6).value();
+  EXPECT_EQ(expect_line.filepath.filename(), "includer.mmm");
+  EXPECT_EQ(expect_line.line, 3);
+  EXPECT_FALSE(target.sourcemap->resolve(8).has_value());
+}
+
+TEST(preprocessor, text) {  // NOLINT
+  fs::path pptest_path = fs::path(TEST_ROOT_DIR) / "preprocessor";
+  mimium::Preprocessor preprocessor(pptest_path);
+  const auto text = preprocessor.process(pptest_path / "includer.mmm").source;
+  auto answer = preprocessor.process(pptest_path / "include_answer.mmm");
+  // includes are resolved from the directory of the path, which does not exist.
+  auto target = preprocessor.process("include \"includer.mmm\"\n", pptest_path / "embedded.mmm");
+  EXPECT_EQ(target.source, answer.source);
+  EXPECT_EQ(preprocessor.process(text, pptest_path / "embedded.mmm").source, answer.source);
+  EXPECT_EQ(target.sourcemap->resolve(1).value().filepath.filename(), "includee.mmm");
+}